@@ -72,7 +72,11 @@ const PhraseNode* OnDiskQuery::Query(const SourcePhrase& sourcePhrase)
 
   for (size_t pos = 0; pos < sourcePhrase.GetSize(); ++pos) {
     const Word &word = sourcePhrase.GetWord(pos);
-    node = node->GetChild(word, m_wrapper);
+    const PhraseNode *child = node->GetChild(word, m_wrapper);
+    if (node != &m_wrapper.GetRootSourceNode()) {
+      delete node;
+    }
+    node = child;
     if (node == NULL) {
       break;
     }
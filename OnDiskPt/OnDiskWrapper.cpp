@@ -25,15 +25,26 @@
 #include "OnDiskWrapper.h"
 #include "moses/Factor.h"
 #include "util/exception.hh"
+#include "util/file.hh"
 
 using namespace std;
 
 namespace OnDiskPt
 {
 
+namespace
+{
+void MapFile(const std::string &path, util::scoped_memory &to)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(path.c_str()));
+  util::MapRead(util::LAZY, fd.get(), 0, util::SizeFile(fd.get()), to);
+}
+}
+
 int OnDiskWrapper::VERSION_NUM = 7;
 
 OnDiskWrapper::OnDiskWrapper()
+  : m_rootSourceNode(NULL)
 {
 }
 
@@ -57,20 +68,9 @@ void OnDiskWrapper::BeginLoad(const std::string &filePath)
 
 bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
 {
-  m_fileSource.open((filePath + "/Source.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileSource.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/Source.dat");
-
-  m_fileTargetInd.open((filePath + "/TargetInd.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetInd.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetInd.dat");
-
-  m_fileTargetColl.open((filePath + "/TargetColl.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetColl.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetColl.dat");
+  MapFile(filePath + "/Source.dat", m_memSource);
+  MapFile(filePath + "/TargetInd.dat", m_memTargetInd);
+  MapFile(filePath + "/TargetColl.dat", m_memTargetColl);
 
   m_fileVocab.open((filePath + "/Vocab.dat").c_str(), ios::in);
   UTIL_THROW_IF(!m_fileVocab.is_open(),
@@ -23,6 +23,7 @@
 #include "Vocab.h"
 #include "PhraseNode.h"
 #include "moses/Word.h"
+#include "util/mmap.hh"
 
 namespace OnDiskPt
 {
@@ -40,6 +41,10 @@ protected:
   int m_numSourceFactors, m_numTargetFactors, m_numScores;
   std::fstream m_fileMisc, m_fileVocab, m_fileSource, m_fileTarget, m_fileTargetInd, m_fileTargetColl;
 
+  // when loaded, the rules are read from these mappings of Source.dat, TargetInd.dat and
+  // TargetColl.dat. They are never written, so one loaded wrapper can be shared by threads
+  util::scoped_memory m_memSource, m_memTargetInd, m_memTargetColl;
+
   size_t m_defaultNodeSize;
   PhraseNode *m_rootSourceNode;
 
@@ -84,6 +89,16 @@ public:
     return m_fileVocab;
   }
 
+  const char *GetMemSource() const {
+    return m_memSource.begin();
+  }
+  const char *GetMemTargetInd() const {
+    return m_memTargetInd.begin();
+  }
+  const char *GetMemTargetColl() const {
+    return m_memTargetColl.begin();
+  }
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
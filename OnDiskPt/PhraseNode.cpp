@@ -45,36 +45,24 @@ PhraseNode::PhraseNode()
 {
 }
 
-PhraseNode::PhraseNode(UINT64 filePos, OnDiskWrapper &onDiskWrapper)
+PhraseNode::PhraseNode(UINT64 filePos, const OnDiskWrapper &onDiskWrapper)
   :m_counts(onDiskWrapper.GetNumCounts())
 {
-  // load saved node
+  // load saved node. The children are read from the mapped file when looked up
   m_filePos = filePos;
 
   size_t countSize = onDiskWrapper.GetNumCounts();
 
-  std::fstream &file = onDiskWrapper.GetFileSource();
-  file.seekg(filePos);
-  assert(filePos == (UINT64)file.tellg());
-
-  file.read((char*) &m_numChildrenLoad, sizeof(UINT64));
+  m_memLoad = onDiskWrapper.GetMemSource() + filePos;
+  m_numChildrenLoad = ((const UINT64*)m_memLoad)[0];
 
   size_t memAlloc = GetNodeSize(m_numChildrenLoad, onDiskWrapper.GetSourceWordSize(), countSize);
-  m_memLoad = (char*) malloc(memAlloc);
-
-  // go to start of node again
-  file.seekg(filePos);
-  assert(filePos == (UINT64)file.tellg());
-
-  // read everything into memory
-  file.read(m_memLoad, memAlloc);
-  assert(filePos + memAlloc == (UINT64)file.tellg());
 
   // get value
-  m_value = ((UINT64*)m_memLoad)[1];
+  m_value = ((const UINT64*)m_memLoad)[1];
 
   // get counts
-  float *memFloat = (float*) (m_memLoad + sizeof(UINT64) * 2);
+  const float *memFloat = (const float*) (m_memLoad + sizeof(UINT64) * 2);
 
   assert(countSize == 1);
   m_counts[0] = memFloat[0];
@@ -84,7 +72,6 @@ PhraseNode::PhraseNode(UINT64 filePos, OnDiskWrapper &onDiskWrapper)
 
 PhraseNode::~PhraseNode()
 {
-  free(m_memLoad);
 }
 
 float PhraseNode::GetCount(size_t ind) const
@@ -194,7 +181,7 @@ void PhraseNode::AddTargetPhrase(size_t pos, const SourcePhrase &sourcePhrase
   }
 }
 
-const PhraseNode *PhraseNode::GetChild(const Word &wordSought, OnDiskWrapper &onDiskWrapper) const
+const PhraseNode *PhraseNode::GetChild(const Word &wordSought, const OnDiskWrapper &onDiskWrapper) const
 {
   const PhraseNode *ret = NULL;
 
@@ -222,13 +209,13 @@ const PhraseNode *PhraseNode::GetChild(const Word &wordSought, OnDiskWrapper &on
   return ret;
 }
 
-void PhraseNode::GetChild(Word &wordFound, UINT64 &childFilePos, size_t ind, OnDiskWrapper &onDiskWrapper) const
+void PhraseNode::GetChild(Word &wordFound, UINT64 &childFilePos, size_t ind, const OnDiskWrapper &onDiskWrapper) const
 {
 
   size_t wordSize = onDiskWrapper.GetSourceWordSize();
   size_t childSize = wordSize + sizeof(UINT64);
 
-  char *currMem = m_memLoad
+  const char *currMem = m_memLoad
                   + sizeof(UINT64) * 2 // size & file pos of target phrase coll
                   + sizeof(float) * onDiskWrapper.GetNumCounts() // count info
                   + childSize * ind;
@@ -242,14 +229,14 @@ size_t PhraseNode::ReadChild(Word &wordFound, UINT64 &childFilePos, const char *
   size_t memRead = wordFound.ReadFromMemory(mem);
 
   const char *currMem = mem + memRead;
-  UINT64 *memArray = (UINT64*) (currMem);
+  const UINT64 *memArray = (const UINT64*) (currMem);
   childFilePos = memArray[0];
 
   memRead += sizeof(UINT64);
   return memRead;
 }
 
-const TargetPhraseCollection *PhraseNode::GetTargetPhraseCollection(size_t tableLimit, OnDiskWrapper &onDiskWrapper) const
+const TargetPhraseCollection *PhraseNode::GetTargetPhraseCollection(size_t tableLimit, const OnDiskWrapper &onDiskWrapper) const
 {
   TargetPhraseCollection *ret = new TargetPhraseCollection();
 
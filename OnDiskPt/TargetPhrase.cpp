@@ -317,76 +317,59 @@ Moses::TargetPhrase *TargetPhrase::ConvertToMoses(const std::vector<Moses::Facto
   return ret;
 }
 
-UINT64 TargetPhrase::ReadOtherInfoFromFile(UINT64 filePos, std::fstream &fileTPColl)
+UINT64 TargetPhrase::ReadOtherInfoFromMemory(const char *mem)
 {
-  assert(filePos == (UINT64)fileTPColl.tellg());
-
   UINT64 memUsed = 0;
-  fileTPColl.read((char*) &m_filePos, sizeof(UINT64));
+  m_filePos = ((const UINT64*) mem)[0];
   memUsed += sizeof(UINT64);
   assert(m_filePos != 0);
 
-  memUsed += ReadAlignFromFile(fileTPColl);
-  assert((memUsed + filePos) == (UINT64)fileTPColl.tellg());
-
-  memUsed += ReadScoresFromFile(fileTPColl);
-  assert((memUsed + filePos) == (UINT64)fileTPColl.tellg());
+  memUsed += ReadAlignFromMemory(mem + memUsed);
+  memUsed += ReadScoresFromMemory(mem + memUsed);
 
   // sparse features
-  memUsed += ReadStringFromFile(fileTPColl, m_sparseFeatures);
+  memUsed += ReadStringFromMemory(mem + memUsed, m_sparseFeatures);
 
   // properties
-  memUsed += ReadStringFromFile(fileTPColl, m_property);
+  memUsed += ReadStringFromMemory(mem + memUsed, m_property);
 
   return memUsed;
 }
 
-UINT64 TargetPhrase::ReadStringFromFile(std::fstream &fileTPColl, std::string &outStr)
+UINT64 TargetPhrase::ReadStringFromMemory(const char *mem, std::string &outStr)
 {
   UINT64 bytesRead = 0;
 
-  UINT64 strSize;
-  fileTPColl.read((char*) &strSize, sizeof(UINT64));
+  UINT64 strSize = ((const UINT64*) mem)[0];
   bytesRead += sizeof(UINT64);
 
-  if (strSize) {
-	  char *mem = (char*) malloc(strSize + 1);
-	  mem[strSize] = '\0';
-	  fileTPColl.read(mem, strSize);
-	  outStr = string(mem);
-	  free(mem);
-
-	  bytesRead += strSize;
-  }
+  outStr.assign(mem + bytesRead, strSize);
+  bytesRead += strSize;
 
   return bytesRead;
 }
 
-UINT64 TargetPhrase::ReadFromFile(std::fstream &fileTP)
+UINT64 TargetPhrase::ReadFromMemory(const char *mem)
 {
   UINT64 bytesRead = 0;
 
-  fileTP.seekg(m_filePos);
-
-  UINT64 numWords;
-  fileTP.read((char*) &numWords, sizeof(UINT64));
+  UINT64 numWords = ((const UINT64*) mem)[0];
   bytesRead += sizeof(UINT64);
 
   for (size_t ind = 0; ind < numWords; ++ind) {
     WordPtr word(new Word());
-    bytesRead += word->ReadFromFile(fileTP);
+    bytesRead += word->ReadFromMemory(mem + bytesRead);
     AddWord(word);
   }
 
   // read source words
-  UINT64 numSourceWords;
-  fileTP.read((char*) &numSourceWords, sizeof(UINT64));
+  UINT64 numSourceWords = ((const UINT64*) (mem + bytesRead))[0];
   bytesRead += sizeof(UINT64);
 
   PhrasePtr sp(new SourcePhrase());
   for (size_t ind = 0; ind < numSourceWords; ++ind) {
     WordPtr word( new Word());
-    bytesRead += word->ReadFromFile(fileTP);
+    bytesRead += word->ReadFromMemory(mem + bytesRead);
     sp->AddWord(word);
   }
   SetSourcePhrase(sp);
@@ -394,37 +377,28 @@ UINT64 TargetPhrase::ReadFromFile(std::fstream &fileTP)
   return bytesRead;
 }
 
-UINT64 TargetPhrase::ReadAlignFromFile(std::fstream &fileTPColl)
+UINT64 TargetPhrase::ReadAlignFromMemory(const char *mem)
 {
-  UINT64 bytesRead = 0;
-
-  UINT64 numAlign;
-  fileTPColl.read((char*) &numAlign, sizeof(UINT64));
-  bytesRead += sizeof(UINT64);
+  const UINT64 *memArray = (const UINT64*) mem;
+  UINT64 numAlign = memArray[0];
 
+  m_align.reserve(m_align.size() + numAlign);
   for (size_t ind = 0; ind < numAlign; ++ind) {
     AlignPair alignPair;
-    fileTPColl.read((char*) &alignPair.first, sizeof(UINT64));
-    fileTPColl.read((char*) &alignPair.second, sizeof(UINT64));
+    alignPair.first = memArray[1 + ind * 2];
+    alignPair.second = memArray[2 + ind * 2];
     m_align.push_back(alignPair);
-
-    bytesRead += sizeof(UINT64) * 2;
   }
 
-  return bytesRead;
+  return sizeof(UINT64) * (1 + numAlign * 2);
 }
 
-UINT64 TargetPhrase::ReadScoresFromFile(std::fstream &fileTPColl)
+UINT64 TargetPhrase::ReadScoresFromMemory(const char *mem)
 {
   UTIL_THROW_IF2(m_scores.size() == 0, "Translation rules must must have some scores");
 
-  UINT64 bytesRead = 0;
-
-  for (size_t ind = 0; ind < m_scores.size(); ++ind) {
-    fileTPColl.read((char*) &m_scores[ind], sizeof(float));
-
-    bytesRead += sizeof(float);
-  }
+  UINT64 bytesRead = sizeof(float) * m_scores.size();
+  memcpy(&m_scores[0], mem, bytesRead);
 
   std::transform(m_scores.begin(),m_scores.end(),m_scores.begin(), Moses::TransformScore);
   std::transform(m_scores.begin(),m_scores.end(),m_scores.begin(), Moses::FloorScore);
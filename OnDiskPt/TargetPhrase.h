@@ -59,9 +59,9 @@ protected:
   size_t WriteScoresToMemory(char *mem) const;
   size_t WriteStringToMemory(char *mem, const std::string &str) const;
 
-  UINT64 ReadAlignFromFile(std::fstream &fileTPColl);
-  UINT64 ReadScoresFromFile(std::fstream &fileTPColl);
-  UINT64 ReadStringFromFile(std::fstream &fileTPColl, std::string &outStr);
+  UINT64 ReadAlignFromMemory(const char *mem);
+  UINT64 ReadScoresFromMemory(const char *mem);
+  UINT64 ReadStringFromMemory(const char *mem, std::string &outStr);
 
 public:
   TargetPhrase() {
@@ -108,8 +108,8 @@ public:
                                       , const Moses::PhraseDictionary &phraseDict
                                       , const std::vector<float> &weightT
                                       , bool isSyntax) const;
-  UINT64 ReadOtherInfoFromFile(UINT64 filePos, std::fstream &fileTPColl);
-  UINT64 ReadFromFile(std::fstream &fileTP);
+  UINT64 ReadOtherInfoFromMemory(const char *mem);
+  UINT64 ReadFromMemory(const char *mem);
 
   virtual void DebugPrint(std::ostream &out, const Vocab &vocab) const;
 
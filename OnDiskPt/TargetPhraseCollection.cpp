@@ -147,32 +147,28 @@ Moses::TargetPhraseCollection *TargetPhraseCollection::ConvertToMoses(const std:
 
 }
 
-void TargetPhraseCollection::ReadFromFile(size_t tableLimit, UINT64 filePos, OnDiskWrapper &onDiskWrapper)
+void TargetPhraseCollection::ReadFromFile(size_t tableLimit, UINT64 filePos, const OnDiskWrapper &onDiskWrapper)
 {
-  fstream &fileTPColl = onDiskWrapper.GetFileTargetColl();
-  fstream &fileTP = onDiskWrapper.GetFileTargetInd();
+  const char *memTPColl = onDiskWrapper.GetMemTargetColl();
+  const char *memTP = onDiskWrapper.GetMemTargetInd();
 
   size_t numScores = onDiskWrapper.GetNumScores();
 
-
-  UINT64 numPhrases;
-
-  UINT64 currFilePos = filePos;
-  fileTPColl.seekg(filePos);
-  fileTPColl.read((char*) &numPhrases, sizeof(UINT64));
+  UINT64 numPhrases = ((const UINT64*) (memTPColl + filePos))[0];
 
   // table limit
   if (tableLimit) {
     numPhrases = std::min(numPhrases, (UINT64) tableLimit);
   }
 
-  currFilePos += sizeof(UINT64);
+  UINT64 currFilePos = filePos + sizeof(UINT64);
 
+  m_coll.reserve(numPhrases);
   for (size_t ind = 0; ind < numPhrases; ++ind) {
     TargetPhrase *tp = new TargetPhrase(numScores);
 
-    UINT64 sizeOtherInfo = tp->ReadOtherInfoFromFile(currFilePos, fileTPColl);
-    tp->ReadFromFile(fileTP);
+    UINT64 sizeOtherInfo = tp->ReadOtherInfoFromMemory(memTPColl + currFilePos);
+    tp->ReadFromMemory(memTP + tp->GetFilePos());
 
     currFilePos += sizeOtherInfo;
 
@@ -70,7 +70,7 @@ size_t Word::WriteToMemory(char *mem) const
 
 size_t Word::ReadFromMemory(const char *mem)
 {
-  UINT64 *vocabMem = (UINT64*) mem;
+  const UINT64 *vocabMem = (const UINT64*) mem;
   m_vocabId = vocabMem[0];
 
   size_t memUsed = sizeof(UINT64);
@@ -84,18 +84,6 @@ size_t Word::ReadFromMemory(const char *mem)
   return memUsed;
 }
 
-size_t Word::ReadFromFile(std::fstream &file)
-{
-  const size_t memAlloc = sizeof(UINT64) + sizeof(char);
-  char mem[sizeof(UINT64) + sizeof(char)];
-  file.read(mem, memAlloc);
-
-  size_t memUsed = ReadFromMemory(mem);
-  assert(memAlloc == memUsed);
-
-  return memAlloc;
-}
-
 void Word::ConvertToMoses(
   const std::vector<Moses::FactorType> &outputFactorsVec,
   const Vocab &vocab,
@@ -7,10 +7,15 @@
 #include <vector>
 
 #include "moses/Util.h"
+#include "util/usage.hh"
 #include "OnDiskWrapper.h"
 #include "SourcePhrase.h"
 #include "OnDiskQuery.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
 using namespace std;
 using namespace OnDiskPt;
 
@@ -18,10 +23,70 @@ void usage();
 
 typedef unsigned int uint;
 
+namespace
+{
+//! looks up every numThreads'th query, starting at the first, with its rules
+void LookUp(OnDiskQuery &onDiskQuery, const OnDiskWrapper &onDiskWrapper, int tableLimit
+            , const std::vector<SourcePhrase> &queries, size_t first, size_t numThreads, size_t repeat)
+{
+  for (size_t i = first; i < queries.size() * repeat; i += numThreads) {
+    const PhraseNode *node = onDiskQuery.Query(queries[i % queries.size()]);
+    if (node) {
+      delete node->GetTargetPhraseCollection(tableLimit, onDiskWrapper);
+      if (node != &onDiskWrapper.GetRootSourceNode()) {
+        delete node;
+      }
+    }
+  }
+}
+
+//! looks up the queries of stdin, repeat times, with each number of threads
+void Benchmark(OnDiskWrapper &onDiskWrapper, int tableLimit
+               , const std::vector<size_t> &threadCounts, size_t repeat)
+{
+  OnDiskQuery onDiskQuery(onDiskWrapper);
+
+  // tokenising adds unknown words to the vocab, so it is done before the threads start
+  std::vector<SourcePhrase> queries;
+  std::string line;
+  while(getline(std::cin, line)) {
+    queries.push_back(onDiskQuery.Tokenize(Moses::Tokenize(line, " ")));
+  }
+  if (queries.empty()) {
+    return;
+  }
+
+  for (size_t t = 0; t < threadCounts.size(); ++t) {
+    size_t numThreads = threadCounts[t];
+    double start = util::WallTime();
+#ifdef WITH_THREADS
+    boost::thread_group threads;
+    for (size_t i = 0; i < numThreads; ++i) {
+      threads.create_thread(boost::bind(&LookUp, boost::ref(onDiskQuery), boost::cref(onDiskWrapper), tableLimit
+                                        , boost::cref(queries), i, numThreads, repeat));
+    }
+    threads.join_all();
+#else
+    if (numThreads != 1) {
+      cerr << "queryOnDiskPt was built without thread support, skipping " << numThreads << " threads" << endl;
+      continue;
+    }
+    LookUp(onDiskQuery, onDiskWrapper, tableLimit, queries, 0, 1, repeat);
+#endif
+    double seconds = util::WallTime() - start;
+    size_t lookups = queries.size() * repeat;
+    cout << numThreads << " threads: " << lookups << " lookups in " << seconds << " seconds, "
+         << lookups / seconds << " lookups/second" << endl;
+  }
+}
+}
+
 int main(int argc, char **argv)
 {
   int tableLimit = 20;
   std::string ttable = "";
+  std::vector<size_t> threadCounts;
+  size_t repeat = 1;
   // bool useAlignments = false;
 
   for(int i = 1; i < argc; i++) {
@@ -33,6 +98,14 @@ int main(int argc, char **argv)
       if(i + 1 == argc)
         usage();
       ttable = argv[++i];
+    } else if(!strcmp(argv[i], "-benchmark")) {
+      if(i + 1 == argc)
+        usage();
+      threadCounts = Moses::Tokenize<size_t>(argv[++i], ",");
+    } else if(!strcmp(argv[i], "-repeat")) {
+      if(i + 1 == argc)
+        usage();
+      repeat = atoi(argv[++i]);
     } else
       usage();
   }
@@ -42,6 +115,12 @@ int main(int argc, char **argv)
 
   OnDiskWrapper onDiskWrapper;
   onDiskWrapper.BeginLoad(ttable);
+
+  if (!threadCounts.empty()) {
+    Benchmark(onDiskWrapper, tableLimit, threadCounts, repeat);
+    return 0;
+  }
+
   OnDiskQuery onDiskQuery(onDiskWrapper);
 
   cerr << "Ready..." << endl;
@@ -81,6 +160,8 @@ void usage()
 {
   std::cerr << "Usage: queryOnDiskPt [-n <nscores>] [-a] -t <ttable>\n"
             "-tlimit <table limit>      max number of rules per source phrase (default: 20)\n"
-            "-t <ttable>       phrase table\n";
+            "-t <ttable>       phrase table\n"
+            "-benchmark <n1,n2,...>     look up the phrases of stdin with n1, n2, ... threads and report lookups/second\n"
+            "-repeat <n>       look up the phrases n times in each benchmark run (default: 1)\n";
   exit(1);
 }
@@ -0,0 +1,143 @@
+// -*- c++ -*-
+#pragma once
+
+/**
+ * Wire format of moses-binary-server.
+ *
+ * Every message is a frame: a 32 bit length followed by that many bytes of
+ * payload. All integers are unsigned 32 bit in network byte order, floats
+ * are sent as the bits of an IEEE single, and strings are a length followed
+ * by that many bytes of UTF-8.
+ *
+ * Request payload:
+ *   request id      chosen by the client, echoed in every result
+ *   n-best size     0 for the 1-best translation only
+ *   flags           FLAG_NBEST_DISTINCT
+ *   stack size      0 for the server default
+ *   count           number of sentences
+ *   count strings   the sentences
+ *
+ * Result payload, one frame per sentence, sent as soon as it is decoded:
+ *   request id
+ *   sentence index  position of the sentence in its request
+ *   status          STATUS_OK, or STATUS_ERROR with the message as translation
+ *   string          translation
+ *   float           score of the translation
+ *   count           number of n-best entries
+ *   count times     string, float
+ *
+ * A client may send more requests without waiting for results, and results
+ * of different sentences arrive in the order they finish.
+ */
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+namespace BinaryProtocol
+{
+
+const uint32_t FLAG_NBEST_DISTINCT = 1;
+
+const uint32_t STATUS_OK = 0;
+const uint32_t STATUS_ERROR = 1;
+
+//! frames larger than this are rejected, so a bad length cannot exhaust memory
+const uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+class FormatError : public std::runtime_error
+{
+public:
+  explicit FormatError(const std::string &what) : std::runtime_error(what) {}
+};
+
+//! Reads the fields of a payload, throwing FormatError if it is too short
+class FrameReader
+{
+public:
+  FrameReader(const char *data, size_t size) : m_data(data), m_left(size) {}
+
+  uint32_t ReadInt() {
+    uint32_t ret;
+    Take(&ret, sizeof(ret));
+    return ntohl(ret);
+  }
+
+  float ReadFloat() {
+    uint32_t bits = ReadInt();
+    float ret;
+    memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+  }
+
+  std::string ReadString() {
+    uint32_t size = ReadInt();
+    if (size > m_left) {
+      throw FormatError("string is longer than its frame");
+    }
+    std::string ret(m_data, size);
+    m_data += size;
+    m_left -= size;
+    return ret;
+  }
+
+  bool AtEnd() const {
+    return m_left == 0;
+  }
+
+private:
+  void Take(void *to, size_t size) {
+    if (size > m_left) {
+      throw FormatError("frame is truncated");
+    }
+    memcpy(to, m_data, size);
+    m_data += size;
+    m_left -= size;
+  }
+
+  const char *m_data;
+  size_t m_left;
+};
+
+//! Builds a frame; the length is filled in by Finish()
+class FrameWriter
+{
+public:
+  FrameWriter() : m_buffer(sizeof(uint32_t)) {}
+
+  void WriteInt(uint32_t value) {
+    value = htonl(value);
+    Append(&value, sizeof(value));
+  }
+
+  void WriteFloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    WriteInt(bits);
+  }
+
+  void WriteString(const std::string &value) {
+    WriteInt(value.size());
+    Append(value.data(), value.size());
+  }
+
+  //! the frame, including its length
+  std::vector<char> &Finish() {
+    uint32_t length = htonl(m_buffer.size() - sizeof(uint32_t));
+    memcpy(&m_buffer[0], &length, sizeof(length));
+    return m_buffer;
+  }
+
+private:
+  void Append(const void *data, size_t size) {
+    const char *bytes = static_cast<const char*>(data);
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+  }
+
+  std::vector<char> m_buffer;
+};
+
+}
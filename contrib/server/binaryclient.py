@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Client for moses-binary-server, see BinaryProtocol.h for the format.
+#
+# Translates stdin line by line, sending --batch sentences per request.
+# All requests are sent without waiting for results; translations are
+# printed in input order, with the n-best list after each if requested.
+#
+#   binaryclient.py --port 8081 --batch 32 < input > output
+#   binaryclient.py --socket /tmp/moses.sock --nbest 10 < input
+
+import argparse
+import socket
+import struct
+import sys
+import threading
+
+FLAG_NBEST_DISTINCT = 1
+STATUS_OK = 0
+
+
+def encode_string(data):
+    return struct.pack('!I', len(data)) + data
+
+
+def request_frame(request_id, sentences, nbest, distinct, stack):
+    payload = struct.pack('!IIIII', request_id, nbest,
+                          FLAG_NBEST_DISTINCT if distinct else 0,
+                          stack, len(sentences))
+    payload += b''.join(encode_string(s) for s in sentences)
+    return struct.pack('!I', len(payload)) + payload
+
+
+def read_exactly(f, size):
+    data = f.read(size)
+    if len(data) != size:
+        raise IOError("connection closed by server")
+    return data
+
+
+class Reader(object):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def int(self):
+        value, = struct.unpack_from('!I', self.data, self.pos)
+        self.pos += 4
+        return value
+
+    def float(self):
+        value, = struct.unpack_from('!f', self.data, self.pos)
+        self.pos += 4
+        return value
+
+    def string(self):
+        size = self.int()
+        value = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+
+def read_result(f):
+    size, = struct.unpack('!I', read_exactly(f, 4))
+    r = Reader(read_exactly(f, size))
+    request_id = r.int()
+    index = r.int()
+    status = r.int()
+    translation = r.string()
+    score = r.float()
+    nbest = [(r.string(), r.float()) for _ in range(r.int())]
+    return request_id, index, status, translation, score, nbest
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', type=int, default=8081)
+    parser.add_argument('--socket', help="Unix socket of the server, instead of --host and --port")
+    parser.add_argument('--batch', type=int, default=16, help="sentences per request")
+    parser.add_argument('--nbest', type=int, default=0)
+    parser.add_argument('--distinct', action='store_true')
+    parser.add_argument('--stack', type=int, default=0, help="stack size, 0 for the server default")
+    args = parser.parse_args()
+
+    # bytes on both python 2 and 3
+    lines = [line.rstrip(b'\n') for line in getattr(sys.stdin, 'buffer', sys.stdin)]
+    batches = [lines[i:i + args.batch] for i in range(0, len(lines), args.batch)]
+
+    if args.socket:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(args.socket)
+    else:
+        sock = socket.create_connection((args.host, args.port))
+
+    # send from another thread, so that results are read while sending
+    def send():
+        for request_id, batch in enumerate(batches):
+            sock.sendall(request_frame(request_id, batch, args.nbest, args.distinct, args.stack))
+    sender = threading.Thread(target=send)
+    sender.start()
+
+    results = {}
+    f = sock.makefile('rb')
+    for _ in range(len(lines)):
+        request_id, index, status, translation, score, nbest = read_result(f)
+        if status != STATUS_OK:
+            sys.stderr.write("Error translating line %d: %s\n" % (request_id * args.batch + index + 1, translation.decode('utf-8')))
+            translation = b''
+        results[request_id * args.batch + index] = (translation, nbest)
+    sender.join()
+    sock.close()
+
+    out = getattr(sys.stdout, 'buffer', sys.stdout)
+    for i in range(len(lines)):
+        translation, nbest = results[i]
+        out.write(translation + b'\n')
+        for hyp, score in nbest:
+            out.write(("%d ||| " % i).encode('utf-8') + hyp + (" ||| %f\n" % score).encode('utf-8'))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,485 @@
+// Translation server speaking the length-prefixed binary protocol of
+// BinaryProtocol.h over TCP and/or a Unix socket.
+//
+// Unlike mosesserver, which parks an xmlrpc connection thread on every
+// request, all sockets are served by one thread with asynchronous I/O. A
+// request may carry many sentences, each of which is decoded as a separate
+// task in the thread pool, and its result is written back as soon as it is
+// done. Clients may pipeline requests on one connection; once
+// --max-pending sentences of a connection are waiting to be decoded or
+// written back, no more requests are read from it until results have gone
+// out.
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "moses/ChartManager.h"
+#include "moses/ChartKBestExtractor.h"
+#include "moses/DecodingOptions.h"
+#include "moses/Hypothesis.h"
+#include "moses/Manager.h"
+#include "moses/Parameter.h"
+#include "moses/Sentence.h"
+#include "moses/StaticData.h"
+#include "moses/ThreadPool.h"
+#include "moses/TreeInput.h"
+#include "moses/TrellisPathList.h"
+#include "moses/Util.h"
+
+#include "BinaryProtocol.h"
+
+#ifndef WITH_THREADS
+#error moses-binary-server needs threads
+#endif
+
+using namespace Moses;
+using namespace std;
+using namespace BinaryProtocol;
+
+namespace asio = boost::asio;
+
+namespace
+{
+
+typedef boost::shared_ptr<vector<char> > FramePtr;
+
+struct Result {
+  Result() : score(0) {}
+  string translation;
+  float score;
+  vector<pair<string, float> > nBest;
+};
+
+//! chart output phrases start with <s> and end with </s>
+void StripSentenceMarkers(Phrase &phrase)
+{
+  if (phrase.GetSize() >= 2) {
+    phrase.RemoveWord(phrase.GetSize() - 1);
+    phrase.RemoveWord(0);
+  }
+}
+
+void Translate(const string &source, long translationId,
+               const boost::shared_ptr<const DecodingOptions> &options,
+               size_t nBestSize, bool nBestDistinct, Result &result)
+{
+  const StaticData &staticData = StaticData::Instance();
+  const vector<FactorType> &inputFactorOrder = staticData.GetInputFactorOrder();
+  const vector<FactorType> &outputFactorOrder = staticData.GetOutputFactorOrder();
+  stringstream in(source + "\n");
+
+  if (staticData.IsChart()) {
+    TreeInput tinput;
+    tinput.Read(in, inputFactorOrder);
+    tinput.SetTranslationId(translationId);
+    tinput.SetOptions(options);
+    ChartManager manager(tinput);
+    manager.Decode();
+    const ChartHypothesis *hypo = manager.GetBestHypothesis();
+    if (hypo) {
+      Phrase outPhrase(20);
+      hypo->GetOutputPhrase(outPhrase);
+      StripSentenceMarkers(outPhrase);
+      result.translation = outPhrase.GetStringRep(outputFactorOrder);
+      result.score = hypo->GetTotalScore();
+    }
+    if (nBestSize > 0) {
+      ChartKBestExtractor::KBestVec nBestList;
+      manager.CalcNBest(nBestSize, nBestList, nBestDistinct);
+      for (size_t i = 0; i < nBestList.size(); ++i) {
+        Phrase outPhrase = ChartKBestExtractor::GetOutputPhrase(*nBestList[i]);
+        StripSentenceMarkers(outPhrase);
+        result.nBest.push_back(make_pair(outPhrase.GetStringRep(outputFactorOrder), nBestList[i]->score));
+      }
+    }
+  } else {
+    Sentence sentence;
+    sentence.Read(in, inputFactorOrder);
+    sentence.SetTranslationId(translationId);
+    sentence.SetOptions(options);
+    Manager manager(sentence, staticData.GetSearchAlgorithm());
+    manager.Decode();
+    const Hypothesis *hypo = manager.GetBestHypothesis();
+    if (hypo) {
+      Phrase outPhrase;
+      hypo->GetOutputPhrase(outPhrase);
+      result.translation = outPhrase.GetStringRep(outputFactorOrder);
+      result.score = hypo->GetTotalScore();
+    }
+    if (nBestSize > 0) {
+      TrellisPathList nBestList;
+      manager.CalcNBest(nBestSize, nBestList, nBestDistinct);
+      for (TrellisPathList::const_iterator iter = nBestList.begin(); iter != nBestList.end(); ++iter) {
+        const TrellisPath &path = **iter;
+        result.nBest.push_back(make_pair(path.GetTargetPhrase().GetStringRep(outputFactorOrder), path.GetTotalScore()));
+      }
+    }
+  }
+}
+
+/** Where the results of sentence tasks go. Kept alive by the tasks, so
+ *  that a client hanging up does not pull the connection from under them.
+ */
+class ResultSink
+{
+public:
+  virtual ~ResultSink() {}
+  //! may be called from any thread
+  virtual void Send(const FramePtr &frame) = 0;
+};
+
+/** Settings shared by the sentences of one request */
+struct Request {
+  uint32_t id;
+  size_t nBestSize;
+  bool nBestDistinct;
+  boost::shared_ptr<const DecodingOptions> options;
+};
+
+class SentenceTask : public Moses::Task
+{
+public:
+  SentenceTask(const boost::shared_ptr<ResultSink> &sink,
+               const boost::shared_ptr<const Request> &request,
+               uint32_t index, const string &source, long translationId)
+    : m_sink(sink)
+    , m_request(request)
+    , m_index(index)
+    , m_source(source)
+    , m_translationId(translationId) {
+  }
+
+  // shorter sentences are picked up first, see -thread-priority-length
+  virtual size_t GetPriority() const {
+    return StaticData::Instance().GetThreadPriority(Tokenize(m_source).size());
+  }
+
+  virtual void Run() {
+    Result result;
+    uint32_t status = STATUS_OK;
+    try {
+      Translate(m_source, m_translationId, m_request->options,
+                m_request->nBestSize, m_request->nBestDistinct, result);
+    } catch (const std::exception &e) {
+      status = STATUS_ERROR;
+      result = Result();
+      result.translation = e.what();
+    }
+
+    FrameWriter writer;
+    writer.WriteInt(m_request->id);
+    writer.WriteInt(m_index);
+    writer.WriteInt(status);
+    writer.WriteString(result.translation);
+    writer.WriteFloat(result.score);
+    writer.WriteInt(result.nBest.size());
+    for (size_t i = 0; i < result.nBest.size(); ++i) {
+      writer.WriteString(result.nBest[i].first);
+      writer.WriteFloat(result.nBest[i].second);
+    }
+    FramePtr frame(new vector<char>);
+    frame->swap(writer.Finish());
+    m_sink->Send(frame);
+  }
+
+private:
+  boost::shared_ptr<ResultSink> m_sink;
+  boost::shared_ptr<const Request> m_request;
+  uint32_t m_index;
+  string m_source;
+  long m_translationId;
+};
+
+/** One client. Reads requests and writes results asynchronously on the I/O
+ *  thread; Send() hands results over from the decoding threads.
+ */
+template <class Socket>
+class Connection : public ResultSink
+  , public boost::enable_shared_from_this<Connection<Socket> >
+{
+public:
+  Connection(asio::io_service &io, ThreadPool &pool, boost::atomic<long> &translationId,
+             size_t maxPending)
+    : m_io(io)
+    , m_socket(io)
+    , m_pool(pool)
+    , m_translationId(translationId)
+    , m_maxPending(maxPending)
+    , m_pending(0)
+    , m_paused(false)
+    , m_closed(false) {
+  }
+
+  Socket &GetSocket() {
+    return m_socket;
+  }
+
+  void Start() {
+    ReadHeader();
+  }
+
+  void Send(const FramePtr &frame) {
+    m_io.post(boost::bind(&Connection::Queue, this->shared_from_this(), frame));
+  }
+
+private:
+  void ReadHeader() {
+    asio::async_read(m_socket, asio::buffer(&m_frameSize, sizeof(m_frameSize)),
+                     boost::bind(&Connection::OnHeader, this->shared_from_this(), asio::placeholders::error));
+  }
+
+  void OnHeader(const boost::system::error_code &error) {
+    if (error) {
+      return;
+    }
+    uint32_t size = ntohl(m_frameSize);
+    if (size > MAX_FRAME_SIZE) {
+      VERBOSE(1, "Closing connection: frame of " << size << " bytes" << endl);
+      Close();
+      return;
+    }
+    m_frame.resize(size);
+    asio::async_read(m_socket, asio::buffer(m_frame),
+                     boost::bind(&Connection::OnFrame, this->shared_from_this(), asio::placeholders::error));
+  }
+
+  void OnFrame(const boost::system::error_code &error) {
+    if (error) {
+      return;
+    }
+    vector<string> sentences;
+    boost::shared_ptr<Request> request(new Request);
+    try {
+      FrameReader reader(m_frame.empty() ? NULL : &m_frame[0], m_frame.size());
+      request->id = reader.ReadInt();
+      request->nBestSize = reader.ReadInt();
+      request->nBestDistinct = reader.ReadInt() & FLAG_NBEST_DISTINCT;
+      size_t stackSize = reader.ReadInt();
+      size_t count = reader.ReadInt();
+      for (size_t i = 0; i < count; ++i) {
+        sentences.push_back(reader.ReadString());
+      }
+
+      boost::shared_ptr<DecodingOptions> options(new DecodingOptions(StaticData::Instance().GetDecodingOptions()));
+      if (request->nBestSize > 0) {
+        options->nBestEnabled = true;
+        options->nBestSize = std::max(options->nBestSize, request->nBestSize);
+      }
+      if (stackSize > 0) {
+        options->maxHypoStackSize = stackSize;
+      }
+      request->options = options;
+    } catch (const FormatError &e) {
+      VERBOSE(1, "Closing connection: " << e.what() << endl);
+      Close();
+      return;
+    }
+
+    for (size_t i = 0; i < sentences.size(); ++i) {
+      m_pool.Submit(new SentenceTask(this->shared_from_this(), request, i, sentences[i], m_translationId++));
+    }
+    m_pending += sentences.size();
+
+    // backpressure: resumed by OnWrite() once results have been written
+    if (m_pending < m_maxPending) {
+      ReadHeader();
+    } else {
+      m_paused = true;
+    }
+  }
+
+  void Queue(const FramePtr &frame) {
+    if (m_closed) {
+      return;
+    }
+    m_outgoing.push_back(frame);
+    if (m_outgoing.size() == 1) {
+      WriteNext();
+    }
+  }
+
+  void WriteNext() {
+    asio::async_write(m_socket, asio::buffer(*m_outgoing.front()),
+                      boost::bind(&Connection::OnWrite, this->shared_from_this(), asio::placeholders::error));
+  }
+
+  void OnWrite(const boost::system::error_code &error) {
+    if (error) {
+      Close();
+      return;
+    }
+    m_outgoing.pop_front();
+    --m_pending;
+    if (!m_outgoing.empty()) {
+      WriteNext();
+    }
+    if (m_paused && m_pending < m_maxPending) {
+      m_paused = false;
+      ReadHeader();
+    }
+  }
+
+  void Close() {
+    m_closed = true;
+    m_outgoing.clear();
+    boost::system::error_code ignored;
+    m_socket.close(ignored);
+  }
+
+  asio::io_service &m_io;
+  Socket m_socket;
+  ThreadPool &m_pool;
+  boost::atomic<long> &m_translationId;
+  size_t m_maxPending;
+
+  // on the I/O thread only
+  size_t m_pending; //!< sentences submitted whose results are not written yet
+  bool m_paused; //!< not reading requests until m_pending drops
+
+  uint32_t m_frameSize;
+  vector<char> m_frame;
+  std::deque<FramePtr> m_outgoing; //!< front is being written
+  bool m_closed;
+};
+
+template <class Protocol>
+class Listener
+{
+public:
+  typedef Connection<typename Protocol::socket> ConnectionType;
+
+  Listener(asio::io_service &io, const typename Protocol::endpoint &endpoint,
+           ThreadPool &pool, boost::atomic<long> &translationId, size_t maxPending)
+    : m_io(io)
+    , m_acceptor(io, endpoint)
+    , m_pool(pool)
+    , m_translationId(translationId)
+    , m_maxPending(maxPending) {
+    Accept();
+  }
+
+private:
+  void Accept() {
+    boost::shared_ptr<ConnectionType> connection(new ConnectionType(m_io, m_pool, m_translationId, m_maxPending));
+    m_acceptor.async_accept(connection->GetSocket(),
+                            boost::bind(&Listener::OnAccept, this, connection, asio::placeholders::error));
+  }
+
+  void OnAccept(boost::shared_ptr<ConnectionType> connection, const boost::system::error_code &error) {
+    if (!error) {
+      connection->Start();
+    } else {
+      VERBOSE(1, "Accept failed: " << error.message() << endl);
+    }
+    Accept();
+  }
+
+  asio::io_service &m_io;
+  typename Protocol::acceptor m_acceptor;
+  ThreadPool &m_pool;
+  boost::atomic<long> &m_translationId;
+  size_t m_maxPending;
+};
+
+}
+
+int main(int argc, char** argv)
+{
+  //Extract server options, send other args to moses
+  vector<char*> mosesargv;
+  int port = -1;
+  const char *socketPath = NULL;
+  int numThreads = 10; //for translation tasks
+  int maxPending = 1000; //sentences per connection
+
+  for (int i = 0; i < argc; ++i) {
+    if (!strcmp(argv[i], "--server-port") || !strcmp(argv[i], "--server-socket")
+        || !strcmp(argv[i], "--threads") || !strcmp(argv[i], "--max-pending")) {
+      if (i + 1 >= argc) {
+        cerr << "Error: Missing argument to " << argv[i] << endl;
+        exit(1);
+      }
+      if (!strcmp(argv[i], "--server-port")) {
+        port = atoi(argv[i + 1]);
+      } else if (!strcmp(argv[i], "--server-socket")) {
+        socketPath = argv[i + 1];
+      } else if (!strcmp(argv[i], "--threads")) {
+        numThreads = atoi(argv[i + 1]);
+        if (numThreads < 1) {
+          cerr << "Error: --threads must be at least 1" << endl;
+          exit(1);
+        }
+      } else {
+        maxPending = atoi(argv[i + 1]);
+        if (maxPending < 1) {
+          cerr << "Error: --max-pending must be at least 1" << endl;
+          exit(1);
+        }
+      }
+      ++i;
+    } else {
+      mosesargv.push_back(argv[i]);
+    }
+  }
+  if (port < 0 && socketPath == NULL) {
+    port = 8081;
+  }
+
+  // a stale socket of an earlier run is replaced, anything else is left alone
+  struct stat socketStat;
+  if (socketPath && lstat(socketPath, &socketStat) == 0) {
+    if (!S_ISSOCK(socketStat.st_mode)) {
+      cerr << "Error: " << socketPath << " exists and is not a socket" << endl;
+      exit(1);
+    }
+    unlink(socketPath);
+  }
+
+  Parameter* params = new Parameter();
+  if (!params->LoadParam(mosesargv.size(), &mosesargv[0])) {
+    params->Explain();
+    exit(1);
+  }
+  if (!StaticData::LoadDataStatic(params, argv[0])) {
+    exit(1);
+  }
+
+  ThreadPool pool(numThreads, StaticData::Instance().GetThreadPriorityClasses());
+  boost::atomic<long> translationId(0);
+  asio::io_service io;
+
+  try {
+    boost::shared_ptr<Listener<asio::ip::tcp> > tcpListener;
+    if (port >= 0) {
+      tcpListener.reset(new Listener<asio::ip::tcp>(io, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port), pool, translationId, maxPending));
+      cerr << "Listening on port " << port << endl;
+    }
+    boost::shared_ptr<Listener<asio::local::stream_protocol> > localListener;
+    if (socketPath) {
+      localListener.reset(new Listener<asio::local::stream_protocol>(io, asio::local::stream_protocol::endpoint(socketPath), pool, translationId, maxPending));
+      cerr << "Listening on " << socketPath << endl;
+    }
+
+    // all network I/O happens here; decoding happens in the pool
+    io.run();
+  } catch (const boost::system::system_error &e) {
+    cerr << "Error: " << e.what() << endl;
+    exit(1);
+  }
+
+  pool.Stop(true);
+  return 0;
+}
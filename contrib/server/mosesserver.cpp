@@ -214,6 +214,15 @@ public:
 
   virtual bool DeleteAfterExecution() {return false;}
 
+  // shorter requests are picked up first, see -thread-priority-length
+  virtual size_t GetPriority() const {
+    const params_t params = m_paramList.getStruct(0);
+    params_t::const_iterator si = params.find("text");
+    if (si == params.end()) return 0;
+    const string source((xmlrpc_c::value_string(si->second)));
+    return StaticData::Instance().GetThreadPriority(Tokenize(source).size());
+  }
+
   bool IsDone() const {return m_done;}
 
   const map<string, xmlrpc_c::value>& GetRetData() { return m_retData;}
@@ -259,18 +268,46 @@ public:
         }
     }
 
+    const StaticData &staticData = StaticData::Instance();
+
+    // options of this request only, so that requests with different
+    // options can be decoded at the same time
+    boost::shared_ptr<DecodingOptions> options(new DecodingOptions(staticData.GetDecodingOptions()));
+
     si = params.find("model_name");
     if (si != params.end() && multiModelWeights.size() > 0) {
         const string model_name = xmlrpc_c::value_string(si->second);
-        PhraseDictionaryMultiModel* pdmm = (PhraseDictionaryMultiModel*) FindPhraseDictionary(model_name);
-        pdmm->SetTemporaryMultiModelWeightsVector(multiModelWeights);
+        options->multiModelWeights[model_name] = multiModelWeights;
     }
 
-    const StaticData &staticData = StaticData::Instance();
-
     //Make sure alternative paths are retained, if necessary
     if (addGraphInfo || nbest_size>0) {
-      (const_cast<StaticData&>(staticData)).SetOutputSearchGraph(true);
+      options->nBestEnabled = true;
+      options->outputSearchGraph = true;
+    }
+    if (nbest_size > 0) {
+      options->nBestSize = std::max(options->nBestSize, size_t(nbest_size));
+    }
+
+    si = params.find("stack");
+    if (si != params.end()) {
+      options->maxHypoStackSize = xmlrpc_c::value_int(si->second);
+    }
+    si = params.find("beam-threshold");
+    if (si != params.end()) {
+      options->beamWidth = TransformScore(xmlrpc_c::value_double(si->second));
+    }
+    si = params.find("cube-pruning-pop-limit");
+    if (si != params.end()) {
+      options->cubePruningPopLimit = xmlrpc_c::value_int(si->second);
+    }
+    si = params.find("time-out");
+    if (si != params.end()) {
+      options->timeoutThreshold = xmlrpc_c::value_int(si->second);
+    }
+    si = params.find("deadline");
+    if (si != params.end()) {
+      options->deadline = xmlrpc_c::value_double(si->second);
     }
 
 
@@ -282,6 +319,7 @@ public:
 	      inputFactorOrder = staticData.GetInputFactorOrder();
         stringstream in(source + "\n");
         tinput.Read(in,inputFactorOrder);
+        tinput.SetOptions(options);
         ChartManager manager(tinput);
         manager.Decode();
         const ChartHypothesis *hypo = manager.GetBestHypothesis();
@@ -301,6 +339,7 @@ public:
 	      inputFactorOrder = staticData.GetInputFactorOrder();
         stringstream in(source + "\n");
         sentence.Read(in,inputFactorOrder);
+        sentence.SetOptions(options);
         Manager manager(sentence, staticData.GetSearchAlgorithm());
 	      manager.Decode();
         const Hypothesis* hypo = manager.GetBestHypothesis();
@@ -335,7 +374,6 @@ public:
           outputNBest(manager, m_retData, nbest_size, nbest_distinct, 
 		      reportAllFactors, addAlignInfo, addScoreBreakdown);
         }
-        (const_cast<StaticData&>(staticData)).SetOutputSearchGraph(false);
 
     }
     pair<string, xmlrpc_c::value>
@@ -525,7 +563,7 @@ public:
           toptXml["start"] =  xmlrpc_c::value_int(startPos);
           toptXml["end"] =  xmlrpc_c::value_int(endPos);
           vector<xmlrpc_c::value> scoresXml;
-          const std::valarray<FValue> &scores = topt->GetScoreBreakdown().getCoreFeatures();
+          const FDenseVector &scores = topt->GetScoreBreakdown().getCoreFeatures();
           for (size_t j = 0; j < scores.size(); ++j) {
             scoresXml.push_back(xmlrpc_c::value_double(scores[j]));
           }
@@ -549,7 +587,8 @@ private:
 class Translator : public xmlrpc_c::method
 {
 public:
-  Translator(size_t numThreads = 10) : m_threadPool(numThreads) {
+  Translator(size_t numThreads = 10)
+    : m_threadPool(numThreads, StaticData::Instance().GetThreadPriorityClasses()) {
     // signature and help strings are documentation -- the client
     // can query this information with a system.methodSignature and
     // system.methodHelp RPC.
@@ -0,0 +1,169 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# Smoke test of moses-binary-server with a toy phrase table.
+#
+#   test-binaryserver.py path/to/moses-binary-server
+#
+# Checks option validation, that a file at --server-socket which is not a
+# socket survives, and that pipelined requests all get their translations
+# with a --max-pending smaller than the pipeline.
+
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from binaryclient import STATUS_OK, read_result, request_frame
+
+PHRASE_TABLE = """\
+das ||| the ||| 0.5 ||| 0-0 |||
+haus ||| house ||| 0.4 ||| 0-0 |||
+das haus ||| the house ||| 0.8 ||| 0-0 1-1 |||
+ist klein ||| is small ||| 0.6 ||| 0-0 1-1 |||
+"""
+
+INI = """\
+[input-factors]
+0
+
+[mapping]
+0 T 0
+
+[distortion-limit]
+6
+
+[feature]
+UnknownWordPenalty
+WordPenalty
+PhrasePenalty
+Distortion
+PhraseDictionaryMemory name=TranslationModel0 num-features=1 path=%s input-factor=0 output-factor=0
+
+[weight]
+UnknownWordPenalty0= 1
+WordPenalty0= -1
+PhrasePenalty0= 0.2
+Distortion0= 0.3
+TranslationModel0= 0.2
+"""
+
+SENTENCES = [b'das haus', b'das haus ist klein', b'haus', b'das auto']
+EXPECTED = [b'the house', b'the house is small', b'house', b'the auto']
+
+
+def fail(message):
+    sys.stderr.write("FAIL: %s\n" % message)
+    sys.exit(1)
+
+
+def run_server(server, args):
+    return subprocess.Popen([server] + args, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT)
+
+
+def expect_rejected(server, args, message):
+    proc = run_server(server, args)
+    output = proc.communicate()[0]
+    if proc.returncode == 0:
+        fail("%s: server accepted %s" % (message, ' '.join(args)))
+    return output
+
+
+def connect(path, proc, timeout=60):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        if proc.poll() is not None:
+            fail("server exited with %d:\n%s" % (proc.returncode, proc.stdout.read()))
+        if os.path.exists(path):
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            try:
+                sock.connect(path)
+                return sock
+            except socket.error:
+                sock.close()
+        time.sleep(0.1)
+    fail("server did not listen on %s" % path)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write("Usage: %s moses-binary-server\n" % sys.argv[0])
+        sys.exit(2)
+    server = sys.argv[1]
+
+    tmp = tempfile.mkdtemp()
+    try:
+        table = os.path.join(tmp, 'phrase-table')
+        with open(table, 'w') as f:
+            f.write(PHRASE_TABLE)
+        ini = os.path.join(tmp, 'moses.ini')
+        with open(ini, 'w') as f:
+            f.write(INI % table)
+        path = os.path.join(tmp, 'server.sock')
+
+        expect_rejected(server, ['-f', ini, '--server-socket', path, '--threads', '0'],
+                        "--threads 0")
+        expect_rejected(server, ['-f', ini, '--server-socket', path, '--max-pending', '0'],
+                        "--max-pending 0")
+
+        with open(path, 'w') as f:
+            f.write('not a socket\n')
+        expect_rejected(server, ['-f', ini, '--server-socket', path],
+                        "regular file at socket path")
+        with open(path) as f:
+            if f.read() != 'not a socket\n':
+                fail("regular file at the socket path was modified")
+        os.unlink(path)
+
+        proc = run_server(server, ['-f', ini, '--server-socket', path,
+                                   '--threads', '2', '--max-pending', '3'])
+        try:
+            sock = connect(path, proc)
+            # 10 requests sent before reading anything; the server stops
+            # reading after 3 pending sentences until results go out
+            requests = 10
+            for request_id in range(requests):
+                sock.sendall(request_frame(request_id, SENTENCES, 2, True, 0))
+            f = sock.makefile('rb')
+            seen = set()
+            for _ in range(requests * len(SENTENCES)):
+                request_id, index, status, translation, score, nbest = read_result(f)
+                if status != STATUS_OK:
+                    fail("request %d sentence %d: status %d" % (request_id, index, status))
+                if translation != EXPECTED[index]:
+                    fail("request %d sentence %d: got '%s', expected '%s'"
+                         % (request_id, index, translation, EXPECTED[index]))
+                if not nbest or nbest[0][0] != translation:
+                    fail("request %d sentence %d: n-best list does not start with the 1-best"
+                         % (request_id, index))
+                seen.add((request_id, index))
+            if len(seen) != requests * len(SENTENCES):
+                fail("duplicate results")
+            sock.close()
+        finally:
+            proc.kill()
+            proc.wait()
+
+        # the killed server left its socket behind, a restart replaces it
+        proc = run_server(server, ['-f', ini, '--server-socket', path])
+        try:
+            sock = connect(path, proc)
+            sock.sendall(request_frame(0, SENTENCES[:1], 0, False, 0))
+            if read_result(sock.makefile('rb'))[3] != EXPECTED[0]:
+                fail("restarted server returned a wrong translation")
+            sock.close()
+        finally:
+            proc.kill()
+            proc.wait()
+    finally:
+        shutil.rmtree(tmp)
+    print("moses-binary-server smoke test passed")
+
+
+if __name__ == '__main__':
+    main()
@@ -205,6 +205,70 @@ void Data::save(const std::string &featfile, const std::string &scorefile, bool
   m_score_data->save(scorefile, bin);
 }
 
+void Data::append(const std::string &featfile, const std::string &scorefile, bool allowDuplicates)
+{
+  if (!allowDuplicates && ifstream(featfile.c_str()) && ifstream(scorefile.c_str())) {
+    removeEntriesOf(featfile, scorefile);
+  }
+  m_feature_data->append(featfile);
+  m_score_data->append(scorefile);
+}
+
+void Data::removeEntriesOf(const std::string &featfile, const std::string &scorefile)
+{
+  Data other(m_scorer);
+  other.m_sparse_weights = m_sparse_weights;
+  other.load(featfile, scorefile);
+
+  size_t nRemoved = 0;
+  for (size_t s = 0; s < m_feature_data->size(); s++) {
+    FeatureArray& feat_array = m_feature_data->get(s);
+    ScoreArray& score_array = m_score_data->get(s);
+    if (!other.m_feature_data->exists(feat_array.getIndex())) {
+      continue;
+    }
+    const FeatureArray& other_feats = other.m_feature_data->get(other.m_feature_data->getIndex(feat_array.getIndex()));
+    const ScoreArray& other_scores = other.m_score_data->get(other.m_score_data->getIndex(feat_array.getIndex()));
+
+    // entries by the sum of their features, as in removeDuplicates()
+    map<double, vector<size_t> > lookup;
+    for (size_t j = 0; j < other_feats.size(); j++) {
+      const FeatureStats& feats = other_feats.get(j);
+      double sum = 0.0;
+      for (size_t l = 0; l < feats.size(); l++)
+        sum += feats.get(l);
+      lookup[sum].push_back(j);
+    }
+
+    // keep the entries that are not found, in order
+    size_t kept = 0;
+    for (size_t k = 0; k < feat_array.size(); k++) {
+      const FeatureStats& cur_feats = feat_array.get(k);
+      double sum = 0.0;
+      for (size_t l = 0; l < cur_feats.size(); l++)
+        sum += cur_feats.get(l);
+
+      bool found = false;
+      map<double, vector<size_t> >::const_iterator candidates = lookup.find(sum);
+      if (candidates != lookup.end()) {
+        for (size_t l = 0; l < candidates->second.size() && !found; l++) {
+          size_t j = candidates->second[l];
+          found = cur_feats == other_feats.get(j) && score_array.get(k) == other_scores.get(j);
+        }
+      }
+      if (!found) {
+        feat_array.swap(kept, k);
+        score_array.swap(kept, k);
+        kept++;
+      }
+    }
+    nRemoved += feat_array.size() - kept;
+    feat_array.resize(kept);
+    score_array.resize(kept);
+  }
+  TRACE_ERR("removed " << nRemoved << " entries already in " << featfile << endl);
+}
+
 void Data::InitFeatureMap(const string& str)
 {
   string buf = str;
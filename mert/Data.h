@@ -73,6 +73,18 @@ public:
 
   void save(const std::string &featfile, const std::string &scorefile, bool bin=false);
 
+  /**
+   * Append to memory mapped stats files, see MappedStatsFile.h. Unless
+   * allowDuplicates, entries which are already in the files are not
+   * appended again.
+   */
+  void append(const std::string &featfile, const std::string &scorefile, bool allowDuplicates=false);
+
+  /**
+   * Remove the entries which are also in the given stats files.
+   */
+  void removeEntriesOf(const std::string &featfile, const std::string &scorefile);
+
   //ADDED BY TS
   void removeDuplicates();
   //END_ADDED
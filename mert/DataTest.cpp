@@ -7,6 +7,9 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include <cstdio>
+#include <fstream>
+
 using namespace MosesTuning;
 
 //very basic test of sharding
@@ -75,3 +78,69 @@ BOOST_AUTO_TEST_CASE(add_features_test)
   BOOST_CHECK(IsAlmostEqual(-14.7486f, stats.get(7)));
   BOOST_CHECK(IsAlmostEqual(7.99917f,  stats.get(8)));
 }
+
+namespace
+{
+
+void WriteFile(const std::string& file, const std::string& text)
+{
+  std::ofstream out(file.c_str());
+  out << text;
+}
+
+// extractor --append of one n-best list
+void AppendNBest(Scorer* scorer, const std::string& nbest, const std::string& featfile, const std::string& scorefile)
+{
+  Data data(scorer);
+  data.loadNBest(nbest);
+  data.removeDuplicates();
+  data.append(featfile, scorefile);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(append_overlapping_nbest_test)
+{
+  const std::string ref = "data_test.ref", nbest1 = "data_test.nbest1", nbest2 = "data_test.nbest2";
+  const std::string featfile = "data_test.features", scorefile = "data_test.scores";
+  remove(featfile.c_str());
+  remove(scorefile.c_str());
+
+  WriteFile(ref, "the house is small\na car\n");
+  WriteFile(nbest1,
+            "0 ||| the house is small ||| d= 0 lm= -1 ||| -1\n"
+            "0 ||| the house is little ||| d= 0 lm= -2 ||| -2\n"
+            "1 ||| a car ||| d= -1 lm= -1 ||| -2\n");
+  // the second iteration finds the first and the third hypothesis again
+  WriteFile(nbest2,
+            "0 ||| the house is small ||| d= 0 lm= -1 ||| -1\n"
+            "0 ||| house is small ||| d= -1 lm= -1 ||| -2\n"
+            "1 ||| a car ||| d= -1 lm= -1 ||| -2\n"
+            "1 ||| the car ||| d= 0 lm= -3 ||| -3\n");
+
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  scorer->setReferenceFiles(std::vector<std::string>(1, ref));
+  AppendNBest(scorer.get(), nbest1, featfile, scorefile);
+  AppendNBest(scorer.get(), nbest2, featfile, scorefile);
+
+  Data data(scorer.get());
+  data.load(featfile, scorefile);
+  BOOST_REQUIRE_EQUAL((std::size_t)2, data.getFeatureData()->size());
+  BOOST_CHECK_EQUAL((std::size_t)3, data.getFeatureData()->get(data.getFeatureData()->getIndex(0)).size());
+  BOOST_CHECK_EQUAL((std::size_t)2, data.getFeatureData()->get(data.getFeatureData()->getIndex(1)).size());
+  BOOST_CHECK_EQUAL((std::size_t)3, data.getScoreData()->get(data.getScoreData()->getIndex(0)).size());
+  BOOST_CHECK_EQUAL((std::size_t)2, data.getScoreData()->get(data.getScoreData()->getIndex(1)).size());
+
+  // appending the same list again adds nothing
+  AppendNBest(scorer.get(), nbest2, featfile, scorefile);
+  Data again(scorer.get());
+  again.load(featfile, scorefile);
+  BOOST_CHECK_EQUAL((std::size_t)3, again.getFeatureData()->get(again.getFeatureData()->getIndex(0)).size());
+  BOOST_CHECK_EQUAL((std::size_t)2, again.getFeatureData()->get(again.getFeatureData()->getIndex(1)).size());
+
+  remove(ref.c_str());
+  remove(nbest1.c_str());
+  remove(nbest2.c_str());
+  remove(featfile.c_str());
+  remove(scorefile.c_str());
+}
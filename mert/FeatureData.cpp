@@ -10,7 +10,9 @@
 
 #include <limits>
 #include "FileStream.h"
+#include "MappedStatsFile.h"
 #include "Util.h"
+#include "util/exception.hh"
 
 using namespace std;
 
@@ -43,6 +45,22 @@ void FeatureData::save(bool bin)
   save(&cout, bin);
 }
 
+void FeatureData::append(const string &file)
+{
+  TRACE_ERR("appending the array to " << file << endl);
+  MappedStatsWriter writer(file, MappedStatsFile::FEATURES, m_num_features, m_features);
+  for (featdata_t::const_iterator i = m_array.begin(); i != m_array.end(); ++i) {
+    for (size_t j = 0; j < i->size(); ++j) {
+      const FeatureStats& entry = i->get(j);
+      UTIL_THROW_IF(entry.size() != m_num_features, util::Exception,
+                    "Entry " << j << " of sentence " << i->getIndex() << " has " << entry.size()
+                    << " features instead of " << m_num_features);
+      writer.Add(i->getIndex(), entry.getArray(), &entry.getSparse());
+    }
+  }
+  writer.Close();
+}
+
 void FeatureData::load(istream* is, const SparseVector& sparseWeights)
 {
   FeatureArray entry;
@@ -67,8 +85,55 @@ void FeatureData::load(istream* is, const SparseVector& sparseWeights)
 }
 
 
+void FeatureData::load(const MappedStatsFile& file, const SparseVector& sparseWeights)
+{
+  UTIL_THROW_IF(file.GetKind() != MappedStatsFile::FEATURES, util::Exception, "Expected a feature file");
+  if (size() == 0)
+    setFeatureMap(file.Description());
+
+  // A sentence occurs once in the file: add the new ones to the index at the end.
+  FeatureStats entry(file.NumberOfColumns());
+  SparseVector sparse;
+  for (size_t i = 0; i < file.size(); ++i) {
+    const int index = file.GetSentenceIndex(i);
+    size_t pos;
+    if (exists(index)) {
+      pos = getIndex(index);
+    } else {
+      pos = m_array.size();
+      m_array.push_back(FeatureArray());
+      m_array.back().setIndex(index);
+      m_array.back().NumberOfFeatures(file.NumberOfColumns());
+      m_array.back().Features(file.Description());
+    }
+
+    for (size_t j = 0; j < file.NumberOfEntries(i); ++j) {
+      if (sparseWeights.size()) {
+        // Merge the sparse features, as FeatureStats::set()
+        const float* dense = file.GetDense(i, j);
+        entry.reset();
+        for (size_t k = 0; k < file.NumberOfColumns(); ++k)
+          entry.add(dense[k]);
+        sparse.clear();
+        file.GetSparse(i, j, sparse);
+        entry.add(inner_product(sparseWeights, sparse));
+      } else {
+        file.GetFeatureStats(i, j, entry);
+      }
+      m_array[pos].add(entry);
+    }
+  }
+  setIndex();
+}
+
 void FeatureData::load(const string &file, const SparseVector& sparseWeights)
 {
+  if (MappedStatsFile::IsMapped(file)) {
+    TRACE_ERR("mapping feature data from " << file << endl);
+    load(MappedStatsFile(file), sparseWeights);
+    return;
+  }
+
   TRACE_ERR("loading feature data from " << file << endl);
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
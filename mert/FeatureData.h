@@ -18,6 +18,8 @@
 namespace MosesTuning
 {
 
+class MappedStatsFile;
+
 
 class FeatureData
 {
@@ -86,7 +88,14 @@ public:
   void save(std::ostream* os, bool bin=false);
   void save(bool bin=false);
 
+  /**
+   * Append the data as a new chunk of a memory mapped stats file,
+   * see MappedStatsFile.h.
+   */
+  void append(const std::string &file);
+
   void load(std::istream* is, const SparseVector& sparseWeights);
+  void load(const MappedStatsFile& file, const SparseVector& sparseWeights);
   void load(const std::string &file, const SparseVector& sparseWeights);
 
   bool check_consistency() const;
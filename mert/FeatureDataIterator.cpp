@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "FeatureArray.h"
 #include "FeatureDataIterator.h"
+#include "MappedStatsFile.h"
 
 
 using namespace std;
@@ -69,11 +70,15 @@ size_t hash_value(FeatureDataItem const& item)
 }
 
 
-FeatureDataIterator::FeatureDataIterator() {}
+FeatureDataIterator::FeatureDataIterator() : m_position(0) {}
 
-FeatureDataIterator::FeatureDataIterator(const string& filename)
+FeatureDataIterator::FeatureDataIterator(const string& filename) : m_position(0)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (MappedStatsFile::IsMapped(filename)) {
+    m_mapped.reset(new MappedStatsFile(filename));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -82,6 +87,21 @@ FeatureDataIterator::~FeatureDataIterator() {}
 void FeatureDataIterator::readNext()
 {
   m_next.clear();
+  if (m_mapped) {
+    if (m_position == m_mapped->size()) {
+      m_mapped.reset();
+      return;
+    }
+    const size_t length = m_mapped->NumberOfColumns();
+    for (size_t i = 0; i < m_mapped->NumberOfEntries(m_position); ++i) {
+      m_next.push_back(FeatureDataItem());
+      const float* dense = m_mapped->GetDense(m_position, i);
+      m_next.back().dense.assign(dense, dense + length);
+      m_mapped->GetSparse(m_position, i, m_next.back().sparse);
+    }
+    ++m_position;
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(FEATURES_TXT_BEGIN)) {
@@ -130,7 +150,9 @@ void FeatureDataIterator::increment()
 
 bool FeatureDataIterator::equal(const FeatureDataIterator& rhs) const
 {
-  if (!m_in && !rhs.m_in) {
+  if (m_mapped || rhs.m_mapped) {
+    return m_mapped == rhs.m_mapped && m_position == rhs.m_position;
+  } else if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
     return false;
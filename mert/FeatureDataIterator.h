@@ -45,6 +45,8 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class MappedStatsFile;
+
 
 class FileFormatException : public util::Exception
 {
@@ -97,6 +99,8 @@ private:
   void readNext();
 
   boost::shared_ptr<util::FilePiece> m_in;
+  boost::shared_ptr<MappedStatsFile> m_mapped;
+  std::size_t m_position; // of the next sentence in m_mapped
   std::vector<FeatureDataItem> m_next;
 };
 
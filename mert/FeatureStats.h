@@ -92,6 +92,9 @@ public:
   void expand();
   void add(FeatureStatsType v);
   void addSparse(const std::string& name, FeatureStatsType v);
+  void addSparse(std::size_t id, FeatureStatsType v) {
+    m_map.set(id, v);
+  }
 
   void clear() {
     memset((void*)m_array, 0, GetArraySizeWithBytes());
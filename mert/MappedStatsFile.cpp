@@ -0,0 +1,308 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "MappedStatsFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+
+using namespace std;
+
+namespace
+{
+
+const char kMagic[8] = {'M', 'E', 'R', 'T', 'S', 'T', 'A', 'T'};
+const uint32_t kVersion = 1;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+};
+
+struct ChunkHeader {
+  uint64_t size; // in bytes, with this header
+  uint64_t entries;
+  uint64_t columns;
+  uint64_t sparse; // number of sparse values
+  uint64_t names;
+  uint64_t names_bytes;
+  uint64_t description_bytes;
+};
+
+// every section starts on 8 bytes
+inline uint64_t Align(uint64_t bytes)
+{
+  return (bytes + 7) & ~static_cast<uint64_t>(7);
+}
+
+void WriteAligned(int fd, const void* data, uint64_t bytes)
+{
+  static const char padding[8] = {0};
+  util::WriteOrThrow(fd, data, bytes);
+  util::WriteOrThrow(fd, padding, Align(bytes) - bytes);
+}
+
+} // namespace
+
+namespace MosesTuning
+{
+
+
+MappedStatsFile::MappedStatsFile(const string& filename)
+  : m_kind(FEATURES), m_columns(0)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(filename.c_str()));
+  const uint64_t file_size = util::SizeOrThrow(fd.get());
+  UTIL_THROW_IF(file_size < sizeof(FileHeader), util::Exception, filename << " is too short for a stats file");
+  util::MapRead(util::LAZY, fd.get(), 0, file_size, m_memory);
+
+  const char* base = static_cast<const char*>(m_memory.get());
+  const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+  UTIL_THROW_IF(memcmp(header->magic, kMagic, sizeof(kMagic)) != 0, util::Exception, filename << " is not a stats file");
+  UTIL_THROW_IF(header->version != kVersion, util::Exception, filename << " has version " << header->version << " instead of " << kVersion);
+  m_kind = static_cast<Kind>(header->kind);
+
+  boost::unordered_map<int, size_t> positions; // sentence index to position in m_sentences
+  uint64_t offset = sizeof(FileHeader);
+  while (offset < file_size) {
+    UTIL_THROW_IF(file_size - offset < sizeof(ChunkHeader), util::Exception, "Truncated chunk at " << offset << " in " << filename);
+    const ChunkHeader* chunk_header = reinterpret_cast<const ChunkHeader*>(base + offset);
+    UTIL_THROW_IF(chunk_header->size > file_size - offset, util::Exception, "Truncated chunk at " << offset << " in " << filename);
+    if (m_chunks.empty()) {
+      m_columns = chunk_header->columns;
+    }
+    UTIL_THROW_IF(chunk_header->columns != m_columns, util::Exception,
+                  "Chunk at " << offset << " in " << filename << " has " << chunk_header->columns << " columns instead of " << m_columns);
+
+    const uint64_t entries = chunk_header->entries;
+    const char* p = base + offset + sizeof(ChunkHeader);
+    m_chunks.push_back(Chunk());
+    Chunk& chunk = m_chunks.back();
+    chunk.sentences = reinterpret_cast<const uint32_t*>(p);
+    p += Align(entries * sizeof(uint32_t));
+    chunk.dense = reinterpret_cast<const float*>(p);
+    p += Align(entries * m_columns * sizeof(float));
+    chunk.sparse_begin = reinterpret_cast<const uint64_t*>(p);
+    p += (entries + 1) * sizeof(uint64_t);
+    chunk.sparse_ids = reinterpret_cast<const uint32_t*>(p);
+    p += Align(chunk_header->sparse * sizeof(uint32_t));
+    chunk.sparse_values = reinterpret_cast<const float*>(p);
+    p += Align(chunk_header->sparse * sizeof(float));
+    const char* names = p;
+    p += Align(chunk_header->names_bytes);
+    if (m_chunks.size() == 1) {
+      m_description.assign(p, chunk_header->description_bytes);
+    }
+    p += Align(chunk_header->description_bytes);
+    UTIL_THROW_IF(static_cast<uint64_t>(p - (base + offset)) != chunk_header->size, util::Exception,
+                  "Inconsistent chunk size at " << offset << " in " << filename);
+
+    for (uint64_t i = 0; i < chunk_header->names; ++i) {
+      const size_t length = strlen(names);
+      chunk.sparse_names.push_back(SparseVector::encode(string(names, length)));
+      names += length + 1;
+    }
+
+    // consecutive entries of the same sentence form a range
+    for (uint64_t i = 0; i < entries; ++i) {
+      const int index = chunk.sentences[i];
+      if (i == 0 || chunk.sentences[i - 1] != chunk.sentences[i]) {
+        boost::unordered_map<int, size_t>::const_iterator found = positions.find(index);
+        size_t position = m_sentences.size();
+        if (found == positions.end()) {
+          positions[index] = position;
+          m_sentences.push_back(Sentence());
+          m_sentences.back().index = index;
+          m_sentences.back().entries = 0;
+        } else {
+          position = found->second;
+        }
+        Range range;
+        range.chunk = m_chunks.size() - 1;
+        range.begin = i;
+        range.end = i;
+        m_sentences[position].ranges.push_back(range);
+      }
+      Sentence& sentence = m_sentences[positions[index]];
+      ++sentence.ranges.back().end;
+      ++sentence.entries;
+    }
+
+    offset += chunk_header->size;
+  }
+
+  sort(m_sentences.begin(), m_sentences.end());
+}
+
+bool MappedStatsFile::IsMapped(const string& filename)
+{
+  ifstream in(filename.c_str(), ios::in | ios::binary);
+  char magic[sizeof(kMagic)];
+  if (!in.read(magic, sizeof(magic))) return false;
+  return memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+void MappedStatsFile::Locate(size_t i, size_t j, size_t& chunk, size_t& entry) const
+{
+  const vector<Range>& ranges = m_sentences.at(i).ranges;
+  for (vector<Range>::const_iterator r = ranges.begin(); r != ranges.end(); ++r) {
+    if (j < r->end - r->begin) {
+      chunk = r->chunk;
+      entry = r->begin + j;
+      return;
+    }
+    j -= r->end - r->begin;
+  }
+  UTIL_THROW(util::Exception, "Sentence " << m_sentences[i].index << " has only " << m_sentences[i].entries << " entries");
+}
+
+const float* MappedStatsFile::GetDense(size_t i, size_t j) const
+{
+  size_t chunk, entry;
+  Locate(i, j, chunk, entry);
+  return m_chunks[chunk].dense + entry * m_columns;
+}
+
+void MappedStatsFile::GetSparse(size_t i, size_t j, SparseVector& sparse) const
+{
+  size_t chunk, entry;
+  Locate(i, j, chunk, entry);
+  const Chunk& c = m_chunks[chunk];
+  for (uint64_t k = c.sparse_begin[entry]; k < c.sparse_begin[entry + 1]; ++k) {
+    sparse.set(c.sparse_names[c.sparse_ids[k]], c.sparse_values[k]);
+  }
+}
+
+void MappedStatsFile::GetFeatureStats(size_t i, size_t j, FeatureStats& stats) const
+{
+  size_t chunk, entry;
+  Locate(i, j, chunk, entry);
+  const Chunk& c = m_chunks[chunk];
+  stats.reset();
+  const float* dense = c.dense + entry * m_columns;
+  for (size_t k = 0; k < m_columns; ++k) {
+    stats.add(dense[k]);
+  }
+  for (uint64_t k = c.sparse_begin[entry]; k < c.sparse_begin[entry + 1]; ++k) {
+    stats.addSparse(c.sparse_names[c.sparse_ids[k]], c.sparse_values[k]);
+  }
+}
+
+
+MappedStatsWriter::MappedStatsWriter(const string& filename, MappedStatsFile::Kind kind,
+                                     size_t columns, const string& description)
+  : m_filename(filename), m_kind(kind), m_columns(columns), m_description(description)
+{
+  m_sparse_begin.push_back(0);
+}
+
+void MappedStatsWriter::Add(int sentence, const float* dense, const SparseVector* sparse)
+{
+  UTIL_THROW_IF(sentence < 0, util::Exception, "Negative sentence index " << sentence);
+  m_sentences.push_back(sentence);
+  m_dense.insert(m_dense.end(), dense, dense + m_columns);
+  if (sparse) {
+    const vector<size_t> ids = sparse->feats();
+    for (vector<size_t>::const_iterator id = ids.begin(); id != ids.end(); ++id) {
+      boost::unordered_map<size_t, uint32_t>::const_iterator found = m_sparse_ids_in_chunk.find(*id);
+      uint32_t chunk_id = m_sparse_names.size();
+      if (found == m_sparse_ids_in_chunk.end()) {
+        m_sparse_ids_in_chunk[*id] = chunk_id;
+        m_sparse_names.push_back(*id);
+      } else {
+        chunk_id = found->second;
+      }
+      m_sparse_ids.push_back(chunk_id);
+      m_sparse_values.push_back(sparse->get(*id));
+    }
+  }
+  m_sparse_begin.push_back(m_sparse_ids.size());
+}
+
+void MappedStatsWriter::Close()
+{
+  util::scoped_fd fd(open(m_filename.c_str(), O_RDWR | O_APPEND | O_CREAT, 0666));
+  UTIL_THROW_IF(fd.get() == -1, util::ErrnoException, "while opening " << m_filename);
+
+  if (util::SizeOrThrow(fd.get()) == 0) {
+    FileHeader header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.kind = m_kind;
+    util::WriteOrThrow(fd.get(), &header, sizeof(header));
+  } else {
+    FileHeader header;
+    util::ErsatzPRead(fd.get(), &header, sizeof(header), 0);
+    UTIL_THROW_IF(memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion,
+                  util::Exception, "Cannot append to " << m_filename << ": not a stats file of version " << kVersion);
+    UTIL_THROW_IF(header.kind != static_cast<uint32_t>(m_kind), util::Exception,
+                  "Cannot append to " << m_filename << ": it stores " << (header.kind == MappedStatsFile::FEATURES ? "features" : "scores"));
+    // nothing new, e.g. all entries were already in the file
+    if (m_sentences.empty()) return;
+  }
+
+  string names;
+  for (vector<size_t>::const_iterator id = m_sparse_names.begin(); id != m_sparse_names.end(); ++id) {
+    names += SparseVector::decode(*id);
+    names += '\0';
+  }
+
+  const uint64_t entries = m_sentences.size();
+  ChunkHeader chunk_header;
+  chunk_header.entries = entries;
+  chunk_header.columns = m_columns;
+  chunk_header.sparse = m_sparse_ids.size();
+  chunk_header.names = m_sparse_names.size();
+  chunk_header.names_bytes = names.size();
+  chunk_header.description_bytes = m_description.size();
+  chunk_header.size = sizeof(ChunkHeader)
+                      + Align(entries * sizeof(uint32_t))
+                      + Align(m_dense.size() * sizeof(float))
+                      + (entries + 1) * sizeof(uint64_t)
+                      + Align(m_sparse_ids.size() * sizeof(uint32_t))
+                      + Align(m_sparse_values.size() * sizeof(float))
+                      + Align(names.size())
+                      + Align(m_description.size());
+
+  util::WriteOrThrow(fd.get(), &chunk_header, sizeof(chunk_header));
+  WriteAligned(fd.get(), m_sentences.empty() ? NULL : &m_sentences[0], entries * sizeof(uint32_t));
+  WriteAligned(fd.get(), m_dense.empty() ? NULL : &m_dense[0], m_dense.size() * sizeof(float));
+  WriteAligned(fd.get(), &m_sparse_begin[0], m_sparse_begin.size() * sizeof(uint64_t));
+  WriteAligned(fd.get(), m_sparse_ids.empty() ? NULL : &m_sparse_ids[0], m_sparse_ids.size() * sizeof(uint32_t));
+  WriteAligned(fd.get(), m_sparse_values.empty() ? NULL : &m_sparse_values[0], m_sparse_values.size() * sizeof(float));
+  WriteAligned(fd.get(), names.data(), names.size());
+  WriteAligned(fd.get(), m_description.data(), m_description.size());
+
+  m_sentences.clear();
+  m_dense.clear();
+  m_sparse_begin.assign(1, 0);
+  m_sparse_ids.clear();
+  m_sparse_values.clear();
+  m_sparse_names.clear();
+  m_sparse_ids_in_chunk.clear();
+}
+
+}
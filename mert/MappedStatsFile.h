@@ -0,0 +1,185 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef MERT_MAPPED_STATS_FILE_H_
+#define MERT_MAPPED_STATS_FILE_H_
+
+/**
+ * Binary feature and score data files, which are memory mapped instead of
+ * parsed, and which grow by appending the statistics of each tuning
+ * iteration instead of being rewritten.
+ *
+ * A file is a header followed by chunks, one per append. A chunk stores its
+ * n-best entries in columns: the sentence of each entry, the dense values as
+ * a row-major matrix, and the sparse features in compressed sparse row form
+ * (offsets, ids and values), with the names of the sparse features used in
+ * the chunk. Score files use the same layout, without sparse values.
+ */
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
+#include "util/mmap.hh"
+
+#include "FeatureStats.h"
+
+namespace MosesTuning
+{
+
+
+class MappedStatsFile
+{
+public:
+  enum Kind {
+    FEATURES = 0,
+    SCORES = 1
+  };
+
+  explicit MappedStatsFile(const std::string& filename);
+
+  /**
+   * Whether the file exists and is in this format, as opposed to the text
+   * and binary formats of FeatureData and ScoreData.
+   */
+  static bool IsMapped(const std::string& filename);
+
+  Kind GetKind() const {
+    return m_kind;
+  }
+
+  /**
+   * Number of dense values of each entry.
+   */
+  std::size_t NumberOfColumns() const {
+    return m_columns;
+  }
+
+  /**
+   * Feature names or score type, as in the header of the text format.
+   */
+  const std::string& Description() const {
+    return m_description;
+  }
+
+  /**
+   * Number of sentences, over all the chunks.
+   */
+  std::size_t size() const {
+    return m_sentences.size();
+  }
+
+  /**
+   * Sentences are in increasing order of their index.
+   */
+  int GetSentenceIndex(std::size_t i) const {
+    return m_sentences[i].index;
+  }
+
+  /**
+   * Number of entries of the i-th sentence, over all the chunks.
+   */
+  std::size_t NumberOfEntries(std::size_t i) const {
+    return m_sentences[i].entries;
+  }
+
+  /**
+   * Dense values of the j-th entry of the i-th sentence.
+   */
+  const float* GetDense(std::size_t i, std::size_t j) const;
+
+  /**
+   * Add the sparse features of the j-th entry of the i-th sentence.
+   */
+  void GetSparse(std::size_t i, std::size_t j, SparseVector& sparse) const;
+
+  void GetFeatureStats(std::size_t i, std::size_t j, FeatureStats& stats) const;
+
+private:
+  struct Chunk {
+    const uint32_t* sentences;
+    const float* dense;
+    const uint64_t* sparse_begin;
+    const uint32_t* sparse_ids;
+    const float* sparse_values;
+    std::vector<std::size_t> sparse_names; // chunk id to SparseVector id
+  };
+
+  // entries [begin, end) of a chunk
+  struct Range {
+    std::size_t chunk;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  struct Sentence {
+    int index;
+    std::size_t entries;
+    std::vector<Range> ranges;
+
+    bool operator<(const Sentence& other) const {
+      return index < other.index;
+    }
+  };
+
+  void Locate(std::size_t i, std::size_t j, std::size_t& chunk, std::size_t& entry) const;
+
+  util::scoped_memory m_memory;
+  Kind m_kind;
+  std::size_t m_columns;
+  std::string m_description;
+  std::vector<Chunk> m_chunks;
+  std::vector<Sentence> m_sentences;
+};
+
+/**
+ * Append a chunk to a file, which is created if it does not exist.
+ * The chunk is written by Close().
+ */
+class MappedStatsWriter
+{
+public:
+  MappedStatsWriter(const std::string& filename, MappedStatsFile::Kind kind,
+                    std::size_t columns, const std::string& description);
+
+  void Add(int sentence, const float* dense, const SparseVector* sparse = NULL);
+
+  void Close();
+
+private:
+  std::string m_filename;
+  MappedStatsFile::Kind m_kind;
+  std::size_t m_columns;
+  std::string m_description;
+
+  std::vector<uint32_t> m_sentences;
+  std::vector<float> m_dense;
+  std::vector<uint64_t> m_sparse_begin;
+  std::vector<uint32_t> m_sparse_ids;
+  std::vector<float> m_sparse_values;
+  std::vector<std::size_t> m_sparse_names; // chunk id to SparseVector id
+  boost::unordered_map<std::size_t, uint32_t> m_sparse_ids_in_chunk; // SparseVector id to chunk id
+};
+
+}
+
+#endif  // MERT_MAPPED_STATS_FILE_H_
@@ -0,0 +1,153 @@
+#include "MappedStatsFile.h"
+#include "FeatureData.h"
+#include "FeatureDataIterator.h"
+#include "ScoreDataIterator.h"
+
+#define BOOST_TEST_MODULE MertMappedStatsFile
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <string>
+
+using namespace MosesTuning;
+
+namespace
+{
+
+const char kFeatureFile[] = "mapped_stats_file_test.features";
+const char kScoreFile[] = "mapped_stats_file_test.scores";
+const char kCopyFile[] = "mapped_stats_file_test.copy";
+
+// sentence 1 and 0, then 0 and 2 in a second chunk
+void WriteFeatures()
+{
+  remove(kFeatureFile);
+  const float dense[][2] = {{1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}};
+
+  MappedStatsWriter first(kFeatureFile, MappedStatsFile::FEATURES, 2, "d_0 lm_0");
+  first.Add(1, dense[0]);
+  SparseVector sparse;
+  sparse.set("sparse_a", 0.5);
+  first.Add(1, dense[1], &sparse);
+  first.Add(0, dense[2]);
+  first.Close();
+
+  MappedStatsWriter second(kFeatureFile, MappedStatsFile::FEATURES, 2, "d_0 lm_0");
+  sparse.clear();
+  sparse.set("sparse_b", -1);
+  second.Add(0, dense[3], &sparse);
+  second.Add(2, dense[4]);
+  second.Close();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(mapped_stats_file_read)
+{
+  WriteFeatures();
+  BOOST_CHECK(MappedStatsFile::IsMapped(kFeatureFile));
+
+  MappedStatsFile file(kFeatureFile);
+  BOOST_CHECK_EQUAL(MappedStatsFile::FEATURES, file.GetKind());
+  BOOST_CHECK_EQUAL(2, file.NumberOfColumns());
+  BOOST_CHECK_EQUAL("d_0 lm_0", file.Description());
+  BOOST_REQUIRE_EQUAL(3, file.size());
+
+  BOOST_CHECK_EQUAL(0, file.GetSentenceIndex(0));
+  BOOST_CHECK_EQUAL(1, file.GetSentenceIndex(1));
+  BOOST_CHECK_EQUAL(2, file.GetSentenceIndex(2));
+  BOOST_CHECK_EQUAL(2, file.NumberOfEntries(0));
+  BOOST_CHECK_EQUAL(2, file.NumberOfEntries(1));
+  BOOST_CHECK_EQUAL(1, file.NumberOfEntries(2));
+
+  // entries of a sentence follow the order of the chunks
+  BOOST_CHECK_EQUAL(5, file.GetDense(0, 0)[0]);
+  BOOST_CHECK_EQUAL(8, file.GetDense(0, 1)[1]);
+  BOOST_CHECK_EQUAL(4, file.GetDense(1, 1)[1]);
+  BOOST_CHECK_EQUAL(9, file.GetDense(2, 0)[0]);
+
+  SparseVector sparse;
+  file.GetSparse(0, 0, sparse);
+  BOOST_CHECK_EQUAL(0, sparse.size());
+  file.GetSparse(0, 1, sparse);
+  BOOST_CHECK_EQUAL(1, sparse.size());
+  BOOST_CHECK_EQUAL(-1, sparse.get("sparse_b"));
+
+  FeatureStats stats;
+  file.GetFeatureStats(1, 1, stats);
+  BOOST_CHECK_EQUAL(2, stats.size());
+  BOOST_CHECK_EQUAL(3, stats.get(0));
+  BOOST_CHECK_EQUAL(0.5, stats.getSparse().get("sparse_a"));
+
+  remove(kFeatureFile);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_stats_file_append_mismatch)
+{
+  WriteFeatures();
+  const float dense[] = {1, 2, 3};
+
+  MappedStatsWriter scores(kFeatureFile, MappedStatsFile::SCORES, 2, "BLEU");
+  scores.Add(0, dense);
+  BOOST_CHECK_THROW(scores.Close(), util::Exception);
+
+  MappedStatsWriter wider(kFeatureFile, MappedStatsFile::FEATURES, 3, "d_0 d_1 lm_0");
+  wider.Add(0, dense);
+  wider.Close();
+  BOOST_CHECK_THROW(MappedStatsFile file(kFeatureFile), util::Exception);
+
+  remove(kFeatureFile);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_stats_file_feature_data)
+{
+  WriteFeatures();
+
+  FeatureData data;
+  data.load(kFeatureFile, SparseVector());
+  BOOST_CHECK_EQUAL(2, data.NumberOfFeatures());
+  BOOST_REQUIRE_EQUAL(3, data.size());
+  BOOST_CHECK(data.exists(2));
+  BOOST_CHECK_EQUAL(2, data.get(data.getIndex(0)).size());
+  BOOST_CHECK_EQUAL(7, data.get(data.getIndex(0), 1).get(0));
+
+  // and back
+  remove(kCopyFile);
+  data.append(kCopyFile);
+  MappedStatsFile file(kCopyFile);
+  BOOST_CHECK_EQUAL(3, file.size());
+  BOOST_CHECK_EQUAL(10, file.GetDense(2, 0)[1]);
+  SparseVector sparse;
+  file.GetSparse(1, 1, sparse);
+  BOOST_CHECK_EQUAL(0.5, sparse.get("sparse_a"));
+
+  remove(kFeatureFile);
+  remove(kCopyFile);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_stats_file_iterators)
+{
+  WriteFeatures();
+  remove(kScoreFile);
+  const float scores[] = {1, 2, 3};
+  MappedStatsWriter writer(kScoreFile, MappedStatsFile::SCORES, 3, "BLEU");
+  writer.Add(3, scores);
+  writer.Add(3, scores);
+  writer.Close();
+
+  size_t sentences = 0;
+  for (FeatureDataIterator i(kFeatureFile); i != FeatureDataIterator::end(); ++i, ++sentences) {
+    BOOST_CHECK_EQUAL(2, i->front().dense.size());
+  }
+  BOOST_CHECK_EQUAL(3, sentences);
+
+  ScoreDataIterator i(kScoreFile);
+  BOOST_REQUIRE(i != ScoreDataIterator::end());
+  BOOST_CHECK_EQUAL(2, i->size());
+  BOOST_CHECK_EQUAL(3, i->back()[2]);
+  ++i;
+  BOOST_CHECK(i == ScoreDataIterator::end());
+
+  remove(kFeatureFile);
+  remove(kScoreFile);
+}
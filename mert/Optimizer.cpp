@@ -12,6 +12,11 @@
 #include "Point.h"
 #include "Util.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#include "moses/ThreadPool.h"
+#endif
+
 using namespace std;
 
 static const float MIN_FLOAT = -1.0 * numeric_limits<float>::max();
@@ -39,7 +44,7 @@ namespace MosesTuning
 
 
 Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool>& pos, const vector<parameter_t>& start, unsigned int nrandom)
-  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_positive(pos)
+  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_num_threads(1), m_positive(pos)
 {
   // Warning: the init vector is a full set of parameters, of dimension m_pdim!
   Point::m_pdim = Pd;
@@ -63,6 +68,16 @@ Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool
 
 Optimizer::~Optimizer() {}
 
+void Optimizer::SetNumThreads(unsigned int num_threads)
+{
+#ifdef WITH_THREADS
+  if (num_threads != m_num_threads || (num_threads > 1 && !m_pool)) {
+    m_pool.reset(num_threads > 1 ? new Moses::ThreadPool(num_threads - 1) : NULL);
+  }
+#endif
+  m_num_threads = num_threads;
+}
+
 statscore_t Optimizer::GetStatScore(const Point& param) const
 {
   vector<unsigned> bests;
@@ -90,6 +105,161 @@ map<float,diff_t >::iterator AddThreshold(map<float,diff_t >& thresholdmap, floa
   return it;
 }
 
+namespace
+{
+
+/**
+ * The upper envelope of the n-best list of a sentence along a line:
+ * the 1best for x=-inf, followed by the points where the 1best changes,
+ * from left to right, with the new 1best.
+ */
+struct Envelope {
+  unsigned first1best;
+  vector<pair<float,unsigned> > intersections;
+};
+
+void ComputeEnvelope(const FeatureArray& nbest, const Point& origin, const Point& direction, Envelope& envelope)
+{
+  // First, we determine the translation with the best feature score
+  // for each value of x.
+  multimap<float, unsigned> gradient;
+  vector<float> f0;
+  f0.resize(nbest.size());
+  for (unsigned j = 0; j < nbest.size(); j++) {
+    // gradient of the feature function for this particular target sentence
+    gradient.insert(pair<float, unsigned>(direction * (nbest.get(j)), j));
+    // compute the feature function at the origin point
+    f0[j] = origin * nbest.get(j);
+  }
+  // Now let's compute the 1best for each value of x.
+
+  multimap<float,unsigned>::iterator gradientit = gradient.begin();
+  multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
+
+  float smallest = gradientit->first;//smallest gradient
+  // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
+
+  gradientit++;
+  while (gradientit != gradient.end() && gradientit->first == smallest) {
+    if (f0[gradientit->second] > f0[highest_f0->second])
+      highest_f0 = gradientit;//the highest line is the one with he highest f0
+    gradientit++;
+  }
+
+  gradientit = highest_f0;
+  envelope.first1best = highest_f0->second;
+  envelope.intersections.clear();
+
+  // Now we look for the intersections points indicating a change of 1 best.
+  // We use the fact that the function is convex, which means that the gradient can only go up.
+  while (gradientit != gradient.end()) {
+    map<float,unsigned>::iterator leftmost = gradientit;
+    float m = gradientit->first;
+    float b = f0[gradientit->second];
+    multimap<float,unsigned>::iterator gradientit2 = gradientit;
+    gradientit2++;
+    float leftmostx = MAX_FLOAT;
+    for (; gradientit2 != gradient.end(); gradientit2++) {
+      // Look for all candidate with a gradient bigger than the current one, and
+      // find the one with the leftmost intersection.
+      float curintersect;
+      if (m != gradientit2->first) {
+        curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
+        if (curintersect<=leftmostx) {
+          // We have found an intersection to the left of the leftmost we had so far.
+          // We might have curintersect==leftmostx for example is 2 candidates are the same
+          // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
+          leftmostx = curintersect;
+          leftmost = gradientit2; // this is the new reference
+        }
+      }
+    }
+    if (leftmost == gradientit) {
+      // We didn't find any more intersections.
+      // The rightmost bestindex is the one with the highest slope.
+
+      // They should be equal but there might be.
+      UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
+                    util::Exception, "Error");
+      // A small difference due to rounding error
+      break;
+    }
+    // We have found the next intersection!
+    envelope.intersections.push_back(pair<float,unsigned>(leftmostx, leftmost->second));
+    gradientit = leftmost;
+  }
+}
+
+/**
+ * Compute the envelopes of the sentences [begin, end).
+ */
+void ComputeEnvelopes(const FeatureData& feature_data, const Point& origin, const Point& direction,
+                      size_t begin, size_t end, vector<Envelope>& envelopes)
+{
+  for (size_t S = begin; S < end; S++) {
+    UTIL_THROW_IF(feature_data.get(S).size() == 0, util::Exception,
+                  "Sentence " << S << " has an empty n-best list");
+    ComputeEnvelope(feature_data.get(S), origin, direction, envelopes[S]);
+  }
+}
+
+#ifdef WITH_THREADS
+/**
+ * Computes the envelopes of one range of sentences for LineOptimize, on a
+ * thread of the optimizer's pool or on the caller's. An exception is kept
+ * in the batch, for the caller to rethrow.
+ */
+class EnvelopeTask : public Moses::Task
+{
+public:
+  struct Batch {
+    explicit Batch(size_t pending) : pending(pending), failed(false) {}
+    boost::mutex mutex;
+    boost::condition_variable done;
+    size_t pending;
+    bool failed;
+    util::Exception error; // the first one thrown
+  };
+
+  EnvelopeTask(const FeatureData& feature_data, const Point& origin, const Point& direction,
+               size_t begin, size_t end, vector<Envelope>& envelopes, Batch& batch)
+    : m_feature_data(feature_data), m_origin(origin), m_direction(direction),
+      m_begin(begin), m_end(end), m_envelopes(envelopes), m_batch(batch) {}
+
+  void Run() {
+    bool failed = true;
+    util::Exception error;
+    try {
+      ComputeEnvelopes(m_feature_data, m_origin, m_direction, m_begin, m_end, m_envelopes);
+      failed = false;
+    } catch (const util::Exception& e) {
+      error = e;
+    } catch (const std::exception& e) {
+      error << e.what();
+    }
+
+    boost::mutex::scoped_lock lock(m_batch.mutex);
+    if (failed && !m_batch.failed) {
+      m_batch.failed = true;
+      m_batch.error = error;
+    }
+    if (--m_batch.pending == 0) {
+      m_batch.done.notify_all();
+    }
+  }
+
+private:
+  const FeatureData& m_feature_data;
+  const Point& m_origin;
+  const Point& m_direction;
+  size_t m_begin, m_end;
+  vector<Envelope>& m_envelopes;
+  Batch& m_batch;
+};
+#endif
+
+} // namespace
+
 statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
 {
   // We are looking for the best Point on the line y=Origin+x*direction
@@ -97,85 +267,48 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
   //typedef pair<unsigned,unsigned> diff;//first the sentence that changes, second is the new 1best for this sentence
   //list<threshold> thresholdlist;
 
+  // The envelopes of the sentences are independent, and computing them is
+  // the expensive part: split the sentences in contiguous ranges, one per thread.
+  // Several line searches may share the pool, so each waits for its own batch
+  vector<Envelope> envelopes(size());
+#ifdef WITH_THREADS
+  const size_t num_threads = min<size_t>(m_num_threads, size());
+  if (num_threads > 1 && m_pool) {
+    EnvelopeTask::Batch batch(num_threads);
+    for (size_t t = 1; t < num_threads; t++) {
+      m_pool->Submit(new EnvelopeTask(*m_feature_data, origin, direction,
+                                      size() * t / num_threads, size() * (t + 1) / num_threads,
+                                      envelopes, batch));
+    }
+    EnvelopeTask(*m_feature_data, origin, direction, 0, size() / num_threads, envelopes, batch).Run();
+
+    boost::mutex::scoped_lock lock(batch.mutex);
+    while (batch.pending > 0) {
+      batch.done.wait(lock);
+    }
+    if (batch.failed) {
+      throw batch.error;
+    }
+  } else
+#endif
+    ComputeEnvelopes(*m_feature_data, origin, direction, 0, size(), envelopes);
+
+  // Merge the intersections into the thresholds, sentence by sentence: close
+  // thresholds are fused with the previous one of the same sentence, so the
+  // result depends on the order of insertion and must not depend on the number
+  // of threads.
   map<float,diff_t> thresholdmap;
   thresholdmap[MIN_FLOAT] = diff_t();
   vector<unsigned> first1best;       // the vector of nbests for x=-inf
+  first1best.reserve(size());
   for (unsigned int S = 0; S < size(); S++) {
     map<float,diff_t >::iterator previnserted = thresholdmap.begin();
-    // First, we determine the translation with the best feature score
-    // for each sentence and each value of x.
-    //cerr << "Sentence " << S << endl;
-    multimap<float, unsigned> gradient;
-    vector<float> f0;
-    f0.resize(m_feature_data->get(S).size());
-    for (unsigned j = 0; j < m_feature_data->get(S).size(); j++) {
-      // gradient of the feature function for this particular target sentence
-      gradient.insert(pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j));
-      // compute the feature function at the origin point
-      f0[j] = origin * m_feature_data->get(S, j);
-    }
-    // Now let's compute the 1best for each value of x.
-
-    //    vector<pair<float,unsigned> > onebest;
-
+    first1best.push_back(envelopes[S].first1best);
 
-    multimap<float,unsigned>::iterator gradientit = gradient.begin();
-    multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
-
-    float smallest = gradientit->first;//smallest gradient
-    // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
-
-    gradientit++;
-    while (gradientit != gradient.end() && gradientit->first == smallest) {
-      //   cerr<<"ni"<<gradientit->second<<endl;;
-      //cerr<<"fos"<<f0[gradientit->second]<<" "<<f0[index]<<" "<<index<<endl;
-      if (f0[gradientit->second] > f0[highest_f0->second])
-        highest_f0 = gradientit;//the highest line is the one with he highest f0
-      gradientit++;
-    }
-
-    gradientit = highest_f0;
-    first1best.push_back(highest_f0->second);
-
-    // Now we look for the intersections points indicating a change of 1 best.
-    // We use the fact that the function is convex, which means that the gradient can only go up.
-    while (gradientit != gradient.end()) {
-      map<float,unsigned>::iterator leftmost = gradientit;
-      float m = gradientit->first;
-      float b = f0[gradientit->second];
-      multimap<float,unsigned>::iterator gradientit2 = gradientit;
-      gradientit2++;
-      float leftmostx = MAX_FLOAT;
-      for (; gradientit2 != gradient.end(); gradientit2++) {
-        //cerr<<"--"<<d++<<' '<<gradientit2->first<<' '<<gradientit2->second<<endl;
-        // Look for all candidate with a gradient bigger than the current one, and
-        // find the one with the leftmost intersection.
-        float curintersect;
-        if (m != gradientit2->first) {
-          curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
-          //cerr << "curintersect: " << curintersect << " leftmostx: " << leftmostx << endl;
-          if (curintersect<=leftmostx) {
-            // We have found an intersection to the left of the leftmost we had so far.
-            // We might have curintersect==leftmostx for example is 2 candidates are the same
-            // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
-            leftmostx = curintersect;
-            leftmost = gradientit2; // this is the new reference
-          }
-        }
-      }
-      if (leftmost == gradientit) {
-        // We didn't find any more intersections.
-        // The rightmost bestindex is the one with the highest slope.
-
-        // They should be equal but there might be.
-        UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
-                      util::Exception, "Error");
-        // A small difference due to rounding error
-        break;
-      }
-      // We have found the next intersection!
-
-      pair<unsigned,unsigned> newd(S, leftmost->second);//new onebest for Sentence S is leftmost->second
+    const vector<pair<float,unsigned> >& intersections = envelopes[S].intersections;
+    for (size_t i = 0; i < intersections.size(); i++) {
+      float leftmostx = intersections[i].first;
+      pair<unsigned,unsigned> newd(S, intersections[i].second);//new onebest for Sentence S
 
       if (leftmostx-previnserted->first < min_int) {
         // Require that the intersection Point be at least min_int to the right of the previous
@@ -221,8 +354,7 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
       } else { //normal insertion process
         previnserted = AddThreshold(thresholdmap, leftmostx, newd);
       }
-      gradientit = leftmost;
-    } // while (gradientit!=gradient.end()){
+    }
   }   // loop on S
 
   // Now the thresholdlist is up to date: it contains a list of all the parameter_ts where
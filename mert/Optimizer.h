@@ -8,6 +8,15 @@
 #include "Scorer.h"
 #include "Types.h"
 
+#ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
+
+namespace Moses
+{
+class ThreadPool;
+}
+#endif
+
 static const float kMaxFloat = std::numeric_limits<float>::max();
 
 namespace MosesTuning
@@ -25,6 +34,10 @@ protected:
   Scorer *m_scorer;      // no accessor for them only child can use them
   FeatureDataHandle m_feature_data;  // no accessor for them only child can use them
   unsigned int m_num_random_directions;
+  unsigned int m_num_threads;  // threads computing the envelopes in LineOptimize
+#ifdef WITH_THREADS
+  boost::scoped_ptr<Moses::ThreadPool> m_pool;  // all but one of them, the caller is the last
+#endif
 
   const std::vector<bool>& m_positive;
 
@@ -37,6 +50,7 @@ public:
   void SetFeatureData(FeatureDataHandle feature_data) {
     m_feature_data = feature_data;
   }
+  void SetNumThreads(unsigned int num_threads);
   virtual ~Optimizer();
 
   unsigned size() const {
@@ -0,0 +1,128 @@
+#include "Optimizer.h"
+#include "OptimizerFactory.h"
+#include "FeatureData.h"
+#include "Point.h"
+#include "ScoreData.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+#include "util/exception.hh"
+
+#define BOOST_TEST_MODULE MertOptimizer
+#include <boost/test/unit_test.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cstdlib>
+
+using namespace MosesTuning;
+
+namespace
+{
+
+const unsigned int kNumFeatures = 4;
+
+// random n-best lists with BLEU statistics; integer feature values make
+// candidates with the same slope and close thresholds likely.
+void MakeData(Scorer* scorer, size_t num_sentences, size_t nbest_size,
+              FeatureDataHandle features, ScoreDataHandle scores)
+{
+  features->NumberOfFeatures(kNumFeatures);
+  for (size_t i = 0; i < num_sentences; ++i) {
+    for (size_t j = 0; j < nbest_size; ++j) {
+      FeatureStats feature_entry;
+      for (unsigned int k = 0; k < kNumFeatures; ++k)
+        feature_entry.add(static_cast<FeatureStatsType>(random() % 20) - 10);
+      features->add(feature_entry, i);
+
+      ScoreStats score_entry;
+      for (size_t n = 0; n < 4; ++n) {
+        const int total = 10 - n;
+        score_entry.add(random() % (total + 1));
+        score_entry.add(total);
+      }
+      score_entry.add(12);
+      scores->add(score_entry, i);
+    }
+  }
+  scorer->setScoreData(scores.get());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(line_optimize_threads)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  FeatureDataHandle features(new FeatureData);
+  ScoreDataHandle scores(new ScoreData(scorer.get()));
+  srandom(1);
+  MakeData(scorer.get(), 50, 30, features, scores);
+
+  std::vector<unsigned> to_optimize;
+  for (unsigned int k = 0; k < kNumFeatures; ++k)
+    to_optimize.push_back(k);
+  std::vector<bool> positive(kNumFeatures, false);
+  std::vector<parameter_t> start(kNumFeatures, 0.0), min(kNumFeatures, -1.0), max(kNumFeatures, 1.0);
+
+  boost::scoped_ptr<Optimizer> optimizer(OptimizerFactory::BuildOptimizer(kNumFeatures, to_optimize, positive, start, "powell", 0));
+  optimizer->SetScorer(scorer.get());
+  optimizer->SetFeatureData(features);
+
+  for (size_t d = 0; d < 20; ++d) {
+    Point origin(start, min, max), direction(start, min, max);
+    origin.Randomize();
+    direction.Randomize();
+
+    Point expected;
+    optimizer->SetNumThreads(1);
+    const statscore_t expected_score = optimizer->LineOptimize(origin, direction, expected);
+    BOOST_CHECK_EQUAL(expected_score, optimizer->GetStatScore(expected));
+
+    // the thresholds do not depend on how the sentences are split between threads
+    for (unsigned int num_threads = 2; num_threads <= 7; num_threads += 5) {
+      Point best;
+      optimizer->SetNumThreads(num_threads);
+      BOOST_CHECK_EQUAL(expected_score, optimizer->LineOptimize(origin, direction, best));
+      BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), best.begin(), best.end());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(line_optimize_threads_rethrow)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  FeatureDataHandle features(new FeatureData);
+  ScoreDataHandle scores(new ScoreData(scorer.get()));
+  srandom(1);
+  MakeData(scorer.get(), 50, 30, features, scores);
+
+  // the last sentence, whose envelope is computed on a thread of the pool
+  FeatureArray empty;
+  empty.setIndex(50);
+  features->add(empty);
+
+  std::vector<unsigned> to_optimize;
+  for (unsigned int k = 0; k < kNumFeatures; ++k)
+    to_optimize.push_back(k);
+  std::vector<bool> positive(kNumFeatures, false);
+  std::vector<parameter_t> start(kNumFeatures, 0.0), min(kNumFeatures, -1.0), max(kNumFeatures, 1.0);
+
+  boost::scoped_ptr<Optimizer> optimizer(OptimizerFactory::BuildOptimizer(kNumFeatures, to_optimize, positive, start, "powell", 0));
+  optimizer->SetScorer(scorer.get());
+  optimizer->SetFeatureData(features);
+
+  Point origin(start, min, max), direction(start, min, max), best;
+  origin.Randomize();
+  direction.Randomize();
+  for (unsigned int num_threads = 1; num_threads <= 3; num_threads += 2) {
+    optimizer->SetNumThreads(num_threads);
+    BOOST_CHECK_THROW(optimizer->LineOptimize(origin, direction, best), util::Exception);
+  }
+
+  // the pool is still usable afterwards
+  features.reset(new FeatureData);
+  scores.reset(new ScoreData(scorer.get()));
+  MakeData(scorer.get(), 50, 30, features, scores);
+  optimizer->SetFeatureData(features);
+  const statscore_t threaded_score = optimizer->LineOptimize(origin, direction, best);
+  optimizer->SetNumThreads(1);
+  BOOST_CHECK_EQUAL(threaded_score, optimizer->LineOptimize(origin, direction, best));
+}
@@ -13,6 +13,8 @@
 #include "Scorer.h"
 #include "Util.h"
 #include "FileStream.h"
+#include "MappedStatsFile.h"
+#include "util/exception.hh"
 
 using namespace std;
 
@@ -55,6 +57,22 @@ void ScoreData::save(bool bin)
   save(&cout, bin);
 }
 
+void ScoreData::append(const string &file)
+{
+  TRACE_ERR("appending the array to " << file << endl);
+  MappedStatsWriter writer(file, MappedStatsFile::SCORES, m_num_scores, m_score_type);
+  for (scoredata_t::const_iterator i = m_array.begin(); i != m_array.end(); ++i) {
+    for (size_t j = 0; j < i->size(); ++j) {
+      const ScoreStats& entry = i->get(j);
+      UTIL_THROW_IF(entry.size() != m_num_scores, util::Exception,
+                    "Entry " << j << " of sentence " << i->getIndex() << " has " << entry.size()
+                    << " scores instead of " << m_num_scores);
+      writer.Add(i->getIndex(), entry.getArray());
+    }
+  }
+  writer.Close();
+}
+
 void ScoreData::load(istream* is)
 {
   ScoreArray entry;
@@ -72,8 +90,45 @@ void ScoreData::load(istream* is)
   }
 }
 
+void ScoreData::load(const MappedStatsFile& file)
+{
+  UTIL_THROW_IF(file.GetKind() != MappedStatsFile::SCORES, util::Exception, "Expected a score file");
+  string score_type = file.Description();
+
+  // A sentence occurs once in the file: add the new ones to the index at the end.
+  ScoreStats entry(file.NumberOfColumns());
+  for (size_t i = 0; i < file.size(); ++i) {
+    const int index = file.GetSentenceIndex(i);
+    size_t pos;
+    if (exists(index)) {
+      pos = getIndex(index);
+    } else {
+      pos = m_array.size();
+      m_array.push_back(ScoreArray());
+      m_array.back().setIndex(index);
+      m_array.back().NumberOfScores(file.NumberOfColumns());
+      m_array.back().name(score_type);
+    }
+
+    for (size_t j = 0; j < file.NumberOfEntries(i); ++j) {
+      const float* scores = file.GetDense(i, j);
+      entry.reset();
+      for (size_t k = 0; k < file.NumberOfColumns(); ++k)
+        entry.add(scores[k]);
+      m_array[pos].add(entry);
+    }
+  }
+  setIndex();
+}
+
 void ScoreData::load(const string &file)
 {
+  if (MappedStatsFile::IsMapped(file)) {
+    TRACE_ERR("mapping score data from " << file << endl);
+    load(MappedStatsFile(file));
+    return;
+  }
+
   TRACE_ERR("loading score data from " << file << endl);
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
@@ -22,6 +22,7 @@ namespace MosesTuning
 
 
 class Scorer;
+class MappedStatsFile;
 
 class ScoreData
 {
@@ -91,7 +92,14 @@ public:
   void save(std::ostream* os, bool bin=false);
   void save(bool bin=false);
 
+  /**
+   * Append the data as a new chunk of a memory mapped stats file,
+   * see MappedStatsFile.h.
+   */
+  void append(const std::string &file);
+
   void load(std::istream* is);
+  void load(const MappedStatsFile& file);
   void load(const std::string &file);
 
   bool check_consistency() const;
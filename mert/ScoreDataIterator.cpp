@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
+#include "MappedStatsFile.h"
 #include "ScoreArray.h"
 #include "ScoreDataIterator.h"
 
@@ -31,11 +32,15 @@ namespace MosesTuning
 {
 
 
-ScoreDataIterator::ScoreDataIterator() {}
+ScoreDataIterator::ScoreDataIterator() : m_position(0) {}
 
-ScoreDataIterator::ScoreDataIterator(const string& filename)
+ScoreDataIterator::ScoreDataIterator(const string& filename) : m_position(0)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (MappedStatsFile::IsMapped(filename)) {
+    m_mapped.reset(new MappedStatsFile(filename));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -44,6 +49,19 @@ ScoreDataIterator::~ScoreDataIterator() {}
 void ScoreDataIterator::readNext()
 {
   m_next.clear();
+  if (m_mapped) {
+    if (m_position == m_mapped->size()) {
+      m_mapped.reset();
+      return;
+    }
+    const size_t length = m_mapped->NumberOfColumns();
+    for (size_t i = 0; i < m_mapped->NumberOfEntries(m_position); ++i) {
+      const float* scores = m_mapped->GetDense(m_position, i);
+      m_next.push_back(ScoreDataItem(scores, scores + length));
+    }
+    ++m_position;
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(SCORES_TXT_BEGIN)) {
@@ -81,7 +99,9 @@ void ScoreDataIterator::increment()
 
 bool ScoreDataIterator::equal(const ScoreDataIterator& rhs) const
 {
-  if (!m_in && !rhs.m_in) {
+  if (m_mapped || rhs.m_mapped) {
+    return m_mapped == rhs.m_mapped && m_position == rhs.m_position;
+  } else if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
     return false;
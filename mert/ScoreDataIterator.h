@@ -41,6 +41,8 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class MappedStatsFile;
+
 
 typedef std::vector<float> ScoreDataItem;
 
@@ -69,6 +71,8 @@ private:
   void readNext();
 
   boost::shared_ptr<util::FilePiece> m_in;
+  boost::shared_ptr<MappedStatsFile> m_mapped;
+  std::size_t m_position; // of the next sentence in m_mapped
   std::vector<ScoreDataItem> m_next;
 };
 
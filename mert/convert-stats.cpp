@@ -0,0 +1,162 @@
+/**
+ * \description Converts feature and score data files between the text, binary
+ * and memory mapped formats, and compares the time to load them.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+#include <boost/scoped_ptr.hpp>
+
+#include "Data.h"
+#include "FeatureData.h"
+#include "ScoreData.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+#include "Timer.h"
+#include "Util.h"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+void usage(int ret)
+{
+  cerr << "usage: convert-stats --ffile <features> --scfile <scores> --out-ffile <features> --out-scfile <scores> [options]" << endl;
+  cerr << "Merges the input feature and score data files, in any format, and writes them" << endl;
+  cerr << "in the memory mapped format of extractor --append (default), text or binary format." << endl;
+  cerr << "[--ffile|-F] comma separated list of feature data files" << endl;
+  cerr << "[--scfile|-S] comma separated list of scorer data files" << endl;
+  cerr << "[--out-ffile|-f] the feature data output file, replaced if it exists" << endl;
+  cerr << "[--out-scfile|-s] the scorer data output file, replaced if it exists" << endl;
+  cerr << "[--text|-t] write the text format" << endl;
+  cerr << "[--binary|-b] write the binary format" << endl;
+  cerr << "[--sctype] the scorer type (default BLEU)" << endl;
+  cerr << "[--scconfig|-c] configuration string passed to scorer" << endl;
+  cerr << "[--help|-h] print this message and exit" << endl;
+  exit(ret);
+}
+
+static struct option long_options[] = {
+  {"ffile", required_argument, 0, 'F'},
+  {"scfile", required_argument, 0, 'S'},
+  {"out-ffile", required_argument, 0, 'f'},
+  {"out-scfile", required_argument, 0, 's'},
+  {"text", no_argument, 0, 't'},
+  {"binary", no_argument, 0, 'b'},
+  {"sctype", required_argument, 0, 'y'},
+  {"scconfig", required_argument, 0, 'c'},
+  {"help", no_argument, 0, 'h'},
+  {0, 0, 0, 0}
+};
+
+// Load the files into data, and return the wall time it took.
+double Load(const vector<string>& feature_files, const vector<string>& score_files, Data& data)
+{
+  Timer timer;
+  timer.start();
+  for (size_t i = 0; i < feature_files.size(); ++i)
+    data.load(feature_files[i], score_files[i]);
+  return timer.get_elapsed_wall_time();
+}
+
+size_t NumberOfEntries(Data& data)
+{
+  size_t entries = 0;
+  for (size_t i = 0; i < data.getFeatureData()->size(); ++i)
+    entries += data.getFeatureData()->get(i).size();
+  return entries;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  string feature_file, score_file, out_feature_file, out_score_file;
+  string scorer_type = "BLEU";
+  string scorer_config = "";
+  bool text = false, binary = false;
+
+  int c;
+  int option_index;
+  while ((c = getopt_long(argc, argv, "F:S:f:s:c:tbh", long_options, &option_index)) != -1) {
+    switch (c) {
+    case 'F':
+      feature_file = string(optarg);
+      break;
+    case 'S':
+      score_file = string(optarg);
+      break;
+    case 'f':
+      out_feature_file = string(optarg);
+      break;
+    case 's':
+      out_score_file = string(optarg);
+      break;
+    case 't':
+      text = true;
+      break;
+    case 'b':
+      binary = true;
+      break;
+    case 'y':
+      scorer_type = string(optarg);
+      break;
+    case 'c':
+      scorer_config = string(optarg);
+      break;
+    case 'h':
+      usage(0);
+      break;
+    default:
+      usage(1);
+    }
+  }
+  if (feature_file.empty() || score_file.empty() || out_feature_file.empty() || out_score_file.empty() || (text && binary))
+    usage(1);
+
+  vector<string> feature_files, score_files;
+  Tokenize(feature_file.c_str(), ',', &feature_files);
+  Tokenize(score_file.c_str(), ',', &score_files);
+  if (feature_files.size() != score_files.size()) {
+    cerr << "Error: there is a different number of score and feature files" << endl;
+    return 1;
+  }
+
+  try {
+    boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer(scorer_type, scorer_config));
+    Data data(scorer.get());
+    const double input_time = Load(feature_files, score_files, data);
+
+    if (text || binary) {
+      data.save(out_feature_file, out_score_file, binary);
+    } else {
+      // appending to an existing file would keep its data
+      remove(out_feature_file.c_str());
+      remove(out_score_file.c_str());
+      data.append(out_feature_file, out_score_file);
+    }
+
+    Data converted(scorer.get());
+    const double output_time = Load(vector<string>(1, out_feature_file), vector<string>(1, out_score_file), converted);
+    if (NumberOfEntries(converted) != NumberOfEntries(data)) {
+      cerr << "Error: " << NumberOfEntries(converted) << " entries in the output instead of " << NumberOfEntries(data) << endl;
+      return 1;
+    }
+
+    cout << data.getFeatureData()->size() << " sentences, " << NumberOfEntries(data) << " entries" << endl;
+    cout << "input loaded in " << input_time << " seconds" << endl;
+    cout << "output loaded in " << output_time << " seconds" << endl;
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
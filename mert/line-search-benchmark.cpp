@@ -0,0 +1,223 @@
+/**
+ * \description Times Optimizer::LineOptimize on the envelopes of a feature/score data set,
+ * scaled up by copying its sentences and n-best entries with perturbed feature values,
+ * for several numbers of threads, and checks that every run finds the same points.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+#include <boost/scoped_ptr.hpp>
+
+#include "Data.h"
+#include "FeatureData.h"
+#include "Optimizer.h"
+#include "OptimizerFactory.h"
+#include "Point.h"
+#include "ScoreData.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+#include "Timer.h"
+#include "Util.h"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+void usage(int ret)
+{
+  cerr << "usage: line-search-benchmark --scfile <scores> --ffile <features> [options]" << endl;
+  cerr << "[--sctype|-s] the scorer type (default BLEU)" << endl;
+  cerr << "[--scconfig|-c] configuration string passed to scorer" << endl;
+  cerr << "[--sentence-copies] copies of each sentence (default 1)" << endl;
+  cerr << "[--nbest-copies] copies of each n-best entry, as in an n-best list accumulated over iterations (default 1)" << endl;
+  cerr << "[--directions] number of random lines to optimize (default 20)" << endl;
+  cerr << "[--threads|-T] comma separated numbers of threads to time (default 1)" << endl;
+  cerr << "[--rseed|-r] the random seed (default 1234)" << endl;
+  cerr << "[--help|-h] print this message and exit" << endl;
+  exit(ret);
+}
+
+static struct option long_options[] = {
+  {"sctype", required_argument, 0, 's'},
+  {"scconfig", required_argument, 0, 'c'},
+  {"scfile", required_argument, 0, 'S'},
+  {"ffile", required_argument, 0, 'F'},
+  {"sentence-copies", required_argument, 0, 'a'},
+  {"nbest-copies", required_argument, 0, 'b'},
+  {"directions", required_argument, 0, 'd'},
+  {"threads", required_argument, 0, 'T'},
+  {"rseed", required_argument, 0, 'r'},
+  {"help", no_argument, 0, 'h'},
+  {0, 0, 0, 0}
+};
+
+// a feature value multiplied by a random factor in [0.95,1.05]
+FeatureStatsType Perturb(FeatureStatsType value)
+{
+  return value * (0.95 + 0.1 * static_cast<float>(random()) / static_cast<float>(RAND_MAX));
+}
+
+/**
+ * Copy the data sentence_copies times with new sentence indexes, and each
+ * n-best entry nbest_copies times. All copies but the first have perturbed
+ * feature values, so that their envelopes differ, and the score statistics of
+ * the entry they were copied from.
+ */
+void ScaleUp(const FeatureData& features, const ScoreData& scores,
+             size_t sentence_copies, size_t nbest_copies,
+             FeatureData& scaled_features, ScoreData& scaled_scores)
+{
+  scaled_features.NumberOfFeatures(features.NumberOfFeatures());
+  scaled_features.Features(features.Features());
+  for (size_t c = 0; c < sentence_copies; ++c) {
+    for (size_t i = 0; i < features.size(); ++i) {
+      const FeatureArray& nbest = features.get(i);
+      const int index = c * features.size() + nbest.getIndex();
+      for (size_t n = 0; n < nbest_copies; ++n) {
+        for (size_t j = 0; j < nbest.size(); ++j) {
+          FeatureStats entry;
+          for (size_t k = 0; k < nbest.get(j).size(); ++k) {
+            FeatureStatsType value = nbest.get(j).get(k);
+            entry.add(c == 0 && n == 0 ? value : Perturb(value));
+          }
+          scaled_features.add(entry, index);
+          scaled_scores.add(scores.get(i, j), index);
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  string scorer_type = "BLEU";
+  string scorer_config = "";
+  string scorer_file = "";
+  string feature_file = "";
+  size_t sentence_copies = 1;
+  size_t nbest_copies = 1;
+  size_t num_directions = 20;
+  string threads_str = "1";
+  unsigned int seed = 1234;
+
+  int c;
+  int option_index;
+  while ((c = getopt_long(argc, argv, "s:c:S:F:T:r:h", long_options, &option_index)) != -1) {
+    switch (c) {
+    case 's':
+      scorer_type = string(optarg);
+      break;
+    case 'c':
+      scorer_config = string(optarg);
+      break;
+    case 'S':
+      scorer_file = string(optarg);
+      break;
+    case 'F':
+      feature_file = string(optarg);
+      break;
+    case 'a':
+      sentence_copies = strtol(optarg, NULL, 10);
+      break;
+    case 'b':
+      nbest_copies = strtol(optarg, NULL, 10);
+      break;
+    case 'd':
+      num_directions = strtol(optarg, NULL, 10);
+      break;
+    case 'T':
+      threads_str = string(optarg);
+      break;
+    case 'r':
+      seed = strtol(optarg, NULL, 10);
+      break;
+    case 'h':
+      usage(0);
+      break;
+    default:
+      usage(1);
+    }
+  }
+  if (scorer_file.empty() || feature_file.empty() || sentence_copies < 1 || nbest_copies < 1)
+    usage(1);
+
+  vector<string> threads_list;
+  Tokenize(threads_str.c_str(), ',', &threads_list);
+
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer(scorer_type, scorer_config));
+  Data data(scorer.get());
+  data.load(feature_file, scorer_file);
+  data.removeDuplicates();
+
+  FeatureDataHandle features(new FeatureData);
+  ScoreDataHandle scores(new ScoreData(scorer.get()));
+  ScaleUp(*data.getFeatureData(), *data.getScoreData(), sentence_copies, nbest_copies, *features, *scores);
+  scorer->setScoreData(scores.get());
+
+  size_t num_entries = 0;
+  for (size_t i = 0; i < features->size(); ++i)
+    num_entries += features->get(i).size();
+  cerr << features->size() << " sentences, " << num_entries << " n-best entries, "
+       << features->NumberOfFeatures() << " features" << endl;
+
+  // optimize all the features, from random points along random directions
+  const unsigned int pdim = features->NumberOfFeatures();
+  vector<unsigned> to_optimize(pdim);
+  for (unsigned int i = 0; i < pdim; ++i)
+    to_optimize[i] = i;
+  vector<bool> positive(pdim, false);
+  vector<parameter_t> start(pdim, 0.0), min(pdim, -1.0), max(pdim, 1.0);
+
+  boost::scoped_ptr<Optimizer> optimizer(OptimizerFactory::BuildOptimizer(pdim, to_optimize, positive, start, "powell", 0));
+  optimizer->SetScorer(scorer.get());
+  optimizer->SetFeatureData(features);
+
+  srandom(seed);
+  vector<Point> origins, directions;
+  for (size_t d = 0; d < num_directions; ++d) {
+    origins.push_back(Point(start, min, max));
+    origins.back().Randomize();
+    directions.push_back(Point(start, min, max));
+    directions.back().Randomize();
+  }
+
+  vector<Point> expected;
+  for (size_t t = 0; t < threads_list.size(); ++t) {
+    const unsigned int num_threads = atoi(threads_list[t].c_str());
+    optimizer->SetNumThreads(num_threads);
+
+    Timer timer;
+    timer.start();
+    vector<Point> best(num_directions);
+    for (size_t d = 0; d < num_directions; ++d)
+      optimizer->LineOptimize(origins[d], directions[d], best[d]);
+    const double seconds = timer.get_elapsed_wall_time();
+
+    bool identical = true;
+    if (expected.empty()) {
+      expected = best;
+    } else {
+      for (size_t d = 0; d < num_directions; ++d) {
+        identical = identical && best[d].GetScore() == expected[d].GetScore();
+        for (size_t k = 0; k < best[d].size(); ++k)
+          identical = identical && best[d][k] == expected[d][k];
+      }
+    }
+
+    cout << num_threads << " threads: " << num_directions << " line searches in "
+         << seconds << " seconds, " << num_directions / seconds << " line searches/second"
+         << (identical ? "" : ", DIFFERENT best points") << endl;
+    if (!identical)
+      return 1;
+  }
+
+  return 0;
+}
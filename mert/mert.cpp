@@ -117,6 +117,7 @@ void usage(int ret)
   cerr<<"[--sparse-weights|-p] required for merging sparse features"<<endl;
 #ifdef WITH_THREADS
   cerr<<"[--threads|-T] use multiple threads (default 1)"<<endl;
+  cerr<<"[--line-threads|-L] threads computing the envelopes of each line search (default 1)"<<endl;
 #endif
   cerr<<"[--shard-count] Split data into shards, optimize for each shard and average"<<endl;
   cerr<<"[--shard-size] Shard size as proportion of data. If 0, use non-overlapping shards"<<endl;
@@ -140,6 +141,7 @@ static struct option long_options[] = {
   {"sparse-weights",required_argument,0,'p'},
 #ifdef WITH_THREADS
   {"threads", required_argument,0,'T'},
+  {"line-threads", required_argument,0,'L'},
 #endif
   {"shard-count", required_argument, 0, 'a'},
   {"shard-size", required_argument, 0, 'b'},
@@ -164,6 +166,7 @@ struct ProgramOption {
   string positive_string;
   string sparse_weights_file;
   size_t num_threads;
+  size_t num_line_threads;
   float shard_size;
   size_t shard_count;
 
@@ -183,6 +186,7 @@ struct ProgramOption {
       positive_string(kDefaultPositiveString),
       sparse_weights_file(kDefaultSparseWeightsFile),
       num_threads(1),
+      num_line_threads(1),
       shard_size(0),
       shard_count(0) { }
 };
@@ -192,7 +196,7 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
   int c;
   int option_index;
 
-  while ((c = getopt_long(argc, argv, "o:r:d:n:m:t:s:S:F:v:p:P:", long_options, &option_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "o:r:d:n:m:t:s:S:F:v:p:P:T:L:", long_options, &option_index)) != -1) {
     switch (c) {
     case 'o':
       opt->to_optimize_str = string(optarg);
@@ -239,6 +243,10 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
       opt->num_threads = strtol(optarg, NULL, 10);
       if (opt->num_threads < 1) opt->num_threads = 1;
       break;
+    case 'L':
+      opt->num_line_threads = strtol(optarg, NULL, 10);
+      if (opt->num_line_threads < 1) opt->num_line_threads = 1;
+      break;
 #endif
     case 'a':
       opt->shard_count = strtof(optarg, NULL);
@@ -470,6 +478,7 @@ int main(int argc, char **argv)
     Optimizer *optimizer = OptimizerFactory::BuildOptimizer(option.pdim, to_optimize, positive, start_list[0], option.optimize_type, option.nrandom);
     optimizer->SetScorer(data_ref.getScorer());
     optimizer->SetFeatureData(data_ref.getFeatureData());
+    optimizer->SetNumThreads(option.num_line_threads);
     // A task for each start point
     for (size_t j = 0; j < startingPoints.size(); ++j) {
       OptimizationTask* task = new OptimizationTask(optimizer, startingPoints[j]);
@@ -0,0 +1,68 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+#include "moses/FactorCollection.h"
+#include "moses/Util.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+void LookUp(const vector<string> &words, size_t lookups, size_t offset)
+{
+  FactorCollection &factors = FactorCollection::Instance();
+  for (size_t i = 0; i < lookups; ++i) {
+    factors.AddFactor(words[(offset + i * 7919) % words.size()]);
+  }
+}
+
+}
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "benchmarkFactorCollection [threads1,threads2,...] [vocabulary] [lookups]\n"
+            "\n"
+            "Adds a vocabulary of words (default 100000) to the FactorCollection,\n"
+            "then looks them up again with AddFactor, lookups times in total\n"
+            "(default 8000000) split over each number of threads (default\n"
+            "1,2,4,8,16,32,64), and reports million lookups/second.\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 4) {
+    printHelp();
+    return EXIT_FAILURE;
+  }
+  vector<size_t> threadCounts = Tokenize<size_t>(argc > 1 ? argv[1] : "1,2,4,8,16,32,64", ",");
+  size_t vocabulary = argc > 2 ? Scan<size_t>(argv[2]) : 100000;
+  size_t lookups = argc > 3 ? Scan<size_t>(argv[3]) : 8000000;
+
+  vector<string> words;
+  for (size_t i = 0; i < vocabulary; ++i) {
+    words.push_back("word" + SPrint(i));
+    FactorCollection::Instance().AddFactor(words.back());
+  }
+
+  for (size_t t = 0; t < threadCounts.size(); ++t) {
+    size_t threads = threadCounts[t];
+    double start = util::WallTime();
+    boost::thread_group group;
+    for (size_t i = 0; i < threads; ++i) {
+      group.create_thread(boost::bind(&LookUp, boost::cref(words), lookups / threads, i));
+    }
+    group.join_all();
+    double seconds = util::WallTime() - start;
+    cout << threads << " threads: " << lookups / seconds / 1e6 << " M lookups/second" << endl;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "moses/Util.h"
+#include "moses/TranslationModel/fuzzy-match/FuzzyMatchWrapper.h"
+#include "moses/TranslationModel/fuzzy-match/SentenceAlignment.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace tmmt;
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "benchmarkFuzzyMatch source target alignment input [threads1,threads2,...]\n"
+            "\n"
+            "Finds the best translation memory match of each input sentence,\n"
+            "with the brute force method and with the n-gram filtered one for each\n"
+            "number of threads (default 1), and reports matches/second and the\n"
+            "recall of the filtered method relative to the brute force one.\n"
+            "source, target and alignment are the translation memory files of\n"
+            "PhraseDictionaryFuzzyMatch.\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 5 && argc != 6) {
+    printHelp();
+    return EXIT_FAILURE;
+  }
+
+  std::vector<size_t> threadCounts(1, 1);
+  if (argc == 6) {
+    threadCounts = Moses::Tokenize<size_t>(argv[5], ",");
+  }
+
+  FuzzyMatchWrapper wrapper(argv[1], argv[2], argv[3]);
+
+  std::vector< std::vector< WORD_ID > > input;
+  wrapper.load_corpus(argv[4], input);
+  if (input.empty()) {
+    return EXIT_SUCCESS;
+  }
+
+  std::vector< FuzzyMatchResult > expected;
+  double start = util::WallTime();
+  wrapper.basic_fuzzy_match(input, expected);
+  double seconds = util::WallTime() - start;
+  cout << "brute force: " << input.size() << " sentences in " << seconds << " seconds, "
+       << input.size() / seconds << " matches/second" << endl;
+
+  size_t found = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (expected[i].sentence != -1) {
+      ++found;
+    }
+  }
+
+  for (size_t t = 0; t < threadCounts.size(); ++t) {
+    size_t numThreads = threadCounts[t];
+    std::vector< FuzzyMatchResult > results;
+    start = util::WallTime();
+    wrapper.batch_fuzzy_match(input, results, numThreads);
+    seconds = util::WallTime() - start;
+
+    // a match is recalled if it is as close as the brute force one
+    size_t recalled = 0, identical = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (expected[i].sentence == -1) {
+        continue;
+      }
+      if (results[i].sentence != -1 && results[i].cost == expected[i].cost) {
+        ++recalled;
+      }
+      if (results[i].sentence == expected[i].sentence) {
+        ++identical;
+      }
+    }
+
+    cout << "n-gram filtered, " << numThreads << " threads: " << input.size() << " sentences in "
+         << seconds << " seconds, " << input.size() / seconds << " matches/second, recall "
+         << (found ? (double) recalled / found : 1.0) << " (" << recalled << "/" << found
+         << ", " << identical << " same sentence)" << endl;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "moses/Parameter.h"
+#include "moses/StaticData.h"
+#include "moses/Util.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+//! hierarchical rules with 4 scores, about 1000 target phrases per source side
+void WriteRuleTable(const string &path, size_t numRules)
+{
+  ofstream out(path.c_str());
+  for (size_t i = 0; i < numRules; ++i) {
+    size_t a = i / 1000000, b = (i / 1000) % 1000, c = i % 1000;
+    out << "s" << a << " [X][X] s" << b << " [X] ||| t" << c << " [X][X] t" << b << " [X] ||| "
+        << (c + 1) / 1001.0 << " 0.2 " << (b + 1) / 1001.0 << " 0.4 ||| 1-1\n";
+  }
+}
+
+}
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "benchmarkRuleTableLoad load-threads [rules] [rule-table]\n"
+            "\n"
+            "Loads a text rule table into PhraseDictionaryMemory with the given\n"
+            "-load-threads and reports the seconds taken and rules/second. Without\n"
+            "a rule table, a synthetic table of that many hierarchical rules (default\n"
+            "10000000) is written to a temporary file first. Run it once per number\n"
+            "of threads, as the models are loaded into the StaticData singleton.\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2 || argc > 4) {
+    printHelp();
+    return EXIT_FAILURE;
+  }
+
+  const string loadThreads = argv[1];
+  size_t numRules = argc > 2 ? Scan<size_t>(argv[2]) : 10000000;
+  string ruleTable = argc > 3 ? argv[3] : "";
+  const bool synthetic = ruleTable.empty();
+  if (synthetic) {
+    ruleTable = "benchmarkRuleTableLoad.rule-table";
+    double start = util::WallTime();
+    WriteRuleTable(ruleTable, numRules);
+    cerr << "wrote " << numRules << " rules in " << util::WallTime() - start << " seconds" << endl;
+  }
+
+  const string ini = "benchmarkRuleTableLoad.ini";
+  {
+    ofstream out(ini.c_str());
+    out << "[input-factors]\n0\n"
+        << "[mapping]\n0 T 0\n"
+        << "[search-algorithm]\n3\n"
+        << "[feature]\n"
+        << "UnknownWordPenalty\n"
+        << "WordPenalty\n"
+        << "PhraseDictionaryMemory name=TranslationModel0 num-features=4 input-factor=0 output-factor=0 path=" << ruleTable << "\n"
+        << "[weight]\n"
+        << "UnknownWordPenalty0= 1\n"
+        << "WordPenalty0= -1\n"
+        << "TranslationModel0= 0.2 0.2 0.2 0.2\n";
+  }
+
+  vector<char*> args;
+  args.push_back(argv[0]);
+  args.push_back(const_cast<char*>("-f"));
+  args.push_back(const_cast<char*>(ini.c_str()));
+  args.push_back(const_cast<char*>("-load-threads"));
+  args.push_back(const_cast<char*>(loadThreads.c_str()));
+  args.push_back(const_cast<char*>("-v"));
+  args.push_back(const_cast<char*>("0"));
+
+  Parameter parameter;
+  if (!parameter.LoadParam(args.size(), &args[0])) {
+    return EXIT_FAILURE;
+  }
+  double start = util::WallTime();
+  if (!StaticData::LoadDataStatic(&parameter, argv[0])) {
+    return EXIT_FAILURE;
+  }
+  double seconds = util::WallTime() - start;
+  cout << "load-threads " << loadThreads << ": " << seconds << " seconds, "
+       << (synthetic ? numRules / seconds : 0) << " rules/second" << endl;
+
+  remove(ini.c_str());
+  if (synthetic) {
+    remove(ruleTable.c_str());
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "moses/Hypothesis.h"
+#include "moses/Manager.h"
+#include "moses/Parameter.h"
+#include "moses/Sentence.h"
+#include "moses/StaticData.h"
+#include "moses/Util.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+const size_t kSourceWords = 300, kTranslations = 10, kSentenceLength = 25;
+
+//! deterministic, so that runs with different options decode the same input
+size_t Random(size_t n)
+{
+  static unsigned long state = 1;
+  state = state * 1103515245 + 12345;
+  return (state / 65536) % n;
+}
+
+//! source word that often follows source word a, with a phrase pair for the two
+size_t Follower(size_t a)
+{
+  return (a * 7 + 1) % kSourceWords;
+}
+
+void WriteModel(const string &phraseTable, const string &lm)
+{
+  ofstream pt(phraseTable.c_str());
+  for (size_t a = 0; a < kSourceWords; ++a) {
+    for (size_t k = 0; k < kTranslations; ++k) {
+      pt << "s" << a << " ||| t" << a * kTranslations + k << " ||| "
+         << 0.05 + 0.9 * Random(1000) / 1000.0 << " 0.5 " << 0.05 + 0.9 * Random(1000) / 1000.0 << " 0.5 ||| 0-0\n";
+    }
+    size_t b = Follower(a);
+    for (size_t k = 0; k < kTranslations / 2; ++k) {
+      pt << "s" << a << " s" << b << " ||| t" << b * kTranslations + k << " t" << a * kTranslations + k << " ||| "
+         << 0.05 + 0.9 * Random(1000) / 1000.0 << " 0.3 " << 0.05 + 0.9 * Random(1000) / 1000.0 << " 0.3 ||| 0-1 1-0\n";
+    }
+  }
+
+  // unigrams and a few successors of every target word
+  const size_t targetWords = kSourceWords * kTranslations, successors = 5;
+  ofstream arpa(lm.c_str());
+  arpa << "\\data\\\n"
+       << "ngram 1=" << targetWords + 3 << "\n"
+       << "ngram 2=" << targetWords * successors << "\n\n"
+       << "\\1-grams:\n"
+       << "-99\t<s>\t-0.3\n"
+       << "-2.0\t</s>\n"
+       << "-5.0\t<unk>\n";
+  for (size_t w = 0; w < targetWords; ++w) {
+    arpa << -2.0 - Random(2000) / 1000.0 << "\tt" << w << "\t-0.3\n";
+  }
+  arpa << "\n\\2-grams:\n";
+  for (size_t w = 0; w < targetWords; ++w) {
+    for (size_t k = 0; k < successors; ++k) {
+      arpa << -0.5 - Random(1000) / 1000.0 << "\tt" << w << " t" << (w * 31 + k * 997 + 1) % targetWords << "\n";
+    }
+  }
+  arpa << "\n\\end\\\n";
+}
+
+string RandomSentence()
+{
+  ostringstream out;
+  size_t word = Random(kSourceWords);
+  for (size_t i = 0; i < kSentenceLength; ++i) {
+    out << (i ? " s" : "s") << word;
+    word = Random(2) ? Follower(word) : Random(kSourceWords);
+  }
+  return out.str();
+}
+
+}
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "benchmarkStackHash sentences [moses options]\n"
+            "\n"
+            "Writes a synthetic phrase table and bigram language model, decodes\n"
+            "sentences random sentences of 25 words with normal phrase-based search\n"
+            "and the given options, e.g. -s 5000 with and without -stack-hash, and\n"
+            "reports seconds/sentence and the sum of the best translations' scores.\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    printHelp();
+    return EXIT_FAILURE;
+  }
+  size_t numSentences = Scan<size_t>(argv[1]);
+
+  const string phraseTable = "benchmarkStackHash.phrase-table", lm = "benchmarkStackHash.arpa";
+  const string ini = "benchmarkStackHash.ini";
+  WriteModel(phraseTable, lm);
+  {
+    ofstream out(ini.c_str());
+    out << "[input-factors]\n0\n"
+        << "[mapping]\n0 T 0\n"
+        << "[distortion-limit]\n6\n"
+        << "[feature]\n"
+        << "UnknownWordPenalty\n"
+        << "WordPenalty\n"
+        << "PhrasePenalty\n"
+        << "Distortion\n"
+        << "PhraseDictionaryMemory name=TranslationModel0 num-features=4 input-factor=0 output-factor=0 path=" << phraseTable << "\n"
+        << "KENLM name=LM0 factor=0 order=2 path=" << lm << "\n"
+        << "[weight]\n"
+        << "UnknownWordPenalty0= 1\n"
+        << "WordPenalty0= -1\n"
+        << "PhrasePenalty0= 0.2\n"
+        << "Distortion0= 0.3\n"
+        << "TranslationModel0= 0.2 0.2 0.2 0.2\n"
+        << "LM0= 0.5\n";
+  }
+
+  vector<char*> args;
+  args.push_back(argv[0]);
+  args.push_back(const_cast<char*>("-f"));
+  args.push_back(const_cast<char*>(ini.c_str()));
+  args.push_back(const_cast<char*>("-v"));
+  args.push_back(const_cast<char*>("0"));
+  for (int i = 2; i < argc; ++i) {
+    args.push_back(argv[i]);
+  }
+
+  Parameter parameter;
+  if (!parameter.LoadParam(args.size(), &args[0]) || !StaticData::LoadDataStatic(&parameter, argv[0])) {
+    return EXIT_FAILURE;
+  }
+  const StaticData &staticData = StaticData::Instance();
+
+  vector<string> input;
+  for (size_t i = 0; i < numSentences; ++i) {
+    input.push_back(RandomSentence());
+  }
+
+  double totalScore = 0;
+  double start = util::WallTime();
+  for (size_t i = 0; i < input.size(); ++i) {
+    Sentence sentence;
+    istringstream in(input[i] + "\n");
+    sentence.Read(in, staticData.GetInputFactorOrder());
+    sentence.SetTranslationId(i);
+
+    Manager manager(sentence, staticData.GetSearchAlgorithm());
+    manager.Decode();
+    const Hypothesis *best = manager.GetBestHypothesis();
+    if (best) {
+      totalScore += best->GetTotalScore();
+    }
+  }
+  double seconds = util::WallTime() - start;
+  cout << input.size() << " sentences in " << seconds << " seconds, " << seconds / input.size()
+       << " seconds/sentence, total best score " << totalScore << endl;
+
+  remove(ini.c_str());
+  remove(phraseTable.c_str());
+  remove(lm.c_str());
+  return EXIT_SUCCESS;
+}
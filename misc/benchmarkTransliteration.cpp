@@ -0,0 +1,260 @@
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "moses/TranslationModel/TransliterationModel.h"
+#include "moses/Util.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+// Cyrillic source letters, Latin target letters
+const size_t kLetters = 32, kWords = 20000, kMaxPhraseLength = 4, kOrder = 5, kNBestSize = 50;
+
+//! deterministic, so that runs with different stack sizes transliterate the same words
+size_t Random(size_t n)
+{
+  static unsigned long state = 1;
+  state = state * 1103515245 + 12345;
+  return (state / 65536) % n;
+}
+
+string SourceLetter(size_t letter)
+{
+  // U+0430 to U+044F, two bytes in UTF-8
+  size_t codePoint = 0x430 + letter;
+  string ret;
+  ret += static_cast<char>(0xC0 | (codePoint >> 6));
+  ret += static_cast<char>(0x80 | (codePoint & 0x3F));
+  return ret;
+}
+
+//! target spellings of a source letter: one to three Latin letters each, the first one usual
+vector<string> Spellings(size_t letter)
+{
+  vector<string> ret;
+  ret.push_back(string(1, 'a' + letter % 26));
+  ret.push_back(string(1, 'a' + (letter * 7 + 3) % 26) + string(1, 'h'));
+  ret.push_back(string(1, 'a' + (letter * 11 + 5) % 26));
+  if (letter % 4 == 0) {
+    ret.push_back(string(1, 'a' + (letter * 5 + 1) % 26) + string(1, 'a' + (letter * 3 + 2) % 26) + "h");
+  }
+  return ret;
+}
+
+//! source letters of a word, following a bigram pattern, and the spelling of each
+void RandomWord(size_t minLength, size_t maxLength, vector<size_t> &letters, vector<size_t> &spellings)
+{
+  letters.clear();
+  spellings.clear();
+  size_t length = minLength + Random(maxLength - minLength + 1);
+  size_t letter = Random(kLetters);
+  for (size_t i = 0; i < length; ++i) {
+    letters.push_back(letter);
+    size_t r = Random(100);
+    spellings.push_back(r < 70 ? 0 : r < 85 ? 1 : r < 95 ? 2 : 3);
+    if (spellings.back() >= Spellings(letter).size()) {
+      spellings.back() = 0;
+    }
+    letter = Random(3) ? (letter * 5 + Random(4)) % kLetters : Random(kLetters);
+  }
+}
+
+/** Writes a model directory as train-transliteration-module.pl makes one:
+ *  a phrase table of character phrases of up to 4 letters with 4 scores,
+ *  extracted from a synthetic corpus of 20000 words, and a 5-gram character
+ *  language model estimated on the target side of the corpus.
+ */
+void WriteModel(const string &dir)
+{
+  boost::filesystem::create_directories(dir + "/model");
+
+  typedef map<string, map<string, size_t> > PairCounts;
+  PairCounts pairCounts;
+  map<string, size_t> targetCounts;
+  vector< map<string, size_t> > ngramCounts(kOrder + 1);
+  size_t unigramTotal = 0;
+
+  vector<size_t> letters, spellings;
+  for (size_t w = 0; w < kWords; ++w) {
+    RandomWord(3, 12, letters, spellings);
+
+    vector<string> target;
+    target.push_back("<s>");
+    for (size_t i = 0; i < letters.size(); ++i) {
+      const string spelling = Spellings(letters[i])[spellings[i]];
+      for (size_t c = 0; c < spelling.size(); ++c) {
+        target.push_back(string(1, spelling[c]));
+      }
+    }
+    target.push_back("</s>");
+
+    for (size_t end = 1; end < target.size(); ++end) {
+      string ngram;
+      for (size_t n = 1; n <= kOrder && n <= end + 1; ++n) {
+        ngram = target[end + 1 - n] + (n > 1 ? " " : "") + ngram;
+        ++ngramCounts[n][ngram];
+      }
+      ++unigramTotal;
+    }
+
+    for (size_t start = 0; start < letters.size(); ++start) {
+      string source, phrase;
+      for (size_t length = 1; length <= kMaxPhraseLength && start + length <= letters.size(); ++length) {
+        size_t i = start + length - 1;
+        source += (length > 1 ? " " : "") + SourceLetter(letters[i]);
+        const string spelling = Spellings(letters[i])[spellings[i]];
+        for (size_t c = 0; c < spelling.size(); ++c) {
+          phrase += (phrase.empty() ? "" : " ") + string(1, spelling[c]);
+        }
+        ++pairCounts[source][phrase];
+        ++targetCounts[phrase];
+      }
+    }
+  }
+
+  size_t numPairs = 0;
+  ofstream table((dir + "/model/phrase-table").c_str());
+  for (PairCounts::const_iterator source = pairCounts.begin(); source != pairCounts.end(); ++source) {
+    numPairs += source->second.size();
+    size_t sourceCount = 0;
+    for (map<string, size_t>::const_iterator target = source->second.begin(); target != source->second.end(); ++target) {
+      sourceCount += target->second;
+    }
+    for (map<string, size_t>::const_iterator target = source->second.begin(); target != source->second.end(); ++target) {
+      float inverse = float(target->second) / targetCounts[target->first];
+      float direct = float(target->second) / sourceCount;
+      table << source->first << " ||| " << target->first << " ||| "
+            << inverse << " " << inverse << " " << direct << " " << direct << " ||| 0-0\n";
+    }
+  }
+
+  // relative frequencies, discounted for the backoff
+  ofstream arpa((dir + "/model/lm.arpa").c_str());
+  arpa << "\\data\\\n"
+       << "ngram 1=" << ngramCounts[1].size() + 2 << "\n";
+  for (size_t n = 2; n <= kOrder; ++n) {
+    arpa << "ngram " << n << "=" << ngramCounts[n].size() << "\n";
+  }
+  arpa << "\n\\1-grams:\n"
+       << "-99\t<s>\t-0.5\n"
+       << "-6\t<unk>\n";
+  for (size_t n = 1; n <= kOrder; ++n) {
+    if (n > 1) {
+      arpa << "\n\\" << n << "-grams:\n";
+    }
+    for (map<string, size_t>::const_iterator ngram = ngramCounts[n].begin(); ngram != ngramCounts[n].end(); ++ngram) {
+      if (ngram->first == "<s>") {
+        continue;
+      }
+      float prob;
+      if (n == 1) {
+        prob = float(ngram->second) / unigramTotal;
+      } else {
+        string context = ngram->first.substr(0, ngram->first.rfind(' '));
+        size_t contextCount = ngramCounts[n - 1][context];
+        if (context == "<s>") {
+          contextCount = kWords;
+        }
+        prob = 0.7 * ngram->second / contextCount;
+      }
+      arpa << log10(prob) << "\t" << ngram->first;
+      if (n < kOrder && ngram->first.rfind("</s>") == string::npos) {
+        arpa << "\t-0.3";
+      }
+      arpa << "\n";
+    }
+  }
+  arpa << "\n\\end\\\n";
+
+  cerr << numPairs << " phrase pairs of " << pairCounts.size() << " source phrases, n-grams:";
+  for (size_t n = 1; n <= kOrder; ++n) {
+    cerr << " " << ngramCounts[n].size();
+  }
+  cerr << endl;
+
+  ofstream ini((dir + "/model/moses.ini").c_str());
+  ini << "[feature]\n"
+      << "WordPenalty\n"
+      << "PhrasePenalty\n"
+      << "PhraseDictionaryMemory name=TranslationModel0 num-features=4 path=" << dir << "/model/phrase-table"
+      << " input-factor=0 output-factor=0\n"
+      << "KENLM name=LM0 factor=0 order=" << kOrder << " path=" << dir << "/model/lm.arpa\n"
+      << "[weight]\n"
+      << "WordPenalty0= -0.5\n"
+      << "PhrasePenalty0= 0.2\n"
+      << "TranslationModel0= 0.2 0.1 0.2 0.1\n"
+      << "LM0= 0.5\n";
+}
+
+}
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "benchmarkTransliteration words stack-size...\n"
+            "\n"
+            "Writes a synthetic transliteration model of character phrases up to 4\n"
+            "letters and a 5-gram character language model, transliterates random\n"
+            "words of 6 to 12 letters into the 50-best with each stack size, and\n"
+            "reports seconds/word and the sum of the best candidates' scores.\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+    printHelp();
+    return EXIT_FAILURE;
+  }
+  size_t numWords = Scan<size_t>(argv[1]);
+
+  const string dir = "benchmarkTransliteration.model";
+  WriteModel(dir);
+
+  vector<string> words;
+  vector<size_t> letters, spellings;
+  for (size_t w = 0; w < numWords; ++w) {
+    RandomWord(6, 12, letters, spellings);
+    string word;
+    for (size_t i = 0; i < letters.size(); ++i) {
+      word += SourceLetter(letters[i]);
+    }
+    words.push_back(word);
+  }
+
+  for (int arg = 2; arg < argc; ++arg) {
+    size_t stackSize = Scan<size_t>(argv[arg]);
+    TransliterationModel model(dir, stackSize, 20);
+
+    double totalScore = 0;
+    size_t numCandidates = 0;
+    vector<TransliterationModel::Candidate> candidates;
+    double start = util::WallTime();
+    for (size_t w = 0; w < words.size(); ++w) {
+      model.Transliterate(words[w], kNBestSize, candidates);
+      if (!candidates.empty()) {
+        totalScore += candidates[0].score;
+      }
+      numCandidates += candidates.size();
+    }
+    double seconds = util::WallTime() - start;
+    cout << "stack " << stackSize << ": " << words.size() << " words in " << seconds << " seconds, "
+         << seconds / words.size() << " seconds/word, " << numCandidates << " candidates, total best score "
+         << totalScore << endl;
+  }
+
+  boost::filesystem::remove_all(dir);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "moses/Util.h"
+#include "moses/WordsBitmap.h"
+#include "moses/WordsRange.h"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+/** one bool per word, as WordsBitmap was before coverage went into
+ *  64-bit chunks; the reference for the timings */
+class ByteBitmap
+{
+public:
+  ByteBitmap(size_t size, const std::vector<bool> &initialize)
+    : m_size(size), m_bitmap((bool*) malloc(size)) {
+    for (size_t pos = 0; pos < m_size; pos++) {
+      m_bitmap[pos] = pos < initialize.size() && initialize[pos];
+    }
+  }
+  ByteBitmap(const ByteBitmap &copy)
+    : m_size(copy.m_size), m_bitmap((bool*) malloc(copy.m_size)) {
+    for (size_t pos = 0; pos < m_size; pos++) {
+      m_bitmap[pos] = copy.m_bitmap[pos];
+    }
+  }
+  ~ByteBitmap() {
+    free(m_bitmap);
+  }
+  size_t GetNumWordsCovered() const {
+    size_t count = 0;
+    for (size_t pos = 0; pos < m_size; pos++) {
+      if (m_bitmap[pos]) count++;
+    }
+    return count;
+  }
+  size_t GetFirstGapPos() const {
+    for (size_t pos = 0; pos < m_size; pos++) {
+      if (!m_bitmap[pos]) return pos;
+    }
+    return NOT_FOUND;
+  }
+  size_t GetLastPos() const {
+    for (int pos = (int) m_size - 1; pos >= 0; pos--) {
+      if (m_bitmap[pos]) return pos;
+    }
+    return NOT_FOUND;
+  }
+  void SetValue(size_t startPos, size_t endPos, bool value) {
+    for (size_t pos = startPos; pos <= endPos; pos++) {
+      m_bitmap[pos] = value;
+    }
+  }
+  bool IsComplete() const {
+    return m_size == GetNumWordsCovered();
+  }
+  bool Overlap(const WordsRange &compare) const {
+    for (size_t pos = compare.GetStartPos(); pos <= compare.GetEndPos(); pos++) {
+      if (m_bitmap[pos]) return true;
+    }
+    return false;
+  }
+  size_t GetEdgeToTheLeftOf(size_t l) const {
+    while (l && !m_bitmap[l-1]) --l;
+    return l;
+  }
+  size_t GetEdgeToTheRightOf(size_t r) const {
+    while (r+1 < m_size && !m_bitmap[r+1]) ++r;
+    return r;
+  }
+private:
+  size_t m_size;
+  bool *m_bitmap;
+};
+
+/** what search does with the coverage of one hypothesis: copy it, then
+ *  look for phrases of up to maxPhrase words that can extend it */
+template <class Bitmap>
+size_t ExpandOne(const Bitmap &prev, size_t size, size_t maxPhrase)
+{
+  Bitmap coverage(prev);
+  size_t result = coverage.GetFirstGapPos() + coverage.GetLastPos();
+  for (size_t start = 0; start < size; ++start) {
+    for (size_t end = start; end < size && end < start + maxPhrase; ++end) {
+      WordsRange range(start, end);
+      if (coverage.Overlap(range)) break;
+      result += coverage.GetEdgeToTheLeftOf(start) + coverage.GetEdgeToTheRightOf(end);
+    }
+  }
+  coverage.SetValue(0, 0, true);
+  return result + coverage.GetNumWordsCovered() + coverage.IsComplete();
+}
+
+template <class Bitmap>
+double NanosPerHypothesis(const vector<vector<bool> > &coverages, size_t size, size_t repeats, size_t &checksum)
+{
+  vector<Bitmap*> bitmaps;
+  for (size_t i = 0; i < coverages.size(); ++i) {
+    bitmaps.push_back(new Bitmap(size, coverages[i]));
+  }
+  double start = util::WallTime();
+  for (size_t r = 0; r < repeats; ++r) {
+    for (size_t i = 0; i < bitmaps.size(); ++i) {
+      checksum += ExpandOne(*bitmaps[i], size, 7);
+    }
+  }
+  double seconds = util::WallTime() - start;
+  for (size_t i = 0; i < bitmaps.size(); ++i) {
+    delete bitmaps[i];
+  }
+  return seconds * 1e9 / (repeats * bitmaps.size());
+}
+
+}
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "benchmarkWordsBitmap [length1,length2,...] [hypotheses]\n"
+            "\n"
+            "Times the coverage work of expanding one hypothesis (copy, gap,\n"
+            "overlap and edge queries for phrases of up to 7 words) for random\n"
+            "coverages of sentences of each length (default 20,60,120), with\n"
+            "WordsBitmap and with one bool per word, and reports ns/hypothesis.\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 3) {
+    printHelp();
+    return EXIT_FAILURE;
+  }
+  vector<size_t> lengths = Tokenize<size_t>(argc > 1 ? argv[1] : "20,60,120", ",");
+  size_t numHypos = argc > 2 ? Scan<size_t>(argv[2]) : 10000;
+
+  srand(1234);
+  size_t checksum = 0;
+  for (size_t l = 0; l < lengths.size(); ++l) {
+    size_t size = lengths[l];
+    vector<vector<bool> > coverages(numHypos, vector<bool>(size));
+    for (size_t i = 0; i < numHypos; ++i) {
+      // about a third of the sentence translated
+      for (size_t pos = 0; pos < size; ++pos) {
+        coverages[i][pos] = rand() % 3 == 0;
+      }
+    }
+    size_t repeats = 1 + 2000000 / (numHypos * size);
+    double bytes = NanosPerHypothesis<ByteBitmap>(coverages, size, repeats, checksum);
+    double chunks = NanosPerHypothesis<WordsBitmap>(coverages, size, repeats, checksum);
+    cout << size << " words: bool per word " << bytes << " ns, WordsBitmap "
+         << chunks << " ns per hypothesis" << endl;
+  }
+  // keeps the work from being optimised away
+  cerr << "checksum " << checksum << endl;
+  return EXIT_SUCCESS;
+}
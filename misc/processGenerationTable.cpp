@@ -0,0 +1,55 @@
+#include <iostream>
+#include <string>
+
+#include "moses/InputFileStream.h"
+#include "moses/GenerationDictionary.h"
+
+using namespace Moses;
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "options: \n"
+            "\t-in  string -- input generation table file name\n"
+            "\t-out string -- prefix of binary table file, the decoder uses <prefix>.bingen\n"
+            "\t               if the Generation feature is given path=<prefix>\n"
+            "If -in is not specified reads from stdin\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  std::string inFilePath;
+  std::string outFilePath("out");
+  if(1 >= argc) {
+    printHelp();
+    return 1;
+  }
+  for(int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if("-in" == arg && i+1 < argc) {
+      ++i;
+      inFilePath = argv[i];
+    } else if("-out" == arg && i+1 < argc) {
+      ++i;
+      outFilePath = argv[i];
+    } else {
+      //somethings wrong... print help
+      printHelp();
+      return 1;
+    }
+  }
+
+  bool success = false;
+
+  if(inFilePath.empty()) {
+    std::cerr << "processing stdin to " << outFilePath << ".bingen\n";
+    success = GenerationDictionary::CreateImage(std::cin, outFilePath);
+  } else {
+    std::cerr << "processing " << inFilePath<< " to " << outFilePath << ".bingen\n";
+    InputFileStream file(inFilePath);
+    success = GenerationDictionary::CreateImage(file, outFilePath);
+  }
+
+  return (success ? 0 : 1);
+}
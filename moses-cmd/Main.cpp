@@ -41,6 +41,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/TypeDef.h"
 #include "moses/Util.h"
 #include "moses/Timer.h"
+#include "moses/DecodingDeadline.h"
 #include "moses/TranslationModel/PhraseDictionary.h"
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/FF/StatelessFeatureFunction.h"
@@ -139,7 +140,7 @@ int main(int argc, char** argv)
     }
 
 #ifdef WITH_THREADS
-    ThreadPool pool(staticData.ThreadCount());
+    ThreadPool pool(staticData.ThreadCount(), staticData.GetThreadPriorityClasses());
 #endif
 
     // main loop over set of input sentences
@@ -203,7 +204,13 @@ int main(int argc, char** argv)
     // we are done, finishing up
 #ifdef WITH_THREADS
     pool.Stop(true); //flush remaining jobs
+    IFVERBOSE(1) {
+      TRACE_ERR("Thread pool: " << pool.GetStats() << endl);
+    }
 #endif
+    IFVERBOSE(1) {
+      DecodingDeadline::OutputSummary(std::cerr);
+    }
 
     delete ioWrapper;
     FeatureFunction::Destroy();
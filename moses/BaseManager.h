@@ -50,6 +50,10 @@ public:
   const InputType& GetSource() const {
     return m_source;
   }
+  //! search options of the input being decoded
+  const DecodingOptions& GetOptions() const {
+    return m_source.GetOptions();
+  }
 
   virtual void Decode() = 0;
   // outputs
@@ -52,8 +52,7 @@ ChartCellBase::~ChartCellBase() {}
 ChartCell::ChartCell(size_t startPos, size_t endPos, ChartManager &manager) :
   ChartCellBase(startPos, endPos), m_manager(manager)
 {
-  const StaticData &staticData = StaticData::Instance();
-  m_nBestIsEnabled = staticData.IsNBestEnabled();
+  m_nBestIsEnabled = manager.GetOptions().nBestEnabled;
 }
 
 ChartCell::~ChartCell() {}
@@ -66,7 +65,11 @@ ChartCell::~ChartCell() {}
 bool ChartCell::AddHypothesis(ChartHypothesis *hypo)
 {
   const Word &targetLHS = hypo->GetTargetLHS();
-  return m_hypoColl[targetLHS].AddHypothesis(hypo, m_manager);
+  MapType::iterator iter = m_hypoColl.find(targetLHS);
+  if (iter == m_hypoColl.end()) {
+    iter = m_hypoColl.insert(std::make_pair(targetLHS, ChartHypothesisCollection(m_manager.GetOptions()))).first;
+  }
+  return iter->second.AddHypothesis(hypo, m_manager);
 }
 
 /** Prune each collection in this cell to a particular size */
@@ -87,8 +90,6 @@ void ChartCell::PruneToSize()
 void ChartCell::Decode(const ChartTranslationOptionList &transOptList
                                 , const ChartCellCollection &allChartCells)
 {
-  const StaticData &staticData = StaticData::Instance();
-
   // priority queue for applicable rules with selected hypotheses
   RuleCubeQueue queue(m_manager);
 
@@ -100,7 +101,7 @@ void ChartCell::Decode(const ChartTranslationOptionList &transOptList
   }
 
   // pluck things out of queue and add to hypo collection
-  const size_t popLimit = staticData.GetCubePruningPopLimit();
+  const size_t popLimit = m_manager.GetOptions().cubePruningPopLimit;
   for (size_t numPops = 0; numPops < popLimit && !queue.IsEmpty(); ++numPops) {
     ChartHypothesis *hypo = queue.Pop();
     AddHypothesis(hypo);
@@ -118,7 +119,8 @@ void ChartCell::SortHypotheses()
 
     if (coll.GetSize()) {
       coll.SortHypotheses();
-      m_targetLabelSet.AddConstituent(iter->first, &coll.GetSortedHypotheses());
+      const HypoList &sortedHypos = coll.GetSortedHypotheses();
+      m_targetLabelSet.AddConstituent(iter->first, &sortedHypos, sortedHypos[0]->GetTotalScore());
     }
   }
 }
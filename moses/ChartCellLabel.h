@@ -54,7 +54,8 @@ public:
     : m_coverage(coverage)
     , m_label(label)
     , m_stack(stack)
-    , m_bestScore(0) {
+    , m_bestScore(0)
+    , m_hasBestScore(false) {
   }
 
   const WordsRange &GetCoverage() const {
@@ -72,12 +73,22 @@ public:
 
   //caching of best score on stack
   float GetBestScore(const ChartParserCallback *outColl) const {
-    if (m_bestScore == 0) {
+    if (!m_hasBestScore) {
       m_bestScore = outColl->GetBestScore(this);
+      m_hasBestScore = true;
     }
     return m_bestScore;
   }
 
+  /** Set the best score when the cell is finished. Cells of one width may
+   *  be decoded by several threads (see -search-threads), which read the
+   *  labels of narrower cells, so the cache must not be filled lazily then.
+   */
+  void SetBestScore(float score) {
+    m_bestScore = score;
+    m_hasBestScore = true;
+  }
+
   bool operator<(const ChartCellLabel &other) const {
     // m_coverage and m_label uniquely identify a ChartCellLabel, so don't
     // need to compare m_stack.
@@ -93,6 +104,7 @@ private:
   //const InputPath &m_inputPath;
   Stack m_stack;
   mutable float m_bestScore;
+  mutable bool m_hasBestScore;
 };
 
 }
@@ -79,7 +79,7 @@ public:
   }
 
   // Stack is a HypoList or whatever the search algorithm uses.
-  void AddConstituent(const Word &w, const HypoList *stack) {
+  void AddConstituent(const Word &w, const HypoList *stack, float bestScore) {
     size_t idx = w[0]->GetId();
     if (ChartCellExists(idx)) {
       ChartCellLabel::Stack & s = m_map[idx]->MutableStack();
@@ -90,6 +90,7 @@ public:
       m_size++;
       m_map[idx] = new ChartCellLabel(m_coverage, w, s);
     }
+    m_map[idx]->SetBestScore(bestScore);
   }
 
   // grow vector if necessary
@@ -292,8 +292,9 @@ void ChartHypothesis::CleanupArcList()
    * so we'll keep all of arc list if nedd distinct n-best list
    */
   const StaticData &staticData = StaticData::Instance();
-  size_t nBestSize = staticData.GetNBestSize();
-  bool distinctNBest = staticData.GetDistinctNBest() || staticData.UseMBR() || staticData.GetOutputSearchGraph() || staticData.GetOutputSearchGraphHypergraph();
+  const DecodingOptions &options = m_manager.GetOptions();
+  size_t nBestSize = options.nBestSize;
+  bool distinctNBest = staticData.GetDistinctNBest() || staticData.UseMBR() || options.outputSearchGraph || staticData.GetOutputSearchGraphHypergraph();
 
   if (!distinctNBest && m_arcList->size() > nBestSize) {
     // prune arc list only if there too many arcs
@@ -33,13 +33,11 @@ using namespace Moses;
 namespace Moses
 {
 
-ChartHypothesisCollection::ChartHypothesisCollection()
+ChartHypothesisCollection::ChartHypothesisCollection(const DecodingOptions &options)
 {
-  const StaticData &staticData = StaticData::Instance();
-
-  m_beamWidth = staticData.GetBeamWidth();
-  m_maxHypoStackSize = staticData.GetMaxHypoStackSize();
-  m_nBestIsEnabled = staticData.IsNBestEnabled();
+  m_beamWidth = options.beamWidth;
+  m_maxHypoStackSize = options.maxHypoStackSize;
+  m_nBestIsEnabled = options.nBestEnabled;
   m_bestScore = -std::numeric_limits<float>::infinity();
 }
 
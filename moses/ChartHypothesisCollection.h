@@ -23,6 +23,7 @@
 #include <set>
 #include "ChartHypothesis.h"
 #include "RuleCube.h"
+#include "DecodingOptions.h"
 
 
 namespace Moses
@@ -90,7 +91,7 @@ public:
     return m_hypos.end();
   }
 
-  ChartHypothesisCollection();
+  explicit ChartHypothesisCollection(const DecodingOptions &options);
   ~ChartHypothesisCollection();
   bool AddHypothesis(ChartHypothesis *hypo, ChartManager &manager);
 
@@ -19,6 +19,8 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
+#include <algorithm>
+#include <cstdlib>
 #include <stdio.h>
 #include "ChartManager.h"
 #include "ChartCell.h"
@@ -34,6 +36,9 @@
 #include "moses/OutputCollector.h"
 #include "moses/ChartKBestExtractor.h"
 #include "moses/HypergraphOutput.h"
+#include "moses/ThreadPool.h"
+
+#include "util/usage.hh"
 
 using namespace std;
 
@@ -41,6 +46,83 @@ namespace Moses
 {
 extern bool g_mosesDebug;
 
+#ifdef WITH_THREADS
+namespace
+{
+boost::once_flag cellPoolOnce = BOOST_ONCE_INIT;
+ThreadPool *cellPool = NULL;
+
+void DeleteCellPool()
+{
+  cellPool->Stop();
+  delete cellPool;
+  cellPool = NULL;
+}
+
+// shared by all sentences; the decoding thread itself is the remaining worker
+void CreateCellPool()
+{
+  cellPool = new ThreadPool(StaticData::Instance().GetSearchThreadCount() - 1);
+  atexit(DeleteCellPool);
+}
+
+ThreadPool &GetCellPool()
+{
+  boost::call_once(cellPoolOnce, CreateCellPool);
+  return *cellPool;
+}
+}
+
+/** Decodes the cells of one width, taking them one at a time from a
+ *  counter shared by all threads working on the width. Runs in the cell
+ *  pool and in the decoding thread itself.
+ */
+class CellDecodeTask : public Task
+{
+public:
+  struct Shared {
+    Shared(size_t width, const std::vector<ChartTranslationOptionList*> &transOptLists)
+      : width(width), numCells(transOptLists.size() - width + 1), transOptLists(transOptLists)
+      , next(0), pending(0), busy(0) {}
+    size_t width;
+    size_t numCells;
+    const std::vector<ChartTranslationOptionList*> &transOptLists; // by start position
+    boost::atomic<size_t> next;
+    boost::mutex mutex;
+    boost::condition_variable done;
+    size_t pending; // helper tasks still running
+    double busy; // seconds spent by helper tasks
+  };
+
+  CellDecodeTask(ChartManager &manager, Shared &shared)
+    : m_manager(manager), m_shared(shared) {}
+
+  static void Decode(ChartManager &manager, Shared &shared) {
+    size_t startPos;
+    while ((startPos = shared.next++) < shared.numCells) {
+      WordsRange range(startPos, startPos + shared.width - 1);
+      manager.DecodeCell(range, *shared.transOptLists[startPos]);
+    }
+  }
+
+  void Run() {
+    double start = util::WallTime();
+    Decode(m_manager, m_shared);
+    double busy = util::WallTime() - start;
+
+    boost::mutex::scoped_lock lock(m_shared.mutex);
+    m_shared.busy += busy;
+    if (--m_shared.pending == 0) {
+      m_shared.done.notify_all();
+    }
+  }
+
+private:
+  ChartManager &m_manager;
+  Shared &m_shared;
+};
+#endif
+
 /* constructor. Initialize everything prior to decoding a particular sentence.
  * \param source the sentence to be decoded
  * \param system which particular set of models to use.
@@ -76,33 +158,54 @@ void ChartManager::Decode()
 
   AddXmlChartOptions();
 
+  // cells of the same width can be decoded by several threads, see DecodeByWidth().
+  // The detailed output of -v 2 and above is only written by one thread, and
+  // features with thread-local sentence state only see this sentence on this thread.
+  // The cell pool has the threads given by -search-threads
+  const StaticData &staticData = StaticData::Instance();
+  size_t numThreads = std::min(GetOptions().searchThreads, staticData.GetSearchThreadCount());
+  if (numThreads > 1 && staticData.HasThreadLocalSentenceState()) {
+    numThreads = 1;
+  }
+  IFVERBOSE(2) {
+    numThreads = 1;
+  }
+  bool byWidth = numThreads > 1 && m_parser.SetWidthOrder();
+
   // MAIN LOOP
   size_t size = m_source.GetSize();
-  for (int startPos = size-1; startPos >= 0; --startPos) {
-    for (size_t width = 1; width <= size-startPos; ++width) {
-      size_t endPos = startPos + width - 1;
-      WordsRange range(startPos, endPos);
-
-      // create trans opt
-      m_translationOptionList.Clear();
-      m_parser.Create(range, m_translationOptionList);
-      m_translationOptionList.ApplyThreshold();
+  if (byWidth) {
+    DecodeByWidth(numThreads);
+  } else {
+    for (int startPos = size-1; startPos >= 0; --startPos) {
+      for (size_t width = 1; width <= size-startPos; ++width) {
+        size_t endPos = startPos + width - 1;
+        WordsRange range(startPos, endPos);
 
-      const InputPath &inputPath = m_parser.GetInputPath(range);
-      m_translationOptionList.EvaluateWithSourceContext(m_source, inputPath);
+        // create trans opt
+        m_translationOptionList.Clear();
+        m_parser.Create(range, m_translationOptionList);
+        m_translationOptionList.ApplyThreshold();
 
-      // decode
-      ChartCell &cell = m_hypoStackColl.Get(range);
-      cell.Decode(m_translationOptionList, m_hypoStackColl);
+        const InputPath &inputPath = m_parser.GetInputPath(range);
+        m_translationOptionList.EvaluateWithSourceContext(m_source, inputPath);
 
-      m_translationOptionList.Clear();
-      cell.PruneToSize();
-      cell.CleanupArcList();
-      cell.SortHypotheses();
+        // decode
+        DecodeCell(range, m_translationOptionList);
+      }
     }
   }
 
   IFVERBOSE(1) {
+    if (byWidth) {
+      const std::vector<ChartWidthTimes> &times = GetSentenceStats().GetChartWidthTimes();
+      for (size_t i = 0; i < times.size(); ++i) {
+        TRACE_ERR("Line " << m_source.GetTranslationId() << ": width " << i + 1 << ", "
+                  << times[i].numCells << " cells: rule lookup took " << times[i].lookup
+                  << " seconds, decoding " << times[i].decodeWall << " seconds, speedup "
+                  << (times[i].decodeWall > 0 ? times[i].decodeBusy / times[i].decodeWall : 1) << endl);
+      }
+    }
 
     for (size_t startPos = 0; startPos < size; ++startPos) {
       cerr.width(3);
@@ -123,6 +226,83 @@ void ChartManager::Decode()
   }
 }
 
+//! fill one cell with hypotheses from its translation options, and prepare it for use by wider cells
+void ChartManager::DecodeCell(const WordsRange &range, ChartTranslationOptionList &transOptList)
+{
+  ChartCell &cell = m_hypoStackColl.Get(range);
+  cell.Decode(transOptList, m_hypoStackColl);
+
+  transOptList.Clear();
+  cell.PruneToSize();
+  cell.CleanupArcList();
+  cell.SortHypotheses();
+}
+
+/** Decode the chart in order of width. Rules are looked up for all cells
+ *  of one width on this thread, as rule lookup managers are not
+ *  thread-safe; then the cells are decoded by several threads. A cell only
+ *  depends on narrower cells, so the chart is the same as that of the
+ *  sequential loop in Decode(). Only the hypothesis ids differ.
+ */
+void ChartManager::DecodeByWidth(size_t numThreads)
+{
+  size_t size = m_source.GetSize();
+  std::vector<ChartTranslationOptionList*> transOptLists;
+  for (size_t startPos = 0; startPos < size; ++startPos) {
+    transOptLists.push_back(new ChartTranslationOptionList(StaticData::Instance().GetRuleLimit(), m_source));
+  }
+
+  for (size_t width = 1; width <= size; ++width) {
+    size_t numCells = size - width + 1;
+    double startTime = util::WallTime();
+
+    // right to left, as in the sequential loop, so that unknown words are collected in the same order
+    for (int startPos = numCells - 1; startPos >= 0; --startPos) {
+      WordsRange range(startPos, startPos + width - 1);
+      ChartTranslationOptionList &transOptList = *transOptLists[startPos];
+
+      transOptList.Clear();
+      m_parser.Create(range, transOptList);
+      transOptList.ApplyThreshold();
+
+      const InputPath &inputPath = m_parser.GetInputPath(range);
+      transOptList.EvaluateWithSourceContext(m_source, inputPath);
+    }
+
+    double lookupTime = util::WallTime() - startTime;
+    startTime = util::WallTime();
+
+#ifdef WITH_THREADS
+    CellDecodeTask::Shared shared(width, transOptLists);
+    size_t numHelpers = std::min(numThreads - 1, numCells - 1);
+    shared.pending = numHelpers;
+    ThreadPool &pool = GetCellPool();
+    for (size_t i = 0; i < numHelpers; ++i) {
+      pool.Submit(new CellDecodeTask(*this, shared));
+    }
+    CellDecodeTask::Decode(*this, shared);
+    {
+      boost::mutex::scoped_lock lock(shared.mutex);
+      while (shared.pending > 0) {
+        shared.done.wait(lock);
+      }
+    }
+    double busyTime = shared.busy;
+#else
+    for (size_t startPos = 0; startPos < numCells; ++startPos) {
+      DecodeCell(WordsRange(startPos, startPos + width - 1), *transOptLists[startPos]);
+    }
+    double busyTime = 0;
+#endif
+
+    double decodeTime = util::WallTime() - startTime;
+    // busy: decoding on the helper threads plus this one
+    GetSentenceStats().AddChartWidth(width, numCells, lookupTime, decodeTime, busyTime + decodeTime);
+  }
+
+  RemoveAllInColl(transOptLists);
+}
+
 /** add specific translation options and hypotheses according to the XML override translation scheme.
  *  Doesn't seem to do anything about walls and zones.
  *  @todo check walls & zones. Check that the implementation doesn't leak, xml options sometimes does if you're not careful
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <vector>
+#include <boost/atomic.hpp>
 #include <boost/unordered_map.hpp>
 #include "ChartCell.h"
 #include "ChartCellCollection.h"
@@ -45,16 +46,21 @@ class ChartSearchGraphWriter;
  */
 class ChartManager : public BaseManager
 {
+  friend class CellDecodeTask;
+
 private:
   ChartCellCollection m_hypoStackColl;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   clock_t m_start; /**< starting time, used for logging */
-  unsigned m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
+  boost::atomic<unsigned> m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
 
   ChartParser m_parser;
 
   ChartTranslationOptionList m_translationOptionList; /**< pre-computed list of translation options for the phrases in this sentence */
 
+  void DecodeCell(const WordsRange &range, ChartTranslationOptionList &transOptList);
+  void DecodeByWidth(size_t numThreads);
+
   /* auxilliary functions for SearchGraphs */
   void FindReachableHypotheses( 
     const ChartHypothesis *hypo, std::map<unsigned,bool> &reachable , size_t* winners, size_t* losers) const; 
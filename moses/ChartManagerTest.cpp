@@ -0,0 +1,175 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#define BOOST_TEST_MODULE ChartManagerTest
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "ChartCell.h"
+#include "ChartHypothesis.h"
+#include "ChartManager.h"
+#include "DecodingOptions.h"
+#include "MockSentenceStateFeature.h"
+#include "Parameter.h"
+#include "Sentence.h"
+#include "StaticData.h"
+#include "util/exception.hh"
+
+using namespace Moses;
+using namespace MosesTest;
+using namespace std;
+
+/** Decodes the sentences of chart-test/input with a string-to-tree grammar
+ *  of several target labels, with and without -search-threads, and
+ *  compares the 1-best and every hypothesis of the chart.
+ *  Arguments: input, language model, rule table.
+ */
+
+namespace
+{
+
+#ifdef WITH_THREADS
+const size_t kSearchThreads = 4;
+#else
+const size_t kSearchThreads = 1;
+#endif
+
+MockSentenceStateFeature *mockFeature;
+
+struct LoadModels {
+  LoadModels() {
+    char **argv = boost::unit_test::framework::master_test_suite().argv;
+    iniPath = boost::filesystem::unique_path(
+                boost::filesystem::temp_directory_path() / "chart-test-%%%%-%%%%.ini").string();
+    ofstream ini(iniPath.c_str());
+    ini << "[input-factors]\n0\n"
+        << "[mapping]\n0 T 0\n"
+        << "[cube-pruning-pop-limit]\n1000\n"
+        << "[non-terminals]\nX\n"
+        << "[search-algorithm]\n3\n"
+        << "[max-chart-span]\n1000\n"
+        << "[search-threads]\n" << kSearchThreads << "\n"
+        << "[feature]\n"
+        << "UnknownWordPenalty\n"
+        << "WordPenalty\n"
+        << "KENLM name=LM0 factor=0 order=2 path=" << argv[2] << "\n"
+        << "PhraseDictionaryMemory name=TranslationModel0 num-features=1 input-factor=0 output-factor=0 path=" << argv[3] << "\n"
+        << "[weight]\n"
+        << "UnknownWordPenalty0= 1\n"
+        << "WordPenalty0= -0.5\n"
+        << "LM0= 0.5\n"
+        << "TranslationModel0= 0.3\n"
+        << "MockSentenceState0= 0\n";
+    ini.close();
+
+    mockFeature = new MockSentenceStateFeature("MockSentenceState");
+
+    // no BOOST_REQUIRE here, outside of a test case
+    UTIL_THROW_IF2(!parameter.LoadParam(iniPath), "could not read " << iniPath);
+    UTIL_THROW_IF2(!StaticData::LoadDataStatic(&parameter, argv[0]), "could not load the models of " << iniPath);
+  }
+
+  ~LoadModels() {
+    boost::filesystem::remove(iniPath);
+  }
+
+  Parameter parameter;
+  string iniPath;
+};
+
+BOOST_GLOBAL_FIXTURE(LoadModels);
+
+//! 1-best, then every cell of the chart with its hypotheses in order
+string Decode(const string &line, size_t searchThreads)
+{
+  const StaticData &staticData = StaticData::Instance();
+  Sentence sentence;
+  istringstream in(line + "\n");
+  sentence.Read(in, staticData.GetInputFactorOrder());
+  boost::shared_ptr<DecodingOptions> options(new DecodingOptions(staticData.GetDecodingOptions()));
+  options->searchThreads = searchThreads;
+  sentence.SetOptions(options);
+
+  ChartManager manager(sentence);
+  manager.Decode();
+
+  ostringstream out;
+  out << setprecision(10);
+  const ChartHypothesis *best = manager.GetBestHypothesis();
+  BOOST_REQUIRE(best != NULL);
+  out << best->GetOutputPhrase() << " " << best->GetTotalScore() << "\n";
+
+  size_t size = sentence.GetSize();
+  for (size_t width = 1; width <= size; ++width) {
+    for (size_t startPos = 0; startPos + width <= size; ++startPos) {
+      WordsRange range(startPos, startPos + width - 1);
+      const HypoList *hypos = manager.GetChartCellCollection().Get(range).GetAllSortedHypotheses();
+      out << range << ":";
+      for (HypoList::const_iterator iter = hypos->begin(); iter != hypos->end(); ++iter) {
+        const ChartHypothesis &hypo = **iter;
+        out << " " << hypo.GetTargetLHS() << " " << hypo.GetOutputPhrase() << " " << hypo.GetTotalScore() << ";";
+      }
+      out << "\n";
+      delete hypos;
+    }
+  }
+  return out.str();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(search_threads_same_chart)
+{
+  ifstream input(boost::unit_test::framework::master_test_suite().argv[1]);
+  string line;
+  size_t numSentences = 0;
+  while (getline(input, line)) {
+    string sequential = Decode(line, 1);
+    BOOST_CHECK_EQUAL(sequential, Decode(line, kSearchThreads));
+    // several runs, as cells of one width finish in any order
+    BOOST_CHECK_EQUAL(sequential, Decode(line, kSearchThreads));
+    ++numSentences;
+  }
+  BOOST_CHECK_EQUAL(5, numSentences);
+}
+
+// last, as the feature then turns -search-threads off
+BOOST_AUTO_TEST_CASE(search_threads_thread_local_sentence_state)
+{
+  mockFeature->SetThreadLocal(true);
+  StaticData::InstanceNonConst().SetWeight(mockFeature, 0.1);
+  BOOST_CHECK(StaticData::Instance().HasThreadLocalSentenceState());
+
+  ifstream input(boost::unit_test::framework::master_test_suite().argv[1]);
+  string line;
+  while (getline(input, line)) {
+    string sequential = Decode(line, 1);
+    mockFeature->ResetCounts();
+    BOOST_CHECK_EQUAL(sequential, Decode(line, kSearchThreads));
+    BOOST_CHECK(mockFeature->GetEvaluated() > 0);
+    BOOST_CHECK_EQUAL(0, mockFeature->GetMissing());
+  }
+}
@@ -205,6 +205,20 @@ void ChartParser::Create(const WordsRange &wordsRange, ChartParserCallback &to)
   }
 }
 
+bool ChartParser::SetWidthOrder()
+{
+  std::vector <ChartRuleLookupManager*>::const_iterator iter;
+  for (iter = m_ruleLookupManagers.begin(); iter != m_ruleLookupManagers.end(); ++iter) {
+    if (!(*iter)->SupportsWidthOrder()) {
+      return false;
+    }
+  }
+  for (iter = m_ruleLookupManagers.begin(); iter != m_ruleLookupManagers.end(); ++iter) {
+    (*iter)->SetWidthOrder();
+  }
+  return true;
+}
+
 void ChartParser::CreateInputPaths(const InputType &input)
 {
   size_t size = input.GetSize();
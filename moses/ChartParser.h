@@ -65,6 +65,11 @@ public:
 
   void Create(const WordsRange &range, ChartParserCallback &to);
 
+  /** Look up rules in order of width, see ChartRuleLookupManager::SupportsWidthOrder().
+   *  Returns false, and changes nothing, if a rule lookup manager does not support it.
+   */
+  bool SetWidthOrder();
+
   //! the sentence being decoded
   //const Sentence &GetSentence() const;
   long GetTranslationId() const;
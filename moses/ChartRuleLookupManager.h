@@ -69,6 +69,18 @@ public:
     size_t lastPos,  // last position to consider if using lookahead
     ChartParserCallback &outColl) = 0;
 
+  /** Whether rules can be looked up in order of width: every range after
+   *  all narrower ranges have been decoded, but not necessarily after the
+   *  ranges to its right, which are decoded first by the sequential loop of
+   *  ChartManager::Decode().
+   */
+  virtual bool SupportsWidthOrder() const {
+    return false;
+  }
+
+  //! Called before the first lookup if ranges are looked up in order of width.
+  virtual void SetWidthOrder() {}
+
 private:
   //! Non-copyable: copy constructor and assignment operator not implemented.
   ChartRuleLookupManager(const ChartRuleLookupManager &);
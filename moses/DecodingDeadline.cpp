@@ -0,0 +1,117 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+
+#include "DecodingDeadline.h"
+#include "StaticData.h"
+#include "Util.h"
+
+namespace Moses
+{
+
+boost::atomic<size_t> DecodingDeadline::s_numSentences(0);
+boost::atomic<size_t> DecodingDeadline::s_numTightened(0);
+boost::atomic<size_t> DecodingDeadline::s_numMissed(0);
+
+const size_t DecodingDeadline::MIN_LIMIT;
+const float DecodingDeadline::MIN_SCALE = 0.1;
+
+DecodingDeadline::DecodingDeadline(float seconds, Clock clock)
+  : m_seconds(seconds)
+  , m_clock(clock)
+  , m_start(clock())
+  , m_searchStart(-1)
+  , m_scale(1)
+  , m_numStacksTightened(0)
+  , m_missed(false)
+{
+}
+
+float DecodingDeadline::GetScale(size_t doneStacks, size_t numStacks)
+{
+  if (!IsSet()) {
+    return 1;
+  }
+  double now = m_clock();
+  if (m_searchStart < 0) {
+    m_searchStart = now;
+  }
+  double available = m_seconds - (m_searchStart - m_start);
+  double usedTime = (now - m_searchStart) / available;
+  if (available <= 0 || usedTime >= 1) {
+    m_missed = true;
+    m_numStacksTightened++;
+    return m_scale = 0;
+  }
+
+  // nothing is known about the pace before the first stack is done
+  double doneWork = double(doneStacks) / numStacks;
+  if (doneWork == 0 || doneWork >= 1) {
+    return m_scale = 1;
+  }
+  // as a float, like m_scale, so that rounding to 1 does not count as tightened
+  float scale = (1 - usedTime) / (1 - doneWork);
+  if (scale >= 1) {
+    return m_scale = 1;
+  }
+  m_numStacksTightened++;
+  return m_scale = scale;
+}
+
+size_t DecodingDeadline::ScaleLimit(size_t limit, float scale)
+{
+  double scaled = limit * double(scale);
+  if (scaled >= limit) {
+    return limit;
+  }
+  return std::max<size_t>(std::min(limit, MIN_LIMIT), scaled);
+}
+
+float DecodingDeadline::ScaleBeam(float beamWidth, float scale)
+{
+  return beamWidth * std::max(scale, MIN_SCALE);
+}
+
+void DecodingDeadline::Finish(long translationId)
+{
+  if (!IsSet()) {
+    return;
+  }
+  s_numSentences++;
+  if (m_numStacksTightened > 0) {
+    s_numTightened++;
+  }
+  if (m_missed) {
+    s_numMissed++;
+  }
+  VERBOSE(1, "Line " << translationId << ": Deadline of " << m_seconds << " seconds: pruning tightened for "
+          << m_numStacksTightened << " stacks" << (m_missed ? ", deadline passed" : "") << std::endl);
+}
+
+void DecodingDeadline::OutputSummary(std::ostream &out)
+{
+  if (s_numSentences == 0) {
+    return;
+  }
+  out << "Deadline: pruning tightened for " << s_numTightened << " of " << s_numSentences
+      << " sentences, deadline passed for " << s_numMissed << std::endl;
+}
+
+}
@@ -0,0 +1,109 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_DecodingDeadline_h
+#define moses_DecodingDeadline_h
+
+#include <cstddef>
+#include <iostream>
+
+#include <boost/atomic.hpp>
+
+#include "util/usage.hh"
+
+namespace Moses
+{
+
+/** Wall clock deadline for decoding one sentence (see -deadline).
+ *
+ * Instead of aborting, the search asks before every stack how much of its
+ * pruning limits (stack size, beam, cube pruning pop limit) it can afford:
+ * all of them while it is on schedule, proportionally less when it is
+ * behind, and the minimum once the deadline has passed. The limits are
+ * never scaled below MIN_LIMIT hypotheses and MIN_SCALE of the beam, so
+ * that the search keeps some alternatives to extend and still ends with a
+ * complete translation.
+ *
+ * The schedule assumes that every stack takes about the same time, measured
+ * from the first stack on; time spent before, e.g. on collecting
+ * translation options, is subtracted from the time available.
+ */
+class DecodingDeadline
+{
+public:
+  //! wall clock in seconds, util::WallTime() unless testing
+  typedef double (*Clock)();
+
+  //! stack size and pop limit when out of time, unless configured lower
+  static const size_t MIN_LIMIT = 10;
+  //! smallest fraction of the beam width used
+  static const float MIN_SCALE;
+
+  //! \param seconds 0 for no deadline
+  explicit DecodingDeadline(float seconds, Clock clock = &util::WallTime);
+
+  bool IsSet() const {
+    return m_seconds > 0;
+  }
+
+  /** Fraction of the pruning limits to use once \p doneStacks of
+   *  \p numStacks stacks have been processed: 1 while on schedule, less
+   *  when behind, 0 when out of time.
+   */
+  float GetScale(size_t doneStacks, size_t numStacks);
+
+  //! whether the previous GetScale() returned less than 1
+  bool IsTightened() const {
+    return m_scale < 1;
+  }
+
+  //! \p limit scaled down, but at least MIN_LIMIT or \p limit if lower
+  static size_t ScaleLimit(size_t limit, float scale);
+  //! beam width (a log threshold, so <= 0) scaled towards 0, but not below MIN_SCALE
+  static float ScaleBeam(float beamWidth, float scale);
+
+  //! stacks for which the limits were tightened
+  size_t GetNumStacksTightened() const {
+    return m_numStacksTightened;
+  }
+  //! whether the deadline passed before the last stack
+  bool IsMissed() const {
+    return m_missed;
+  }
+
+  //! record this sentence in the totals and log it at -v 1
+  void Finish(long translationId);
+
+  //! totals over all sentences decoded with a deadline, if there were any
+  static void OutputSummary(std::ostream &out);
+
+private:
+  float m_seconds;
+  Clock m_clock;
+  double m_start; /**< when the object was made */
+  double m_searchStart; /**< first call to GetScale(), < 0 before */
+  float m_scale; /**< returned by the last GetScale() */
+  size_t m_numStacksTightened;
+  bool m_missed;
+
+  static boost::atomic<size_t> s_numSentences, s_numTightened, s_numMissed;
+};
+
+}
+#endif
@@ -0,0 +1,89 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#include <limits>
+
+#include "DecodingDeadline.h"
+
+using namespace Moses;
+
+namespace
+{
+double fakeNow = 0;
+double FakeClock()
+{
+  return fakeNow;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(decoding_deadline)
+
+BOOST_AUTO_TEST_CASE(no_deadline)
+{
+  DecodingDeadline deadline(0, &FakeClock);
+  BOOST_CHECK(!deadline.IsSet());
+  BOOST_CHECK_EQUAL(deadline.GetScale(5, 10), 1);
+  BOOST_CHECK_EQUAL(deadline.GetNumStacksTightened(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(scale_limits)
+{
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleLimit(200, 1), 200);
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleLimit(200, 0.5), 100);
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleLimit(200, 0), DecodingDeadline::MIN_LIMIT);
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleLimit(3, 0), 3);
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleLimit(size_t(-1), 1), size_t(-1));
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleBeam(-10, 1), -10);
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleBeam(-10, 0.5), -5);
+  BOOST_CHECK_CLOSE(DecodingDeadline::ScaleBeam(-10, 0), -10 * DecodingDeadline::MIN_SCALE, 0.001);
+  BOOST_CHECK_EQUAL(DecodingDeadline::ScaleBeam(-std::numeric_limits<float>::infinity(), 0),
+                    -std::numeric_limits<float>::infinity());
+}
+
+BOOST_AUTO_TEST_CASE(on_schedule_and_out_of_time)
+{
+  fakeNow = 100;
+  DecodingDeadline deadline(10, &FakeClock);
+  // one second collecting translation options
+  fakeNow = 101;
+  BOOST_CHECK_EQUAL(deadline.GetScale(0, 10), 1);
+  fakeNow = 101.9;
+  BOOST_CHECK_EQUAL(deadline.GetScale(1, 10), 1);
+  BOOST_CHECK(!deadline.IsTightened());
+
+  // half of the 9 seconds left for a fifth of the work
+  fakeNow = 105.5;
+  BOOST_CHECK_CLOSE(deadline.GetScale(2, 10), 0.5 / 0.8, 0.001);
+  BOOST_CHECK(deadline.IsTightened());
+
+  // back on schedule
+  fakeNow = 106;
+  BOOST_CHECK_EQUAL(deadline.GetScale(6, 10), 1);
+  BOOST_CHECK(!deadline.IsTightened());
+  BOOST_CHECK(!deadline.IsMissed());
+
+  fakeNow = 110;
+  BOOST_CHECK_EQUAL(deadline.GetScale(7, 10), 0);
+  BOOST_CHECK(deadline.IsTightened());
+  BOOST_CHECK(deadline.IsMissed());
+  BOOST_CHECK_EQUAL(deadline.GetNumStacksTightened(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,69 @@
+// -*- c++ -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_DecodingOptions_h
+#define moses_DecodingOptions_h
+
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Moses
+{
+
+/** Search options that may differ between inputs decoded at the same time,
+ *  e.g. between requests to mosesserver.
+ *
+ *  StaticData holds the options given in moses.ini and on the command line
+ *  (see StaticData::GetDecodingOptions()). An input uses them unless it is
+ *  given options of its own with InputType::SetOptions(). The managers and
+ *  their search read the options of their input instead of StaticData.
+ */
+struct DecodingOptions {
+  //! keep the arcs of recombined hypotheses, for n-best lists and search graphs
+  bool nBestEnabled;
+  //! arcs are pruned to a multiple of this, unless the whole search graph is kept
+  size_t nBestSize;
+  //! keep all arcs
+  bool outputSearchGraph;
+
+  size_t maxHypoStackSize;
+  size_t minHypoStackDiversity;
+  float beamWidth; //!< log of -beam-threshold
+  float earlyDiscardingThreshold; //!< log of -early-discarding-threshold
+  size_t cubePruningPopLimit;
+  size_t cubePruningDiversity;
+  size_t timeoutThreshold; //!< seconds, (size_t)-1 for none
+  float deadline; //!< wall clock seconds per sentence, 0 for none, see DecodingDeadline
+  size_t searchThreads; //!< threads working on one stack or chart width, at most -search-threads
+
+  //! weights of the component models of PhraseDictionaryMultiModel features, by feature name
+  std::map<std::string, std::vector<float> > multiModelWeights;
+
+  bool UseEarlyDiscarding() const {
+    return earlyDiscardingThreshold != -std::numeric_limits<float>::infinity();
+  }
+};
+
+}
+
+#endif
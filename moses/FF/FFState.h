@@ -1,17 +1,28 @@
 #ifndef moses_FFState_h
 #define moses_FFState_h
 
+#include <cstddef>
 #include <vector>
 
+#include "moses/HypothesisArena.h"
 
 namespace Moses
 {
 
-class FFState
+/** State of a stateful feature function in a hypothesis. States are
+ *  ArenaObjects: created while decoding, they live in the memory of the
+ *  sentence. */
+class FFState : public ArenaObject
 {
 public:
   virtual ~FFState();
   virtual int Compare(const FFState& other) const = 0;
+  /** hash consistent with Compare: states that compare equal must hash
+   *  equally. Used by hash-based recombination; the default puts all
+   *  states of a feature in one bucket. */
+  virtual size_t hash() const {
+    return 0;
+  }
 };
 
 class DummyState : public FFState
@@ -93,6 +93,13 @@ public:
   virtual void InitializeForInput(InputType const& source) {
   }
 
+  //! true if InitializeForInput() keeps the sentence in thread-local storage.
+  //! Such a feature can only be evaluated on the thread that decodes the sentence,
+  //! so -search-threads decodes on that thread alone
+  virtual bool HasThreadLocalSentenceState() const {
+    return false;
+  }
+
   // clean up temporary memory, called after processing each sentence
   virtual void CleanUpAfterSentenceProcessing(const InputType& source) {
   }
@@ -67,6 +67,9 @@ public:
   void SetParameter(const std::string& key, const std::string& value);
 
   void InitializeForInput( Sentence const& in );
+  bool HasThreadLocalSentenceState() const {
+    return true;
+  }
 
   bool IsUseable(const FactorMask &mask) const;
 
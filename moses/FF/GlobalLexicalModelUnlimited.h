@@ -74,6 +74,9 @@ public:
   bool Load(const std::string &filePathSource, const std::string &filePathTarget);
 
   void InitializeForInput( Sentence const& in );
+  bool HasThreadLocalSentenceState() const {
+    return true;
+  }
 
   const FFState* EmptyHypothesisState(const InputType &) const {
     return new DummyState();
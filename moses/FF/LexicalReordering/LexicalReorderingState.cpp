@@ -1,6 +1,7 @@
 
 #include <vector>
 #include <string>
+#include <boost/functional/hash.hpp>
 
 #include "moses/FF/FFState.h"
 #include "moses/Hypothesis.h"
@@ -224,6 +225,14 @@ int PhraseBasedReorderingState::Compare(const FFState& o) const
   return 1;
 }
 
+size_t PhraseBasedReorderingState::hash() const
+{
+  // forward states also compare the previous scores, equal ones share the range
+  size_t ret = m_prevRange.GetStartPos();
+  boost::hash_combine(ret, m_prevRange.GetEndPos());
+  return ret;
+}
+
 LexicalReorderingState* PhraseBasedReorderingState::Expand(const TranslationOption& topt, const InputType& input,ScoreComponentCollection* scores) const
 {
   ReorderingType reoType;
@@ -318,6 +327,13 @@ int BidirectionalReorderingState::Compare(const FFState& o) const
     return m_forward->Compare(*other.m_forward);
 }
 
+size_t BidirectionalReorderingState::hash() const
+{
+  size_t ret = m_backward->hash();
+  boost::hash_combine(ret, m_forward->hash());
+  return ret;
+}
+
 LexicalReorderingState* BidirectionalReorderingState::Expand(const TranslationOption& topt, const InputType& input, ScoreComponentCollection* scores) const
 {
   LexicalReorderingState *newbwd = m_backward->Expand(topt,input, scores);
@@ -30,6 +30,9 @@ public:
    * calling hypo.GetPrevHypo().  If you need something from the "previous"
    * hypothesis, you should store it in an FFState object which will be passed
    * in as prev_state.  If you don't do this, you will get in trouble.
+   * With -search-threads, it is called concurrently for hypotheses of the
+   * same sentence, so it must not modify the feature function, or any cache
+   * it keeps, without locking.
    */
   virtual FFState* EvaluateWhenApplied(
     const Hypothesis& cur_hypo,
@@ -25,6 +25,8 @@ public:
 
   /**
     * This should be implemented for features that apply to phrase-based models.
+    * With -search-threads, it is called concurrently for hypotheses of the
+    * same sentence, see StatefulFeatureFunction::EvaluateWhenApplied.
     **/
   virtual void EvaluateWhenApplied(const Hypothesis& hypo,
                         ScoreComponentCollection* accumulator) const = 0;
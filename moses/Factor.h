@@ -31,7 +31,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 namespace Moses
 {
 
-struct FactorFriend;
 class FactorCollection;
 
 /** Represents a factor (word, POS, etc).
@@ -41,9 +40,8 @@ class Factor
 {
   friend std::ostream& operator<<(std::ostream&, const Factor&);
 
-  // only these classes are allowed to instantiate this class
+  // only this class is allowed to instantiate this class
   friend class FactorCollection;
-  friend struct FactorFriend;
 
   // FactorCollection writes here.
   // This is mutable so the pointer can be changed to pool-backed memory.
@@ -53,10 +51,8 @@ class Factor
   //! protected constructor. only friend class, FactorCollection, is allowed to create Factor objects
   Factor() {}
 
-  // Needed for STL containers.  They'll delegate through FactorFriend, which is never exposed publicly.
-  Factor(const Factor &factor) : m_string(factor.m_string), m_id(factor.m_id) {}
-
-  // Not implemented.  Shouldn't be called.
+  // Not implemented.  Factors are never copied.
+  Factor(const Factor &factor);
   Factor &operator=(const Factor &factor);
 
 public:
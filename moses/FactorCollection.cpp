@@ -20,13 +20,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <boost/version.hpp>
-#ifdef WITH_THREADS
-#include <boost/thread/locks.hpp>
-#endif
+#include <cstring>
+#include <new>
 #include <ostream>
 #include <string>
 #include "FactorCollection.h"
 #include "Util.h"
+#include "util/murmur_hash.hh"
 #include "util/pool.hh"
 
 using namespace std;
@@ -35,70 +35,127 @@ namespace Moses
 {
 FactorCollection FactorCollection::s_instance;
 
-const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+FactorCollection::Table::Table(size_t size)
+  : mask(size - 1)
+  , count(0)
+  , slots(new boost::atomic<const Factor*>[size])
 {
-  FactorFriend to_ins;
-  to_ins.in.m_string = factorString;
-  to_ins.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  // If we're threaded, hope a read-only lock is sufficient.
-#ifdef WITH_THREADS
-  {
-    // read=lock scope
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-    Set::const_iterator i = set.find(to_ins);
-    if (i != set.end()) return &i->in;
+  for (size_t i = 0; i < size; ++i) {
+    slots[i].store(NULL, boost::memory_order_relaxed);
   }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#endif // WITH_THREADS
-  std::pair<Set::iterator, bool> ret(set.insert(to_ins));
-  if (ret.second) {
-    ret.first->in.m_string.set(
-      memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
-      factorString.size());
-    if (isNonTerminal) {
-      m_factorIdNonTerminal++;
-      UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
-    } else {
-      m_factorId++;
+}
+
+FactorCollection::Table::~Table()
+{
+  delete [] slots;
+}
+
+FactorCollection::FactorCollection()
+  : m_terminals(new Table(1 << 16))
+  , m_nonTerminals(new Table(1 << 8))
+  , m_factorIdNonTerminal(0)
+  , m_factorId(moses_MaxNumNonterminals)
+{
+}
+
+size_t FactorCollection::Hash(const StringPiece &factorString)
+{
+  return util::MurmurHashNative(factorString.data(), factorString.size());
+}
+
+const Factor *FactorCollection::Find(const Table &table, const StringPiece &factorString, size_t hash)
+{
+  // the table is at most half full, so this ends at an empty slot
+  for (size_t i = hash & table.mask; ; i = (i + 1) & table.mask) {
+    const Factor *factor = table.slots[i].load(boost::memory_order_acquire);
+    if (factor == NULL || factor->m_string == factorString) {
+      return factor;
     }
   }
-  return &ret.first->in;
 }
 
-const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+void FactorCollection::Insert(Table &table, const Factor *factor, size_t hash)
 {
-  FactorFriend to_find;
-  to_find.in.m_string = factorString;
-  to_find.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  { // read=lock scope
+  size_t i = hash & table.mask;
+  while (table.slots[i].load(boost::memory_order_relaxed)) {
+    i = (i + 1) & table.mask;
+  }
+  // publish the fully constructed factor to lock-free readers
+  table.slots[i].store(factor, boost::memory_order_release);
+  table.count++;
+}
+
+const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  boost::atomic<Table*> &table = isNonTerminal ? m_nonTerminals : m_terminals;
+  size_t hash = Hash(factorString);
+  const Factor *ret = Find(*table.load(boost::memory_order_acquire), factorString, hash);
+  if (ret) return ret;
+
 #ifdef WITH_THREADS
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-#endif // WITH_THREADS
-    Set::const_iterator i = set.find(to_find);
-    if (i != set.end()) return &i->in;
+  boost::mutex::scoped_lock lock(m_insertLock);
+#endif
+  // somebody may have added it in the meantime
+  Table *current = table.load(boost::memory_order_relaxed);
+  ret = Find(*current, factorString, hash);
+  if (ret) return ret;
+
+  if (2 * (current->count + 1) > current->mask + 1) {
+    Table *bigger = new Table(2 * (current->mask + 1));
+    for (size_t i = 0; i <= current->mask; ++i) {
+      const Factor *factor = current->slots[i].load(boost::memory_order_relaxed);
+      if (factor) {
+        Insert(*bigger, factor, Hash(factor->m_string));
+      }
+    }
+    table.store(bigger, boost::memory_order_release);
+    m_retired.push_back(current);
+    current = bigger;
   }
-  return NULL;
+
+  Factor *factor = new (m_factor_backing.Allocate(sizeof(Factor))) Factor();
+  factor->m_string.set(
+    memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
+    factorString.size());
+  if (isNonTerminal) {
+    factor->m_id = m_factorIdNonTerminal++;
+    UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
+  } else {
+    factor->m_id = m_factorId++;
+  }
+  Insert(*current, factor, hash);
+  return factor;
 }
 
+const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  const Table &table = *(isNonTerminal ? m_nonTerminals : m_terminals).load(boost::memory_order_acquire);
+  return Find(table, factorString, Hash(factorString));
+}
 
-FactorCollection::~FactorCollection() {}
+
+FactorCollection::~FactorCollection()
+{
+  delete m_terminals.load();
+  delete m_nonTerminals.load();
+  for (size_t i = 0; i < m_retired.size(); ++i) {
+    delete m_retired[i];
+  }
+}
 
 TO_STRING_BODY(FactorCollection);
 
 // friend
 ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_accessLock);
-#endif
-  for (FactorCollection::Set::const_iterator i = factorCollection.m_set.begin(); i != factorCollection.m_set.end(); ++i) {
-    out << i->in;
+  const FactorCollection::Table &table = *factorCollection.m_terminals.load(boost::memory_order_acquire);
+  for (size_t i = 0; i <= table.mask; ++i) {
+    const Factor *factor = table.slots[i].load(boost::memory_order_acquire);
+    if (factor) {
+      out << *factor;
+    }
   }
   return out;
 }
 
 }
-
-
@@ -28,14 +28,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #endif
+#include <boost/atomic.hpp>
 
-#include "util/murmur_hash.hh"
-#include <boost/unordered_set.hpp>
-
-#include <functional>
 #include <string>
+#include <vector>
 
 #include "util/string_piece.hh"
 #include "util/pool.hh"
@@ -44,17 +42,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 namespace Moses
 {
 
-/** We don't want Factor to be copyable by anybody.  But we also want to store
- * it in an STL container.  The solution is that Factor's copy constructor is
- * private and friended to FactorFriend.  The STL containers can delegate
- * copying, so friending the container isn't sufficient.  STL containers see
- * FactorFriend's public copy constructor and everybody else sees Factor's
- * private copy constructor.
- */
-struct FactorFriend {
-  Factor in;
-};
-
 /** collection of factors
  *
  * All Factors in moses are accessed and created by a FactorCollection.
@@ -62,41 +49,48 @@ struct FactorFriend {
  * from being created on the stack, etc), their memory addresses can
  * be used as keys to uniquely identify them.
  * Only 1 FactorCollection object should be created.
+ *
+ * Factors are kept in open addressing hash tables whose slots are published
+ * atomically, so looking up an existing factor takes no lock. Only adding a
+ * new factor is serialised. A table that fills up is replaced by a larger
+ * one; the old one stays valid for readers still probing it, and is freed
+ * with the collection.
  */
 class FactorCollection
 {
   friend std::ostream& operator<<(std::ostream&, const FactorCollection&);
 
-  struct HashFactor : public std::unary_function<const FactorFriend &, std::size_t> {
-    std::size_t operator()(const FactorFriend &factor) const {
-      return util::MurmurHashNative(factor.in.m_string.data(), factor.in.m_string.size());
-    }
-  };
-  struct EqualsFactor : public std::binary_function<const FactorFriend &, const FactorFriend &, bool> {
-    bool operator()(const FactorFriend &left, const FactorFriend &right) const {
-      return left.in.GetString() == right.in.GetString();
-    }
+  struct Table {
+    explicit Table(size_t size);
+    ~Table();
+    size_t mask; /**< size - 1, size is a power of 2 */
+    size_t count; /**< factors in the table, only changed under m_insertLock */
+    boost::atomic<const Factor*> *slots; /**< NULL if empty */
   };
-  typedef boost::unordered_set<FactorFriend, HashFactor, EqualsFactor> Set;
-  Set m_set;
-  Set m_setNonTerminal;
+  boost::atomic<Table*> m_terminals;
+  boost::atomic<Table*> m_nonTerminals;
+  std::vector<Table*> m_retired; /**< replaced tables */
 
   util::Pool m_string_backing;
+  util::Pool m_factor_backing;
 
   static FactorCollection s_instance;
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  //! taken to add factors only
+  boost::mutex m_insertLock;
 #endif
 
   size_t m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
   size_t m_factorId; /**< unique, contiguous ids, starting from moses_MaxNumNonterminals, for each terminal factor */
 
   //! constructor. only the 1 static variable can be created
-  FactorCollection()
-    : m_factorIdNonTerminal(0)
-    , m_factorId(moses_MaxNumNonterminals) {
-  }
+  FactorCollection();
+
+  //! factor with this string, or NULL. Safe without any lock
+  static const Factor *Find(const Table &table, const StringPiece &factorString, size_t hash);
+  //! put a factor in an empty slot of the table
+  static void Insert(Table &table, const Factor *factor, size_t hash);
+  static size_t Hash(const StringPiece &factorString);
 
 public:
   static FactorCollection& Instance() {
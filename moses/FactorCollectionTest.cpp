@@ -0,0 +1,97 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+#include "FactorCollection.h"
+
+using namespace Moses;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(factor_collection)
+
+namespace
+{
+
+// adds the same words as every other thread, in a different order
+void AddWords(size_t offset, size_t numWords, vector<const Factor*> &factors)
+{
+  FactorCollection &collection = FactorCollection::Instance();
+  factors.resize(numWords);
+  for (size_t i = 0; i < numWords; ++i) {
+    size_t word = (i + offset) % numWords;
+    factors[word] = collection.AddFactor("fctest" + boost::lexical_cast<string>(word));
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(add_and_get)
+{
+  FactorCollection &collection = FactorCollection::Instance();
+  BOOST_CHECK(collection.GetFactor("fctest-unseen") == NULL);
+  const Factor *a = collection.AddFactor("fctest-a");
+  const Factor *x = collection.AddFactor("fctest-X", true);
+  BOOST_CHECK_EQUAL(a, collection.AddFactor("fctest-a"));
+  BOOST_CHECK_EQUAL(a, collection.GetFactor("fctest-a"));
+  BOOST_CHECK_EQUAL(a->GetString(), "fctest-a");
+  BOOST_CHECK(collection.GetFactor("fctest-X") == NULL);
+  BOOST_CHECK_EQUAL(x, collection.GetFactor("fctest-X", true));
+  BOOST_CHECK(x->GetId() < moses_MaxNumNonterminals);
+  BOOST_CHECK(a->GetId() >= moses_MaxNumNonterminals);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_add)
+{
+  // enough words to make the table grow while the threads are adding
+  const size_t numWords = 100000;
+  const size_t numThreads = 4;
+  vector<vector<const Factor*> > factors(numThreads);
+#ifdef WITH_THREADS
+  boost::thread_group threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.create_thread(boost::bind(&AddWords, t * numWords / numThreads, numWords, boost::ref(factors[t])));
+  }
+  threads.join_all();
+#else
+  for (size_t t = 0; t < numThreads; ++t) {
+    AddWords(t * numWords / numThreads, numWords, factors[t]);
+  }
+#endif
+
+  set<size_t> ids;
+  for (size_t i = 0; i < numWords; ++i) {
+    for (size_t t = 1; t < numThreads; ++t) {
+      BOOST_REQUIRE_EQUAL(factors[t][i], factors[0][i]);
+    }
+    BOOST_CHECK_EQUAL(factors[0][i]->GetString(), "fctest" + boost::lexical_cast<string>(i));
+    ids.insert(factors[0][i]->GetId());
+  }
+  BOOST_CHECK_EQUAL(ids.size(), numWords);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
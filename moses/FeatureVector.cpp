@@ -163,11 +163,39 @@ bool FName::operator!=(const FName& rhs) const
   return ! (*this == rhs);
 }
 
-FVector::FVector(size_t coreFeatures) : m_coreFeatures(coreFeatures) {}
+FVector::FNVmap FVector::s_noFeatures;
+
+FVector::FVector(size_t coreFeatures) : m_features(NULL), m_coreFeatures(coreFeatures) {}
+
+FVector::FVector(const FVector& rhs)
+  : m_features(rhs.m_features ? new FNVmap(*rhs.m_features) : NULL)
+  , m_coreFeatures(rhs.m_coreFeatures) {}
+
+FVector::~FVector()
+{
+  delete m_features;
+}
+
+FVector& FVector::operator=( const FVector& rhs )
+{
+  if (this == &rhs) return *this;
+  if (rhs.m_features) {
+    if (m_features) {
+      *m_features = *rhs.m_features;
+    } else {
+      m_features = new FNVmap(*rhs.m_features);
+    }
+  } else {
+    delete m_features;
+    m_features = NULL;
+  }
+  m_coreFeatures = rhs.m_coreFeatures;
+  return *this;
+}
 
 void FVector::resize(size_t newsize)
 {
-  valarray<FValue> oldValues(m_coreFeatures);
+  FDenseVector oldValues(m_coreFeatures);
   m_coreFeatures.resize(newsize);
   for (size_t i = 0; i < min(m_coreFeatures.size(), oldValues.size()); ++i) {
     m_coreFeatures[i] = oldValues[i];
@@ -177,7 +205,8 @@ void FVector::resize(size_t newsize)
 void FVector::clear()
 {
   m_coreFeatures.resize(0);
-  m_features.clear();
+  delete m_features;
+  m_features = NULL;
 }
 
 bool FVector::load(const std::string& filename)
@@ -306,8 +335,11 @@ ostream& operator<<(ostream& out, const FVector& fv)
 const FValue& FVector::get(const FName& name) const
 {
   static const FValue DEFAULT = 0;
-  const_iterator fi = m_features.find(name);
-  if (fi == m_features.end()) {
+  if (!m_features) {
+    return DEFAULT;
+  }
+  const_iterator fi = m_features->find(name);
+  if (fi == m_features->end()) {
     return DEFAULT;
   } else {
     return fi->second;
@@ -316,8 +348,11 @@ const FValue& FVector::get(const FName& name) const
 
 FValue FVector::getBackoff(const FName& name, float backoff) const
 {
-  const_iterator fi = m_features.find(name);
-  if (fi == m_features.end()) {
+  if (!m_features) {
+    return backoff;
+  }
+  const_iterator fi = m_features->find(name);
+  if (fi == m_features->end()) {
     return backoff;
   } else {
     return fi->second;
@@ -352,7 +387,15 @@ void FVector::capMin(FValue minValue)
 
 void FVector::set(const FName& name, const FValue& value)
 {
-  m_features[name] = value;
+  getRef(name) = value;
+}
+
+FValue& FVector::getRef(const FName& name)
+{
+  if (!m_features) {
+    m_features = new FNVmap();
+  }
+  return (*m_features)[name];
 }
 
 void FVector::printCoreFeatures()
@@ -443,7 +486,7 @@ size_t FVector::pruneSparseFeatures(size_t threshold)
   }
 
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    m_features->erase(toErase[i]);
 
   return count;
 }
@@ -463,7 +506,7 @@ size_t FVector::pruneZeroWeightFeatures()
   }
 
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    m_features->erase(toErase[i]);
 
   return count;
 }
@@ -718,7 +761,7 @@ size_t FVector::l1regularize(float lambda)
 
   // erase features that have become zero
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    m_features->erase(toErase[i]);
   numberPruned -= size();
   return numberPruned;
 }
@@ -768,7 +811,7 @@ size_t FVector::sparseL1regularize(float lambda)
 
   // erase features that have become zero
   for (size_t i = 0; i < toErase.size(); ++i)
-    m_features.erase(toErase[i]);
+    m_features->erase(toErase[i]);
   numberPruned -= size();
   return numberPruned;
 }
@@ -822,10 +865,10 @@ void FVector::merge(const FVector &other)
 
   // sparse
   FNVmap::const_iterator iter;
-  for (iter = other.m_features.begin(); iter != other.m_features.end(); ++iter) {
+  for (iter = other.cbegin(); iter != other.cend(); ++iter) {
     const FName  &otherKey = iter->first;
     const FValue otherVal = iter->second;
-    m_features[otherKey] = otherVal;
+    set(otherKey, otherVal);
   }
 }
 
@@ -22,11 +22,11 @@
 #ifndef FEATUREVECTOR_H
 #define FEATUREVECTOR_H
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <sstream>
 #include <string>
-#include <valarray>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -37,7 +37,6 @@
 #include <boost/serialization/split_member.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
-#include <boost/serialization/valarray.hpp>
 #endif
 
 #ifdef WITH_THREADS
@@ -121,20 +120,119 @@ struct FNameHash
 
 class ProxyFVector;
 
+#ifndef FVECTOR_INLINE_CORE
+#define FVECTOR_INLINE_CORE 32
+#endif
+
+/**
+ * The core (dense) values of an FVector. Up to FVECTOR_INLINE_CORE values
+ * are kept inside the object, so that the scores of a hypothesis or
+ * translation option can be copied without going to the heap.
+ **/
+class FDenseVector
+{
+public:
+  explicit FDenseVector(size_t size = 0)
+    : m_size(0), m_capacity(FVECTOR_INLINE_CORE), m_values(m_inline) {
+    resize(size);
+  }
+  FDenseVector(const FDenseVector &rhs)
+    : m_size(0), m_capacity(FVECTOR_INLINE_CORE), m_values(m_inline) {
+    *this = rhs;
+  }
+  ~FDenseVector() {
+    if (m_values != m_inline) delete [] m_values;
+  }
+
+  FDenseVector &operator=(const FDenseVector &rhs) {
+    if (this != &rhs) {
+      reserve(rhs.m_size);
+      m_size = rhs.m_size;
+      std::copy(rhs.m_values, rhs.m_values + m_size, m_values);
+    }
+    return *this;
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+  FValue &operator[](size_t i) {
+    return m_values[i];
+  }
+  FValue operator[](size_t i) const {
+    return m_values[i];
+  }
+  const FValue *data() const {
+    return m_values;
+  }
+
+  //! as std::valarray::resize, all values are 0 afterwards
+  void resize(size_t size) {
+    reserve(size);
+    m_size = size;
+    std::fill(m_values, m_values + m_size, FValue(0));
+  }
+
+  FValue sum() const {
+    FValue ret = 0;
+    for (size_t i = 0; i < m_size; ++i) ret += m_values[i];
+    return ret;
+  }
+  FDenseVector &operator*=(FValue rhs) {
+    for (size_t i = 0; i < m_size; ++i) m_values[i] *= rhs;
+    return *this;
+  }
+  FDenseVector &operator/=(FValue rhs) {
+    for (size_t i = 0; i < m_size; ++i) m_values[i] /= rhs;
+    return *this;
+  }
+
+  friend void swap(FDenseVector &first, FDenseVector &second);
+
+private:
+  //! make room for size values; the current ones are not kept
+  void reserve(size_t size) {
+    if (size > m_capacity) {
+      if (m_values != m_inline) delete [] m_values;
+      m_values = new FValue[size];
+      m_capacity = size;
+    }
+  }
+
+  size_t m_size, m_capacity;
+  FValue *m_values; /**< m_inline, or on the heap if that is too small */
+  FValue m_inline[FVECTOR_INLINE_CORE];
+};
+
+inline void swap(FDenseVector &first, FDenseVector &second)
+{
+  if (first.m_values != first.m_inline && second.m_values != second.m_inline) {
+    std::swap(first.m_values, second.m_values);
+    std::swap(first.m_size, second.m_size);
+    std::swap(first.m_capacity, second.m_capacity);
+  } else {
+    FDenseVector tmp(first);
+    first = second;
+    second = tmp;
+  }
+}
+
 /**
  * A sparse feature (or weight) vector.
+ *
+ * Core features are held in an FDenseVector. The map of sparse features is
+ * only allocated once a sparse value is set, so vectors of purely dense
+ * models never touch it.
  **/
 class FVector
 {
 public:
   /** Empty feature vector */
   FVector(size_t coreFeatures = 0);
+  FVector(const FVector& rhs);
+  ~FVector();
 
-  FVector& operator=( const FVector& rhs ) {
-    m_features = rhs.m_features;
-    m_coreFeatures = rhs.m_coreFeatures;
-    return *this;
-  }
+  FVector& operator=( const FVector& rhs );
 
   /*
    * Change the number of core features
@@ -146,20 +244,20 @@ public:
   typedef FNVmap::iterator iterator;
   typedef FNVmap::const_iterator const_iterator;
   iterator begin() {
-    return m_features.begin();
+    return m_features ? m_features->begin() : s_noFeatures.begin();
   }
   iterator end() {
-    return m_features.end();
+    return m_features ? m_features->end() : s_noFeatures.end();
   }
   const_iterator cbegin() const {
-    return m_features.cbegin();
+    return m_features ? m_features->cbegin() : s_noFeatures.cbegin();
   }
   const_iterator cend() const {
-    return m_features.cend();
+    return m_features ? m_features->cend() : s_noFeatures.cend();
   }
 
   bool hasNonDefaultValue(FName name) const {
-    return m_features.find(name) != m_features.end();
+    return m_features && m_features->find(name) != m_features->end();
   }
   void clear();
 
@@ -177,14 +275,14 @@ public:
 
   /** Size */
   size_t size() const {
-    return m_features.size() + m_coreFeatures.size();
+    return (m_features ? m_features->size() : 0) + m_coreFeatures.size();
   }
 
   size_t coreSize() const {
     return m_coreFeatures.size();
   }
 
-  const std::valarray<FValue> &getCoreFeatures() const {
+  const FDenseVector &getCoreFeatures() const {
     return m_coreFeatures;
   }
 
@@ -270,9 +368,12 @@ private:
   const FValue& get(const FName& name) const;
   FValue getBackoff(const FName& name, float backoff) const;
   void set(const FName& name, const FValue& value);
+  //! reference to the sparse value, inserting it if needed
+  FValue& getRef(const FName& name);
 
-  FNVmap m_features;
-  std::valarray<FValue> m_coreFeatures;
+  FNVmap *m_features; /**< sparse features, NULL until one is set */
+  FDenseVector m_coreFeatures;
+  static FNVmap s_noFeatures; /**< iterated over instead of a NULL m_features */
 
 #ifdef MPI_ENABLE
   //serialization
@@ -286,9 +387,10 @@ private:
       names.push_back(ostr.str());
       values.push_back(i->second);
     }
+    std::vector<FValue> core(m_coreFeatures.data(), m_coreFeatures.data() + m_coreFeatures.size());
     ar << names;
     ar << values;
-    ar << m_coreFeatures;
+    ar << core;
   }
 
   template<class Archive>
@@ -296,9 +398,14 @@ private:
     clear();
     std::vector<std::string> names;
     std::vector<FValue> values;
+    std::vector<FValue> core;
     ar >> names;
     ar >> values;
-    ar >> m_coreFeatures;
+    ar >> core;
+    m_coreFeatures.resize(core.size());
+    for (size_t i = 0; i < core.size(); ++i) {
+      m_coreFeatures[i] = core[i];
+    }
     UTIL_THROW_IF2(names.size() != values.size(), "Error");
     for (size_t i = 0; i < names.size(); ++i) {
       set(FName(names[i]), values[i]);
@@ -313,7 +420,7 @@ private:
 
 inline void swap(FVector &first, FVector &second)
 {
-  swap(first.m_features, second.m_features);
+  std::swap(first.m_features, second.m_features);
   swap(first.m_coreFeatures, second.m_coreFeatures);
 }
 
@@ -366,15 +473,15 @@ public:
    }*/
 
   FValue operator++() {
-    return ++m_fv->m_features[m_name];
+    return ++m_fv->getRef(m_name);
   }
 
   FValue operator +=(FValue lhs) {
-    return (m_fv->m_features[m_name] += lhs);
+    return (m_fv->getRef(m_name) += lhs);
   }
 
   FValue operator -=(FValue lhs) {
-    return (m_fv->m_features[m_name] -= lhs);
+    return (m_fv->getRef(m_name) -= lhs);
   }
 
 private:
@@ -306,6 +306,37 @@ BOOST_AUTO_TEST_CASE(ip)
   BOOST_CHECK_CLOSE((FValue)p1, 1.1*0.5 + -0.1*0.25 + 2.2*2.4, TOL);
 }
 
+BOOST_AUTO_TEST_CASE(copy_dense_and_sparse)
+{
+  // more core features than fit inline
+  const size_t size = FVECTOR_INLINE_CORE + 5;
+  FVector f1(size);
+  for (size_t i = 0; i < size; ++i) f1[i] = i;
+  FVector f2(f1);
+  BOOST_CHECK_EQUAL(f2.size(), size);
+  BOOST_CHECK(f2.cbegin() == f2.cend());
+  BOOST_CHECK_CLOSE((FValue)f2[size-1], size-1, TOL);
+
+  FName n1("a");
+  f2[n1] = 2;
+  f1 = f2;
+  f2[n1] += 1;
+  BOOST_CHECK_CLOSE((FValue)f1[n1], 2, TOL);
+  BOOST_CHECK_CLOSE((FValue)f2[n1], 3, TOL);
+
+  FVector f3(2);
+  f3[1] = 4;
+  f1 = f3;
+  BOOST_CHECK_EQUAL(f1.size(), 2);
+  BOOST_CHECK(!f1.hasNonDefaultValue(n1));
+  f1.resize(size);
+  BOOST_CHECK_CLOSE((FValue)f1[1], 4, TOL);
+  BOOST_CHECK_CLOSE((FValue)f1[size-1], 0, TOL);
+  swap(f1, f2);
+  BOOST_CHECK_CLOSE((FValue)f1[n1], 3, TOL);
+  BOOST_CHECK_CLOSE((FValue)f2[1], 4, TOL);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
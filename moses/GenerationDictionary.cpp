@@ -19,8 +19,11 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <string>
+#include <boost/filesystem.hpp>
 #include "GenerationDictionary.h"
 #include "FactorCollection.h"
 #include "Word.h"
@@ -29,15 +32,54 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "StaticData.h"
 #include "UserMessage.h"
 #include "util/exception.hh"
+#include "util/file.hh"
+#include "util/murmur_hash.hh"
 
 using namespace std;
 
 namespace Moses
 {
+
+namespace
+{
+// Layout of the binary image, all numbers in native byte order:
+//   header      magic, number of source words, number of scores per entry (uint64_t)
+//   index       hash of source and offset of its entry, sorted by hash (uint64_t pairs)
+//   entries     per source word: source, number of targets (uint32_t), then
+//               per target: target, scores (float)
+// where strings are their length (uint32_t) and bytes, factors separated by '|'.
+const uint64_t kGenerationImageMagic = 0x3130676d496e6547ULL; // "GenImg01" on little endian
+const size_t kGenerationImageHeader = 3;
+
+uint64_t HashSource(const std::string &source)
+{
+  return util::MurmurHashNative(source.data(), source.size());
+}
+
+uint32_t ReadUint32(const char *&pos)
+{
+  uint32_t ret;
+  memcpy(&ret, pos, sizeof(ret));
+  pos += sizeof(ret);
+  return ret;
+}
+
+void WriteString(std::ostream &out, const std::string &str)
+{
+  uint32_t size = str.size();
+  out.write((const char*)&size, sizeof(size));
+  out.write(str.data(), size);
+}
+}
+
 std::vector<GenerationDictionary*> GenerationDictionary::s_staticColl;
 
 GenerationDictionary::GenerationDictionary(const std::string &line)
   : DecodeFeature(line)
+  , m_imageIndex(NULL)
+  , m_imageEntries(NULL)
+  , m_imageNumSources(0)
+  , m_imageNumScores(0)
 {
   s_staticColl.push_back(this);
 
@@ -45,6 +87,22 @@ GenerationDictionary::GenerationDictionary(const std::string &line)
 }
 
 void GenerationDictionary::Load()
+{
+  std::string imagePath = m_filePath + ".bingen";
+  if (!FileExists(imagePath)) {
+    LoadText();
+  } else if (FileExists(m_filePath)
+             && boost::filesystem::last_write_time(imagePath) < boost::filesystem::last_write_time(m_filePath)) {
+    // made from an earlier version of the table
+    std::cerr << "Warning: " << imagePath << " is older than " << m_filePath
+              << ", loading the text table. Recreate the image with processGenerationTable" << std::endl;
+    LoadText();
+  } else {
+    LoadImage(imagePath);
+  }
+}
+
+void GenerationDictionary::LoadText()
 {
   FactorCollection &factorCollection = FactorCollection::Instance();
 
@@ -107,16 +165,120 @@ void GenerationDictionary::Load()
   inFile.Close();
 }
 
+void GenerationDictionary::LoadImage(const std::string &imagePath)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(imagePath.c_str()));
+  uint64_t fileSize = util::SizeFile(fd.get());
+  UTIL_THROW_IF2(fileSize == util::kBadSize || fileSize < kGenerationImageHeader * sizeof(uint64_t),
+                 imagePath << " is not a binary generation table");
+
+  // lazily, so that pages are only read when looked up, and shared with other processes
+  util::MapRead(util::LAZY, fd.get(), 0, fileSize, m_image);
+  const uint64_t *header = static_cast<const uint64_t*>(m_image.get());
+  UTIL_THROW_IF2(header[0] != kGenerationImageMagic, imagePath << " is not a binary generation table");
+  m_imageNumSources = header[1];
+  m_imageNumScores = header[2];
+  UTIL_THROW_IF2(m_imageNumScores < GetNumScoreComponents(), imagePath << ": expected "
+                 << GetNumScoreComponents() << " feature values, but found " << m_imageNumScores);
+  uint64_t entriesStart = (kGenerationImageHeader + 2 * m_imageNumSources) * sizeof(uint64_t);
+  UTIL_THROW_IF2(entriesStart > fileSize, imagePath << " is truncated");
+
+  m_imageIndex = header + kGenerationImageHeader;
+  m_imageEntries = static_cast<const char*>(m_image.get()) + entriesStart;
+  m_imageDecoded.reset(new boost::atomic<const OutputWordCollection*>[m_imageNumSources]);
+  for (uint64_t i = 0; i < m_imageNumSources; ++i) {
+    m_imageDecoded[i].store(NULL, boost::memory_order_relaxed);
+  }
+}
+
+bool GenerationDictionary::CreateImage(std::istream &inFile, const std::string &outFilePath)
+{
+  typedef std::vector<std::pair<std::string, std::vector<float> > > Targets;
+  std::map<std::string, Targets> table;
+  size_t numScores = 0;
+
+  string line;
+  size_t lineNum = 0;
+  while(getline(inFile, line)) {
+    ++lineNum;
+    vector<string> token = Tokenize( line );
+    if (token.size() < 2) {
+      std::cerr << "line " << lineNum << ": expected source, target and scores" << std::endl;
+      return false;
+    }
+    if (lineNum == 1) {
+      numScores = token.size() - 2;
+    } else if (token.size() - 2 < numScores) {
+      std::cerr << "line " << lineNum << ": expected " << numScores << " feature values, but found "
+                << token.size() - 2 << std::endl;
+      return false;
+    }
+    std::vector<float> scores(numScores);
+    for (size_t i = 0; i < numScores; i++) {
+      scores[i] = FloorScore(TransformScore(Scan<float>(token[2+i])));
+    }
+    table[token[0]].push_back(std::make_pair(token[1], scores));
+  }
+
+  std::vector<std::pair<uint64_t, const std::string*> > sources;
+  for (std::map<std::string, Targets>::const_iterator iter = table.begin(); iter != table.end(); ++iter) {
+    sources.push_back(std::make_pair(HashSource(iter->first), &iter->first));
+  }
+  std::sort(sources.begin(), sources.end());
+
+  std::string imagePath = outFilePath + ".bingen";
+  std::ofstream out(imagePath.c_str(), std::ios::binary);
+  uint64_t header[kGenerationImageHeader] = {kGenerationImageMagic, sources.size(), numScores};
+  out.write((const char*)header, sizeof(header));
+
+  // index, then the entries in the same order
+  uint64_t offset = 0;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    uint64_t entry[2] = {sources[i].first, offset};
+    out.write((const char*)entry, sizeof(entry));
+    const Targets &targets = table[*sources[i].second];
+    offset += sizeof(uint32_t) + sources[i].second->size() + sizeof(uint32_t);
+    for (size_t j = 0; j < targets.size(); ++j) {
+      offset += sizeof(uint32_t) + targets[j].first.size() + numScores * sizeof(float);
+    }
+  }
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const Targets &targets = table[*sources[i].second];
+    WriteString(out, *sources[i].second);
+    uint32_t numTargets = targets.size();
+    out.write((const char*)&numTargets, sizeof(numTargets));
+    for (size_t j = 0; j < targets.size(); ++j) {
+      WriteString(out, targets[j].first);
+      if (numScores > 0) {
+        out.write((const char*)&targets[j].second[0], numScores * sizeof(float));
+      }
+    }
+  }
+  out.close();
+  if (!out) {
+    std::cerr << "Failed to write " << imagePath << std::endl;
+    return false;
+  }
+  return true;
+}
+
 GenerationDictionary::~GenerationDictionary()
 {
   Collection::const_iterator iter;
   for (iter = m_collection.begin() ; iter != m_collection.end() ; ++iter) {
     delete iter->first;
   }
+  for (uint64_t i = 0; m_imageDecoded && i < m_imageNumSources; ++i) {
+    delete m_imageDecoded[i].load(boost::memory_order_relaxed);
+  }
 }
 
 const OutputWordCollection *GenerationDictionary::FindWord(const Word &word) const
 {
+  if (m_imageIndex) {
+    return FindWordInImage(word);
+  }
+
   const OutputWordCollection *ret;
 
   Collection::const_iterator iter = m_collection.find(&word);
@@ -129,6 +291,70 @@ const OutputWordCollection *GenerationDictionary::FindWord(const Word &word) con
   return ret;
 }
 
+const OutputWordCollection *GenerationDictionary::FindWordInImage(const Word &word) const
+{
+  std::string source;
+  for (size_t i = 0 ; i < GetInput().size() ; i++) {
+    if (i > 0) {
+      source += '|';
+    }
+    source += word.GetFactor(GetInput()[i])->GetString().as_string();
+  }
+
+  // the index is pairs of hash and offset: search it as pairs
+  uint64_t hash = HashSource(source);
+  const std::pair<uint64_t, uint64_t> *index = reinterpret_cast<const std::pair<uint64_t, uint64_t>*>(m_imageIndex);
+  const std::pair<uint64_t, uint64_t> *found = std::lower_bound(index, index + m_imageNumSources,
+      std::make_pair(hash, uint64_t(0)));
+  for (; found != index + m_imageNumSources && found->first == hash; ++found) {
+    const char *pos = m_imageEntries + found->second;
+    uint32_t size = ReadUint32(pos);
+    if (source.compare(0, std::string::npos, pos, size) != 0) {
+      // hash collision
+      continue;
+    }
+    pos += size;
+
+    boost::atomic<const OutputWordCollection*> &decoded = m_imageDecoded[found - index];
+    const OutputWordCollection *ret = decoded.load(boost::memory_order_acquire);
+    if (ret) {
+      return ret;
+    }
+
+    FactorCollection &factorCollection = FactorCollection::Instance();
+    const size_t numFeatureValuesInConfig = GetNumScoreComponents();
+    OutputWordCollection *outputWords = new OutputWordCollection(); // deleted in destructor
+
+    uint32_t numTargets = ReadUint32(pos);
+    for (uint32_t t = 0; t < numTargets; ++t) {
+      size = ReadUint32(pos);
+      vector<string> factorString = Tokenize(std::string(pos, size), "|");
+      pos += size;
+
+      Word outputWord;
+      for (size_t i = 0 ; i < GetOutput().size() ; i++) {
+        FactorType factorType = GetOutput()[i];
+        const Factor *factor = factorCollection.AddFactor( Output, factorType, factorString[i]);
+        outputWord.SetFactor(factorType, factor);
+      }
+      std::vector<float> scores(numFeatureValuesInConfig);
+      for (size_t i = 0; i < numFeatureValuesInConfig; i++) {
+        memcpy(&scores[i], pos + i * sizeof(float), sizeof(float));
+      }
+      pos += m_imageNumScores * sizeof(float);
+      (*outputWords)[outputWord].Assign(this, scores);
+    }
+
+    // another thread may have decoded the same entry meanwhile: keep the first
+    if (!decoded.compare_exchange_strong(ret, outputWords, boost::memory_order_acq_rel, boost::memory_order_acquire)) {
+      delete outputWords;
+      return ret;
+    }
+    return outputWords;
+  }
+  return NULL;
+}
+
 void GenerationDictionary::SetParameter(const std::string& key, const std::string& value)
 {
   if (key == "path") {
@@ -22,10 +22,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_GenerationDictionary_h
 #define moses_GenerationDictionary_h
 
+#include <iostream>
 #include <list>
 #include <map>
 #include <stdexcept>
 #include <vector>
+#include <stdint.h>
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include "util/mmap.hh"
 #include "ScoreComponentCollection.h"
 #include "Phrase.h"
 #include "TypeDef.h"
@@ -41,6 +46,12 @@ typedef std::map < Word , ScoreComponentCollection > OutputWordCollection;
 // 2nd = log probability (score)
 
 /** Implementation of a generation table in a trie.
+ *
+ * If there is a binary image of the table (path + ".bingen", see
+ * CreateImage()), it is memory mapped instead of loaded. The pages of the
+ * image are shared by all processes using it, e.g. when it is kept in
+ * /dev/shm, and only the entries of words actually looked up are decoded.
+ * An image older than the text table at path is ignored.
  */
 class GenerationDictionary : public DecodeFeature
 {
@@ -48,11 +59,25 @@ class GenerationDictionary : public DecodeFeature
 protected:
   static std::vector<GenerationDictionary*> s_staticColl;
 
+  // all entries if loaded from text
   Collection m_collection;
   // 1st = source
   // 2nd = target
   std::string						m_filePath;
 
+  // the mapped image, if any
+  util::scoped_memory m_image;
+  const uint64_t *m_imageIndex; /**< hash of source and offset of its entry, by hash */
+  const char *m_imageEntries;
+  uint64_t m_imageNumSources, m_imageNumScores;
+  /** entries decoded so far, by position in the index, NULL if not yet.
+   *  Set once, so that looking up a decoded entry takes no lock */
+  boost::scoped_array<boost::atomic<const OutputWordCollection*> > m_imageDecoded;
+
+  void LoadText();
+  void LoadImage(const std::string &imagePath);
+  const OutputWordCollection *FindWordInImage(const Word &word) const;
+
 public:
   static const std::vector<GenerationDictionary*>& GetColl() {
     return s_staticColl;
@@ -68,7 +93,7 @@ public:
   * NOT the number of lines in the generation table
   */
   size_t GetSize() const {
-    return m_collection.size();
+    return m_imageIndex ? m_imageNumSources : m_collection.size();
   }
   /** returns a bag of output words, OutputWordCollection, for a particular input word.
   *	Or NULL if the input word isn't found. The search function used is the WordComparer functor
@@ -76,6 +101,11 @@ public:
   const OutputWordCollection *FindWord(const Word &word) const;
   void SetParameter(const std::string& key, const std::string& value);
 
+  /** write the binary image of a generation table in text format to
+   *  outFilePath + ".bingen"
+   */
+  static bool CreateImage(std::istream &inFile, const std::string &outFilePath);
+
 };
 
 
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <limits>
 #include <vector>
 #include <algorithm>
+#include <boost/functional/hash.hpp>
 
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
@@ -42,10 +43,6 @@ using namespace std;
 namespace Moses
 {
 
-#ifdef USE_HYPO_POOL
-ObjectPool<Hypothesis> Hypothesis::s_objectPool("Hypothesis", 300000);
-#endif
-
 Hypothesis::Hypothesis(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt)
   : m_prevHypo(NULL)
   , m_sourceCompleted(source.GetSize(), manager.GetSource().m_sourceCompleted)
@@ -114,13 +111,16 @@ Hypothesis::~Hypothesis()
     for (iter = m_arcList->begin() ; iter != m_arcList->end() ; ++iter) {
       FREEHYPO(*iter);
     }
-    m_arcList->clear();
-
-    delete m_arcList;
+    m_manager.GetHypothesisArena().FreeArcList(m_arcList);
     m_arcList = NULL;
   }
 }
 
+void Hypothesis::Free(Hypothesis *hypo)
+{
+  hypo->m_manager.GetHypothesisArena().Free(hypo);
+}
+
 void Hypothesis::AddArc(Hypothesis *loserHypo)
 {
   if (!m_arcList) {
@@ -128,7 +128,7 @@ void Hypothesis::AddArc(Hypothesis *loserHypo)
       this->m_arcList = loserHypo->m_arcList;  // take ownership, we'll delete
       loserHypo->m_arcList = 0;                // prevent a double deletion
     } else {
-      this->m_arcList = new ArcList();
+      this->m_arcList = m_manager.GetHypothesisArena().AllocateArcList();
     }
   } else {
     if (loserHypo->m_arcList) {  // both have an arc list: merge. delete loser
@@ -136,7 +136,7 @@ void Hypothesis::AddArc(Hypothesis *loserHypo)
       size_t add_size = loserHypo->m_arcList->size();
       this->m_arcList->resize(my_size + add_size, 0);
       std::memcpy(&(*m_arcList)[0] + my_size, &(*loserHypo->m_arcList)[0], add_size * sizeof(Hypothesis *));
-      delete loserHypo->m_arcList;
+      m_manager.GetHypothesisArena().FreeArcList(loserHypo->m_arcList);
       loserHypo->m_arcList = 0;
     } else { // loserHypo doesn't have any arcs
       // DO NOTHING
@@ -158,13 +158,14 @@ Hypothesis* Hypothesis::CreateNext(const TranslationOption &transOpt) const
  */
 Hypothesis* Hypothesis::Create(const Hypothesis &prevHypo, const TranslationOption &transOpt)
 {
-
-#ifdef USE_HYPO_POOL
-  Hypothesis *ptr = s_objectPool.getPtr();
-  return new(ptr) Hypothesis(prevHypo, transOpt);
-#else
-  return new Hypothesis(prevHypo, transOpt);
-#endif
+  HypothesisArena &arena = prevHypo.GetManager().GetHypothesisArena();
+  void *ptr = arena.Allocate();
+  try {
+    return new(ptr) Hypothesis(prevHypo, transOpt);
+  } catch (...) {
+    arena.Release(ptr);
+    throw;
+  }
 }
 /***
  * return the subclass of Hypothesis most appropriate to the given target phrase
@@ -172,12 +173,14 @@ Hypothesis* Hypothesis::Create(const Hypothesis &prevHypo, const TranslationOpti
 
 Hypothesis* Hypothesis::Create(Manager& manager, InputType const& m_source, const TranslationOption &initialTransOpt)
 {
-#ifdef USE_HYPO_POOL
-  Hypothesis *ptr = s_objectPool.getPtr();
-  return new(ptr) Hypothesis(manager, m_source, initialTransOpt);
-#else
-  return new Hypothesis(manager, m_source, initialTransOpt);
-#endif
+  HypothesisArena &arena = manager.GetHypothesisArena();
+  void *ptr = arena.Allocate();
+  try {
+    return new(ptr) Hypothesis(manager, m_source, initialTransOpt);
+  } catch (...) {
+    arena.Release(ptr);
+    throw;
+  }
 }
 
 /** check, if two hypothesis can be recombined.
@@ -206,6 +209,15 @@ int Hypothesis::RecombineCompare(const Hypothesis &compare) const
   return 0;
 }
 
+size_t Hypothesis::GetRecombinationHash() const
+{
+  size_t seed = m_sourceCompleted.hash();
+  for (unsigned i = 0; i < m_ffStates.size(); ++i) {
+    boost::hash_combine(seed, m_ffStates[i] ? m_ffStates[i]->hash() : 0);
+  }
+  return seed;
+}
+
 void Hypothesis::EvaluateWhenApplied(const StatefulFeatureFunction &sfff,
                               int state_idx)
 {
@@ -332,8 +344,9 @@ void Hypothesis::CleanupArcList()
    * so we'll keep all of arc list if nedd distinct n-best list
    */
   const StaticData &staticData = StaticData::Instance();
-  size_t nBestSize = staticData.GetNBestSize();
-  bool distinctNBest = staticData.GetDistinctNBest() || staticData.GetLatticeSamplesSize() ||  staticData.UseMBR() || staticData.GetOutputSearchGraph() || staticData.GetOutputSearchGraphSLF() || staticData.GetOutputSearchGraphHypergraph() || staticData.UseLatticeMBR() ;
+  const DecodingOptions &options = m_manager.GetOptions();
+  size_t nBestSize = options.nBestSize;
+  bool distinctNBest = staticData.GetDistinctNBest() || staticData.GetLatticeSamplesSize() ||  staticData.UseMBR() || options.outputSearchGraph || staticData.GetOutputSearchGraphSLF() || staticData.GetOutputSearchGraphHypergraph() || staticData.UseLatticeMBR() ;
 
   if (!distinctNBest && m_arcList->size() > nBestSize * 5) {
     // prune arc list only if there too many arcs
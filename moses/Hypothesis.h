@@ -37,7 +37,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "GenerationDictionary.h"
 #include "ScoreComponentCollection.h"
 #include "InputType.h"
-#include "ObjectPool.h"
 
 namespace Moses
 {
@@ -67,8 +66,6 @@ class Hypothesis
   friend std::ostream& operator<<(std::ostream&, const Hypothesis&);
 
 protected:
-  static ObjectPool<Hypothesis> s_objectPool;
-
   const Hypothesis* m_prevHypo; /*! backpointer to previous hypothesis (from which this one was created) */
 //	const Phrase			&m_targetPhrase; /*! target phrase being created at the current decoding step */
   WordsBitmap				m_sourceCompleted; /*! keeps track of which words have been translated so far */
@@ -97,12 +94,11 @@ protected:
   Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt);
 
 public:
-  static ObjectPool<Hypothesis> &GetObjectPool() {
-    return s_objectPool;
-  }
-
   ~Hypothesis();
 
+  /** give the hypothesis back to the arena of its Manager. Use FREEHYPO */
+  static void Free(Hypothesis *hypo);
+
   /** return the subclass of Hypothesis most appropriate to the given translation option */
   static Hypothesis* Create(const Hypothesis &prevHypo, const TranslationOption &transOpt);
 
@@ -147,6 +143,10 @@ public:
   int GetId()const {
     return m_id;
   }
+  //! renumber, for hypotheses that were created out of order by parallel search
+  void SetId(int id) {
+    m_id = id;
+  }
 
   const Hypothesis* GetPrevHypo() const;
 
@@ -194,6 +194,8 @@ public:
   }
 
   int RecombineCompare(const Hypothesis &compare) const;
+  //! hash of coverage and feature function states, equal for hypotheses that RecombineCompare equal
+  size_t GetRecombinationHash() const;
 
   void GetOutputPhrase(Phrase &out) const;
 
@@ -295,17 +297,7 @@ struct CompareHypothesisTotalScore {
   }
 };
 
-#ifdef USE_HYPO_POOL
-
-#define FREEHYPO(hypo) \
-{ \
-	ObjectPool<Hypothesis> &pool = Hypothesis::GetObjectPool(); \
-	pool.freeObject(hypo); \
-} \
- 
-#else
-#define FREEHYPO(hypo) delete hypo
-#endif
+#define FREEHYPO(hypo) Hypothesis::Free(hypo)
 
 /** defines less-than relation on hypotheses.
 * The particular order is not important for us, we need just to figure out
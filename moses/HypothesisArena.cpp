@@ -0,0 +1,296 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <new>
+
+#include "HypothesisArena.h"
+#include "Hypothesis.h"
+
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
+namespace Moses
+{
+
+namespace
+{
+const size_t kObjectAlign = 16;
+const size_t kNumSizeClasses = 16; // objects up to 256 bytes
+const size_t kObjectBlockSize = 64 * 1024;
+
+#ifdef WITH_THREADS
+void NoCleanup(HypothesisArena *) {}
+boost::thread_specific_ptr<HypothesisArena> currentArena(&NoCleanup);
+#else
+struct {
+  HypothesisArena *arena;
+  HypothesisArena *get() const {
+    return arena;
+  }
+  void reset(HypothesisArena *a) {
+    arena = a;
+  }
+} currentArena = { NULL };
+#endif
+}
+
+/** Memory of the ArenaObjects of one arena, in size classes of
+ *  kObjectAlign bytes. Each object is preceded by a header naming its
+ *  owner, NULL for objects on the heap. Objects may be deleted after the
+ *  arena is gone (by a cache in a feature function, say), so the last of
+ *  the arena and its objects deletes the blocks.
+ */
+class HypothesisArena::ObjectBlocks
+{
+public:
+  struct Header {
+    ObjectBlocks *owner;
+    size_t sizeClass;
+  };
+
+  ObjectBlocks() : m_used(kObjectBlockSize), m_live(0), m_orphaned(false) {
+    std::fill(m_free, m_free + kNumSizeClasses, static_cast<Header*>(NULL));
+  }
+
+  ~ObjectBlocks() {
+    for (size_t i = 0; i < m_blocks.size(); ++i) {
+      ::operator delete(m_blocks[i]);
+    }
+  }
+
+  Header *Allocate(size_t sizeClass) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_live++;
+    Header *header = m_free[sizeClass - 1];
+    if (header) {
+      // a free object keeps the next free one in place of its header
+      m_free[sizeClass - 1] = *reinterpret_cast<Header**>(header);
+    } else {
+      size_t bytes = sizeof(Header) + sizeClass * kObjectAlign;
+      if (m_used + bytes > kObjectBlockSize) {
+        m_blocks.push_back(static_cast<char*>(::operator new(kObjectBlockSize)));
+        m_used = 0;
+      }
+      header = reinterpret_cast<Header*>(m_blocks.back() + m_used);
+      m_used += bytes;
+    }
+    header->owner = this;
+    header->sizeClass = sizeClass;
+    return header;
+  }
+
+  //! true if this was the last object of an arena that is gone
+  bool Free(Header *header) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    size_t sizeClass = header->sizeClass;
+    *reinterpret_cast<Header**>(header) = m_free[sizeClass - 1];
+    m_free[sizeClass - 1] = header;
+    return --m_live == 0 && m_orphaned;
+  }
+
+  //! true if no object is alive any more
+  bool Orphan() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_orphaned = true;
+    return m_live == 0;
+  }
+
+private:
+  std::vector<char*> m_blocks;
+  size_t m_used; /**< bytes handed out from the last block */
+  Header *m_free[kNumSizeClasses];
+  size_t m_live;
+  bool m_orphaned;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+};
+
+HypothesisArena::Scope::Scope(HypothesisArena &arena)
+  : m_previous(currentArena.get())
+{
+  currentArena.reset(&arena);
+}
+
+HypothesisArena::Scope::~Scope()
+{
+  currentArena.reset(m_previous);
+}
+
+HypothesisArena::HypothesisArena(size_t firstBlockSize)
+  : m_firstBlockSize(firstBlockSize)
+  , m_used(0)
+  , m_objects(new ObjectBlocks)
+  , m_numAllocated(0)
+  , m_numReused(0)
+  , m_numBlocks(0)
+  , m_destroying(false)
+{
+}
+
+HypothesisArena::~HypothesisArena()
+{
+  Clear();
+  if (m_objects->Orphan()) {
+    delete m_objects;
+  }
+}
+
+void HypothesisArena::Clear()
+{
+  // every slot handed out holds a constructed hypothesis, freed or not,
+  // unless its constructor threw. Their destructors free arcs and arc
+  // lists, which need not be recorded any more
+  m_destroying = true;
+  std::sort(m_unconstructed.begin(), m_unconstructed.end());
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    size_t used = (i + 1 < m_blocks.size()) ? m_blockSizes[i] : m_used;
+    for (size_t j = 0; j < used; ++j) {
+      Hypothesis *hypo = m_blocks[i] + j;
+      if (m_unconstructed.empty()
+          || !std::binary_search(m_unconstructed.begin(), m_unconstructed.end(), static_cast<void*>(hypo))) {
+        hypo->~Hypothesis();
+      }
+    }
+  }
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    ::operator delete(m_blocks[i]);
+  }
+  for (size_t i = 0; i < m_arcLists.size(); ++i) {
+    delete m_arcLists[i];
+  }
+  m_blocks.clear();
+  m_blockSizes.clear();
+  m_free.clear();
+  m_unconstructed.clear();
+  m_arcLists.clear();
+  m_freeArcLists.clear();
+  m_used = 0;
+  m_destroying = false;
+}
+
+void *HypothesisArena::Allocate()
+{
+  Hypothesis *reused;
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_numAllocated++;
+    if (!m_unconstructed.empty()) {
+      void *slot = m_unconstructed.back();
+      m_unconstructed.pop_back();
+      return slot;
+    }
+    if (m_free.empty()) {
+      if (m_blocks.empty() || m_used == m_blockSizes.back()) {
+        m_blockSizes.push_back(m_blocks.empty() ? m_firstBlockSize : m_blockSizes.back() * 2);
+        m_blocks.push_back(static_cast<Hypothesis*>(::operator new(sizeof(Hypothesis) * m_blockSizes.back())));
+        m_used = 0;
+        m_numBlocks++;
+      }
+      return m_blocks.back() + m_used++;
+    }
+    m_numReused++;
+    reused = m_free.back();
+    m_free.pop_back();
+  }
+
+  // outside the lock: the destructor frees the arcs of the old hypothesis
+  reused->~Hypothesis();
+  return reused;
+}
+
+void HypothesisArena::Release(void *slot)
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  m_unconstructed.push_back(slot);
+}
+
+void HypothesisArena::Free(Hypothesis *hypo)
+{
+  if (m_destroying) return;
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  m_free.push_back(hypo);
+}
+
+std::vector<Hypothesis*> *HypothesisArena::AllocateArcList()
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  if (m_freeArcLists.empty()) {
+    m_arcLists.push_back(new std::vector<Hypothesis*>());
+    return m_arcLists.back();
+  }
+  std::vector<Hypothesis*> *arcList = m_freeArcLists.back();
+  m_freeArcLists.pop_back();
+  return arcList;
+}
+
+void HypothesisArena::FreeArcList(std::vector<Hypothesis*> *arcList)
+{
+  if (m_destroying) return;
+  // keeps its capacity for the next hypothesis that collects arcs
+  arcList->clear();
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  m_freeArcLists.push_back(arcList);
+}
+
+void *HypothesisArena::AllocateObject(size_t size)
+{
+  HypothesisArena *arena = currentArena.get();
+  size_t sizeClass = (size + kObjectAlign - 1) / kObjectAlign;
+  ObjectBlocks::Header *header;
+  if (arena && sizeClass > 0 && sizeClass <= kNumSizeClasses) {
+    header = arena->m_objects->Allocate(sizeClass);
+  } else {
+    header = static_cast<ObjectBlocks::Header*>(::operator new(sizeof(ObjectBlocks::Header) + size));
+    header->owner = NULL;
+  }
+  return header + 1;
+}
+
+void HypothesisArena::FreeObject(void *ptr)
+{
+  if (ptr == NULL) return;
+  ObjectBlocks::Header *header = static_cast<ObjectBlocks::Header*>(ptr) - 1;
+  ObjectBlocks *owner = header->owner;
+  if (owner == NULL) {
+    ::operator delete(header);
+  } else if (owner->Free(header)) {
+    delete owner;
+  }
+}
+
+}
@@ -0,0 +1,142 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_HypothesisArena_h
+#define moses_HypothesisArena_h
+
+#include <cstddef>
+#include <vector>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace Moses
+{
+
+class Hypothesis;
+
+/** Memory for the hypotheses of one sentence, owned by its Manager.
+ *
+ * Hypotheses are carved out of blocks that double in size, so a sentence
+ * needs a handful of heap allocations instead of one per hypothesis.
+ * As in ObjectPool, a freed hypothesis is only destroyed when its memory
+ * is handed out again, or when the Manager clears the arena at the end of
+ * the sentence; then all blocks are released at once.
+ *
+ * The arena also recycles the arc lists of the hypotheses, and hands out
+ * memory for the small objects that die with them, feature function
+ * states and translation options (see ArenaObject). Those are allocated
+ * from the arena made current for the calling thread with a Scope.
+ *
+ * Safe to use from several threads (see -search-threads).
+ */
+class HypothesisArena
+{
+public:
+  /** Makes an arena current for the calling thread while in scope, so that
+   *  ArenaObjects created by it come out of the arena. */
+  class Scope
+  {
+  public:
+    explicit Scope(HypothesisArena &arena);
+    ~Scope();
+  private:
+    HypothesisArena *m_previous;
+  };
+
+  explicit HypothesisArena(size_t firstBlockSize = 1024);
+  ~HypothesisArena();
+
+  //! uninitialised memory for one Hypothesis, construct it with placement new
+  void *Allocate();
+  //! give back memory from Allocate() whose constructor threw
+  void Release(void *slot);
+  //! give back a hypothesis that is not referenced anymore
+  void Free(Hypothesis *hypo);
+  //! destroy all hypotheses, freed or not, and release the memory
+  void Clear();
+
+  //! empty arc list, possibly with the capacity of one given back before
+  std::vector<Hypothesis*> *AllocateArcList();
+  //! give back an arc list, the hypotheses in it are not touched
+  void FreeArcList(std::vector<Hypothesis*> *arcList);
+
+  //! memory for an ArenaObject, from the current arena if there is one
+  static void *AllocateObject(size_t size);
+  //! give back memory from AllocateObject()
+  static void FreeObject(void *ptr);
+
+  //! number of calls to Allocate()
+  size_t GetNumAllocated() const {
+    return m_numAllocated;
+  }
+  //! allocations served from freed hypotheses
+  size_t GetNumReused() const {
+    return m_numReused;
+  }
+  //! heap allocations made by the arena
+  size_t GetNumBlocks() const {
+    return m_numBlocks;
+  }
+
+private:
+  HypothesisArena(const HypothesisArena&);
+  void operator=(const HypothesisArena&);
+
+  class ObjectBlocks;
+
+  size_t m_firstBlockSize;
+  std::vector<Hypothesis*> m_blocks;
+  std::vector<size_t> m_blockSizes;
+  size_t m_used; /**< hypotheses handed out from the last block */
+  std::vector<Hypothesis*> m_free;
+  std::vector<void*> m_unconstructed; /**< slots released by Release() */
+  std::vector<std::vector<Hypothesis*>*> m_arcLists, m_freeArcLists;
+  ObjectBlocks *m_objects; /**< outlives the arena while objects are alive */
+  size_t m_numAllocated, m_numReused, m_numBlocks;
+  bool m_destroying;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+};
+
+/** Base of classes whose instances should come out of the current
+ *  HypothesisArena. Without a current arena they go to the heap as usual,
+ *  so such objects may also be created outside of decoding.
+ */
+class ArenaObject
+{
+public:
+  static void *operator new(size_t size) {
+    return HypothesisArena::AllocateObject(size);
+  }
+  static void operator delete(void *ptr) {
+    HypothesisArena::FreeObject(ptr);
+  }
+  static void *operator new(size_t, void *place) {
+    return place;
+  }
+  static void operator delete(void *, void *) {
+  }
+};
+
+}
+
+#endif
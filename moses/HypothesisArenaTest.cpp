@@ -0,0 +1,100 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include "HypothesisArena.h"
+#include "FF/FFState.h"
+
+using namespace Moses;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(hypothesis_arena)
+
+namespace
+{
+
+class CountState : public FFState
+{
+public:
+  CountState(int value) : m_value(value) {}
+  int Compare(const FFState& other) const {
+    return m_value - static_cast<const CountState&>(other).m_value;
+  }
+private:
+  int m_value;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(released_slot)
+{
+  // a slot whose constructor threw is handed out again, and Clear() does
+  // not destroy it
+  HypothesisArena arena;
+  void *slot = arena.Allocate();
+  arena.Release(slot);
+  BOOST_CHECK_EQUAL(slot, arena.Allocate());
+  arena.Release(slot);
+  arena.Clear();
+  BOOST_CHECK_EQUAL(0, arena.GetNumReused());
+}
+
+BOOST_AUTO_TEST_CASE(arc_lists)
+{
+  HypothesisArena arena;
+  vector<Hypothesis*> *arcList = arena.AllocateArcList();
+  arcList->push_back(NULL);
+  arena.FreeArcList(arcList);
+  BOOST_CHECK_EQUAL(arcList, arena.AllocateArcList());
+  BOOST_CHECK(arcList->empty());
+}
+
+BOOST_AUTO_TEST_CASE(objects_in_scope)
+{
+  HypothesisArena arena;
+  FFState *first, *second;
+  {
+    HypothesisArena::Scope scope(arena);
+    first = new CountState(1);
+    second = new CountState(2);
+    BOOST_CHECK_EQUAL(-1, first->Compare(*second));
+    delete first;
+    // same size class, reuses the memory
+    FFState *third = new CountState(3);
+    BOOST_CHECK_EQUAL(first, third);
+    delete third;
+  }
+  // out of scope: heap
+  FFState *heap = new CountState(4);
+  BOOST_CHECK(heap != first);
+  delete heap;
+
+  // objects may outlive their arena
+  HypothesisArena *gone = new HypothesisArena;
+  {
+    HypothesisArena::Scope scope(*gone);
+    first = new CountState(5);
+  }
+  delete gone;
+  delete first;
+  delete second;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
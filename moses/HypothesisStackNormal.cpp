@@ -33,12 +33,43 @@ using namespace std;
 
 namespace Moses
 {
+
+namespace
+{
+/** CompareHypothesisTotalScore, with ties broken by the order of the
+ * recombination set. Pruning keeps the same survivors whether the stack is
+ * in the set (stable sort of the set order) or in the hash table. */
+struct CompareHypothesisTotalScoreRecombination {
+  bool operator()(const Hypothesis* hypo1, const Hypothesis* hypo2) const {
+    if (hypo1->GetTotalScore() != hypo2->GetTotalScore()) {
+      return hypo1->GetTotalScore() > hypo2->GetTotalScore();
+    }
+    return hypo1->RecombineCompare(*hypo2) < 0;
+  }
+};
+}
+
 HypothesisStackNormal::HypothesisStackNormal(Manager& manager) :
   HypothesisStack(manager)
 {
-  m_nBestIsEnabled = StaticData::Instance().IsNBestEnabled();
+  m_nBestIsEnabled = manager.GetOptions().nBestEnabled;
   m_bestScore = -std::numeric_limits<float>::infinity();
   m_worstScore = -std::numeric_limits<float>::infinity();
+  m_useHashTable = StaticData::Instance().UseStackHash();
+  m_tableCount = 0;
+  if (m_useHashTable) {
+    RebuildTable(std::vector<RecombinationSlot>());
+  }
+}
+
+HypothesisStackNormal::~HypothesisStackNormal()
+{
+  // only left over if search stopped before this stack was pruned
+  for (size_t i = 0; i < m_table.size(); ++i) {
+    if (m_table[i].hypo) {
+      FREEHYPO(m_table[i].hypo);
+    }
+  }
 }
 
 /** remove all hypotheses from the collection */
@@ -54,37 +85,46 @@ pair<HypothesisStackNormal::iterator, bool> HypothesisStackNormal::Add(Hypothesi
   std::pair<iterator, bool> ret = m_hypos.insert(hypo);
   if (ret.second) {
     // equiv hypo doesn't exists
-    VERBOSE(3,"added hyp to stack");
-
-    // Update best score, if this hypothesis is new best
-    if (hypo->GetTotalScore() > m_bestScore) {
-      VERBOSE(3,", best on stack");
-      m_bestScore = hypo->GetTotalScore();
-      // this may also affect the worst score
-      if ( m_bestScore + m_beamWidth > m_worstScore )
-        m_worstScore = m_bestScore + m_beamWidth;
-    }
-    // update best/worst score for stack diversity 1
-    if ( m_minHypoStackDiversity == 1 &&
-         hypo->GetTotalScore() > GetWorstScoreForBitmap( hypo->GetWordsBitmap() ) ) {
-      SetWorstScoreForBitmap( hypo->GetWordsBitmap().GetID(), hypo->GetTotalScore() );
-    }
+    UpdateAfterAdd(hypo);
+  }
+
+  return ret;
+}
+
+void HypothesisStackNormal::UpdateAfterAdd(Hypothesis *hypo)
+{
+  VERBOSE(3,"added hyp to stack");
+
+  // Update best score, if this hypothesis is new best
+  if (hypo->GetTotalScore() > m_bestScore) {
+    VERBOSE(3,", best on stack");
+    m_bestScore = hypo->GetTotalScore();
+    // this may also affect the worst score
+    if ( m_bestScore + m_beamWidth > m_worstScore )
+      m_worstScore = m_bestScore + m_beamWidth;
+  }
+  // update best/worst score for stack diversity 1
+  if ( m_minHypoStackDiversity == 1 &&
+       hypo->GetTotalScore() > GetWorstScoreForBitmap( hypo->GetWordsBitmap() ) ) {
+    SetWorstScoreForBitmap( hypo->GetWordsBitmap().GetID(), hypo->GetTotalScore() );
+  }
 
-    VERBOSE(3,", now size " << m_hypos.size());
+  VERBOSE(3,", now size " << GetNumHypos());
 
-    // prune only if stack is twice as big as needed (lazy pruning)
-    size_t toleratedSize = 2*m_maxHypoStackSize-1;
-    // add in room for stack diversity
-    if (m_minHypoStackDiversity)
-      toleratedSize += m_minHypoStackDiversity << StaticData::Instance().GetMaxDistortion();
-    if (m_hypos.size() > toleratedSize) {
-      PruneToSize(m_maxHypoStackSize);
+  // prune only if stack is twice as big as needed (lazy pruning)
+  size_t toleratedSize = 2*m_maxHypoStackSize-1;
+  // add in room for stack diversity
+  if (m_minHypoStackDiversity)
+    toleratedSize += m_minHypoStackDiversity << StaticData::Instance().GetMaxDistortion();
+  if (GetNumHypos() > toleratedSize) {
+    if (m_useHashTable) {
+      PruneHashed(m_maxHypoStackSize);
     } else {
-      VERBOSE(3,std::endl);
+      PruneToSize(m_maxHypoStackSize);
     }
+  } else {
+    VERBOSE(3,std::endl);
   }
-
-  return ret;
 }
 
 bool HypothesisStackNormal::AddPrune(Hypothesis *hypo)
@@ -107,6 +147,10 @@ bool HypothesisStackNormal::AddPrune(Hypothesis *hypo)
     return false;
   }
 
+  if (m_useHashTable) {
+    return AddPruneHashed(hypo);
+  }
+
   // over threshold, try to add to collection
   std::pair<iterator, bool> addRet = Add(hypo);
   if (addRet.second) {
@@ -151,21 +195,9 @@ bool HypothesisStackNormal::AddPrune(Hypothesis *hypo)
   }
 }
 
-void HypothesisStackNormal::PruneToSize(size_t newSize)
+void HypothesisStackNormal::SelectSurvivors(const vector<Hypothesis*> &hypos, size_t newSize, vector<bool> &included)
 {
-  if ( newSize == 0) return; // no limit
-  if ( size() <= newSize ) return; // ok, if not over the limit
-
-  // we need to store a temporary list of hypotheses
-  vector< Hypothesis* > hypos = GetSortedListNOTCONST();
-  bool* included = (bool*) malloc(sizeof(bool) * hypos.size());
-  for(size_t i=0; i<hypos.size(); i++) included[i] = false;
-
-  // clear out original set
-  for( iterator iter = m_hypos.begin(); iter != m_hypos.end(); ) {
-    iterator removeHyp = iter++;
-    Detach(removeHyp);
-  }
+  size_t numIncluded = 0;
 
   // add best hyps for each coverage according to minStackDiversity
   if ( m_minHypoStackDiversity > 0 ) {
@@ -177,8 +209,8 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
         diversityCount[ coverage ] = 0;
 
       if (diversityCount[ coverage ] < m_minHypoStackDiversity) {
-        m_hypos.insert( hyp );
         included[i] = true;
+        numIncluded++;
         diversityCount[ coverage ]++;
         if (diversityCount[ coverage ] == m_minHypoStackDiversity)
           SetWorstScoreForBitmap( coverage, hyp->GetTotalScore());
@@ -187,29 +219,54 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
   }
 
   // only add more if stack not full after satisfying minStackDiversity
-  if ( size() < newSize ) {
+  if ( numIncluded < newSize ) {
 
     // add best remaining hypotheses
     for(size_t i=0; i<hypos.size()
-        && size() < newSize
+        && numIncluded < newSize
         && hypos[i]->GetTotalScore() > m_bestScore+m_beamWidth; i++) {
       if (! included[i]) {
-        m_hypos.insert( hypos[i] );
         included[i] = true;
-        if (size() == newSize)
+        numIncluded++;
+        if (numIncluded == newSize)
           m_worstScore = hypos[i]->GetTotalScore();
       }
     }
   }
+}
+
+void HypothesisStackNormal::PruneToSize(size_t newSize)
+{
+  if (m_useHashTable) {
+    PruneHashed(newSize);
+    FlushTable();
+    return;
+  }
+
+  if ( newSize == 0) return; // no limit
+  if ( size() <= newSize ) return; // ok, if not over the limit
+
+  // we need to store a temporary list of hypotheses
+  vector< Hypothesis* > hypos = GetSortedListNOTCONST();
+  vector<bool> included(hypos.size(), false);
+
+  // clear out original set
+  for( iterator iter = m_hypos.begin(); iter != m_hypos.end(); ) {
+    iterator removeHyp = iter++;
+    Detach(removeHyp);
+  }
+
+  SelectSurvivors(hypos, newSize, included);
 
   // delete hypotheses that have not been included
   for(size_t i=0; i<hypos.size(); i++) {
-    if (! included[i]) {
+    if (included[i]) {
+      m_hypos.insert( hypos[i] );
+    } else {
       FREEHYPO( hypos[i] );
       m_manager.GetSentenceStats().AddPruning();
     }
   }
-  free(included);
 
   // some reporting....
   VERBOSE(3,", pruned to size " << size() << endl);
@@ -223,8 +280,163 @@ void HypothesisStackNormal::PruneToSize(size_t newSize)
   }
 }
 
+void HypothesisStackNormal::FlushTable()
+{
+  if (!m_useHashTable) return;
+
+  // the stack is complete: move it into the ordered set, where it is
+  // iterated over in the same order as without -stack-hash
+  for (size_t i = 0; i < m_table.size(); ++i) {
+    if (m_table[i].hypo) {
+      m_hypos.insert(m_table[i].hypo);
+    }
+  }
+  m_table.clear();
+  m_tableCount = 0;
+  m_useHashTable = false;
+}
+
+/** recombine and add hypothesis through the hash table. Same decisions as
+ * the set-based code in AddPrune. */
+bool HypothesisStackNormal::AddPruneHashed(Hypothesis *hypo)
+{
+  // keep the load factor at or below 1/2
+  if (2 * (m_tableCount + 1) > m_table.size()) {
+    RebuildTable(m_table);
+  }
+
+  size_t hash = hypo->GetRecombinationHash();
+  RecombinationSlot &slot = FindSlot(hash, *hypo);
+  if (!slot.hypo) {
+    slot.hash = hash;
+    slot.hypo = hypo;
+    m_tableCount++;
+    UpdateAfterAdd(hypo);
+    return true;
+  }
+
+  // equiv hypo exists, recombine with other hypo
+  Hypothesis *hypoExisting = slot.hypo;
+  m_manager.GetSentenceStats().AddRecombination(*hypo, *hypoExisting);
+
+  // keep the best 1
+  if (hypo->GetTotalScore() > hypoExisting->GetTotalScore()) {
+    VERBOSE(3,"better than matching hyp " << hypoExisting->GetId() << ", recombining, ");
+    if (m_nBestIsEnabled) {
+      hypo->AddArc(hypoExisting);
+    } else {
+      FREEHYPO(hypoExisting);
+    }
+    slot.hypo = hypo;
+    UpdateAfterAdd(hypo);
+  } else {
+    VERBOSE(3,"worse than matching hyp " << hypoExisting->GetId() << ", recombining" << std::endl)
+    if (m_nBestIsEnabled) {
+      hypoExisting->AddArc(hypo);
+    } else {
+      FREEHYPO(hypo);
+    }
+  }
+  return false;
+}
+
+/** slot holding a hypothesis that recombines with the given one, or the
+ * empty slot where it should go */
+HypothesisStackNormal::RecombinationSlot &HypothesisStackNormal::FindSlot(size_t hash, const Hypothesis &hypo)
+{
+  const size_t mask = m_table.size() - 1;
+  // Fibonacci hashing: spread the (weakly mixed) combined hash over the table
+  size_t i = (size_t) ((hash * 0x9E3779B97F4A7C15ULL) >> (64 - m_tableBits));
+  while (m_table[i].hypo
+         && (m_table[i].hash != hash || m_table[i].hypo->RecombineCompare(hypo) != 0)) {
+    i = (i + 1) & mask;
+  }
+  return m_table[i];
+}
+
+/** size the table for twice the hypotheses in slots, and insert them */
+void HypothesisStackNormal::RebuildTable(const vector<RecombinationSlot> &slots)
+{
+  vector<RecombinationSlot> oldSlots(slots);
+  size_t count = 0;
+  for (size_t i = 0; i < oldSlots.size(); ++i) {
+    if (oldSlots[i].hypo) count++;
+  }
+
+  m_tableBits = 6;
+  while (((size_t) 1 << m_tableBits) < 4 * (count + 1)) {
+    m_tableBits++;
+  }
+  m_table.assign((size_t) 1 << m_tableBits, RecombinationSlot());
+  m_tableCount = 0;
+  for (size_t i = 0; i < oldSlots.size(); ++i) {
+    if (oldSlots[i].hypo) {
+      // hypotheses in the table never recombine with each other
+      const size_t mask = m_table.size() - 1;
+      size_t j = (size_t) ((oldSlots[i].hash * 0x9E3779B97F4A7C15ULL) >> (64 - m_tableBits));
+      while (m_table[j].hypo) j = (j + 1) & mask;
+      m_table[j] = oldSlots[i];
+      m_tableCount++;
+    }
+  }
+}
+
+/** PruneToSize for the hash table. Without stack diversity, the survivors
+ * are found with nth_element instead of sorting the whole stack */
+void HypothesisStackNormal::PruneHashed(size_t newSize)
+{
+  if ( newSize == 0) return; // no limit
+  if ( m_tableCount <= newSize ) return; // ok, if not over the limit
+
+  vector<Hypothesis*> hypos;
+  hypos.reserve(m_tableCount);
+  for (size_t i = 0; i < m_table.size(); ++i) {
+    if (m_table[i].hypo) {
+      hypos.push_back(m_table[i].hypo);
+    }
+  }
+  vector<bool> included(hypos.size(), false);
+
+  if (m_minHypoStackDiversity > 0) {
+    sort(hypos.begin(), hypos.end(), CompareHypothesisTotalScoreRecombination());
+    SelectSurvivors(hypos, newSize, included);
+  } else {
+    // the newSize best, in no particular order, the worst of them last
+    nth_element(hypos.begin(), hypos.begin() + newSize - 1, hypos.end(), CompareHypothesisTotalScoreRecombination());
+    size_t numIncluded = 0;
+    for (size_t i = 0; i < newSize; ++i) {
+      if (hypos[i]->GetTotalScore() > m_bestScore + m_beamWidth) {
+        included[i] = true;
+        numIncluded++;
+      }
+    }
+    if (numIncluded == newSize) {
+      m_worstScore = hypos[newSize - 1]->GetTotalScore();
+    }
+  }
+
+  // rebuild the table from the survivors, delete the rest
+  vector<RecombinationSlot> survivors;
+  survivors.reserve(newSize);
+  for (size_t i = 0; i < hypos.size(); ++i) {
+    if (included[i]) {
+      RecombinationSlot slot;
+      slot.hash = hypos[i]->GetRecombinationHash();
+      slot.hypo = hypos[i];
+      survivors.push_back(slot);
+    } else {
+      FREEHYPO( hypos[i] );
+      m_manager.GetSentenceStats().AddPruning();
+    }
+  }
+  RebuildTable(survivors);
+
+  VERBOSE(3,", pruned to size " << m_tableCount << endl);
+}
+
 const Hypothesis *HypothesisStackNormal::GetBestHypothesis() const
 {
+  assert(!m_useHashTable);
   if (!m_hypos.empty()) {
     const_iterator iter = m_hypos.begin();
     Hypothesis *bestHypo = *iter;
@@ -240,6 +452,7 @@ const Hypothesis *HypothesisStackNormal::GetBestHypothesis() const
 
 vector<const Hypothesis*> HypothesisStackNormal::GetSortedList() const
 {
+  assert(!m_useHashTable);
   vector<const Hypothesis*> ret;
   ret.reserve(m_hypos.size());
   std::copy(m_hypos.begin(), m_hypos.end(), std::inserter(ret, ret.end()));
@@ -253,7 +466,8 @@ vector<Hypothesis*> HypothesisStackNormal::GetSortedListNOTCONST()
   vector<Hypothesis*> ret;
   ret.reserve(m_hypos.size());
   std::copy(m_hypos.begin(), m_hypos.end(), std::inserter(ret, ret.end()));
-  sort(ret.begin(), ret.end(), CompareHypothesisTotalScore());
+  // stable: ties stay in recombination order, see CompareHypothesisTotalScoreRecombination
+  stable_sort(ret.begin(), ret.end(), CompareHypothesisTotalScore());
 
   return ret;
 }
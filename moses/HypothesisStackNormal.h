@@ -48,11 +48,40 @@ protected:
   size_t m_minHypoStackDiversity; /**< minimum number of hypothesis with different source word coverage */
   bool m_nBestIsEnabled; /**< flag to determine whether to keep track of old arcs */
 
+  /** slot of the open-addressing recombination table, see -stack-hash */
+  struct RecombinationSlot {
+    RecombinationSlot() : hash(0), hypo(NULL) {}
+    size_t hash; /**< Hypothesis::GetRecombinationHash() of hypo */
+    Hypothesis *hypo; /**< NULL if empty */
+  };
+  /** while true, hypotheses are recombined in m_table instead of m_hypos.
+   *  PruneToSize and FlushTable move them into m_hypos, after which the stack behaves as
+   *  the set-based one. */
+  bool m_useHashTable;
+  std::vector<RecombinationSlot> m_table; /**< size is a power of 2 */
+  size_t m_tableBits;
+  size_t m_tableCount;
+
   /** add hypothesis to stack. Prune if necessary.
    * Returns false if equiv hypo exists in collection, otherwise returns true
    */
   std::pair<HypothesisStackNormal::iterator, bool> Add(Hypothesis *hypothesis);
 
+  //! update best/worst scores for a new hypothesis and prune lazily
+  void UpdateAfterAdd(Hypothesis *hypothesis);
+  //! number of hypotheses, in whichever container holds them
+  size_t GetNumHypos() const {
+    return m_useHashTable ? m_tableCount : m_hypos.size();
+  }
+  //! pick the hypotheses that survive pruning to newSize from a list sorted by score
+  void SelectSurvivors(const std::vector<Hypothesis*> &sortedHypos, size_t newSize, std::vector<bool> &included);
+
+  // hash table recombination
+  bool AddPruneHashed(Hypothesis *hypothesis);
+  RecombinationSlot &FindSlot(size_t hash, const Hypothesis &hypothesis);
+  void RebuildTable(const std::vector<RecombinationSlot> &slots);
+  void PruneHashed(size_t newSize);
+
   /** destroy all instances of Hypothesis in this collection */
   void RemoveAll();
 
@@ -71,6 +100,7 @@ public:
   }
 
   HypothesisStackNormal(Manager& manager);
+  ~HypothesisStackNormal();
 
   /** adds the hypo, but only if within thresholds (beamThr, stackSize).
   *	This function will recombine hypotheses silently!  There is no record
@@ -112,9 +142,18 @@ public:
    * The threshold is chosen so that exactly newSize top items remain on the
    * stack in fact, in situations where some of the hypothesis fell below
    * m_beamWidth, the stack will contain less items.
+   * With -stack-hash, this also ends hash table recombination, and must be
+   * called before iterating over the stack.
    * \param newSize maximum size */
   void PruneToSize(size_t newSize);
 
+  /** with -stack-hash, move the hypotheses of the recombination table into
+   * the ordered set, without pruning. PruneToSize does this; search calls it
+   * for the stacks it did not get to when it is interrupted, so that their
+   * hypotheses reach the n-best list, lattice and search graph.
+   */
+  void FlushTable();
+
   //! return the hypothesis with best score. Used to get the translated at end of decoding
   const Hypothesis *GetBestHypothesis() const;
   //! return all hypothesis, sorted by descending score. Used in creation of N best list
@@ -37,6 +37,11 @@ InputType::InputType(long translationId) : m_translationId(translationId)
 
 InputType::~InputType() {}
 
+const DecodingOptions &InputType::GetOptions() const
+{
+  return m_options ? *m_options : StaticData::Instance().GetDecodingOptions();
+}
+
 TO_STRING_BODY(InputType);
 
 std::ostream& operator<<(std::ostream& out,InputType const& x)
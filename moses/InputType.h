@@ -24,12 +24,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_InputType_h
 
 #include <string>
+#include <boost/shared_ptr.hpp>
 #include "TypeDef.h"
 #include "Phrase.h"
 #include "TargetPhraseCollection.h"
 #include "ReorderingConstraint.h"
 #include "NonTerminal.h"
 #include "WordsRange.h"
+#include "DecodingOptions.h"
 
 namespace Moses
 {
@@ -57,6 +59,7 @@ protected:
   ReorderingConstraint m_reorderingConstraint; /**< limits on reordering specified either by "-mp" switch or xml tags */
   std::string m_textType;
   std::string m_passthrough;
+  boost::shared_ptr<const DecodingOptions> m_options; /**< NULL for those of StaticData */
 
 public:
 
@@ -122,6 +125,11 @@ public:
   std::string GetWeightSetting() const {
     return m_weightSetting;
   }
+  //! search options for this input, by default those of StaticData
+  const DecodingOptions &GetOptions() const;
+  void SetOptions(const boost::shared_ptr<const DecodingOptions> &options) {
+    m_options = options;
+  }
   void SetTextType(std::string type) {
     m_textType = type;
   }
@@ -60,6 +60,9 @@ struct KenLMState : public FFState {
     if (state.length > other.state.length) return 1;
     return std::memcmp(state.words, other.state.words, sizeof(lm::WordIndex) * state.length);
   }
+  size_t hash() const {
+    return lm::ngram::hash_value(state);
+  }
 };
 
 ///*
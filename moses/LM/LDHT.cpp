@@ -84,6 +84,9 @@ public:
   LDHT::Client* initTSSClient();
   virtual ~LanguageModelLDHT();
   virtual void InitializeForInput(InputType const& source);
+  virtual bool HasThreadLocalSentenceState() const {
+    return true;
+  }
   virtual void CleanUpAfterSentenceProcessing(const InputType &source);
   virtual const FFState* EmptyHypothesisState(const InputType& input) const;
   virtual void CalcScore(const Phrase& phrase,
@@ -72,7 +72,8 @@ Manager::~Manager()
 {
   delete m_transOptColl;
   delete m_search;
-  // this is a comment ...
+  // all hypotheses go at once, before the sentence is cleaned up
+  m_hypoArena.Clear();
 
   StaticData::Instance().CleanUpAfterSentenceProcessing(m_source);
 }
@@ -83,6 +84,9 @@ Manager::~Manager()
  */
 void Manager::Decode()
 {
+  // translation options and feature function states of this sentence
+  HypothesisArena::Scope arenaScope(m_hypoArena);
+
   // initialize statistics
   ResetSentenceStats(m_source);
   IFVERBOSE(2) {
@@ -120,6 +124,8 @@ void Manager::Decode()
   VERBOSE(1, "Line " << m_source.GetTranslationId() << ": Search took " << searchTime << " seconds" << endl);
     IFVERBOSE(2) {
     GetSentenceStats().StopTimeTotal();
+    GetSentenceStats().SetHypothesisArenaStats(m_hypoArena.GetNumAllocated(),
+        m_hypoArena.GetNumReused(), m_hypoArena.GetNumBlocks());
     TRACE_ERR(GetSentenceStats());
   }
 }
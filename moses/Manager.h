@@ -24,8 +24,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <vector>
 #include <list>
+#include <boost/atomic.hpp>
 #include "InputType.h"
 #include "Hypothesis.h"
+#include "HypothesisArena.h"
 #include "StaticData.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
@@ -112,13 +114,14 @@ private:
 
 protected:
   // data
+  HypothesisArena m_hypoArena; /**< memory of all hypotheses of this sentence */
   TranslationOptionCollection *m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
   Search *m_search;
 
   HypothesisStack* actual_hypoStack; /**actual (full expanded) stack of hypotheses*/
   size_t interrupted_flag;
   std::auto_ptr<SentenceStats> m_sentenceStats;
-  int m_hypoId; //used to number the hypos as they are created.
+  boost::atomic<int> m_hypoId; //used to number the hypos as they are created.
 
   void GetConnectedGraph(
     std::map< int, bool >* pConnected,
@@ -161,6 +164,13 @@ public:
   void GetOutputLanguageModelOrder( std::ostream &out, const Hypothesis *hypo ) const;
   void GetWordGraph(long translationId, std::ostream &outputWordGraphStream) const;
   int GetNextHypoId();
+  HypothesisArena &GetHypothesisArena() {
+    return m_hypoArena;
+  }
+  //! restart hypothesis numbering, used by search that renumbers hypotheses itself
+  void SetNextHypoId(int id) {
+    m_hypoId = id;
+  }
 
   void OutputLatticeMBRNBest(std::ostream& out, const std::vector<LatticeMBRSolution>& solutions,long translationId) const;
   void OutputBestHypo(const std::vector<Moses::Word>&  mbrBestHypo, long /*translationId*/,
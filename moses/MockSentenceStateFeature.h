@@ -0,0 +1,133 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef _MOCK_SENTENCE_STATE_FEATURE_
+#define _MOCK_SENTENCE_STATE_FEATURE_
+
+#include <string>
+
+#include <boost/atomic.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#else
+#include <memory>
+#endif
+
+#include "moses/FF/StatelessFeatureFunction.h"
+#include "moses/ChartHypothesis.h"
+#include "moses/Hypothesis.h"
+#include "moses/InputType.h"
+#include "moses/ScoreComponentCollection.h"
+
+namespace MosesTest
+{
+
+//
+// A feature that keeps the sentence in thread-local storage, like
+// GlobalLexicalModel, and scores each hypothesis with the length of the
+// sentence. Counts the evaluations on threads that have not seen the
+// sentence, which score nothing. Construct it before the models are loaded,
+// so that its score is part of every score breakdown.
+//
+
+class MockSentenceStateFeature : public Moses::StatelessFeatureFunction
+{
+public:
+  MockSentenceStateFeature(const std::string &line)
+    : StatelessFeatureFunction(1, line), m_threadLocal(false), m_evaluated(0), m_missing(0) {
+    ReadParameters();
+  }
+
+  bool IsUseable(const Moses::FactorMask &mask) const {
+    return true;
+  }
+
+  void InitializeForInput(const Moses::InputType &source) {
+    m_local.reset(new SentenceState);
+    m_local->input = &source;
+  }
+  bool HasThreadLocalSentenceState() const {
+    return m_threadLocal;
+  }
+  //! off by default, so that the feature does not turn -search-threads off
+  void SetThreadLocal(bool threadLocal) {
+    m_threadLocal = threadLocal;
+  }
+
+  void EvaluateInIsolation(const Moses::Phrase &source
+                           , const Moses::TargetPhrase &targetPhrase
+                           , Moses::ScoreComponentCollection &scoreBreakdown
+                           , Moses::ScoreComponentCollection &estimatedFutureScore) const {
+  }
+  void EvaluateWithSourceContext(const Moses::InputType &input
+                                 , const Moses::InputPath &inputPath
+                                 , const Moses::TargetPhrase &targetPhrase
+                                 , const Moses::StackVec *stackVec
+                                 , Moses::ScoreComponentCollection &scoreBreakdown
+                                 , Moses::ScoreComponentCollection *estimatedFutureScore = NULL) const {
+  }
+
+  void EvaluateWhenApplied(const Moses::Hypothesis &hypo,
+                           Moses::ScoreComponentCollection *accumulator) const {
+    Score(accumulator);
+  }
+  void EvaluateWhenApplied(const Moses::ChartHypothesis &hypo,
+                           Moses::ScoreComponentCollection *accumulator) const {
+    Score(accumulator);
+  }
+
+  //! hypotheses scored since the last reset
+  size_t GetEvaluated() const {
+    return m_evaluated;
+  }
+  //! of which without the sentence
+  size_t GetMissing() const {
+    return m_missing;
+  }
+  void ResetCounts() {
+    m_evaluated = 0;
+    m_missing = 0;
+  }
+
+private:
+  struct SentenceState {
+    const Moses::InputType *input;
+  };
+
+#ifdef WITH_THREADS
+  boost::thread_specific_ptr<SentenceState> m_local;
+#else
+  std::auto_ptr<SentenceState> m_local;
+#endif
+  bool m_threadLocal;
+  mutable boost::atomic<size_t> m_evaluated, m_missing;
+
+  void Score(Moses::ScoreComponentCollection *accumulator) const {
+    ++m_evaluated;
+    if (m_local.get() == NULL) {
+      ++m_missing;
+      return;
+    }
+    accumulator->PlusEquals(this, static_cast<float>(m_local->input->GetSize()));
+  }
+};
+
+}
+
+#endif
@@ -67,7 +67,11 @@ Parameter::Parameter()
   AddParam("report-all-factors-in-n-best", "Report all factors in n-best-lists. Default is false");
   AddParam("stack", "s", "maximum stack size for histogram pruning. 0 = unlimited stack size");
   AddParam("stack-diversity", "sd", "minimum number of hypothesis of each coverage in stack (default 0)");
+  AddParam("stack-hash", "recombine hypotheses in a hash table and prune stacks by partial selection, normal phrase-based search only (default false)");
   AddParam("threads","th", "number of threads to use in decoding (defaults to single-threaded)");
+  AddParam("load-threads", "number of feature functions loaded at the same time at startup, and of threads parsing the text rule tables; phrase tables are loaded after the other features (default 1 = sequential)");
+  AddParam("search-threads", "number of threads expanding the hypotheses of one stack in parallel in normal phrase-based search, or decoding the chart cells of one width in parallel in chart decoding (default 1 = sequential)");
+  AddParam("thread-priority-length", "ascending source lengths splitting sentences into thread pool priority classes; shorter sentences are decoded first (default: single class)");
   AddParam("translation-details", "T", "for each best hypothesis, report translation details to the given file");
   AddParam("tree-translation-details", "Ttree", "for each hypothesis, report translation details with tree fragment info to given file");
   //DIMw
@@ -101,6 +105,7 @@ Parameter::Parameter()
   AddParam("recover-input-path", "r", "(conf net/word lattice only) - recover input path corresponding to the best translation");
   AddParam("output-word-graph", "owg", "Output stack info as word graph. Takes filename, 0=only hypos in stack, 1=stack + nbest hypos");
   AddParam("time-out", "seconds after which is interrupted (-1=no time-out, default is -1)");
+  AddParam("deadline", "wall clock seconds per sentence; pruning is tightened while search is behind schedule, down to a few hypotheses per stack when the time is up (0=no deadline, default is 0)");
   AddParam("output-search-graph", "osg", "Output connected hypotheses of search into specified filename");
   AddParam("output-search-graph-extended", "osgx", "Output connected hypotheses of search into specified filename, in extended format");
   AddParam("unpruned-search-graph", "usg", "When outputting chart search graph, do not exclude dead ends. Note: stack pruning may have eliminated some hypotheses");
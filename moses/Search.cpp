@@ -10,6 +10,8 @@ namespace Moses
 
 Search::Search(Manager& manager)
   : m_manager(manager)
+  ,m_options(manager.GetOptions())
+  ,m_deadline(m_options.deadline)
   ,m_inputPath()
   ,m_initialTransOpt()
 {
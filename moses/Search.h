@@ -6,6 +6,8 @@
 #include "TranslationOption.h"
 #include "Phrase.h"
 #include "InputPath.h"
+#include "DecodingOptions.h"
+#include "DecodingDeadline.h"
 
 namespace Moses
 {
@@ -41,6 +43,8 @@ public:
 
 protected:
   Manager& m_manager;
+  const DecodingOptions &m_options; /**< of the input being decoded */
+  DecodingDeadline m_deadline;
   InputPath m_inputPath; // for initial hypo
   TranslationOption m_initialTransOpt; /**< used to seed 1st hypo */
 };
@@ -43,13 +43,12 @@ SearchCubePruning::SearchCubePruning(Manager& manager, const InputType &source,
   ,m_hypoStackColl(source.GetSize() + 1)
   ,m_transOptColl(transOptColl)
 {
-  const StaticData &staticData = StaticData::Instance();
 
   std::vector < HypothesisStackCubePruning >::iterator iterStack;
   for (size_t ind = 0 ; ind < m_hypoStackColl.size() ; ++ind) {
     HypothesisStackCubePruning *sourceHypoColl = new HypothesisStackCubePruning(m_manager);
-    sourceHypoColl->SetMaxHypoStackSize(staticData.GetMaxHypoStackSize());
-    sourceHypoColl->SetBeamWidth(staticData.GetBeamWidth());
+    sourceHypoColl->SetMaxHypoStackSize(m_options.maxHypoStackSize);
+    sourceHypoColl->SetBeamWidth(m_options.beamWidth);
 
     m_hypoStackColl[ind] = sourceHypoColl;
   }
@@ -66,7 +65,6 @@ SearchCubePruning::~SearchCubePruning()
  */
 void SearchCubePruning::Decode()
 {
-  const StaticData &staticData = StaticData::Instance();
 
   // initial seed hypothesis: nothing translated, no words produced
   Hypothesis *hypo = Hypothesis::Create(m_manager,m_source, m_initialTransOpt);
@@ -77,10 +75,10 @@ void SearchCubePruning::Decode()
   firstStack.CleanupArcList();
   CreateForwardTodos(firstStack);
 
-  const size_t PopLimit = StaticData::Instance().GetCubePruningPopLimit();
-  VERBOSE(3,"Cube Pruning pop limit is " << PopLimit << std::endl)
+  const size_t DefaultPopLimit = m_options.cubePruningPopLimit;
+  VERBOSE(3,"Cube Pruning pop limit is " << DefaultPopLimit << std::endl)
 
-  const size_t Diversity = StaticData::Instance().GetCubePruningDiversity();
+  const size_t Diversity = m_options.cubePruningDiversity;
   VERBOSE(3,"Cube Pruning diversity is " << Diversity << std::endl)
 
   // go through each stack
@@ -89,12 +87,29 @@ void SearchCubePruning::Decode()
   for (iterStack = m_hypoStackColl.begin() + 1 ; iterStack != m_hypoStackColl.end() ; ++iterStack) {
     // check if decoding ran out of time
     double _elapsed_time = GetUserTime();
-    if (_elapsed_time > staticData.GetTimeoutThreshold()) {
-      VERBOSE(1,"Decoding is out of time (" << _elapsed_time << "," << staticData.GetTimeoutThreshold() << ")" << std::endl);
+    if (_elapsed_time > m_options.timeoutThreshold) {
+      VERBOSE(1,"Decoding is out of time (" << _elapsed_time << "," << m_options.timeoutThreshold << ")" << std::endl);
       return;
     }
     HypothesisStackCubePruning &sourceHypoColl = *static_cast<HypothesisStackCubePruning*>(*iterStack);
 
+    // tighten pruning if running late for the deadline, and restore it
+    // once back on schedule. The work is filling all stacks but the first
+    size_t PopLimit = DefaultPopLimit;
+    size_t maxHypoStackSize = m_options.maxHypoStackSize;
+    if (m_deadline.IsSet()) {
+      bool wasTightened = m_deadline.IsTightened();
+      float scale = m_deadline.GetScale(iterStack - m_hypoStackColl.begin() - 1, m_hypoStackColl.size() - 1);
+      PopLimit = DecodingDeadline::ScaleLimit(PopLimit, scale);
+      maxHypoStackSize = DecodingDeadline::ScaleLimit(maxHypoStackSize, scale);
+      if (scale < 1 || wasTightened) {
+        float beamWidth = DecodingDeadline::ScaleBeam(m_options.beamWidth, scale);
+        for (std::vector < HypothesisStack* >::iterator iter = iterStack; iter != m_hypoStackColl.end(); ++iter) {
+          static_cast<HypothesisStackCubePruning*>(*iter)->SetBeamWidth(beamWidth);
+        }
+      }
+    }
+
     // priority queue which has a single entry for each bitmap container, sorted by score of top hyp
     std::priority_queue< BitmapContainer*, std::vector< BitmapContainer* >, BitmapContainerOrderer> BCQueue;
 
@@ -144,7 +159,7 @@ void SearchCubePruning::Decode()
     IFVERBOSE(2) {
       m_manager.GetSentenceStats().StartTimeStack();
     }
-    sourceHypoColl.PruneToSize(staticData.GetMaxHypoStackSize());
+    sourceHypoColl.PruneToSize(maxHypoStackSize);
     VERBOSE(3,std::endl);
     sourceHypoColl.CleanupArcList();
     IFVERBOSE(2) {
@@ -161,6 +176,7 @@ void SearchCubePruning::Decode()
 
     stackNo++;
   }
+  m_deadline.Finish(m_source.GetTranslationId());
 }
 
 void SearchCubePruning::CreateForwardTodos(HypothesisStackCubePruning &stack)
@@ -1,12 +1,93 @@
+#include <algorithm>
+#include <cstdlib>
+
 #include "Manager.h"
 #include "Timer.h"
 #include "SearchNormal.h"
 #include "SentenceStats.h"
+#include "ThreadPool.h"
+
+#include "util/usage.hh"
 
 using namespace std;
 
 namespace Moses
 {
+
+#ifdef WITH_THREADS
+/** Expands hypotheses of one stack into per-hypothesis buffers, taking
+ *  them one at a time from a counter shared by all threads working on the
+ *  stack. Runs in the expansion pool and in the decoding thread itself.
+ */
+class ExpansionTask : public Task
+{
+public:
+  struct Shared {
+    Shared(size_t numHypos) : buffers(numHypos), next(0), pending(0), busy(0) {}
+    std::vector<const Hypothesis*> hypos;
+    std::vector<SearchNormal::ExpansionBuffer> buffers;
+    boost::atomic<size_t> next;
+    boost::mutex mutex;
+    boost::condition_variable done;
+    size_t pending; // helper tasks still running
+    double busy; // seconds spent by helper tasks
+  };
+
+  ExpansionTask(SearchNormal &search, Shared &shared)
+    : m_search(search), m_shared(shared) {}
+
+  static void Expand(SearchNormal &search, Shared &shared) {
+    size_t i;
+    while ((i = shared.next++) < shared.hypos.size()) {
+      search.ProcessOneHypothesis(*shared.hypos[i], &shared.buffers[i]);
+    }
+  }
+
+  void Run() {
+    HypothesisArena::Scope arenaScope(m_search.m_manager.GetHypothesisArena());
+    double start = util::WallTime();
+    Expand(m_search, m_shared);
+    double busy = util::WallTime() - start;
+
+    boost::mutex::scoped_lock lock(m_shared.mutex);
+    m_shared.busy += busy;
+    if (--m_shared.pending == 0) {
+      m_shared.done.notify_all();
+    }
+  }
+
+private:
+  SearchNormal &m_search;
+  Shared &m_shared;
+};
+
+namespace
+{
+boost::once_flag expansionPoolOnce = BOOST_ONCE_INIT;
+ThreadPool *expansionPool = NULL;
+
+void DeleteExpansionPool()
+{
+  expansionPool->Stop();
+  delete expansionPool;
+  expansionPool = NULL;
+}
+
+// shared by all sentences; the decoding thread itself is the remaining worker
+void CreateExpansionPool()
+{
+  expansionPool = new ThreadPool(StaticData::Instance().GetSearchThreadCount() - 1);
+  atexit(DeleteExpansionPool);
+}
+
+ThreadPool &GetExpansionPool()
+{
+  boost::call_once(expansionPoolOnce, CreateExpansionPool);
+  return *expansionPool;
+}
+}
+#endif
+
 /**
  * Organizing main function
  *
@@ -23,6 +104,17 @@ SearchNormal::SearchNormal(Manager& manager, const InputType &source, const Tran
   VERBOSE(1, "Translating: " << m_source << endl);
   const StaticData &staticData = StaticData::Instance();
 
+  // the detailed timers of SentenceStats can only be driven by one thread,
+  // and features with thread-local sentence state only see this sentence on this thread.
+  // The expansion pool has the threads given by -search-threads
+  m_searchThreads = std::min(m_options.searchThreads, staticData.GetSearchThreadCount());
+  if (m_searchThreads > 1 && staticData.HasThreadLocalSentenceState()) {
+    m_searchThreads = 1;
+  }
+  IFVERBOSE(2) {
+    m_searchThreads = 1;
+  }
+
   // only if constraint decoding (having to match a specified output)
   // long sentenceID = source.GetTranslationId();
 
@@ -30,9 +122,9 @@ SearchNormal::SearchNormal(Manager& manager, const InputType &source, const Tran
   std::vector < HypothesisStackNormal >::iterator iterStack;
   for (size_t ind = 0 ; ind < m_hypoStackColl.size() ; ++ind) {
     HypothesisStackNormal *sourceHypoColl = new HypothesisStackNormal(m_manager);
-    sourceHypoColl->SetMaxHypoStackSize(staticData.GetMaxHypoStackSize(),
-                                        staticData.GetMinHypoStackDiversity());
-    sourceHypoColl->SetBeamWidth(staticData.GetBeamWidth());
+    sourceHypoColl->SetMaxHypoStackSize(m_options.maxHypoStackSize,
+                                        m_options.minHypoStackDiversity);
+    sourceHypoColl->SetBeamWidth(m_options.beamWidth);
 
     m_hypoStackColl[ind] = sourceHypoColl;
   }
@@ -49,7 +141,6 @@ SearchNormal::~SearchNormal()
  */
 void SearchNormal::Decode()
 {
-  const StaticData &staticData = StaticData::Instance();
   SentenceStats &stats = m_manager.GetSentenceStats();
 
   // initial seed hypothesis: nothing translated, no words produced
@@ -61,19 +152,22 @@ void SearchNormal::Decode()
   for (iterStack = m_hypoStackColl.begin() ; iterStack != m_hypoStackColl.end() ; ++iterStack) {
     // check if decoding ran out of time
     double _elapsed_time = GetUserTime();
-    if (_elapsed_time > staticData.GetTimeoutThreshold()) {
-      VERBOSE(1,"Decoding is out of time (" << _elapsed_time << "," << staticData.GetTimeoutThreshold() << ")" << std::endl);
+    if (_elapsed_time > m_options.timeoutThreshold) {
+      VERBOSE(1,"Decoding is out of time (" << _elapsed_time << "," << m_options.timeoutThreshold << ")" << std::endl);
       interrupted_flag = 1;
+      FlushStacks();
       return;
     }
     HypothesisStackNormal &sourceHypoColl = *static_cast<HypothesisStackNormal*>(*iterStack);
 
+    size_t maxHypoStackSize = GetStackSizeForDeadline(iterStack);
+
     // the stack is pruned before processing (lazy pruning):
     VERBOSE(3,"processing hypothesis from next stack");
     IFVERBOSE(2) {
       stats.StartTimeStack();
     }
-    sourceHypoColl.PruneToSize(staticData.GetMaxHypoStackSize());
+    sourceHypoColl.PruneToSize(maxHypoStackSize);
     VERBOSE(3,std::endl);
     sourceHypoColl.CleanupArcList();
     IFVERBOSE(2) {
@@ -81,10 +175,14 @@ void SearchNormal::Decode()
     }
 
     // go through each hypothesis on the stack and try to expand it
-    HypothesisStackNormal::const_iterator iterHypo;
-    for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
-      Hypothesis &hypothesis = **iterHypo;
-      ProcessOneHypothesis(hypothesis); // expand the hypothesis
+    if (m_searchThreads > 1 && sourceHypoColl.size() > 1) {
+      ExpandStackParallel(sourceHypoColl);
+    } else {
+      HypothesisStackNormal::const_iterator iterHypo;
+      for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
+        Hypothesis &hypothesis = **iterHypo;
+        ProcessOneHypothesis(hypothesis); // expand the hypothesis
+      }
     }
     // some logging
     IFVERBOSE(2) {
@@ -96,6 +194,105 @@ void SearchNormal::Decode()
 
   }
   //OutputHypoStack();
+  m_deadline.Finish(m_source.GetTranslationId());
+
+  IFVERBOSE(1) {
+    if (m_searchThreads > 1) {
+      TRACE_ERR("Line " << m_source.GetTranslationId() << ": Parallel expansion of "
+                << m_source.GetSize() << " words took " << stats.GetTimeExpandWall()
+                << " seconds, speedup " << stats.GetExpandSpeedup() << endl);
+    }
+  }
+}
+
+/**
+ * Stack size to prune the stack \p iterStack to before expanding it. If
+ * running late for the deadline, this is less than the configured size,
+ * and the beam of the later stacks is tightened too, until the search is
+ * back on schedule.
+ */
+size_t SearchNormal::GetStackSizeForDeadline(std::vector < HypothesisStack* >::iterator iterStack)
+{
+  if (!m_deadline.IsSet()) {
+    return m_options.maxHypoStackSize;
+  }
+  // the expansions of all stacks but the last one are the work to be done
+  bool wasTightened = m_deadline.IsTightened();
+  float scale = m_deadline.GetScale(iterStack - m_hypoStackColl.begin(), m_hypoStackColl.size() - 1);
+  if (scale < 1 || wasTightened) {
+    float beamWidth = DecodingDeadline::ScaleBeam(m_options.beamWidth, scale);
+    for (std::vector < HypothesisStack* >::iterator iter = iterStack + 1; iter != m_hypoStackColl.end(); ++iter) {
+      static_cast<HypothesisStackNormal*>(*iter)->SetBeamWidth(beamWidth);
+    }
+  }
+  return DecodingDeadline::ScaleLimit(m_options.maxHypoStackSize, scale);
+}
+
+/**
+ * End hash table recombination on the stacks that were not pruned, see
+ * HypothesisStackNormal::FlushTable.
+ */
+void SearchNormal::FlushStacks()
+{
+  std::vector < HypothesisStack* >::iterator iterStack;
+  for (iterStack = m_hypoStackColl.begin() ; iterStack != m_hypoStackColl.end() ; ++iterStack) {
+    static_cast<HypothesisStackNormal*>(*iterStack)->FlushTable();
+  }
+}
+
+/**
+ * Expand all hypotheses of a stack with several threads. Each thread
+ * collects the new hypotheses of the source hypotheses it picks up in a
+ * buffer of their own; the buffers are then added to the stacks in stack
+ * order, so that the result is the same as that of sequential expansion.
+ */
+void SearchNormal::ExpandStackParallel(const HypothesisStackNormal &sourceHypoColl)
+{
+#ifdef WITH_THREADS
+  double startTime = util::WallTime();
+
+  ExpansionTask::Shared shared(sourceHypoColl.size());
+  HypothesisStackNormal::const_iterator iterHypo;
+  for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
+    shared.hypos.push_back(*iterHypo);
+  }
+
+  // hypotheses are numbered in creation order, which is not deterministic
+  // here: renumber them below in the order they are added to the stacks
+  const int firstId = m_manager.GetNextHypoId();
+
+  size_t numHelpers = std::min(m_searchThreads - 1, shared.hypos.size() - 1);
+  shared.pending = numHelpers;
+  ThreadPool &pool = GetExpansionPool();
+  for (size_t i = 0 ; i < numHelpers ; ++i) {
+    pool.Submit(new ExpansionTask(*this, shared));
+  }
+  ExpansionTask::Expand(*this, shared);
+  {
+    boost::mutex::scoped_lock lock(shared.mutex);
+    while (shared.pending > 0) {
+      shared.done.wait(lock);
+    }
+  }
+
+  m_manager.SetNextHypoId(firstId);
+  for (size_t i = 0 ; i < shared.hypos.size() ; ++i) {
+    ExpansionBuffer &buffer = shared.buffers[i];
+    for (size_t j = 0 ; j < buffer.size() ; ++j) {
+      AddCollectedHypothesis(*shared.hypos[i], buffer[j]);
+    }
+  }
+
+  double wallTime = util::WallTime() - startTime;
+  // busy: collecting on all threads plus adding to the stacks on this one
+  double busyTime = shared.busy + wallTime;
+  m_manager.GetSentenceStats().AddParallelExpansion(wallTime, busyTime);
+#else
+  HypothesisStackNormal::const_iterator iterHypo;
+  for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
+    ProcessOneHypothesis(**iterHypo);
+  }
+#endif
 }
 
 
@@ -104,7 +301,7 @@ void SearchNormal::Decode()
  * violation of reordering limits.
  * \param hypothesis hypothesis to be expanded upon
  */
-void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
+void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis, ExpansionBuffer *buffer)
 {
   // since we check for reordering limits, its good to have that limit handy
   int maxDistortion = StaticData::Instance().GetMaxDistortion();
@@ -133,7 +330,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
         }
 
         //TODO: does this method include incompatible WordLattice hypotheses?
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, buffer);
       }
     }
 
@@ -207,7 +404,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
 
       // any length extension is okay if starting at left-most edge
       if (leftMostEdge) {
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, buffer);
       }
       // starting somewhere other than left-most edge, use caution
       else {
@@ -227,7 +424,7 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
         }
 
         // everything is fine, we're good to go
-        ExpandAllHypotheses(hypothesis, startPos, endPos);
+        ExpandAllHypotheses(hypothesis, startPos, endPos, buffer);
 
       }
     }
@@ -240,14 +437,15 @@ void SearchNormal::ProcessOneHypothesis(const Hypothesis &hypothesis)
  * \param hypothesis hypothesis to be expanded upon
  * \param startPos first word position of span covered
  * \param endPos last word position of span covered
+ * \param buffer if given, collect the new hypotheses here instead of adding them to the stacks
  */
 
-void SearchNormal::ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos)
+void SearchNormal::ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos, ExpansionBuffer *buffer)
 {
   // early discarding: check if hypothesis is too bad to build
   // this idea is explained in (Moore&Quirk, MT Summit 2007)
   float expectedScore = 0.0f;
-  if (StaticData::Instance().UseEarlyDiscarding()) {
+  if (m_options.UseEarlyDiscarding()) {
     // expected score is based on score of current hypothesis
     expectedScore = hypothesis.GetScore();
 
@@ -259,7 +457,11 @@ void SearchNormal::ExpandAllHypotheses(const Hypothesis &hypothesis, size_t star
   const TranslationOptionList &transOptList = m_transOptColl.GetTranslationOptionList(WordsRange(startPos, endPos));
   TranslationOptionList::const_iterator iter;
   for (iter = transOptList.begin() ; iter != transOptList.end() ; ++iter) {
-    ExpandHypothesis(hypothesis, **iter, expectedScore);
+    if (buffer) {
+      CollectHypothesis(hypothesis, **iter, expectedScore, *buffer);
+    } else {
+      ExpandHypothesis(hypothesis, **iter, expectedScore);
+    }
   }
 }
 
@@ -274,11 +476,10 @@ void SearchNormal::ExpandAllHypotheses(const Hypothesis &hypothesis, size_t star
  */
 void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt, float expectedScore)
 {
-  const StaticData &staticData = StaticData::Instance();
   SentenceStats &stats = m_manager.GetSentenceStats();
 
   Hypothesis *newHypo;
-  if (! staticData.UseEarlyDiscarding()) {
+  if (! m_options.UseEarlyDiscarding()) {
     // simple build, no questions asked
     IFVERBOSE(2) {
       stats.StartTimeBuildHyp();
@@ -293,14 +494,7 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const Translat
     // early discarding: check if hypothesis is too bad to build
   {
     // worst possible score may have changed -> recompute
-    size_t wordsTranslated = hypothesis.GetWordsBitmap().GetNumWordsCovered() + transOpt.GetSize();
-    float allowedScore = m_hypoStackColl[wordsTranslated]->GetWorstScore();
-    if (staticData.GetMinHypoStackDiversity()) {
-      WordsBitmapID id = hypothesis.GetWordsBitmap().GetIDPlus(transOpt.GetStartPos(), transOpt.GetEndPos());
-      float allowedScoreForBitmap = m_hypoStackColl[wordsTranslated]->GetWorstScoreForBitmap( id );
-      allowedScore = std::min( allowedScore, allowedScoreForBitmap );
-    }
-    allowedScore += staticData.GetEarlyDiscardingThreshold();
+    float allowedScore = GetAllowedScore(hypothesis, transOpt);
 
     // add expected score of translation option
     expectedScore += transOpt.GetFutureScore();
@@ -350,6 +544,90 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const Translat
   }
 }
 
+/**
+ * Lowest expected score with which an extension of hypothesis by transOpt
+ * survives early discarding, given the current state of the stacks.
+ */
+float SearchNormal::GetAllowedScore(const Hypothesis &hypothesis, const TranslationOption &transOpt) const
+{
+  size_t wordsTranslated = hypothesis.GetWordsBitmap().GetNumWordsCovered() + transOpt.GetSize();
+  float allowedScore = m_hypoStackColl[wordsTranslated]->GetWorstScore();
+  if (m_options.minHypoStackDiversity) {
+    WordsBitmapID id = hypothesis.GetWordsBitmap().GetIDPlus(transOpt.GetStartPos(), transOpt.GetEndPos());
+    float allowedScoreForBitmap = m_hypoStackColl[wordsTranslated]->GetWorstScoreForBitmap( id );
+    allowedScore = std::min( allowedScore, allowedScoreForBitmap );
+  }
+  return allowedScore + m_options.earlyDiscardingThreshold;
+}
+
+/**
+ * Parallel counterpart of ExpandHypothesis: build the new hypothesis and
+ * keep it in the buffer. Runs concurrently with other threads doing the
+ * same, and must not change any stack.
+ * With early discarding, the stacks seen here may be less full than
+ * sequential search would see them, so the test is repeated in
+ * AddCollectedHypothesis; an extension that is already too bad now is not
+ * built, but remembered in case it passes the test there.
+ */
+void SearchNormal::CollectHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt, float expectedScore, ExpansionBuffer &buffer)
+{
+  Hypothesis *newHypo;
+  if (! m_options.UseEarlyDiscarding()) {
+    newHypo = hypothesis.CreateNext(transOpt);
+    if (newHypo==NULL) return;
+    newHypo->EvaluateWhenApplied(m_transOptColl.GetFutureScore());
+  } else {
+    expectedScore += transOpt.GetFutureScore();
+    if (expectedScore < GetAllowedScore(hypothesis, transOpt)) {
+      buffer.push_back(ExpansionCandidate(transOpt, expectedScore, NULL));
+      return;
+    }
+    newHypo = hypothesis.CreateNext(transOpt);
+    if (newHypo==NULL) return;
+  }
+  buffer.push_back(ExpansionCandidate(transOpt, expectedScore, newHypo));
+}
+
+/**
+ * Add a hypothesis collected by CollectHypothesis to its stack, making the
+ * decisions ExpandHypothesis would make at this point of sequential search.
+ */
+void SearchNormal::AddCollectedHypothesis(const Hypothesis &hypothesis, ExpansionCandidate &candidate)
+{
+  SentenceStats &stats = m_manager.GetSentenceStats();
+
+  if (m_options.UseEarlyDiscarding()
+      && candidate.expectedScore < GetAllowedScore(hypothesis, *candidate.transOpt)) {
+    IFVERBOSE(2) {
+      if (candidate.hypo) {
+        stats.AddEarlyDiscarded();
+      } else {
+        stats.AddNotBuilt();
+      }
+    }
+    if (candidate.hypo) {
+      FREEHYPO( candidate.hypo );
+    }
+    return;
+  }
+
+  Hypothesis *newHypo = candidate.hypo;
+  if (newHypo) {
+    newHypo->SetId(m_manager.GetNextHypoId());
+  } else {
+    newHypo = hypothesis.CreateNext(*candidate.transOpt);
+    if (newHypo==NULL) return;
+  }
+
+  // logging for the curious
+  IFVERBOSE(3) {
+    newHypo->PrintHypothesis();
+  }
+
+  size_t wordsTranslated = newHypo->GetWordsBitmap().GetNumWordsCovered();
+  m_hypoStackColl[wordsTranslated]->AddPrune(newHypo);
+}
+
 const std::vector < HypothesisStack* >& SearchNormal::GetHypothesisStacks() const
 {
   return m_hypoStackColl;
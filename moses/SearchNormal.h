@@ -19,7 +19,22 @@ class TranslationOptionCollection;
  */
 class SearchNormal: public Search
 {
+  friend class ExpansionTask;
+
 protected:
+  /** An extension of one hypothesis, found by a worker during parallel
+   *  stack expansion. Candidates are added to the stacks afterwards, in the
+   *  order sequential search would have added them.
+   */
+  struct ExpansionCandidate {
+    ExpansionCandidate(const TranslationOption &transOpt, float expectedScore, Hypothesis *hypo)
+      : transOpt(&transOpt), expectedScore(expectedScore), hypo(hypo) {}
+    const TranslationOption *transOpt;
+    float expectedScore; // for early discarding
+    Hypothesis *hypo; // NULL if early discarding already ruled it out
+  };
+  typedef std::vector<ExpansionCandidate> ExpansionBuffer;
+
   const InputType &m_source;
   std::vector < HypothesisStack* > m_hypoStackColl; /**< stacks to store hypotheses (partial translations) */
   // no of elements = no of words in source + 1
@@ -27,11 +42,27 @@ protected:
   HypothesisStackNormal* actual_hypoStack; /**actual (full expanded) stack of hypotheses*/
   const TranslationOptionCollection &m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
 
+  /** threads expanding one stack, see -search-threads. They evaluate the
+   *  feature functions of new hypotheses concurrently, so feature functions
+   *  must be safe to call from several threads within one sentence.
+   *  1 if one of them has thread-local sentence state. */
+  size_t m_searchThreads;
+
   // functions for creating hypotheses
-  void ProcessOneHypothesis(const Hypothesis &hypothesis);
-  void ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos);
+  // if buffer is given, new hypotheses are collected there instead of added to the stacks
+  void ProcessOneHypothesis(const Hypothesis &hypothesis, ExpansionBuffer *buffer = NULL);
+  void ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos, ExpansionBuffer *buffer = NULL);
   virtual void ExpandHypothesis(const Hypothesis &hypothesis,const TranslationOption &transOpt, float expectedScore);
 
+  size_t GetStackSizeForDeadline(std::vector < HypothesisStack* >::iterator iterStack);
+  void FlushStacks();
+
+  // parallel stack expansion
+  void ExpandStackParallel(const HypothesisStackNormal &sourceHypoColl);
+  void CollectHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt, float expectedScore, ExpansionBuffer &buffer);
+  void AddCollectedHypothesis(const Hypothesis &hypothesis, ExpansionCandidate &candidate);
+  float GetAllowedScore(const Hypothesis &hypothesis, const TranslationOption &transOpt) const;
+
 public:
   SearchNormal(Manager& manager, const InputType &source, const TranslationOptionCollection &transOptColl);
   ~SearchNormal();
@@ -14,7 +14,7 @@ SearchNormalBatch::SearchNormalBatch(Manager& manager, const InputType &source,
   :SearchNormal(manager, source, transOptColl)
   ,m_batch_size(10000)
 {
-  m_max_stack_size = StaticData::Instance().GetMaxHypoStackSize();
+  m_max_stack_size = m_options.maxHypoStackSize;
 
   // Split the feature functions into sets of stateless, stateful
   // distributed lm, and stateful non-distributed.
@@ -42,7 +42,6 @@ SearchNormalBatch::~SearchNormalBatch()
  */
 void SearchNormalBatch::Decode()
 {
-  const StaticData &staticData = StaticData::Instance();
   SentenceStats &stats = m_manager.GetSentenceStats();
 
   // initial seed hypothesis: nothing translated, no words produced
@@ -54,19 +53,21 @@ void SearchNormalBatch::Decode()
   for (iterStack = m_hypoStackColl.begin() ; iterStack != m_hypoStackColl.end() ; ++iterStack) {
     // check if decoding ran out of time
     double _elapsed_time = GetUserTime();
-    if (_elapsed_time > staticData.GetTimeoutThreshold()) {
-      VERBOSE(1,"Decoding is out of time (" << _elapsed_time << "," << staticData.GetTimeoutThreshold() << ")" << std::endl);
+    if (_elapsed_time > m_options.timeoutThreshold) {
+      VERBOSE(1,"Decoding is out of time (" << _elapsed_time << "," << m_options.timeoutThreshold << ")" << std::endl);
       interrupted_flag = 1;
+      FlushStacks();
       return;
     }
     HypothesisStackNormal &sourceHypoColl = *static_cast<HypothesisStackNormal*>(*iterStack);
+    size_t maxHypoStackSize = GetStackSizeForDeadline(iterStack);
 
     // the stack is pruned before processing (lazy pruning):
     VERBOSE(3,"processing hypothesis from next stack");
     IFVERBOSE(2) {
       stats.StartTimeStack();
     }
-    sourceHypoColl.PruneToSize(staticData.GetMaxHypoStackSize());
+    sourceHypoColl.PruneToSize(maxHypoStackSize);
     VERBOSE(3,std::endl);
     sourceHypoColl.CleanupArcList();
     IFVERBOSE(2) {
@@ -91,6 +92,7 @@ void SearchNormalBatch::Decode()
   }
 
   EvalAndMergePartialHypos();
+  m_deadline.Finish(m_source.GetTranslationId());
 }
 
 /**
@@ -113,11 +115,10 @@ ExpandHypothesis(const Hypothesis &hypothesis,
     EvalAndMergePartialHypos();
   }
 
-  const StaticData &staticData = StaticData::Instance();
   SentenceStats &stats = m_manager.GetSentenceStats();
 
   Hypothesis *newHypo;
-  if (! staticData.UseEarlyDiscarding()) {
+  if (! m_options.UseEarlyDiscarding()) {
     // simple build, no questions asked
     IFVERBOSE(2) {
       stats.StartTimeBuildHyp();
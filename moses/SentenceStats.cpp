@@ -21,6 +21,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <iostream>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/resource.h>
+#endif
 #include "SentenceStats.h"
 #include "InputPath.h"
 #include "TranslationOption.h"
@@ -40,6 +43,17 @@ void SentenceStats::CalcFinalStats(const Hypothesis& bestHypo)
   //inserted words--not implemented yet 8/1 TODO
 }
 
+size_t SentenceStats::GetPeakRSS()
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    return usage.ru_maxrss;
+  }
+#endif
+  return 0;
+}
+
 void SentenceStats::AddDeletedWords(const Hypothesis& hypo)
 {
   //don't check either a null pointer or the empty initial hypothesis (if we were given the empty hypo, the null check will save us)
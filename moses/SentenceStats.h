@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <string>
 #include <vector>
 #include <time.h>
+#include <boost/atomic.hpp>
 #include "Timer.h"
 #include "Phrase.h"
 #include "Hypothesis.h"
@@ -46,6 +47,15 @@ struct RecombinationInfo {
   float betterProb, worseProb;
 };
 
+//! Time spent on the chart cells of one width, see ChartManager::DecodeByWidth(). Used by SentenceStats class
+struct ChartWidthTimes {
+  ChartWidthTimes() : numCells(0), lookup(0), decodeWall(0), decodeBusy(0) {}
+
+  size_t numCells;
+  double lookup; // looking up rules, on the decoding thread
+  double decodeWall, decodeBusy; // decoding the cells, wall clock and summed over all threads
+};
+
 /**
  * stats relating to decoder operation on a given sentence
  */
@@ -66,6 +76,12 @@ public:
     m_numHyposDiscarded = 0;
     m_numHyposEarlyDiscarded = 0;
     m_numHyposNotBuilt = 0;
+    m_timeExpandWall = 0;
+    m_timeExpandBusy = 0;
+    m_numHyposAllocated = 0;
+    m_numHyposReused = 0;
+    m_numArenaBlocks = 0;
+    m_chartWidthTimes.clear();
     m_totalSourceWords = source.GetSize();
     m_recombinationInfos.clear();
     m_deletedWords.clear();
@@ -125,6 +141,34 @@ public:
   double GetTimeTotal() const {
     return m_timeTotal.get_elapsed_time();
   }
+  //! wall clock seconds spent in parallel stack expansion
+  double GetTimeExpandWall() const {
+    return m_timeExpandWall;
+  }
+  //! seconds spent expanding hypotheses, summed over all threads taking part
+  double GetTimeExpandBusy() const {
+    return m_timeExpandBusy;
+  }
+  double GetExpandSpeedup() const {
+    return m_timeExpandWall > 0 ? m_timeExpandBusy / m_timeExpandWall : 1;
+  }
+  //! chart decoding in order of width: times per width, starting with width 1
+  const std::vector<ChartWidthTimes>& GetChartWidthTimes() const {
+    return m_chartWidthTimes;
+  }
+  //! Allocate() calls on the hypothesis arena of the Manager
+  size_t GetNumHyposAllocated() const {
+    return m_numHyposAllocated;
+  }
+  size_t GetNumHyposReused() const {
+    return m_numHyposReused;
+  }
+  //! heap allocations made for hypotheses
+  size_t GetNumArenaBlocks() const {
+    return m_numArenaBlocks;
+  }
+  //! peak resident set size of the process in kB, 0 if unknown
+  static size_t GetPeakRSS();
   size_t GetTotalSourceWords() const {
     return m_totalSourceWords;
   }
@@ -163,6 +207,25 @@ public:
   void AddDiscarded() {
     m_numHyposDiscarded++;
   }
+  void AddParallelExpansion(double wall, double busy) {
+    m_timeExpandWall += wall;
+    m_timeExpandBusy += busy;
+  }
+  void AddChartWidth(size_t width, size_t numCells, double lookup, double decodeWall, double decodeBusy) {
+    if (m_chartWidthTimes.size() < width) {
+      m_chartWidthTimes.resize(width);
+    }
+    ChartWidthTimes &times = m_chartWidthTimes[width - 1];
+    times.numCells += numCells;
+    times.lookup += lookup;
+    times.decodeWall += decodeWall;
+    times.decodeBusy += decodeBusy;
+  }
+  void SetHypothesisArenaStats(size_t allocated, size_t reused, size_t blocks) {
+    m_numHyposAllocated = allocated;
+    m_numHyposReused = reused;
+    m_numArenaBlocks = blocks;
+  }
 
   void StartTimeCollectOpts() {
     m_timeCollectOpts.start();
@@ -231,10 +294,10 @@ protected:
   // since clock seconds aren't reliable in a multi-threaded environment -Jon
   // (see Manager.cpp for some initial work moving in this direction)
   std::vector<RecombinationInfo> m_recombinationInfos;
-  unsigned int m_numHyposCreated;
+  boost::atomic<unsigned int> m_numHyposCreated; // hypotheses may be created by several threads
   unsigned int m_numHyposPopped;
-  unsigned int m_numHyposPruned;
-  unsigned int m_numHyposDiscarded;
+  boost::atomic<unsigned int> m_numHyposPruned; // chart cells may be pruned by several threads
+  boost::atomic<unsigned int> m_numHyposDiscarded;
   unsigned int m_numHyposEarlyDiscarded;
   unsigned int m_numHyposNotBuilt;
   Timer m_timeCollectOpts;
@@ -246,6 +309,12 @@ protected:
   Timer m_timeSetupCubes;
   Timer m_timeManageCubes;
   Timer m_timeTotal;
+  double m_timeExpandWall;
+  double m_timeExpandBusy;
+  size_t m_numHyposAllocated;
+  size_t m_numHyposReused;
+  size_t m_numArenaBlocks;
+  std::vector<ChartWidthTimes> m_chartWidthTimes;
 
   //words
   size_t m_totalSourceWords;
@@ -275,6 +344,11 @@ inline std::ostream& operator<<(std::ostream& os, const SentenceStats& ss)
          << "        manage cubes    " << ss.GetTimeManageCubes()   << " (" << (int)(100 * ss.GetTimeManageCubes()/totalTime) << "%)" << std::endl
          << "        manage stacks   " << ss.GetTimeStack()         << " (" << (int)(100 * ss.GetTimeStack()/totalTime) << "%)" << std::endl
          << "        other           " << otherTime                 << " (" << (int)(100 * otherTime/totalTime) << "%)" << std::endl
+         << "parallel expansion      " << ss.GetTimeExpandWall()    << " (speedup " << ss.GetExpandSpeedup() << ")" << std::endl
+
+         << "hypotheses allocated = " << ss.GetNumHyposAllocated() << " (" << ss.GetNumHyposReused() << " reused, "
+         << ss.GetNumArenaBlocks() << " heap allocations)" << std::endl
+         << "peak RSS = " << SentenceStats::GetPeakRSS() << " kB" << std::endl
 
          << "total source words = " << ss.GetTotalSourceWords() << std::endl
          << "     words deleted = " << ss.GetNumWordsDeleted() << " (" << Join(" ", ss.GetDeletedWords()) << ")" << std::endl
@@ -45,17 +45,141 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "DecodeGraph.h"
 #include "TranslationModel/PhraseDictionary.h"
 #include "TranslationModel/PhraseDictionaryTreeAdaptor.h"
+#include "ThreadPool.h"
+#include "util/exception.hh"
+#include "util/usage.hh"
 
 #ifdef WITH_THREADS
 #include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
 #endif
 
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
 using namespace std;
 
 namespace Moses
 {
 bool g_mosesDebug = false;
 
+namespace
+{
+//! bytes read by the calling thread so far, -1 if unknown. Pages of mapped files are not counted
+long long ThreadBytesRead()
+{
+  std::ifstream io("/proc/thread-self/io");
+  string key;
+  long long value;
+  while (io >> key >> value) {
+    if (key == "rchar:") {
+      return value;
+    }
+  }
+  return -1;
+}
+
+//! resident set size of the process in kB, 0 if unknown
+size_t CurrentRSS()
+{
+  std::ifstream statm("/proc/self/statm");
+  size_t size, resident;
+  if (statm >> size >> resident) {
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+  }
+  return 0;
+}
+
+//! Load() of one feature function, with what it cost
+class FeatureLoad
+{
+public:
+  explicit FeatureLoad(FeatureFunction *ff) : m_ff(ff) {}
+
+  void Load() {
+    VERBOSE(1, "Loading " << m_ff->GetScoreProducerDescription() << endl);
+    double start = util::WallTime();
+    long long bytesRead = ThreadBytesRead();
+    m_ff->Load();
+    double wallTime = util::WallTime() - start;
+    if (bytesRead >= 0) {
+      bytesRead = ThreadBytesRead() - bytesRead;
+    }
+
+    // one write, as other features may be loaded at the same time
+    std::ostringstream report;
+    report << "Loaded " << m_ff->GetScoreProducerDescription() << " in " << wallTime << " seconds";
+    if (bytesRead >= 0) {
+      report << ", read " << bytesRead / (1024 * 1024) << " MB";
+    }
+    report << ", process resident " << CurrentRSS() / 1024 << " MB" << endl;
+    VERBOSE(1, report.str());
+  }
+
+  //! Load(), keeping the message of an exception for the loading thread to throw
+  void LoadCatching() {
+    try {
+      Load();
+    } catch (const std::exception &e) {
+      m_error = e.what();
+    } catch (const std::string &e) {
+      m_error = e;
+    } catch (...) {
+      m_error = "unknown error";
+    }
+  }
+
+  const FeatureFunction &GetFeature() const {
+    return *m_ff;
+  }
+  const std::string &GetError() const {
+    return m_error;
+  }
+
+private:
+  FeatureFunction *m_ff;
+  std::string m_error;
+};
+
+#ifdef WITH_THREADS
+class FeatureLoadTask : public Task
+{
+public:
+  explicit FeatureLoadTask(FeatureLoad &load) : m_load(load) {}
+  virtual void Run() {
+    m_load.LoadCatching();
+  }
+private:
+  FeatureLoad &m_load;
+};
+#endif
+
+//! features are independent of each other, so they can be loaded at the same time
+void LoadFeatures(std::vector<FeatureLoad> &loads, size_t numThreads)
+{
+#ifdef WITH_THREADS
+  if (numThreads > 1 && loads.size() > 1) {
+    {
+      ThreadPool pool(std::min(numThreads, loads.size()));
+      for (size_t i = 0; i < loads.size(); ++i) {
+        pool.Submit(new FeatureLoadTask(loads[i]));
+      }
+      pool.Stop(true);
+    }
+    for (size_t i = 0; i < loads.size(); ++i) {
+      UTIL_THROW_IF2(!loads[i].GetError().empty(), "Error loading "
+                     << loads[i].GetFeature().GetScoreProducerDescription() << ": " << loads[i].GetError());
+    }
+    return;
+  }
+#endif
+  for (size_t i = 0; i < loads.size(); ++i) {
+    loads[i].Load();
+  }
+}
+}
+
 StaticData StaticData::s_instance;
 
 StaticData::StaticData()
@@ -65,6 +189,7 @@ StaticData::StaticData()
   ,m_needAlignmentInfo(false)
   ,m_lmEnableOOVFeature(false)
   ,m_isAlwaysCreateDirectTranslationOption(false)
+  ,m_ruleLoadPool(NULL)
   ,m_currentWeightSetting("default")
   ,m_useS2TDecoder(false)
   ,m_treeStructure(NULL)
@@ -303,6 +428,8 @@ bool StaticData::LoadData(Parameter *parameter)
   //Disable discarding
   m_parameter->SetParameter(m_disableDiscarding, "disable-discarding", false);
 
+  m_parameter->SetParameter(m_useStackHash, "stack-hash", false);
+
   //Print Translation Options
   m_parameter->SetParameter(m_printTranslationOptions, "print-translation-option", false );
 
@@ -414,6 +541,7 @@ bool StaticData::LoadData(Parameter *parameter)
 
   m_parameter->SetParameter<size_t>(m_timeout_threshold, "time-out", -1);
   m_timeout = (GetTimeoutThreshold() == (size_t)-1) ? false : true;
+  m_parameter->SetParameter<float>(m_deadline, "deadline", 0);
 
   m_parameter->SetParameter<size_t>(m_lmcache_cleanup_threshold, "clean-lm-cache", 1);
 
@@ -446,6 +574,33 @@ bool StaticData::LoadData(Parameter *parameter)
     }
   }
 
+  m_parameter->SetParameter<size_t>(m_searchThreadCount, "search-threads", 1);
+#ifndef WITH_THREADS
+  if (m_searchThreadCount > 1) {
+    UserMessage::Add("Error: search-threads > 1 but moses not built with thread support");
+    return false;
+  }
+#endif
+
+  m_parameter->SetParameter<size_t>(m_loadThreadCount, "load-threads", 1);
+#ifndef WITH_THREADS
+  if (m_loadThreadCount > 1) {
+    UserMessage::Add("Error: load-threads > 1 but moses not built with thread support");
+    return false;
+  }
+#endif
+
+  params = m_parameter->GetParam("thread-priority-length");
+  if (params && params->size()) {
+    m_threadPriorityLengths = Scan<size_t>(*params);
+    for (size_t i = 1; i < m_threadPriorityLengths.size(); ++i) {
+      if (m_threadPriorityLengths[i] <= m_threadPriorityLengths[i - 1]) {
+        UserMessage::Add("thread-priority-length values must be ascending");
+        return false;
+      }
+    }
+  }
+
   m_parameter->SetParameter<long>(m_startTranslationId, "start-translation-id", 0);
 
   // use of xml in input
@@ -504,6 +659,11 @@ bool StaticData::LoadData(Parameter *parameter)
 
   if (!LoadDecodeGraphs()) return false;
 
+  if (m_searchThreadCount > 1 && HasThreadLocalSentenceState()) {
+    VERBOSE(1, "search-threads: a feature keeps sentence state in thread-local storage, "
+            "each sentence is decoded on one thread" << endl);
+  }
+
 
   if (!CheckWeights()) {
     return false;
@@ -533,9 +693,27 @@ bool StaticData::LoadData(Parameter *parameter)
       return false;
     }
   }
+
+  InitDecodingOptions();
   return true;
 }
 
+void StaticData::InitDecodingOptions()
+{
+  m_decodingOptions.nBestEnabled = IsNBestEnabled();
+  m_decodingOptions.nBestSize = m_nBestSize;
+  m_decodingOptions.outputSearchGraph = m_outputSearchGraph;
+  m_decodingOptions.maxHypoStackSize = m_maxHypoStackSize;
+  m_decodingOptions.minHypoStackDiversity = m_minHypoStackDiversity;
+  m_decodingOptions.beamWidth = m_beamWidth;
+  m_decodingOptions.earlyDiscardingThreshold = m_earlyDiscardingThreshold;
+  m_decodingOptions.cubePruningPopLimit = m_cubePruningPopLimit;
+  m_decodingOptions.cubePruningDiversity = m_cubePruningDiversity;
+  m_decodingOptions.timeoutThreshold = m_timeout_threshold;
+  m_decodingOptions.deadline = m_deadline;
+  m_decodingOptions.searchThreads = m_searchThreadCount;
+}
+
 void StaticData::SetWeight(const FeatureFunction* sp, float weight)
 {
   m_allWeights.Resize();
@@ -848,6 +1026,18 @@ void StaticData::InitializeForInput(const InputType& source) const
   }
 }
 
+bool StaticData::HasThreadLocalSentenceState() const
+{
+  const std::vector<FeatureFunction*> &producers = FeatureFunction::GetFeatureFunctions();
+  for(size_t i=0; i<producers.size(); ++i) {
+    const FeatureFunction &ff = *producers[i];
+    if (! IsFeatureFunctionIgnored(ff) && ff.HasThreadLocalSentenceState()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void StaticData::CleanUpAfterSentenceProcessing(const InputType& source) const
 {
   const std::vector<FeatureFunction*> &producers = FeatureFunction::GetFeatureFunctions();
@@ -861,29 +1051,46 @@ void StaticData::CleanUpAfterSentenceProcessing(const InputType& source) const
 
 void StaticData::LoadFeatureFunctions()
 {
+  double start = util::WallTime();
+
+  // phrase tables are loaded after all other features, as they may score
+  // their rules with them. Within each group, see -load-threads
+  std::vector<FeatureLoad> features, phraseTables;
   const std::vector<FeatureFunction*> &ffs = FeatureFunction::GetFeatureFunctions();
   std::vector<FeatureFunction*>::const_iterator iter;
   for (iter = ffs.begin(); iter != ffs.end(); ++iter) {
     FeatureFunction *ff = *iter;
-    bool doLoad = true;
-
-    // if (PhraseDictionary *ffCast = dynamic_cast<PhraseDictionary*>(ff)) {
-    if (dynamic_cast<PhraseDictionary*>(ff)) {
-      doLoad = false;
-    }
-
-    if (doLoad) {
-      VERBOSE(1, "Loading " << ff->GetScoreProducerDescription() << endl);
-      ff->Load();
+    if (!dynamic_cast<PhraseDictionary*>(ff)) {
+      features.push_back(FeatureLoad(ff));
     }
   }
 
   const std::vector<PhraseDictionary*> &pts = PhraseDictionary::GetColl();
   for (size_t i = 0; i < pts.size(); ++i) {
-    PhraseDictionary *pt = pts[i];
-    VERBOSE(1, "Loading " << pt->GetScoreProducerDescription() << endl);
-    pt->Load();
+    phraseTables.push_back(FeatureLoad(pts[i]));
+  }
+
+  LoadFeatures(features, m_loadThreadCount);
+#ifdef WITH_THREADS
+  // one pool parses the rules of all text tables loaded at the same time.
+  // A pool per table would start load-threads squared threads
+  boost::scoped_ptr<ThreadPool> ruleLoadPool;
+  if (m_loadThreadCount > 1) {
+    ruleLoadPool.reset(new ThreadPool(m_loadThreadCount));
+  }
+  m_ruleLoadPool = ruleLoadPool.get();
+  try {
+    LoadFeatures(phraseTables, m_loadThreadCount);
+  } catch (...) {
+    m_ruleLoadPool = NULL;
+    throw;
   }
+  m_ruleLoadPool = NULL;
+#else
+  LoadFeatures(phraseTables, m_loadThreadCount);
+#endif
+  VERBOSE(1, "Loaded " << features.size() + phraseTables.size() << " feature functions in "
+          << util::WallTime() - start << " seconds with " << m_loadThreadCount << " load threads" << endl);
 
   CheckLEGACYPT();
 }
@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_StaticData_h
 #define moses_StaticData_h
 
+#include <algorithm>
 #include <stdexcept>
 #include <limits>
 #include <list>
@@ -41,6 +42,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Parameter.h"
 #include "SentenceStats.h"
 #include "ScoreComponentCollection.h"
+#include "DecodingOptions.h"
 #include "moses/FF/Factory.h"
 #include "moses/PP/Factory.h"
 
@@ -50,6 +52,7 @@ namespace Moses
 class InputType;
 class DecodeGraph;
 class DecodeStep;
+class ThreadPool;
 
 class DynamicCacheBasedLanguageModel;
 class PhraseDictionaryDynamicCacheBased;
@@ -71,6 +74,7 @@ protected:
   Parameter *m_parameter;
   std::vector<FactorType>	m_inputFactorOrder, m_outputFactorOrder;
   mutable ScoreComponentCollection m_allWeights;
+  DecodingOptions m_decodingOptions; //!< defaults for all inputs, from the options below
 
   std::vector<DecodeGraph*> m_decodeGraphs;
 
@@ -107,6 +111,7 @@ protected:
   bool m_wordDeletionEnabled;
 
   bool m_disableDiscarding;
+  bool m_useStackHash;
   bool m_printAllDerivations;
   bool m_printTranslationOptions;
 
@@ -163,6 +168,7 @@ protected:
 
   bool m_timeout; //! use timeout
   size_t m_timeout_threshold; //! seconds after which time out is activated
+  float m_deadline; //! wall clock seconds per sentence, see DecodingDeadline
 
   bool m_isAlwaysCreateDirectTranslationOption;
   //! constructor. only the 1 static variable can be created
@@ -196,6 +202,10 @@ protected:
   WordAlignmentSort m_wordAlignmentSort;
 
   int m_threadCount;
+  size_t m_searchThreadCount;
+  size_t m_loadThreadCount;
+  ThreadPool *m_ruleLoadPool; //!< see GetRuleLoadThreadPool()
+  std::vector<size_t> m_threadPriorityLengths;
   long m_startTranslationId;
 
   // alternate weight settings
@@ -224,6 +234,8 @@ protected:
 
   void NoCache();
 
+  void InitDecodingOptions();
+
   bool m_continuePartialTranslation;
   std::string m_binPath;
 
@@ -304,6 +316,10 @@ public:
   bool IsWordDeletionEnabled() const {
     return m_wordDeletionEnabled;
   }
+  //! search options of inputs that do not have their own, see InputType::GetOptions()
+  const DecodingOptions &GetDecodingOptions() const {
+    return m_decodingOptions;
+  }
   size_t GetMaxHypoStackSize() const {
     return m_maxHypoStackSize;
   }
@@ -346,6 +362,10 @@ public:
   bool UseEarlyDiscarding() const {
     return m_earlyDiscardingThreshold != -std::numeric_limits<float>::infinity();
   }
+  //! recombine in a hash table while a stack is filled (-stack-hash)
+  bool UseStackHash() const {
+    return m_useStackHash;
+  }
   bool UseEarlyDistortionCost() const {
     return m_useEarlyDistortionCost;
   }
@@ -526,6 +546,9 @@ public:
   size_t GetTimeoutThreshold() const {
     return m_timeout_threshold;
   }
+  float GetDeadline() const {
+    return m_deadline;
+  }
 
   size_t GetLMCacheCleanupThreshold() const {
     return m_lmcache_cleanup_threshold;
@@ -540,6 +563,7 @@ public:
   }
   void SetOutputSearchGraph(bool outputSearchGraph) {
     m_outputSearchGraph = outputSearchGraph;
+    InitDecodingOptions();
   }
   bool GetOutputSearchGraphExtended() const {
     return m_outputSearchGraphExtended;
@@ -623,6 +647,31 @@ public:
     return m_threadCount;
   }
 
+  //! threads working on one stack of a phrase-based search, including the decoding thread
+  size_t GetSearchThreadCount() const {
+    return m_searchThreadCount;
+  }
+  //! a feature keeps sentence state in thread-local storage, see FeatureFunction::HasThreadLocalSentenceState()
+  bool HasThreadLocalSentenceState() const;
+  size_t GetLoadThreadCount() const {
+    return m_loadThreadCount;
+  }
+  //! threads parsing text rule tables, shared by the phrase tables loaded at startup.
+  //! NULL with -load-threads 1, and once the phrase tables are loaded
+  ThreadPool *GetRuleLoadThreadPool() const {
+    return m_ruleLoadPool;
+  }
+
+  //! number of thread pool priority classes set up by -thread-priority-length
+  size_t GetThreadPriorityClasses() const {
+    return m_threadPriorityLengths.size() + 1;
+  }
+  //! thread pool priority class of a source sentence with the given length
+  size_t GetThreadPriority(size_t sourceLength) const {
+    return std::lower_bound(m_threadPriorityLengths.begin(), m_threadPriorityLengths.end(), sourceLength)
+           - m_threadPriorityLengths.begin();
+  }
+
   long GetStartTranslationId() const {
     return m_startTranslationId;
   }
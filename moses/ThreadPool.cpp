@@ -20,6 +20,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 
+#include <algorithm>
+
 #include "ThreadPool.h"
 
 #ifdef WITH_THREADS
@@ -30,54 +32,143 @@ using namespace Moses;
 namespace Moses
 {
 
-ThreadPool::ThreadPool( size_t numThreads )
-  : m_stopped(false), m_stopping(false), m_queueLimit(0)
+std::ostream& operator<<(std::ostream &out, const ThreadPoolStats &stats)
 {
+  out << "tasks=" << stats.executed
+      << " stolen=" << stats.stolen
+      << " steal-rate=" << stats.GetStealRate()
+      << " mean-queue-wait=" << stats.GetMeanWait()
+      << " max-queue-wait=" << stats.maxWait;
+  return out;
+}
+
+ThreadPool::ThreadPool( size_t numThreads, size_t numPriorityClasses )
+  : m_numPriorityClasses(numPriorityClasses ? numPriorityClasses : 1)
+  , m_queued(0), m_idle(0), m_nextWorker(0)
+  , m_stopped(false), m_stopping(false), m_queueLimit(0)
+{
+  // always keep one set of deques, so that Submit has somewhere to queue
+  for (size_t i = 0; i < std::max<size_t>(numThreads, 1); ++i) {
+    m_workers.push_back(new Worker(m_numPriorityClasses));
+  }
   for (size_t i = 0; i < numThreads; ++i) {
-    m_threads.create_thread(boost::bind(&ThreadPool::Execute,this));
+    m_threads.create_thread(boost::bind(&ThreadPool::Execute,this,i));
+  }
+}
+
+bool ThreadPool::Take(size_t workerId, Task *&task, boost::posix_time::ptime &submitted)
+{
+  if (m_queued == 0) {
+    return false;
+  }
+  const size_t numWorkers = m_workers.size();
+  Worker &self = m_workers[workerId];
+  for (size_t priority = 0; priority < m_numPriorityClasses; ++priority) {
+    {
+      // own deque: oldest first, so sentences finish roughly in input order
+      boost::mutex::scoped_lock lock(self.mutex);
+      std::deque<QueuedTask> &queue = self.queues[priority];
+      if (!queue.empty()) {
+        task = queue.front().task;
+        submitted = queue.front().submitted;
+        queue.pop_front();
+        --m_queued;
+        return true;
+      }
+    }
+    for (size_t i = 1; i < numWorkers; ++i) {
+      // steal from the back, away from the victim's own end
+      Worker &victim = m_workers[(workerId + i) % numWorkers];
+      boost::mutex::scoped_lock lock(victim.mutex);
+      std::deque<QueuedTask> &queue = victim.queues[priority];
+      if (!queue.empty()) {
+        task = queue.back().task;
+        submitted = queue.back().submitted;
+        queue.pop_back();
+        --m_queued;
+        lock.unlock();
+
+        boost::mutex::scoped_lock selfLock(self.mutex);
+        ++self.stats.stolen;
+        return true;
+      }
+    }
   }
+  return false;
 }
 
-void ThreadPool::Execute()
+void ThreadPool::Execute(size_t workerId)
 {
+  Worker &self = m_workers[workerId];
   do {
     Task* task = NULL;
-    {
-      // Find a job to perform
+    boost::posix_time::ptime submitted;
+    if (!Take(workerId, task, submitted)) {
+      // Nothing to do anywhere: sleep until a job is submitted
       boost::mutex::scoped_lock lock(m_mutex);
-      if (m_tasks.empty() && !m_stopped) {
+      ++m_idle;
+      if (m_queued == 0 && !m_stopped) {
         m_threadNeeded.wait(lock);
       }
-      if (!m_stopped && !m_tasks.empty()) {
-        task = m_tasks.front();
-        m_tasks.pop();
+      --m_idle;
+      continue;
+    }
+    if (m_queueLimit > 0 || m_stopping) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_threadAvailable.notify_all();
+    }
+
+    double wait = (boost::posix_time::microsec_clock::universal_time()
+                   - submitted).total_microseconds() / 1000000.0;
+    {
+      boost::mutex::scoped_lock lock(self.mutex);
+      ++self.stats.executed;
+      self.stats.totalWait += wait;
+      if (wait > self.stats.maxWait) {
+        self.stats.maxWait = wait;
       }
     }
+
     //Execute job
-    if (task) {
-      // must read from task before run. otherwise task may be deleted by main thread
-      // race condition
-      bool del = task->DeleteAfterExecution();
-      task->Run();
-      if (del) {
-        delete task;
-      }
+    // must read from task before run. otherwise task may be deleted by main thread
+    // race condition
+    bool del = task->DeleteAfterExecution();
+    task->Run();
+    if (del) {
+      delete task;
     }
-    m_threadAvailable.notify_all();
   } while (!m_stopped);
 }
 
-void ThreadPool::Submit( Task* task )
+void ThreadPool::Submit( Task* task, size_t priority )
 {
-  boost::mutex::scoped_lock lock(m_mutex);
   if (m_stopping) {
     throw runtime_error("ThreadPool stopping - unable to accept new jobs");
   }
-  while (m_queueLimit > 0 && m_tasks.size() >= m_queueLimit) {
-    m_threadAvailable.wait(lock);
+  if (priority >= m_numPriorityClasses) {
+    priority = m_numPriorityClasses - 1;
+  }
+  if (m_queueLimit > 0 && m_queued >= m_queueLimit) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_queued >= m_queueLimit && !m_stopped) {
+      m_threadAvailable.wait(lock);
+    }
+  }
+
+  Worker &worker = m_workers[m_nextWorker++ % m_workers.size()];
+  {
+    boost::mutex::scoped_lock lock(worker.mutex);
+    worker.queues[priority].push_back(
+      QueuedTask(task, boost::posix_time::microsec_clock::universal_time()));
+    ++m_queued;
+  }
+
+  // the increment above is visible to any thread that registers as idle
+  // after this check, so it will not go to sleep on a non-empty pool
+  if (m_idle > 0) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_threadNeeded.notify_one();
   }
-  m_tasks.push(task);
-  m_threadNeeded.notify_all();
 }
 
 void ThreadPool::Stop(bool processRemainingJobs)
@@ -91,7 +182,7 @@ void ThreadPool::Stop(bool processRemainingJobs)
   if (processRemainingJobs) {
     boost::mutex::scoped_lock lock(m_mutex);
     //wait for queue to drain.
-    while (!m_tasks.empty() && !m_stopped) {
+    while (m_queued > 0 && !m_stopped) {
       m_threadAvailable.wait(lock);
     }
   }
@@ -101,10 +192,27 @@ void ThreadPool::Stop(bool processRemainingJobs)
     m_stopped = true;
   }
   m_threadNeeded.notify_all();
+  m_threadAvailable.notify_all();
 
   m_threads.join_all();
 }
 
+ThreadPoolStats ThreadPool::GetStats() const
+{
+  ThreadPoolStats total;
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    const Worker &worker = m_workers[i];
+    boost::mutex::scoped_lock lock(worker.mutex);
+    total.executed += worker.stats.executed;
+    total.stolen += worker.stats.stolen;
+    total.totalWait += worker.stats.totalWait;
+    if (worker.stats.maxWait > total.maxWait) {
+      total.maxWait = worker.stats.maxWait;
+    }
+  }
+  return total;
+}
+
 }
 #endif //WITH_THREADS
 
@@ -22,12 +22,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_ThreadPool_h
 #define moses_ThreadPool_h
 
+#include <deque>
 #include <iostream>
-#include <queue>
 #include <vector>
 
 #ifdef WITH_THREADS
+#include <boost/atomic.hpp>
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/thread.hpp>
 #endif
 
@@ -54,27 +57,66 @@ public:
   virtual bool DeleteAfterExecution() {
     return true;
   }
+  /** Priority class of this task. Lower classes are picked up first;
+   *  classes beyond the pool's range are clamped to its last class.
+   */
+  virtual size_t GetPriority() const {
+    return 0;
+  }
   virtual ~Task() {}
 };
 
 #ifdef WITH_THREADS
 
+/** Scheduling counters of a ThreadPool, summed over all workers.
+ */
+struct ThreadPoolStats {
+  ThreadPoolStats() : executed(0), stolen(0), totalWait(0), maxWait(0) {}
+
+  size_t executed; // tasks run
+  size_t stolen; // tasks run by a worker other than the one they were queued on
+  double totalWait; // seconds between Submit and start of Run, summed
+  double maxWait;
+
+  double GetMeanWait() const {
+    return executed ? totalWait / executed : 0;
+  }
+  double GetStealRate() const {
+    return executed ? (double) stolen / executed : 0;
+  }
+};
+
+std::ostream& operator<<(std::ostream &out, const ThreadPoolStats &stats);
+
+/** Work-stealing thread pool. Each worker owns one deque per priority
+ *  class, guarded by its own mutex. Submitted tasks are spread round-robin
+ *  over the workers; a worker runs the oldest task of the most urgent
+ *  class it can find, taking it from its own deques first and otherwise
+ *  stealing the newest task of that class from another worker.
+ */
 class ThreadPool
 {
 public:
   /**
    * Construct a thread pool of a fixed size.
    **/
-  explicit ThreadPool(size_t numThreads);
+  explicit ThreadPool(size_t numThreads, size_t numPriorityClasses = 1);
 
   ~ThreadPool() {
     Stop();
   }
 
   /**
-   * Add a job to the threadpool.
+   * Add a job to the threadpool, in the priority class given by the task.
    **/
-  void Submit(Task* task);
+  void Submit(Task* task) {
+    Submit(task, task->GetPriority());
+  }
+
+  /**
+   * Add a job to the threadpool in the given priority class.
+   **/
+  void Submit(Task* task, size_t priority);
 
   /**
    * Wait until all queued jobs have completed, and shut down
@@ -89,19 +131,56 @@ public:
     m_queueLimit = limit;
   }
 
+  size_t GetNumPriorityClasses() const {
+    return m_numPriorityClasses;
+  }
+
+  /**
+   * Scheduling counters so far. Exact once the pool has been stopped.
+   **/
+  ThreadPoolStats GetStats() const;
+
 private:
+  struct QueuedTask {
+    QueuedTask(Task *task, const boost::posix_time::ptime &submitted)
+      : task(task), submitted(submitted) {}
+    Task *task;
+    boost::posix_time::ptime submitted;
+  };
+
+  struct Worker {
+    explicit Worker(size_t numPriorityClasses)
+      : queues(numPriorityClasses) {}
+    mutable boost::mutex mutex;
+    std::vector<std::deque<QueuedTask> > queues; // one per priority class
+    ThreadPoolStats stats; // only written by the owning thread
+  };
+
   /**
    * The main loop executed by each thread.
    **/
-  void Execute();
+  void Execute(size_t workerId);
+
+  /**
+   * Take the next task for the given worker, from its own deques or from
+   * another worker's. Returns false if every deque is empty.
+   **/
+  bool Take(size_t workerId, Task *&task, boost::posix_time::ptime &submitted);
 
-  std::queue<Task*> m_tasks;
+  boost::ptr_vector<Worker> m_workers;
+  size_t m_numPriorityClasses;
   boost::thread_group m_threads;
+
+  // only taken to sleep, wake up, or wait for queue space
   boost::mutex m_mutex;
   boost::condition_variable m_threadNeeded;
   boost::condition_variable m_threadAvailable;
-  bool m_stopped;
-  bool m_stopping;
+
+  boost::atomic<size_t> m_queued;
+  boost::atomic<size_t> m_idle;
+  boost::atomic<size_t> m_nextWorker;
+  boost::atomic<bool> m_stopped;
+  boost::atomic<bool> m_stopping;
   size_t m_queueLimit;
 };
 
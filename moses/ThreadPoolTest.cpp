@@ -0,0 +1,136 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ThreadPool.h"
+
+using namespace Moses;
+using namespace std;
+
+#ifdef WITH_THREADS
+
+BOOST_AUTO_TEST_SUITE(thread_pool)
+
+namespace
+{
+
+class CountTask : public Task
+{
+public:
+  CountTask(boost::atomic<size_t> &count) : m_count(count) {}
+  void Run() {
+    ++m_count;
+  }
+private:
+  boost::atomic<size_t> &m_count;
+};
+
+// Blocks the (single) worker until Open is called.
+class GateTask : public Task
+{
+public:
+  GateTask() : m_started(false), m_open(false) {}
+  bool DeleteAfterExecution() {
+    return false;
+  }
+  void Run() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_started = true;
+    m_cond.notify_all();
+    while (!m_open) m_cond.wait(lock);
+  }
+  void WaitStarted() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_started) m_cond.wait(lock);
+  }
+  void Open() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_open = true;
+    m_cond.notify_all();
+  }
+private:
+  boost::mutex m_mutex;
+  boost::condition_variable m_cond;
+  bool m_started, m_open;
+};
+
+class RecordTask : public Task
+{
+public:
+  RecordTask(vector<int> &order, int id, size_t priority)
+    : m_order(order), m_id(id), m_priority(priority) {}
+  size_t GetPriority() const {
+    return m_priority;
+  }
+  void Run() {
+    m_order.push_back(m_id);
+  }
+private:
+  vector<int> &m_order;
+  int m_id;
+  size_t m_priority;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(runs_all_tasks)
+{
+  boost::atomic<size_t> count(0);
+  ThreadPool pool(4);
+  pool.SetQueueLimit(16);
+  for (size_t i = 0; i < 1000; ++i) {
+    pool.Submit(new CountTask(count));
+  }
+  pool.Stop(true);
+  BOOST_CHECK_EQUAL(count, 1000);
+
+  ThreadPoolStats stats = pool.GetStats();
+  BOOST_CHECK_EQUAL(stats.executed, 1000);
+  BOOST_CHECK(stats.stolen <= stats.executed);
+  BOOST_CHECK(stats.maxWait >= stats.GetMeanWait());
+}
+
+BOOST_AUTO_TEST_CASE(priority_order)
+{
+  vector<int> order;
+  ThreadPool pool(1, 2);
+  GateTask gate;
+  pool.Submit(&gate);
+  gate.WaitStarted();
+
+  pool.Submit(new RecordTask(order, 1, 1));
+  pool.Submit(new RecordTask(order, 2, 5)); // clamped to the last class
+  pool.Submit(new RecordTask(order, 3, 0));
+  pool.Submit(new RecordTask(order, 4, 0));
+  gate.Open();
+  pool.Stop(true);
+
+  BOOST_REQUIRE_EQUAL(order.size(), 4);
+  BOOST_CHECK_EQUAL(order[0], 3);
+  BOOST_CHECK_EQUAL(order[1], 4);
+  BOOST_CHECK_EQUAL(order[2], 1);
+  BOOST_CHECK_EQUAL(order[3], 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -17,6 +17,7 @@
   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
+#include <algorithm>
 #include <iostream>
 #include "ChartRuleLookupManagerMemory.h"
 
@@ -48,6 +49,9 @@ ChartRuleLookupManagerMemory::ChartRuleLookupManagerMemory(
 
   m_completedRules.resize(sourceSize);
 
+  m_widthOrder = false;
+  m_matrixWidth = 1;
+
   m_isSoftMatching = !m_softMatchingMap.empty();
 }
 
@@ -66,16 +70,24 @@ void ChartRuleLookupManagerMemory::GetChartRuleCollection(
   m_unaryPos = absEndPos-1; // rules ending in this position are unary and should not be added to collection
 
   // create/update data structure to quickly look up all chart cells that match start position and label.
-  UpdateCompressedMatrix(startPos, absEndPos, lastPos);
+  if (m_widthOrder) {
+    // only rules ending at absEndPos are collected, they only use narrower cells
+    m_lastPos = absEndPos;
+    UpdateCompressedMatrixByWidth(range.GetNumWordsCovered());
+  } else {
+    UpdateCompressedMatrix(startPos, absEndPos, lastPos);
+  }
 
   const PhraseDictionaryNodeMemory &rootNode = m_ruleTable.GetRootNode();
 
   // all rules starting with terminal
-  if (startPos == absEndPos) {
+  if (startPos == absEndPos || m_widthOrder) {
     GetTerminalExtension(&rootNode, startPos);
   }
   // all rules starting with nonterminal
-  else if (absEndPos > startPos) {
+  if (absEndPos > startPos && m_widthOrder) {
+    GetNonTerminalExtensionByEnd(&rootNode, startPos);
+  } else if (absEndPos > startPos) {
     GetNonTerminalExtension(&rootNode, startPos);
   }
 
@@ -131,31 +143,55 @@ void ChartRuleLookupManagerMemory::UpdateCompressedMatrix(size_t startPos,
     cellMatrix.clear();
     cellMatrix.resize(numNonTerms);
     for (std::vector<size_t>::iterator p = endPosVec.begin(); p != endPosVec.end(); ++p) {
+        AddCellToCompressedMatrix(startPos, *p);
+    }
+}
 
-        size_t endPos = *p;
-        // target non-terminal labels for the span
-        const ChartCellLabelSet &targetNonTerms = GetTargetLabelSet(startPos, endPos);
+// Width order: add the cells of all widths below the given one, which have been decoded since the last lookup.
+// Cells are added in order of width, so each column stays sorted by end position.
+void ChartRuleLookupManagerMemory::UpdateCompressedMatrixByWidth(size_t width) {
+
+    size_t sourceSize = GetParser().GetSize();
+    size_t numNonTerms = FactorCollection::Instance().GetNumNonTerminals();
+    m_compressedMatrixVec.resize(sourceSize);
+    for (size_t pos = 0; pos < sourceSize; pos++) {
+        m_compressedMatrixVec[pos].resize(numNonTerms);
+    }
 
-        if (targetNonTerms.GetSize() == 0) {
-            continue;
+    for (; m_matrixWidth < width; m_matrixWidth++) {
+        for (size_t startPos = 0; startPos + m_matrixWidth <= sourceSize; startPos++) {
+            AddCellToCompressedMatrix(startPos, startPos + m_matrixWidth - 1);
         }
+    }
+}
+
+// Add the labels of one chart cell to the compressed matrix of its start position.
+void ChartRuleLookupManagerMemory::AddCellToCompressedMatrix(size_t startPos, size_t endPos) {
+
+    // target non-terminal labels for the span
+    const ChartCellLabelSet &targetNonTerms = GetTargetLabelSet(startPos, endPos);
+
+    if (targetNonTerms.GetSize() == 0) {
+        return;
+    }
 
 #if !defined(UNLABELLED_SOURCE)
-        // source non-terminal labels for the span
-        const InputPath &inputPath = GetParser().GetInputPath(startPos, endPos);
+    // source non-terminal labels for the span
+    const InputPath &inputPath = GetParser().GetInputPath(startPos, endPos);
 
-        // can this ever be true? Moses seems to pad the non-terminal set of the input with [X]
-        if (inputPath.GetNonTerminalSet().size() == 0) {
-            continue;
-        }
+    // can this ever be true? Moses seems to pad the non-terminal set of the input with [X]
+    if (inputPath.GetNonTerminalSet().size() == 0) {
+        return;
+    }
 #endif
 
-        for (size_t i = 0; i < numNonTerms; i++) {
-            const ChartCellLabel *cellLabel = targetNonTerms.Find(i);
-            if (cellLabel != NULL) {
-                float score = cellLabel->GetBestScore(m_outColl);
-                cellMatrix[i].push_back(ChartCellCache(endPos, cellLabel, score));
-            }
+    CompressedMatrix & cellMatrix = m_compressedMatrixVec[startPos];
+    size_t numNonTerms = cellMatrix.size();
+    for (size_t i = 0; i < numNonTerms; i++) {
+        const ChartCellLabel *cellLabel = targetNonTerms.Find(i);
+        if (cellLabel != NULL) {
+            float score = cellLabel->GetBestScore(m_outColl);
+            cellMatrix[i].push_back(ChartCellCache(endPos, cellLabel, score));
         }
     }
 }
@@ -167,7 +203,9 @@ void ChartRuleLookupManagerMemory::AddAndExtend(
 
     const TargetPhraseCollection &tpc = node->GetTargetPhraseCollection();
     // add target phrase collection (except if rule is empty or a unary non-terminal rule)
-    if (!tpc.IsEmpty() && (m_stackVec.empty() || endPos != m_unaryPos)) {
+    // in width order, only rules for the range that is looked up are needed
+    if (!tpc.IsEmpty() && (m_stackVec.empty() || endPos != m_unaryPos)
+        && (!m_widthOrder || endPos == m_lastPos)) {
       m_completedRules[endPos].Add(tpc, m_stackVec, m_stackScores, *m_outColl);
     }
 
@@ -244,6 +282,9 @@ void ChartRuleLookupManagerMemory::GetNonTerminalExtension(
         for (std::vector<Word>::const_iterator softMatch = softMatches.begin(); softMatch != softMatches.end(); ++softMatch) {
           const CompressedColumn &matches = compressedMatrix[(*softMatch)[0]->GetId()];
           for (CompressedColumn::const_iterator match = matches.begin(); match != matches.end(); ++match) {
+            if (match->endPos > m_lastPos) {
+              break; // columns are sorted by end position
+            }
             m_stackVec.back() = match->cellLabel;
             m_stackScores.back() = match->score;
             AddAndExtend(child, match->endPos);
@@ -253,6 +294,9 @@ void ChartRuleLookupManagerMemory::GetNonTerminalExtension(
 
       const CompressedColumn &matches = compressedMatrix[targetNonTerm[0]->GetId()];
       for (CompressedColumn::const_iterator match = matches.begin(); match != matches.end(); ++match) {
+        if (match->endPos > m_lastPos) {
+          break; // columns are sorted by end position
+        }
         m_stackVec.back() = match->cellLabel;
         m_stackScores.back() = match->score;
         AddAndExtend(child, match->endPos);
@@ -263,4 +307,65 @@ void ChartRuleLookupManagerMemory::GetNonTerminalExtension(
     m_stackScores.pop_back();
 }
 
+// Width order: all rules of a range that start with a non-terminal are found by one lookup.
+// The sequential order finds them in one lookup per end position of the first non-terminal,
+// so go through end positions first and labels second, to add the rules in the same order.
+// Ties in the translation option list and the rule cube queue are broken by that order.
+void ChartRuleLookupManagerMemory::GetNonTerminalExtensionByEnd(
+    const PhraseDictionaryNodeMemory *node,
+    size_t startPos) {
+
+    const CompressedMatrix &compressedMatrix = m_compressedMatrixVec[startPos];
+    const PhraseDictionaryNodeMemory::NonTerminalMap & nonTermMap = node->GetNonTerminalMap();
+
+    m_stackVec.push_back(NULL);
+    m_stackScores.push_back(0);
+
+    PhraseDictionaryNodeMemory::NonTerminalMap::const_iterator p;
+    PhraseDictionaryNodeMemory::NonTerminalMap::const_iterator end = nonTermMap.end();
+    for (size_t endPos = startPos; endPos < m_lastPos; ++endPos) {
+      for (p = nonTermMap.begin(); p != end; ++p) {
+#if defined(UNLABELLED_SOURCE)
+        const Word &targetNonTerm = p->first;
+#else
+        const Word &targetNonTerm = p->first.second;
+#endif
+        const PhraseDictionaryNodeMemory *child = &p->second;
+        if (m_isSoftMatching && !m_softMatchingMap[targetNonTerm[0]->GetId()].empty()) {
+          const std::vector<Word>& softMatches = m_softMatchingMap[targetNonTerm[0]->GetId()];
+          for (std::vector<Word>::const_iterator softMatch = softMatches.begin(); softMatch != softMatches.end(); ++softMatch) {
+            ExtendWithCell(child, compressedMatrix[(*softMatch)[0]->GetId()], endPos);
+          }
+        }
+        ExtendWithCell(child, compressedMatrix[targetNonTerm[0]->GetId()], endPos);
+      }
+    }
+
+    m_stackVec.pop_back();
+    m_stackScores.pop_back();
+}
+
+namespace
+{
+bool EndsBefore(const ChartCellCache &cell, size_t endPos)
+{
+  return cell.endPos < endPos;
+}
+}
+
+// extend a partial rule with the cell of a column that ends at endPos, if there is one
+void ChartRuleLookupManagerMemory::ExtendWithCell(
+    const PhraseDictionaryNodeMemory *child,
+    const CompressedColumn &matches,
+    size_t endPos) {
+
+    // columns are sorted by end position and hold at most one cell per end position
+    CompressedColumn::const_iterator match = std::lower_bound(matches.begin(), matches.end(), endPos, EndsBefore);
+    if (match != matches.end() && match->endPos == endPos) {
+      m_stackVec.back() = match->cellLabel;
+      m_stackScores.back() = match->score;
+      AddAndExtend(child, endPos);
+    }
+}
+
 }  // namespace Moses
@@ -54,6 +54,14 @@ public:
     size_t lastPos, // last position to consider if using lookahead
     ChartParserCallback &outColl);
 
+  virtual bool SupportsWidthOrder() const {
+    return true;
+  }
+
+  virtual void SetWidthOrder() {
+    m_widthOrder = true;
+  }
+
 private:
 
   void GetTerminalExtension(
@@ -64,6 +72,15 @@ private:
     const PhraseDictionaryNodeMemory *node,
     size_t startPos);
 
+  void GetNonTerminalExtensionByEnd(
+    const PhraseDictionaryNodeMemory *node,
+    size_t startPos);
+
+  void ExtendWithCell(
+    const PhraseDictionaryNodeMemory *child,
+    const CompressedColumn &matches,
+    size_t endPos);
+
   void AddAndExtend(
     const PhraseDictionaryNodeMemory *node,
     size_t endPos);
@@ -72,6 +89,10 @@ private:
     size_t endPos,
     size_t lastPos);
 
+  void UpdateCompressedMatrixByWidth(size_t width);
+
+  void AddCellToCompressedMatrix(size_t startPos, size_t endPos);
+
   const PhraseDictionaryFuzzyMatch &m_ruleTable;
 
   // permissible soft nonterminal matches (target side)
@@ -91,6 +112,11 @@ private:
 
   std::vector<CompressedMatrix> m_compressedMatrixVec;
 
+  // look up rules for one range at a time, in order of width (see SupportsWidthOrder())
+  bool m_widthOrder;
+  // cells narrower than this are in m_compressedMatrixVec (width order only)
+  size_t m_matrixWidth;
+
 };
 
 }  // namespace Moses
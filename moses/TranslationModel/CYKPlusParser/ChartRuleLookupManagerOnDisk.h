@@ -49,6 +49,11 @@ public:
                                       size_t last,
                                       ChartParserCallback &outColl);
 
+  // dotted rules are kept per start position and extended one end position at a time
+  virtual bool SupportsWidthOrder() const {
+    return true;
+  }
+
 private:
   const PhraseDictionaryOnDisk &m_dictionary;
   OnDiskPt::OnDiskWrapper &m_dbWrapper;
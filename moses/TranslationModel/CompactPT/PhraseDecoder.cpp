@@ -40,6 +40,7 @@ PhraseDecoder::PhraseDecoder(
     m_containsAlignmentInfo(true), m_maxRank(0),
     m_symbolTree(0), m_multipleScoreTrees(false),
     m_scoreTrees(1), m_alignTree(0),
+    m_decodingCache(phraseDictionary.m_decodingCacheSize * 1024 * 1024),
     m_phraseDictionary(phraseDictionary), m_input(input), m_output(output),
     m_weight(weight),
     m_separator(" ||| ")
@@ -449,4 +450,9 @@ void PhraseDecoder::PruneCache()
   m_decodingCache.Prune();
 }
 
+TargetPhraseCollectionCache::Stats PhraseDecoder::GetCacheStats()
+{
+  return m_decodingCache.GetStats();
+}
+
 }
@@ -140,6 +140,7 @@ public:
                                          bool eval);
 
   void PruneCache();
+  TargetPhraseCollectionCache::Stats GetCacheStats();
 };
 
 }
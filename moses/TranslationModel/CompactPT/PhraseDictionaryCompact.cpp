@@ -46,6 +46,7 @@ PhraseDictionaryCompact::PhraseDictionaryCompact(const std::string &line)
   :PhraseDictionary(line)
   ,m_inMemory(true)
   ,m_useAlignmentInfo(true)
+  ,m_decodingCacheSize(64)
   ,m_hash(10, 16)
   ,m_phraseDecoder(0)
   ,m_weight(0)
@@ -53,6 +54,15 @@ PhraseDictionaryCompact::PhraseDictionaryCompact(const std::string &line)
   ReadParameters();
 }
 
+void PhraseDictionaryCompact::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "decoding-cache-size") {
+    m_decodingCacheSize = Scan<size_t>(value);
+  } else {
+    PhraseDictionary::SetParameter(key, value);
+  }
+}
+
 void PhraseDictionaryCompact::Load()
 {
   const StaticData &staticData = StaticData::Instance();
@@ -189,6 +199,14 @@ void PhraseDictionaryCompact::CleanUpAfterSentenceProcessing(const InputType &so
 
   m_phraseDecoder->PruneCache();
 
+  IFVERBOSE(2) {
+    TargetPhraseCollectionCache::Stats stats = m_phraseDecoder->GetCacheStats();
+    VERBOSE(2, GetScoreProducerDescription() << " decoding cache: "
+            << stats.entries << " phrases, " << stats.bytes / 1024 << " kB, "
+            << stats.hits << " hits, " << stats.misses << " misses, "
+            << stats.evictions << " evictions" << std::endl);
+  }
+
 #ifdef WITH_THREADS
   boost::mutex::scoped_lock lock(m_sentenceMutex);
   PhraseCache &ref = m_sentenceCache[boost::this_thread::get_id()];
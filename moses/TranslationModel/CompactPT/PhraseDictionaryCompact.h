@@ -50,6 +50,7 @@ protected:
 
   bool m_inMemory;
   bool m_useAlignmentInfo;
+  size_t m_decodingCacheSize; /**< in MB, shared by all threads */
 
   typedef std::vector<TargetPhraseCollection*> PhraseCache;
 #ifdef WITH_THREADS
@@ -73,6 +74,7 @@ public:
   ~PhraseDictionaryCompact();
 
   void Load();
+  void SetParameter(const std::string& key, const std::string& value);
 
   const TargetPhraseCollection* GetTargetPhraseCollectionNonCacheLEGACY(const Phrase &source) const;
   TargetPhraseVectorPtr GetTargetPhraseCollectionRaw(const Phrase &source) const;
@@ -22,17 +22,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_TargetPhraseCollectionCache_h
 #define moses_TargetPhraseCollectionCache_h
 
-#include <map>
-#include <set>
+#include <list>
 #include <vector>
 
 #ifdef WITH_THREADS
-#ifdef BOOST_HAS_PTHREADS
 #include <boost/thread/mutex.hpp>
 #endif
-#endif
 
+#include <boost/atomic.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "moses/Phrase.h"
 #include "moses/TargetPhraseCollection.h"
@@ -44,125 +43,190 @@ namespace Moses
 typedef std::vector<TargetPhrase> TargetPhraseVector;
 typedef boost::shared_ptr<TargetPhraseVector> TargetPhraseVectorPtr;
 
-/** Implementation of Persistent Cache **/
+/** Implementation of Persistent Cache
+ *
+ * Decoded target phrase collections, shared by all decoder threads. The
+ * cache is split into shards by hash of the source phrase, each with its
+ * own lock, so threads looking up different phrases rarely wait for each
+ * other. Every shard evicts with the CLOCK approximation of LRU: a hit
+ * only sets a flag, and the clock hand evicts the first entry it finds
+ * without the flag, clearing the flags it passes. Memory use is bounded by
+ * an estimate of the bytes held, not by the number of entries.
+ **/
 class TargetPhraseCollectionCache
 {
+public:
+  struct Stats {
+    size_t hits, misses, evictions, entries, bytes;
+  };
+
 private:
-  size_t m_max;
-  float m_tolerance;
+  static const size_t NumShards = 16;
 
-  struct LastUsed {
-    clock_t m_clock;
+  struct Entry {
     TargetPhraseVectorPtr m_tpv;
     size_t m_bitsLeft;
-
-    LastUsed() : m_clock(0), m_bitsLeft(0) {}
-
-    LastUsed(clock_t clock, TargetPhraseVectorPtr tpv, size_t bitsLeft = 0)
-      : m_clock(clock), m_tpv(tpv), m_bitsLeft(bitsLeft) {}
+    size_t m_bytes; /**< estimated memory use */
+    bool m_referenced; /**< used since the clock hand last passed */
   };
 
-  typedef std::map<Phrase, LastUsed> CacheMap;
-
-  CacheMap m_phraseCache;
+  typedef boost::unordered_map<Phrase, Entry> CacheMap;
+  // entries in clock order; map nodes do not move when the map rehashes
+  typedef std::list<CacheMap::value_type*> Ring;
 
+  struct Shard {
+    CacheMap m_map;
+    Ring m_ring;
+    Ring::iterator m_hand;
+    size_t m_bytes;
 #ifdef WITH_THREADS
-  boost::mutex m_mutex;
+    boost::mutex m_mutex;
 #endif
+    Shard() : m_hand(m_ring.end()), m_bytes(0) {}
+  };
 
-public:
+  size_t m_maxBytesPerShard;
+  Shard m_shards[NumShards];
 
-  typedef CacheMap::iterator iterator;
-  typedef CacheMap::const_iterator const_iterator;
+  boost::atomic<size_t> m_hits, m_misses, m_evictions;
 
-  TargetPhraseCollectionCache(size_t max = 5000, float tolerance = 0.2)
-    : m_max(max), m_tolerance(tolerance) {
+  Shard &GetShard(const Phrase &sourcePhrase) {
+    size_t hash = hash_value(sourcePhrase);
+    return m_shards[(hash ^ (hash >> 17)) % NumShards];
   }
 
-  iterator Begin() {
-    return m_phraseCache.begin();
+  static size_t EstimateBytes(const Phrase &sourcePhrase, const TargetPhraseVector &tpv) {
+    size_t bytes = sizeof(CacheMap::value_type) + sizeof(Ring::value_type) + 4 * sizeof(void*)
+                   + sourcePhrase.GetSize() * sizeof(Word)
+                   + sizeof(TargetPhraseVector) + tpv.capacity() * sizeof(TargetPhrase);
+    for(TargetPhraseVector::const_iterator it = tpv.begin(); it != tpv.end(); it++)
+      bytes += it->GetSize() * sizeof(Word);
+    return bytes;
   }
 
-  const_iterator Begin() const {
-    return m_phraseCache.begin();
+  // evict until the shard fits into maxBytes. Call with the shard locked
+  void Evict(Shard &shard, size_t maxBytes) {
+    while(shard.m_bytes > maxBytes && !shard.m_ring.empty()) {
+      if(shard.m_hand == shard.m_ring.end())
+        shard.m_hand = shard.m_ring.begin();
+
+      Entry &entry = (*shard.m_hand)->second;
+      if(entry.m_referenced) {
+        // second chance
+        entry.m_referenced = false;
+        ++shard.m_hand;
+      } else {
+        CacheMap::iterator victim = shard.m_map.find((*shard.m_hand)->first);
+        shard.m_bytes -= entry.m_bytes;
+        shard.m_hand = shard.m_ring.erase(shard.m_hand);
+        shard.m_map.erase(victim);
+        ++m_evictions;
+      }
+    }
   }
 
-  iterator End() {
-    return m_phraseCache.end();
+public:
+
+  //! maxBytes is the approximate memory limit of the whole cache
+  TargetPhraseCollectionCache(size_t maxBytes = 64 * 1024 * 1024)
+    : m_maxBytesPerShard(maxBytes / NumShards), m_hits(0), m_misses(0), m_evictions(0) {
   }
 
-  const_iterator End() const {
-    return m_phraseCache.end();
+  void SetMaxBytes(size_t maxBytes) {
+    m_maxBytesPerShard = maxBytes / NumShards;
   }
 
   /** retrieve translations for source phrase from persistent cache **/
   void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
              size_t bitsLeft = 0, size_t maxRank = 0) {
+    // copy outside the lock
+    if(maxRank && tpv->size() > maxRank) {
+      TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector(tpv->begin(), tpv->begin() + maxRank));
+      tpv = tpv_temp;
+    }
+    size_t bytes = EstimateBytes(sourcePhrase, *tpv);
+
+    Shard &shard = GetShard(sourcePhrase);
 #ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
+    boost::mutex::scoped_lock lock(shard.m_mutex);
 #endif
 
     // check if source phrase is already in cache
-    iterator it = m_phraseCache.find(sourcePhrase);
-    if(it != m_phraseCache.end())
-      // if found, just update clock
-      it->second.m_clock = clock();
-    else {
-      // else, add to cache
-      if(maxRank && tpv->size() > maxRank) {
-        TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
-        tpv_temp->resize(maxRank);
-        std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
-        m_phraseCache[sourcePhrase] = LastUsed(clock(), tpv_temp, bitsLeft);
-      } else
-        m_phraseCache[sourcePhrase] = LastUsed(clock(), tpv, bitsLeft);
+    std::pair<CacheMap::iterator, bool> inserted
+      = shard.m_map.insert(CacheMap::value_type(sourcePhrase, Entry()));
+    Entry &entry = inserted.first->second;
+    if(!inserted.second) {
+      // if found, just mark as used
+      entry.m_referenced = true;
+      return;
     }
+
+    // else, add to cache just behind the clock hand, evicting as needed
+    entry.m_tpv = tpv;
+    entry.m_bitsLeft = bitsLeft;
+    entry.m_bytes = bytes;
+    entry.m_referenced = false;
+    shard.m_ring.insert(shard.m_hand, &*inserted.first);
+    shard.m_bytes += bytes;
+    Evict(shard, m_maxBytesPerShard);
   }
 
   std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase) {
+    Shard &shard = GetShard(sourcePhrase);
 #ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
+    boost::mutex::scoped_lock lock(shard.m_mutex);
 #endif
 
-    iterator it = m_phraseCache.find(sourcePhrase);
-    if(it != m_phraseCache.end()) {
-      LastUsed &lu = it->second;
-      lu.m_clock = clock();
-      return std::make_pair(lu.m_tpv, lu.m_bitsLeft);
-    } else
+    CacheMap::iterator it = shard.m_map.find(sourcePhrase);
+    if(it != shard.m_map.end()) {
+      Entry &entry = it->second;
+      entry.m_referenced = true;
+      ++m_hits;
+      return std::make_pair(entry.m_tpv, entry.m_bitsLeft);
+    } else {
+      ++m_misses;
       return std::make_pair(TargetPhraseVectorPtr(), 0);
+    }
   }
 
-  // if cache full, reduce
+  // if cache full, reduce. The cache is kept within its limit while
+  // phrases are added, so this only matters after the limit was lowered
   void Prune() {
+    for(size_t i = 0; i < NumShards; ++i) {
 #ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
+      boost::mutex::scoped_lock lock(m_shards[i].m_mutex);
 #endif
-
-    if(m_phraseCache.size() > m_max * (1 + m_tolerance)) {
-      typedef std::set<std::pair<clock_t, Phrase> > Cands;
-      Cands cands;
-      for(CacheMap::iterator it = m_phraseCache.begin();
-          it != m_phraseCache.end(); it++) {
-        LastUsed &lu = it->second;
-        cands.insert(std::make_pair(lu.m_clock, it->first));
-      }
-
-      for(Cands::iterator it = cands.begin(); it != cands.end(); it++) {
-        const Phrase& p = it->second;
-        m_phraseCache.erase(p);
-
-        if(m_phraseCache.size() < (m_max * (1 - m_tolerance)))
-          break;
-      }
+      Evict(m_shards[i], m_maxBytesPerShard);
     }
   }
 
   void CleanUp() {
+    for(size_t i = 0; i < NumShards; ++i) {
 #ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
+      boost::mutex::scoped_lock lock(m_shards[i].m_mutex);
 #endif
-    m_phraseCache.clear();
+      m_shards[i].m_ring.clear();
+      m_shards[i].m_hand = m_shards[i].m_ring.end();
+      m_shards[i].m_map.clear();
+      m_shards[i].m_bytes = 0;
+    }
+  }
+
+  Stats GetStats() {
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.entries = 0;
+    stats.bytes = 0;
+    for(size_t i = 0; i < NumShards; ++i) {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(m_shards[i].m_mutex);
+#endif
+      stats.entries += m_shards[i].m_map.size();
+      stats.bytes += m_shards[i].m_bytes;
+    }
+    return stats;
   }
 
 };
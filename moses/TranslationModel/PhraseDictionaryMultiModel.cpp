@@ -366,6 +366,17 @@ void PhraseDictionaryMultiModel::CacheForCleanup(TargetPhraseCollection* tpc)
 }
 
 
+void PhraseDictionaryMultiModel::InitializeForInput(InputType const& source)
+{
+  // this object is shared between threads, so weights for this input are
+  // kept per thread until CleanUpAfterSentenceProcessing()
+  const std::map<std::string, std::vector<float> > &weights = source.GetOptions().multiModelWeights;
+  std::map<std::string, std::vector<float> >::const_iterator iter = weights.find(GetScoreProducerDescription());
+  if (iter != weights.end()) {
+    SetTemporaryMultiModelWeightsVector(iter->second);
+  }
+}
+
 void PhraseDictionaryMultiModel::CleanUpAfterSentenceProcessing(const InputType &source)
 {
   PhraseCache &ref = GetPhraseCache();
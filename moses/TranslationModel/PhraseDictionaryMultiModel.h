@@ -86,9 +86,7 @@ public:
 #endif
   // functions below required by base class
   virtual const TargetPhraseCollection* GetTargetPhraseCollectionLEGACY(const Phrase& src) const;
-  virtual void InitializeForInput(InputType const&) {
-    /* Don't do anything source specific here as this object is shared between threads.*/
-  }
+  virtual void InitializeForInput(InputType const& source);
   ChartRuleLookupManager *CreateRuleLookupManager(const ChartParser &, const ChartCellCollectionBase&, std::size_t);
   void SetParameter(const std::string& key, const std::string& value);
 
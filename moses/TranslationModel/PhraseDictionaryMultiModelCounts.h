@@ -97,10 +97,6 @@ public:
   std::vector<float> MinimizePerplexity(std::vector<std::pair<std::string, std::string> > &phrase_pair_vector);
 #endif
   // functions below required by base class
-  virtual void InitializeForInput(InputType const&) {
-    /* Don't do anything source specific here as this object is shared between threads.*/
-  }
-
   void SetParameter(const std::string& key, const std::string& value);
 
 private:
@@ -1,5 +1,4 @@
 // vim:tabstop=2
-#include <stdlib.h>
 #include "PhraseDictionaryTransliteration.h"
 #include "moses/TranslationModel/CYKPlusParser/ChartRuleLookupManagerSkeleton.h"
 #include "moses/DecodeGraph.h"
@@ -11,18 +10,18 @@ namespace Moses
 {
 PhraseDictionaryTransliteration::PhraseDictionaryTransliteration(const std::string &line)
   : PhraseDictionary(line)
+  , m_stackSize(5000) // as moses -s 5000 in the transliteration script
+  , m_nBestSize(50)
 {
   ReadParameters();
-  UTIL_THROW_IF2(m_mosesDir.empty() ||
-		  m_scriptDir.empty() ||
-		  m_externalDir.empty() ||
-		  m_inputLang.empty() ||
-		  m_outputLang.empty(), "Must specify all arguments");
 }
 
 void PhraseDictionaryTransliteration::Load()
 {
 	SetFeaturesToApply();
+
+	// 20 options per source phrase, the default table limit of the moses the script ran
+	m_model.reset(new TransliterationModel(m_filePath, m_stackSize, 20));
 }
 
 void PhraseDictionaryTransliteration::CleanUpAfterSentenceProcessing(const InputType& source)
@@ -32,6 +31,10 @@ void PhraseDictionaryTransliteration::CleanUpAfterSentenceProcessing(const Input
 
 void PhraseDictionaryTransliteration::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 {
+  CacheColl &cache = GetCache();
+
+  // words not yet in the cache, each transliterated once for all its input paths
+  std::map<size_t, std::vector<InputPath*> > uncached;
 
   InputPathList::const_iterator iter;
   for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter) {
@@ -48,98 +51,51 @@ void PhraseDictionaryTransliteration::GetTargetPhraseCollectionBatch(const Input
     	continue;
     }
 
-    GetTargetPhraseCollection(inputPath);
-  }
-}
-
-void PhraseDictionaryTransliteration::GetTargetPhraseCollection(InputPath &inputPath) const
-{
-    const Phrase &sourcePhrase = inputPath.GetPhrase();
     size_t hash = hash_value(sourcePhrase);
-
-    CacheColl &cache = GetCache();
-
-    CacheColl::iterator iter;
-    iter = cache.find(hash);
-
-    if (iter != cache.end()) {
+    CacheColl::iterator cacheIter = cache.find(hash);
+    if (cacheIter != cache.end()) {
     	// already in cache
-    	const TargetPhraseCollection *tpColl = iter->second.first;
+    	const TargetPhraseCollection *tpColl = cacheIter->second.first;
     	inputPath.SetTargetPhrases(*this, tpColl, NULL);
+    } else {
+    	uncached[hash].push_back(&inputPath);
     }
-    else {
-        // TRANSLITERATE
-    	char *ptr = tmpnam(NULL);
-    	string inFile(ptr);
-    	ptr = tmpnam(NULL);
-    	string outDir(ptr);
-
-    	ofstream inStream(inFile.c_str());
-    	inStream << sourcePhrase.ToString() << endl;
-    	inStream.close();
-
-    	string cmd = m_scriptDir + "/Transliteration/prepare-transliteration-phrase-table.pl" +
-    			" --transliteration-model-dir " + m_filePath +
-    			" --moses-src-dir " + m_mosesDir +
-    			" --external-bin-dir " + m_externalDir +
-    			" --input-extension " + m_inputLang +
-    			" --output-extension " + m_outputLang +
-    			" --oov-file " + inFile +
-    			" --out-dir " + outDir;
-
-    	int ret = system(cmd.c_str());
-    	UTIL_THROW_IF2(ret != 0, "Transliteration script error");
-
-    	TargetPhraseCollection *tpColl = new TargetPhraseCollection();
-    	vector<TargetPhrase*> targetPhrases = CreateTargetPhrases(sourcePhrase, outDir);
-    	vector<TargetPhrase*>::const_iterator iter;
-    	for (iter = targetPhrases.begin(); iter != targetPhrases.end(); ++iter) {
-    		TargetPhrase *tp = *iter;
-    		tpColl->Add(tp);
-    	}
-
-    	std::pair<const TargetPhraseCollection*, clock_t> value(tpColl, clock());
-    	cache[hash] = value;
+  }
 
-    	inputPath.SetTargetPhrases(*this, tpColl, NULL);
+  std::map<size_t, std::vector<InputPath*> >::const_iterator wordIter;
+  for (wordIter = uncached.begin(); wordIter != uncached.end(); ++wordIter) {
+    const std::vector<InputPath*> &inputPaths = wordIter->second;
+    const TargetPhraseCollection *tpColl = CreateTargetPhraseCollection(inputPaths[0]->GetPhrase());
 
-    	// clean up temporary files
-    	remove(inFile.c_str());
+    std::pair<const TargetPhraseCollection*, clock_t> value(tpColl, clock());
+    cache[wordIter->first] = value;
 
-    	cmd = "rm -rf " + outDir;
-    	system(cmd.c_str());
+    for (size_t i = 0; i < inputPaths.size(); ++i) {
+    	inputPaths[i]->SetTargetPhrases(*this, tpColl, NULL);
     }
+  }
 }
 
-std::vector<TargetPhrase*> PhraseDictionaryTransliteration::CreateTargetPhrases(const Phrase &sourcePhrase, const string &outDir) const
+TargetPhraseCollection *PhraseDictionaryTransliteration::CreateTargetPhraseCollection(const Phrase &sourcePhrase) const
 {
-	std::vector<TargetPhrase*> ret;
-
-	string outPath = outDir + "/out.txt";
-	ifstream outStream(outPath.c_str());
-
-	string line;
-	while (getline(outStream, line)) {
-		vector<string> toks;
-		Tokenize(toks, line, "\t");
-		UTIL_THROW_IF2(toks.size() != 2, "Error in transliteration output file. Expecting word\tscore");
+	std::vector<TransliterationModel::Candidate> candidates;
+	m_model->Transliterate(sourcePhrase.GetWord(0).GetString(m_input, false), m_nBestSize, candidates);
 
+	TargetPhraseCollection *tpColl = new TargetPhraseCollection();
+	for (size_t i = 0; i < candidates.size(); ++i) {
 	  TargetPhrase *tp = new TargetPhrase(this);
 	  Word &word = tp->AddWord();
-	  word.CreateFromString(Output, m_output, toks[0], false);
+	  word.CreateFromString(Output, m_output, candidates[i].word, false);
 
-	  float score = Scan<float>(toks[1]);
-	  tp->GetScoreBreakdown().PlusEquals(this, score);
+	  tp->GetScoreBreakdown().PlusEquals(this, candidates[i].score);
 
 	  // score of all other ff when this rule is being loaded
 	  tp->EvaluateInIsolation(sourcePhrase, GetFeaturesToApply());
 
-	  ret.push_back(tp);
+	  tpColl->Add(tp);
 	}
 
-	outStream.close();
-
-  return ret;
+  return tpColl;
 }
 
 ChartRuleLookupManager* PhraseDictionaryTransliteration::CreateRuleLookupManager(const ChartParser &parser,
@@ -154,16 +110,13 @@ void
 PhraseDictionaryTransliteration::
 SetParameter(const std::string& key, const std::string& value)
 {
-  if (key == "moses-dir") {
-	  m_mosesDir = value;
-  } else if (key == "script-dir") {
-	  m_scriptDir = value;
-  } else if (key == "external-dir") {
-	  m_externalDir = value;
-  } else if (key == "input-lang") {
-	  m_inputLang = value;
-  } else if (key == "output-lang") {
-	  m_outputLang = value;
+  if (key == "stack-size") {
+	  m_stackSize = Scan<size_t>(value);
+  } else if (key == "nbest-size") {
+	  m_nBestSize = Scan<size_t>(value);
+  } else if (key == "moses-dir" || key == "script-dir" || key == "external-dir"
+		  || key == "input-lang" || key == "output-lang") {
+	  // for prepare-transliteration-phrase-table.pl, which is no longer run
   } else {
 	  PhraseDictionary::SetParameter(key, value);
   }
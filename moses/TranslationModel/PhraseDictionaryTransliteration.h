@@ -2,6 +2,8 @@
 #pragma once
 
 #include "PhraseDictionary.h"
+#include "TransliterationModel.h"
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/tss.hpp>
 
 namespace Moses
@@ -33,11 +35,10 @@ public:
   TO_STRING();
 
 protected:
-  std::string m_mosesDir, m_scriptDir, m_externalDir, m_inputLang, m_outputLang;
+  boost::scoped_ptr<TransliterationModel> m_model;
+  size_t m_stackSize, m_nBestSize;
 
-  std::vector<TargetPhrase*> CreateTargetPhrases(const Phrase &sourcePhrase, const std::string &outDir) const;
-
-  void GetTargetPhraseCollection(InputPath &inputPath) const;
+  TargetPhraseCollection *CreateTargetPhraseCollection(const Phrase &sourcePhrase) const;
 
 };
 
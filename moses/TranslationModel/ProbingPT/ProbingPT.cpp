@@ -32,33 +32,8 @@ void ProbingPT::Load()
 
 	m_unkId = 456456546456;
 
-	// source vocab
-	const std::map<uint64_t, std::string> &sourceVocab = m_engine->getSourceVocab();
-	std::map<uint64_t, std::string>::const_iterator iterSource;
-	for (iterSource = sourceVocab.begin(); iterSource != sourceVocab.end(); ++iterSource) {
-	  const string &wordStr = iterSource->second;
-	  const Factor *factor = FactorCollection::Instance().AddFactor(wordStr);
-
-	  uint64_t probingId = iterSource->first;
-
-	  SourceVocabMap::value_type entry(factor, probingId);
-	  m_sourceVocabMap.insert(entry);
-
-	}
-
-	// target vocab
-	const std::map<unsigned int, std::string> &probingVocab = m_engine->getVocab();
-	std::map<unsigned int, std::string>::const_iterator iter;
-	for (iter = probingVocab.begin(); iter != probingVocab.end(); ++iter) {
-	  const string &wordStr = iter->second;
-	  const Factor *factor = FactorCollection::Instance().AddFactor(wordStr);
-
-	  unsigned int probingId = iter->first;
-
-	  TargetVocabMap::value_type entry(factor, probingId);
-	  m_vocabMap.insert(entry);
-
-	}
+	// the vocabularies are mmaped and looked up on demand, so loading does
+	// not depend on their size
 }
 
 void ProbingPT::InitializeForInput(InputType const& source)
@@ -187,23 +162,20 @@ TargetPhrase *ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase, const ta
 
 const Factor *ProbingPT::GetTargetFactor(uint64_t probingId) const
 {
-	TargetVocabMap::right_map::const_iterator iter;
-	iter = m_vocabMap.right.find(probingId);
-	if (iter != m_vocabMap.right.end()) {
-		return iter->second;
-	}
-	else {
+	const StringTable &targetVocab = m_engine->getVocab();
+	if (probingId == 0 || probingId >= targetVocab.size()) {
 		// not in mapping. Must be UNK
 		return NULL;
 	}
+	return FactorCollection::Instance().AddFactor(targetVocab.get(probingId));
 }
 
 uint64_t ProbingPT::GetSourceProbingId(const Factor *factor) const
 {
-	SourceVocabMap::left_map::const_iterator iter;
-	iter = m_sourceVocabMap.left.find(factor);
-	if (iter != m_sourceVocabMap.left.end()) {
-		return iter->second;
+	uint64_t probingId = getHash(factor->GetString());
+	StringPiece wordStr;
+	if (m_engine->getSourceVocab().find(probingId, wordStr) && wordStr == factor->GetString()) {
+		return probingId;
 	}
 	else {
 		// not in mapping. Must be UNK
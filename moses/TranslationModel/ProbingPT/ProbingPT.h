@@ -1,7 +1,6 @@
 
 #pragma once
 
-#include <boost/bimap.hpp>
 #include "../PhraseDictionary.h"
 
 class QueryEngine;
@@ -40,12 +39,6 @@ public:
 protected:
   QueryEngine *m_engine;
 
-  typedef boost::bimap<const Factor *, uint64_t> SourceVocabMap;
-  mutable SourceVocabMap m_sourceVocabMap;
-
-  typedef boost::bimap<const Factor *, unsigned int> TargetVocabMap;
-  mutable TargetVocabMap m_vocabMap;
-
   TargetPhraseCollection *CreateTargetPhrase(const Phrase &sourcePhrase) const;
   TargetPhrase *CreateTargetPhrase(const Phrase &sourcePhrase, const target_text &probingTargetPhrase) const;
   const Factor *GetTargetFactor(uint64_t probingId) const;
@@ -118,20 +118,24 @@ void Huffman::serialize_maps(const char * dirname){
     //Note that directory name should exist.
     std::string basedir(dirname);
     std::string target_phrase_path(basedir + "/target_phrases");
-    std::string probabilities_path(basedir + "/probs");
     std::string word_all1_path(basedir + "/Wall1");
 
+    //The codes are 1..n, so the tables are indexed by code with an empty entry for the delimiter 0.
     //Target phrase
-    std::ofstream os (target_phrase_path.c_str(), std::ios::binary);
-    boost::archive::text_oarchive oarch(os);
-    oarch << lookup_target_phrase;
-    os.close();
+    StringTableWriter target_writer;
+    target_writer.add(StringPiece());
+    for (std::map<unsigned int, std::string>::iterator it = lookup_target_phrase.begin(); it != lookup_target_phrase.end(); it++) {
+        target_writer.add(it->second);
+    }
+    target_writer.write(target_phrase_path.c_str());
 
     //Word all1
-    std::ofstream os2 (word_all1_path.c_str(), std::ios::binary);
-    boost::archive::text_oarchive oarch2(os2);
-    oarch2 << lookup_word_all1;
-    os2.close();
+    StringTableWriter word_all1_writer;
+    word_all1_writer.add(StringPiece());
+    for (std::map<unsigned int, std::vector<unsigned char> >::iterator it = lookup_word_all1.begin(); it != lookup_word_all1.end(); it++) {
+        word_all1_writer.add(it->second);
+    }
+    word_all1_writer.write(word_all1_path.c_str());
 }
 
 std::vector<unsigned char> Huffman::full_encode_line(line_text line){
@@ -183,31 +187,15 @@ void Huffman::produce_lookups(){
 }
 
 HuffmanDecoder::HuffmanDecoder (const char * dirname){
-    //Read the maps from disk
+    //Map the lookups from disk
 
     //Note that directory name should exist.
     std::string basedir(dirname);
     std::string target_phrase_path(basedir + "/target_phrases");
     std::string word_all1_path(basedir + "/Wall1");
 
-    //Target phrases
-    std::ifstream is (target_phrase_path.c_str(), std::ios::binary);
-    boost::archive::text_iarchive iarch(is);
-    iarch >> lookup_target_phrase;
-    is.close();
-
-    //Word allignment 1
-    std::ifstream is2 (word_all1_path.c_str(), std::ios::binary);
-    boost::archive::text_iarchive iarch2(is2);
-    iarch2 >> lookup_word_all1;
-    is2.close();
-
-}
-
-HuffmanDecoder::HuffmanDecoder (std::map<unsigned int, std::string> * lookup_target,
-     std::map<unsigned int, std::vector<unsigned char> > * lookup_word1) {
-    lookup_target_phrase = *lookup_target;
-    lookup_word_all1 = *lookup_word1;
+    lookup_target_phrase.load(target_phrase_path.c_str());
+    lookup_word_all1.load(word_all1_path.c_str());
 }
 
 std::vector<target_text> HuffmanDecoder::full_decode_line (std::vector<unsigned char> lines, int num_scores){
@@ -285,7 +273,8 @@ target_text HuffmanDecoder::decode_line (std::vector<unsigned int> input, int nu
     }
 
     ret.target_phrase = target_phrase;
-    ret.word_all1 = lookup_word_all1.find(wAll)->second;
+    StringPiece word_all1 = lookup_word_all1.get(wAll);
+    ret.word_all1.assign(word_all1.data(), word_all1.data() + word_all1.size());
 
     //Decode probabilities
     for (std::vector<unsigned int>::iterator it = probs.begin(); it != probs.end(); it++){
@@ -296,27 +285,12 @@ target_text HuffmanDecoder::decode_line (std::vector<unsigned int> input, int nu
 
 }
 
-inline std::string HuffmanDecoder::getTargetWordFromID(unsigned int id) {
-    return lookup_target_phrase.find(id)->second;
-}
-
 std::string HuffmanDecoder::getTargetWordsFromIDs(std::vector<unsigned int> ids){
     std::string returnstring;
     for (std::vector<unsigned int>::iterator it = ids.begin(); it != ids.end(); it++){
-        returnstring.append(getTargetWordFromID(*it) + " ");
-    }
-
-    return returnstring;
-}
-
-inline std::string getTargetWordFromID(unsigned int id, std::map<unsigned int, std::string> * lookup_target_phrase) {
-    return lookup_target_phrase->find(id)->second;
-}
-
-std::string getTargetWordsFromIDs(std::vector<unsigned int> ids, std::map<unsigned int, std::string> * lookup_target_phrase) {
-    std::string returnstring;
-    for (std::vector<unsigned int>::iterator it = ids.begin(); it != ids.end(); it++){
-        returnstring.append(getTargetWordFromID(*it, lookup_target_phrase) + " ");
+        StringPiece word = getTargetWordFromID(*it);
+        returnstring.append(word.data(), word.size());
+        returnstring.append(" ");
     }
 
     return returnstring;
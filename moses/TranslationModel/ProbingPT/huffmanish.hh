@@ -7,11 +7,8 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
-#include <boost/serialization/serialization.hpp>
-#include <boost/serialization/vector.hpp>
-#include <boost/serialization/map.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/archive/text_oarchive.hpp>
+#include <map>
+#include "string_table.hh"
 
 //Sorting for the second
 struct sort_pair {
@@ -71,22 +68,24 @@ class Huffman {
 };
 
 class HuffmanDecoder {
-    std::map<unsigned int, std::string> lookup_target_phrase;
-    std::map<unsigned int, std::vector<unsigned char> > lookup_word_all1;
+    //mmaped lookups from huffman code to target word and to word alignment
+    StringTable lookup_target_phrase;
+    StringTable lookup_word_all1;
 
 public:
     HuffmanDecoder (const char *);
-    HuffmanDecoder (std::map<unsigned int, std::string> *, std::map<unsigned int, std::vector<unsigned char> > *);
 
     //Getters
-    const std::map<unsigned int, std::string> get_target_lookup_map() const{
+    const StringTable &get_target_lookup_map() const{
         return lookup_target_phrase;
     }
-    const std::map<unsigned int, std::vector<unsigned char> > get_word_all1_lookup_map() const{
+    const StringTable &get_word_all1_lookup_map() const{
         return lookup_word_all1;
     }
 
-    inline std::string getTargetWordFromID(unsigned int id);
+    StringPiece getTargetWordFromID(unsigned int id) const {
+        return lookup_target_phrase.get(id);
+    }
 
     std::string getTargetWordsFromIDs(std::vector<unsigned int> ids);
 
@@ -96,10 +95,6 @@ public:
     std::vector<target_text> full_decode_line (std::vector<unsigned char> lines, int num_scores);
 };
 
-std::string getTargetWordsFromIDs(std::vector<unsigned int> ids, std::map<unsigned int, std::string> * lookup_target_phrase);
-
-inline std::string getTargetWordFromID(unsigned int id, std::map<unsigned int, std::string> * lookup_target_phrase);
-
 inline unsigned int reinterpret_float(float * num);
 
 inline float reinterpret_uint(unsigned int * num);
@@ -31,10 +31,7 @@ QueryEngine::QueryEngine(const char * filepath) : decoder(filepath){
     std::string path_to_source_vocabid = basepath + "/source_vocabids";
 
     ///Source phrase vocabids
-    read_map(&source_vocabids, path_to_source_vocabid.c_str());
-
-    //Target phrase vocabIDs
-    vocabids = decoder.get_target_lookup_map();
+    source_vocabids.load(path_to_source_vocabid.c_str());
 
     //Read config file
     std::string line;
@@ -171,7 +168,7 @@ void QueryEngine::printTargetInfo(std::vector<target_text> target_phrases){
     for (int i = 0; i<entries; i++){
         std::cout << "Entry " << i+1 << " of " << entries << ":" << std::endl;
         //Print text
-        std::cout << getTargetWordsFromIDs(target_phrases[i].target_phrase, &vocabids) << "\t";
+        std::cout << decoder.getTargetWordsFromIDs(target_phrases[i].target_phrase) << "\t";
         
         //Print probabilities:
         for (int j = 0; j<target_phrases[i].prob.size(); j++){
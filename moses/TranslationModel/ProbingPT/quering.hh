@@ -6,15 +6,14 @@
 #include <sys/stat.h> //For finding size of file
 #include "vocabid.hh"
 #include <algorithm> //toLower
-#define API_VERSION 3
+#define API_VERSION 4
 
 
 char * read_binary_file(char * filename);
 
 class QueryEngine {
     unsigned char * binary_mmaped; //The binari phrase table file
-    std::map<unsigned int, std::string> vocabids;
-    std::map<uint64_t, std::string> source_vocabids;
+    StringTable source_vocabids; //mmaped, sorted by vocab id
 
     Table table;
     char *mem; //Memory for the table, necessary so that we can correctly destroy the object
@@ -31,10 +30,10 @@ class QueryEngine {
         std::pair<bool, std::vector<target_text> > query(StringPiece source_phrase);
         std::pair<bool, std::vector<target_text> > query(std::vector<uint64_t> source_phrase);
         void printTargetInfo(std::vector<target_text> target_phrases);
-        const std::map<unsigned int, std::string> getVocab() const
+        const StringTable &getVocab() const
         { return decoder.get_target_lookup_map(); }
 
-        const std::map<uint64_t, std::string> getSourceVocab() const {
+        const StringTable &getSourceVocab() const {
             return source_vocabids;
         }
 
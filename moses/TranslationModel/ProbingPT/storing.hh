@@ -12,7 +12,7 @@
 #include "util/file_piece.hh"
 #include "util/file.hh"
 #include "vocabid.hh"
-#define API_VERSION 3
+#define API_VERSION 4
 
 void createProbingPT(const char * phrasetable_path, const char * target_path,
     const char * num_scores, const char * is_reordering);
@@ -0,0 +1,83 @@
+#include "string_table.hh"
+
+#include <algorithm>
+#include <fstream>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+
+namespace {
+const uint64_t kStringTableMagic = 0x3162615467727453ULL; //"StrgTab1" on little endian
+const uint64_t kHeaderSize = 3;
+}
+
+StringTableWriter::StringTableWriter() {
+    offsets.push_back(0);
+}
+
+void StringTableWriter::add(StringPiece str) {
+    blob.append(str.data(), str.size());
+    offsets.push_back(blob.size());
+}
+
+void StringTableWriter::add(const std::vector<unsigned char> &bytes) {
+    blob.append(bytes.begin(), bytes.end());
+    offsets.push_back(blob.size());
+}
+
+void StringTableWriter::write(const char * filename) const {
+    std::ofstream os (filename, std::ios::binary);
+    uint64_t header[kHeaderSize] = {kStringTableMagic, offsets.size() - 1, !keys.empty()};
+    os.write((const char *)header, sizeof(header));
+    if (!keys.empty()) {
+        os.write((const char *)&keys[0], keys.size() * sizeof(uint64_t));
+    }
+    os.write((const char *)&offsets[0], offsets.size() * sizeof(uint64_t));
+    os.write(blob.data(), blob.size());
+    os.close();
+    UTIL_THROW_IF(!os, util::ErrnoException, "Failed to write " << filename);
+}
+
+void StringTableWriter::write_keyed(const std::map<uint64_t, std::string> &karta, const char * filename) {
+    //std::map is sorted by key already, which is the order find() searches in.
+    StringTableWriter writer;
+    writer.keys.reserve(karta.size());
+    for (std::map<uint64_t, std::string>::const_iterator it = karta.begin(); it != karta.end(); it++) {
+        writer.keys.push_back(it->first);
+        writer.add(it->second);
+    }
+    writer.write(filename);
+}
+
+StringTable::StringTable() : num_strings(0), keys(NULL), offsets(NULL), blob(NULL) {}
+
+void StringTable::load(const char * filename) {
+    util::scoped_fd fd(util::OpenReadOrThrow(filename));
+    uint64_t filesize = util::SizeFile(fd.get());
+    UTIL_THROW_IF(filesize == util::kBadSize || filesize < kHeaderSize * sizeof(uint64_t), util::Exception,
+        filename << " is not a ProbingPT string table, please rebinarize your phrase table.");
+
+    //Lazy: pages are read when strings are looked up, and shared with other processes.
+    util::MapRead(util::LAZY, fd.get(), 0, filesize, mem);
+    const uint64_t * header = static_cast<const uint64_t *>(mem.get());
+    UTIL_THROW_IF(header[0] != kStringTableMagic, util::Exception,
+        filename << " is not a ProbingPT string table, please rebinarize your phrase table.");
+
+    num_strings = header[1];
+    const uint64_t * arrays = header + kHeaderSize;
+    keys = header[2] ? arrays : NULL;
+    offsets = arrays + (keys ? num_strings : 0);
+    blob = reinterpret_cast<const char *>(offsets + num_strings + 1);
+    uint64_t arrays_end = (kHeaderSize + (keys ? num_strings : 0) + num_strings + 1) * sizeof(uint64_t);
+    UTIL_THROW_IF(arrays_end > filesize || arrays_end + offsets[num_strings] > filesize, util::Exception,
+        filename << " is truncated.");
+}
+
+bool StringTable::find(uint64_t key, StringPiece &out) const {
+    const uint64_t * found = std::lower_bound(keys, keys + num_strings, key);
+    if (found == keys + num_strings || *found != key) {
+        return false;
+    }
+    out = get(found - keys);
+    return true;
+}
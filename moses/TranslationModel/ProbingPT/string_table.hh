@@ -0,0 +1,67 @@
+#pragma once
+
+//Flat string tables that are mmaped instead of deserialized, so that loading a
+//phrase table does not depend on the size of its vocabulary and the pages are
+//shared between processes using the same table.
+//
+//File layout, all numbers are uint64_t in native byte order:
+//  magic, number of strings n, whether there are keys (0 or 1)
+//  keys[n]        sorted hashes, only if there are keys
+//  offsets[n + 1] start of every string in the blob, then the end of the last
+//  blob           the strings, concatenated
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/mmap.hh"
+#include "util/string_piece.hh"
+
+class StringTableWriter {
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> offsets;
+    std::string blob;
+
+public:
+    StringTableWriter();
+
+    //Strings are numbered in the order they are added, starting from zero.
+    void add(StringPiece str);
+    void add(const std::vector<unsigned char> &bytes);
+
+    //Write a table indexed by number.
+    void write(const char * filename) const;
+
+    //Write a table from hash keys to strings, looked up by key.
+    static void write_keyed(const std::map<uint64_t, std::string> &karta, const char * filename);
+};
+
+class StringTable {
+    util::scoped_memory mem;
+    uint64_t num_strings;
+    const uint64_t * keys; //NULL if the table is indexed by number
+    const uint64_t * offsets;
+    const char * blob;
+
+public:
+    StringTable();
+
+    //Map a table written by StringTableWriter. Throws util::Exception if the file is not one.
+    void load(const char * filename);
+
+    uint64_t size() const {
+        return num_strings;
+    }
+
+    StringPiece get(uint64_t index) const {
+        return StringPiece(blob + offsets[index], offsets[index + 1] - offsets[index]);
+    }
+
+    //Keyed tables only: find the string with this key.
+    bool find(uint64_t key, StringPiece &out) const;
+
+    //Keyed tables only: the key of the index-th string, in increasing order.
+    uint64_t key(uint64_t index) const {
+        return keys[index];
+    }
+};
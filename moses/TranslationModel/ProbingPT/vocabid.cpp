@@ -11,19 +11,14 @@ void add_to_map(std::map<uint64_t, std::string> *karta, StringPiece textin){
 }
 
 void serialize_map(std::map<uint64_t, std::string> *karta, const char* filename){
-    std::ofstream os (filename, std::ios::binary);
-    boost::archive::text_oarchive oarch(os);
-
-    oarch << *karta;  //Serialise map
-    os.close();
+    StringTableWriter::write_keyed(*karta, filename);
 }
 
 void read_map(std::map<uint64_t, std::string> *karta, const char* filename){
-    std::ifstream is (filename, std::ios::binary);
-    boost::archive::text_iarchive iarch(is);
-
-    iarch >> *karta;
+    StringTable table;
+    table.load(filename);
 
-    //Close the stream after we are done.
-    is.close();
+    for (uint64_t i = 0; i < table.size(); i++){
+        karta->insert(std::pair<uint64_t, std::string>(table.key(i), table.get(i).as_string()));
+    }
 }
@@ -19,6 +19,7 @@
 
 #include "LoaderStandard.h"
 
+#include <deque>
 #include <fstream>
 #include <string>
 #include <iterator>
@@ -35,13 +36,20 @@
 #include "moses/WordsRange.h"
 #include "moses/UserMessage.h"
 #include "moses/ChartTranslationOptionList.h"
-#include "moses/FactorCollection.h"
+#include "moses/ThreadPool.h"
 #include "util/file_piece.hh"
 #include "util/string_piece.hh"
 #include "util/tokenize_piece.hh"
 #include "util/double-conversion/double-conversion.h"
 #include "util/exception.hh"
 
+#include <boost/ptr_container/ptr_deque.hpp>
+#include <boost/scoped_ptr.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
+
 using namespace std;
 
 namespace Moses
@@ -142,44 +150,127 @@ void ReformatHieroRule(const string &lineOrig, string &out)
   out = ret.str();
 }
 
-bool RuleTableLoaderStandard::Load(FormatType format
-                                   , const std::vector<FactorType> &input
-                                   , const std::vector<FactorType> &output
-                                   , const std::string &inFile
-                                   , size_t /* tableLimit */
-                                   , RuleTableTrie &ruleTable)
+namespace
 {
-  PrintUserTime(string("Start loading text phrase table. ") + (format==MosesFormat?"Moses":"Hiero") + " format");
-
-  const StaticData &staticData = StaticData::Instance();
+//! lines parsed per unit of work
+const size_t LINES_PER_BATCH = 10000;
+
+//! a rule of the text table, parsed but not yet in the trie
+struct ParsedRule {
+  ParsedRule() : targetPhrase(NULL), sourceLHS(NULL) {}
+  Phrase sourcePhrase;
+  TargetPhrase *targetPhrase;
+  Word *sourceLHS;
+};
+
+//! consecutive lines of the table and the rules parsed from them
+class RuleBatch
+{
+public:
+  explicit RuleBatch(size_t firstLine) : firstLine(firstLine), submitted(false), m_done(false) {}
+
+  ~RuleBatch() {
+    for (size_t i = 0; i < rules.size(); ++i) {
+      delete rules[i].targetPhrase;
+      // not implemented correctly in memory pt. just delete it for now
+      delete rules[i].sourceLHS;
+    }
+  }
 
-  string lineOrig;
-  size_t count = 0;
+  void SetDone() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_done = true;
+    m_cond.notify_all();
+#else
+    m_done = true;
+#endif
+  }
 
-  std::ostream *progress = NULL;
-  IFVERBOSE(1) progress = &std::cerr;
-  util::FilePiece in(inFile.c_str(), progress);
+  void WaitDone() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_done) {
+      m_cond.wait(lock);
+    }
+#endif
+  }
 
-  // reused variables
-  vector<float> scoreVector;
-  StringPiece line;
-  std::string hiero_before, hiero_after;
+  std::string text; //!< the lines, each ended by '\n'
+  size_t firstLine; //!< number of the first line in the file, from 1
+  std::vector<ParsedRule> rules;
+  std::string error; //!< set if parsing on a loading thread failed
+  bool submitted; //!< being parsed, or parsed; SetDone() will be called
+
+private:
+  bool m_done;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+  boost::condition_variable m_cond;
+#endif
+};
+
+//! append up to maxLines lines of the file to text, returning how many were read
+size_t ReadLines(util::FilePiece &in, std::string &text, size_t maxLines)
+{
+  size_t count = 0;
+  try {
+    for (; count < maxLines; ++count) {
+      StringPiece line = in.ReadLine();
+      text.append(line.data(), line.size());
+      text += '\n';
+    }
+  } catch (const util::EndOfFileException &e) {
+  }
+  return count;
+}
 
-  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
+//! Parses lines into rules. Only reads shared state, so batches may be parsed at the same time
+class RuleParser
+{
+public:
+  RuleParser(FormatType format
+             , const std::vector<FactorType> &input
+             , const std::vector<FactorType> &output
+             , RuleTableTrie &ruleTable)
+    : m_format(format)
+    , m_input(input)
+    , m_output(output)
+    , m_ruleTable(ruleTable)
+    , m_wordDeletionEnabled(StaticData::Instance().IsWordDeletionEnabled()) {
+  }
 
-  while(true) {
-    try {
-      line = in.ReadLine();
-    } catch (const util::EndOfFileException &e) {
-      break;
-    }
+  void Parse(RuleBatch &batch) const {
+    // reused variables
+    vector<float> scoreVector;
+    std::string hiero_before, hiero_after;
+    double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
+
+    batch.rules.reserve(LINES_PER_BATCH);
+    size_t count = batch.firstLine;
+    for (size_t begin = 0; begin < batch.text.size(); ++count) {
+      size_t end = batch.text.find('\n', begin);
+      StringPiece line(batch.text.data() + begin, end - begin);
+      begin = end + 1;
+
+      if (m_format == HieroFormat) { // inefficiently reformat line
+        hiero_before.assign(line.data(), line.size());
+        ReformatHieroRule(hiero_before, hiero_after);
+        line = hiero_after;
+      }
 
-    if (format == HieroFormat) { // inefficiently reformat line
-      hiero_before.assign(line.data(), line.size());
-      ReformatHieroRule(hiero_before, hiero_after);
-      line = hiero_after;
+      batch.rules.push_back(ParsedRule());
+      if (!ParseLine(line, count, converter, scoreVector, batch.rules.back())) {
+        batch.rules.pop_back();
+      }
     }
+  }
 
+private:
+  bool ParseLine(const StringPiece &line, size_t count
+                 , const double_conversion::StringToDoubleConverter &converter
+                 , vector<float> &scoreVector
+                 , ParsedRule &rule) const {
     util::TokenIter<util::MultiCharacter> pipes(line, "|||");
     StringPiece sourcePhraseString(*pipes);
     StringPiece targetPhraseString(*++pipes);
@@ -196,9 +287,9 @@ bool RuleTableLoaderStandard::Load(FormatType format
     }
 
     bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
-    if (isLHSEmpty && !staticData.IsWordDeletionEnabled()) {
-      TRACE_ERR( ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
-      continue;
+    if (isLHSEmpty && !m_wordDeletionEnabled) {
+      TRACE_ERR( m_ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
+      return false;
     }
 
     scoreVector.clear();
@@ -208,7 +299,7 @@ bool RuleTableLoaderStandard::Load(FormatType format
       UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << count);
       scoreVector.push_back(FloorScore(TransformScore(score)));
     }
-    const size_t numScoreComponents = ruleTable.GetNumScoreComponents();
+    const size_t numScoreComponents = m_ruleTable.GetNumScoreComponents();
     if (scoreVector.size() != numScoreComponents) {
       UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
                   << numScoreComponents << ") of score components on line " << count);
@@ -217,15 +308,14 @@ bool RuleTableLoaderStandard::Load(FormatType format
     // parse source & find pt node
 
     // constituent labels
-    Word *sourceLHS = NULL;
     Word *targetLHS;
 
     // create target phrase obj
-    TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
-    targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
+    rule.targetPhrase = new TargetPhrase(&m_ruleTable);
+    TargetPhrase *targetPhrase = rule.targetPhrase;
+    targetPhrase->CreateFromString(Output, m_output, targetPhraseString, &targetLHS);
     // source
-    Phrase sourcePhrase;
-    sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
+    rule.sourcePhrase.CreateFromString(Input, m_input, sourcePhraseString, &rule.sourceLHS);
 
     // rest of target phrase
     targetPhrase->SetAlignmentInfo(alignString);
@@ -235,7 +325,7 @@ bool RuleTableLoaderStandard::Load(FormatType format
 
     if (++pipes) {
       StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ruleTable, sparseString);
+      targetPhrase->SetSparseScore(&m_ruleTable, sparseString);
     }
 
     if (++pipes) {
@@ -243,16 +333,123 @@ bool RuleTableLoaderStandard::Load(FormatType format
       targetPhrase->SetProperties(propertiesString);
     }
 
-    targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
-    targetPhrase->EvaluateInIsolation(sourcePhrase, ruleTable.GetFeaturesToApply());
+    targetPhrase->GetScoreBreakdown().Assign(&m_ruleTable, scoreVector);
+    targetPhrase->EvaluateInIsolation(rule.sourcePhrase, m_ruleTable.GetFeaturesToApply());
+    return true;
+  }
+
+  FormatType m_format;
+  const std::vector<FactorType> &m_input;
+  const std::vector<FactorType> &m_output;
+  RuleTableTrie &m_ruleTable;
+  bool m_wordDeletionEnabled;
+};
+
+#ifdef WITH_THREADS
+class RuleParseTask : public Task
+{
+public:
+  RuleParseTask(const RuleParser &parser, RuleBatch &batch)
+    : m_parser(parser), m_batch(batch) {}
 
-    TargetPhraseCollection &phraseColl = GetOrCreateTargetPhraseCollection(ruleTable, sourcePhrase, *targetPhrase, sourceLHS);
-    phraseColl.Add(targetPhrase);
+  virtual void Run() {
+    try {
+      m_parser.Parse(m_batch);
+    } catch (const std::exception &e) {
+      m_batch.error = e.what();
+    } catch (...) {
+      m_batch.error = "unknown error";
+    }
+    m_batch.SetDone();
+  }
 
-    // not implemented correctly in memory pt. just delete it for now
-    delete sourceLHS;
+private:
+  const RuleParser &m_parser;
+  RuleBatch &m_batch;
+};
+#endif
+}
 
-    count++;
+bool RuleTableLoaderStandard::Load(FormatType format
+                                   , const std::vector<FactorType> &input
+                                   , const std::vector<FactorType> &output
+                                   , const std::string &inFile
+                                   , size_t /* tableLimit */
+                                   , RuleTableTrie &ruleTable)
+{
+  PrintUserTime(string("Start loading text phrase table. ") + (format==MosesFormat?"Moses":"Hiero") + " format");
+
+  std::ostream *progress = NULL;
+  IFVERBOSE(1) progress = &std::cerr;
+  util::FilePiece in(inFile.c_str(), progress);
+
+  // The file is read, and decompressed, on this thread in batches of lines.
+  // With -load-threads n the batches are parsed on n threads, and added to
+  // the trie here in file order, so the table is the same as when loaded
+  // on one thread.
+  RuleParser parser(format, input, output, ruleTable);
+  size_t maxPending = 1;
+#ifdef WITH_THREADS
+  // tables loaded at startup share one pool, see StaticData::GetRuleLoadThreadPool()
+  ThreadPool *pool = StaticData::Instance().GetRuleLoadThreadPool();
+  boost::scoped_ptr<ThreadPool> ownPool;
+  size_t numThreads = StaticData::Instance().GetLoadThreadCount();
+  if (!pool && numThreads > 1) {
+    ownPool.reset(new ThreadPool(numThreads));
+    pool = ownPool.get();
+  }
+  if (pool) {
+    maxPending = 2 * numThreads;
+  }
+#endif
+
+  boost::ptr_deque<RuleBatch> pending; // in file order
+  size_t lineNum = 1;
+  try {
+    for (bool eof = false; !eof; ) {
+      pending.push_back(new RuleBatch(lineNum));
+      RuleBatch &batch = pending.back();
+      size_t numLines = ReadLines(in, batch.text, LINES_PER_BATCH);
+      lineNum += numLines;
+      eof = numLines < LINES_PER_BATCH;
+
+      if (!numLines) {
+        pending.pop_back();
+      } else {
+#ifdef WITH_THREADS
+        if (pool) {
+          pool->Submit(new RuleParseTask(parser, batch));
+        } else
+#endif
+        {
+          parser.Parse(batch);
+          batch.SetDone();
+        }
+        batch.submitted = true;
+      }
+
+      while (!pending.empty() && (eof || pending.size() >= maxPending)) {
+        RuleBatch &done = pending.front();
+        done.WaitDone();
+        UTIL_THROW_IF2(!done.error.empty(), done.error);
+        for (size_t i = 0; i < done.rules.size(); ++i) {
+          ParsedRule &rule = done.rules[i];
+          TargetPhraseCollection &phraseColl = GetOrCreateTargetPhraseCollection(ruleTable, rule.sourcePhrase, *rule.targetPhrase, rule.sourceLHS);
+          phraseColl.Add(rule.targetPhrase);
+          rule.targetPhrase = NULL;
+        }
+        pending.pop_front();
+      }
+    }
+  } catch (...) {
+    // tasks still refer to the batches; the pool may be shared, so wait
+    // for this table's batches rather than stopping it
+    for (size_t i = 0; i < pending.size(); ++i) {
+      if (pending[i].submitted) {
+        pending[i].WaitDone();
+      }
+    }
+    throw;
   }
 
   // sort and prune each target phrase collection
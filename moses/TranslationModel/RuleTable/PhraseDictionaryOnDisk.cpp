@@ -49,6 +49,26 @@ PhraseDictionaryOnDisk::~PhraseDictionaryOnDisk()
 void PhraseDictionaryOnDisk::Load()
 {
   SetFeaturesToApply();
+
+  OnDiskPt::OnDiskWrapper *obj = new OnDiskPt::OnDiskWrapper();
+  m_implementation.reset(obj);
+  obj->BeginLoad(m_filePath);
+
+  UTIL_THROW_IF2(obj->GetMisc("Version") != OnDiskPt::OnDiskWrapper::VERSION_NUM,
+                 "On-disk phrase table is version " <<  obj->GetMisc("Version")
+                 << ". It is not compatible with version " << OnDiskPt::OnDiskWrapper::VERSION_NUM);
+
+  UTIL_THROW_IF2(obj->GetMisc("NumSourceFactors") != m_input.size(),
+                 "On-disk phrase table has " <<  obj->GetMisc("NumSourceFactors") << " source factors."
+                 << ". The ini file specified " << m_input.size() << " source factors");
+
+  UTIL_THROW_IF2(obj->GetMisc("NumTargetFactors") != m_output.size(),
+                 "On-disk phrase table has " <<  obj->GetMisc("NumTargetFactors") << " target factors."
+                 << ". The ini file specified " << m_output.size() << " target factors");
+
+  UTIL_THROW_IF2(obj->GetMisc("NumScores") != m_numScoreComponents,
+                 "On-disk phrase table has " <<  obj->GetMisc("NumScores") << " scores."
+                 << ". The ini file specified " << m_numScoreComponents << " scores");
 }
 
 ChartRuleLookupManager *PhraseDictionaryOnDisk::CreateRuleLookupManager(
@@ -66,7 +86,7 @@ OnDiskPt::OnDiskWrapper &PhraseDictionaryOnDisk::GetImplementation()
 {
   OnDiskPt::OnDiskWrapper* dict;
   dict = m_implementation.get();
-  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet created for this thread");
+  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet loaded");
   return *dict;
 }
 
@@ -74,36 +94,13 @@ const OnDiskPt::OnDiskWrapper &PhraseDictionaryOnDisk::GetImplementation() const
 {
   OnDiskPt::OnDiskWrapper* dict;
   dict = m_implementation.get();
-  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet created for this thread");
+  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet loaded");
   return *dict;
 }
 
 void PhraseDictionaryOnDisk::InitializeForInput(InputType const& source)
 {
-  const StaticData &staticData = StaticData::Instance();
-
   ReduceCache();
-
-  OnDiskPt::OnDiskWrapper *obj = new OnDiskPt::OnDiskWrapper();
-  obj->BeginLoad(m_filePath);
-
-  UTIL_THROW_IF2(obj->GetMisc("Version") != OnDiskPt::OnDiskWrapper::VERSION_NUM,
-                 "On-disk phrase table is version " <<  obj->GetMisc("Version")
-                 << ". It is not compatible with version " << OnDiskPt::OnDiskWrapper::VERSION_NUM);
-
-  UTIL_THROW_IF2(obj->GetMisc("NumSourceFactors") != m_input.size(),
-                 "On-disk phrase table has " <<  obj->GetMisc("NumSourceFactors") << " source factors."
-                 << ". The ini file specified " << m_input.size() << " source factors");
-
-  UTIL_THROW_IF2(obj->GetMisc("NumTargetFactors") != m_output.size(),
-                 "On-disk phrase table has " <<  obj->GetMisc("NumTargetFactors") << " target factors."
-                 << ". The ini file specified " << m_output.size() << " target factors");
-
-  UTIL_THROW_IF2(obj->GetMisc("NumScores") != m_numScoreComponents,
-                 "On-disk phrase table has " <<  obj->GetMisc("NumScores") << " scores."
-                 << ". The ini file specified " << m_numScoreComponents << " scores");
-
-  m_implementation.reset(obj);
 }
 
 void PhraseDictionaryOnDisk::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
@@ -62,6 +62,11 @@ public:
     size_t last,
     ChartParserCallback &outColl);
 
+  // rule applications are precomputed per range
+  bool SupportsWidthOrder() const {
+    return true;
+  }
+
 private:
   // Define a callback type for use by StackLatticeSearcher.
   struct MatchCallback {
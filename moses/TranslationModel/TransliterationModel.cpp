@@ -0,0 +1,493 @@
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <set>
+
+#include "TransliterationModel.h"
+#include "lm/model.hh"
+#include "moses/InputFileStream.h"
+#include "moses/TypeDef.h"
+#include "moses/Util.h"
+#include "util/exception.hh"
+
+using namespace std;
+
+namespace Moses
+{
+
+namespace
+{
+//! the path, or the path with .gz if only that exists
+string ResolvePath(const string &path)
+{
+  if (!FileExists(path) && FileExists(path + ".gz")) {
+    return path + ".gz";
+  }
+  return path;
+}
+
+const string &GetArg(const map<string, string> &args, const string &key)
+{
+  map<string, string>::const_iterator iter = args.find(key);
+  UTIL_THROW_IF2(iter == args.end(),
+                 "Transliteration model feature " << args.find("name")->second << " has no " << key);
+  return iter->second;
+}
+
+//! extension of a partial transliteration by one phrase
+struct Arc {
+  size_t prev; //!< node extended
+  const string *target; //!< NULL if an unknown character was dropped
+  float score; //!< weighted phrase and language model score
+};
+
+/** Partial transliterations covering the first characters of a word, with
+ *  the same language model state. The search is monotone, so they have the
+ *  same future and are recombined: only the best is extended, the arcs are
+ *  kept to read off the n-best.
+ */
+struct Node {
+  lm::ngram::State state;
+  float score; //!< of the best partial transliteration
+  vector<Arc> arcs; //!< empty for the start node
+};
+
+struct NodeOrderer {
+  NodeOrderer(const vector<Node> &nodes) : m_nodes(nodes) {}
+  bool operator()(size_t a, size_t b) const {
+    return m_nodes[a].score > m_nodes[b].score;
+  }
+  const vector<Node> &m_nodes;
+};
+
+//! add an arc to the node of its language model state in a stack, creating the node if needed
+void AddArc(vector<Node> &nodes, vector<size_t> &stack, boost::unordered_map<lm::ngram::State, size_t> &recombination
+            , const lm::ngram::State &state, const Arc &arc)
+{
+  const float score = nodes[arc.prev].score + arc.score;
+  pair<boost::unordered_map<lm::ngram::State, size_t>::iterator, bool> inserted
+    = recombination.insert(make_pair(state, nodes.size()));
+  if (inserted.second) {
+    Node node;
+    node.state = state;
+    node.score = score;
+    stack.push_back(nodes.size());
+    nodes.push_back(node);
+  }
+  Node &node = nodes[inserted.first->second];
+  node.score = max(node.score, score);
+  node.arcs.push_back(arc);
+}
+
+//! a partial transliteration: the arc into its node, and which partial transliteration of the node extended
+struct Derivation {
+  size_t arc; //!< NOT_FOUND for the start node
+  size_t prevRank;
+  float score;
+
+  bool operator<(const Derivation &other) const {
+    return score < other.score;
+  }
+};
+
+/** Partial transliterations of the nodes best first, found lazily as
+ *  algorithm 3 of Huang and Chiang (2005), Better k-best parsing.
+ */
+class KBest
+{
+public:
+  KBest(const vector<Node> &nodes)
+    :m_nodes(nodes), m_derivations(nodes.size()), m_candidates(nodes.size())
+    ,m_started(nodes.size(), false), m_exhausted(nodes.size(), false) {}
+
+  //! the k-th best partial transliteration of a node, counting from 0, or NULL if there are fewer
+  const Derivation *Get(size_t node, size_t k) {
+    vector<Derivation> &derivations = m_derivations[node];
+    const Node &n = m_nodes[node];
+    priority_queue<Derivation> &candidates = m_candidates[node];
+
+    if (!m_started[node]) {
+      m_started[node] = true;
+      if (n.arcs.empty()) {
+        Derivation start = { NOT_FOUND, 0, n.score };
+        derivations.push_back(start);
+        m_exhausted[node] = true;
+      }
+      for (size_t i = 0; i < n.arcs.size(); ++i) {
+        Derivation best = { i, 0, m_nodes[n.arcs[i].prev].score + n.arcs[i].score };
+        candidates.push(best);
+      }
+    }
+
+    while (derivations.size() <= k && !m_exhausted[node]) {
+      if (!derivations.empty()) {
+        // the next partial transliteration along the arc of the last one
+        const Derivation last = derivations.back();
+        const Arc &arc = n.arcs[last.arc];
+        const Derivation *next = Get(arc.prev, last.prevRank + 1);
+        if (next) {
+          Derivation successor = { last.arc, last.prevRank + 1, next->score + arc.score };
+          candidates.push(successor);
+        }
+      }
+      if (candidates.empty()) {
+        m_exhausted[node] = true;
+        break;
+      }
+      derivations.push_back(candidates.top());
+      candidates.pop();
+    }
+    return k < derivations.size() ? &derivations[k] : NULL;
+  }
+
+private:
+  const vector<Node> &m_nodes;
+  vector< vector<Derivation> > m_derivations;
+  vector< priority_queue<Derivation> > m_candidates;
+  vector<bool> m_started, m_exhausted;
+};
+
+}
+
+TransliterationModel::TransliterationModel(const string &modelDir, size_t stackSize, size_t tableLimit)
+  :m_maxSourceLength(0)
+  ,m_stackSize(stackSize)
+{
+  // features of the trained model, weights of the tuned one
+  FeatureLines features;
+  Weights weights;
+  const string iniPath = modelDir + "/model/moses.ini";
+  LoadIni(iniPath, features, weights);
+
+  const string tunedIniPath = modelDir + "/tuning/moses.tuned.ini";
+  if (FileExists(tunedIniPath)) {
+    FeatureLines tunedFeatures;
+    weights.clear();
+    LoadIni(tunedIniPath, tunedFeatures, weights);
+  }
+
+  // the tables are read as text, binarised ones cannot be used
+  for (size_t i = 0; i < features.size(); ++i) {
+    const string &featureClass = features[i].first;
+    UTIL_THROW_IF2(featureClass.compare(0, 16, "PhraseDictionary") == 0 && featureClass != "PhraseDictionaryMemory",
+                   "Transliteration model " << iniPath << " uses a " << featureClass
+                   << ", only text phrase tables (PhraseDictionaryMemory) can be loaded");
+  }
+
+  const FeatureArgs *phraseTable = FindFeature(features, "PhraseDictionary");
+  const FeatureArgs *lm = FindFeature(features, "KENLM");
+  UTIL_THROW_IF2(phraseTable == NULL || lm == NULL,
+                 "Transliteration model " << iniPath << " needs a phrase table and a KENLM language model");
+
+  m_lm.reset(lm::ngram::LoadVirtual(GetArg(*lm, "path").c_str()));
+  m_lmWeight = GetWeights(weights, *lm, 1)[0];
+
+  const FeatureArgs *wordPenalty = FindFeature(features, "WordPenalty");
+  m_wordPenaltyWeight = wordPenalty ? GetWeights(weights, *wordPenalty, 1)[0] : 0;
+  const FeatureArgs *phrasePenalty = FindFeature(features, "PhrasePenalty");
+  m_phrasePenaltyWeight = phrasePenalty ? GetWeights(weights, *phrasePenalty, 1)[0] : 0;
+
+  // all phrases are monotone, so only the monotone orientations are needed
+  ReorderingColl reordering;
+  const FeatureArgs *reorderingTable = FindFeature(features, "LexicalReordering");
+  if (reorderingTable) {
+    size_t numFeatures = Scan<size_t>(GetArg(*reorderingTable, "num-features"));
+    const string path = ResolvePath(GetArg(*reorderingTable, "path"));
+    UTIL_THROW_IF2(!FileExists(path), "Transliteration model " << iniPath << " has no text reordering table "
+                   << path << ", binarised reordering tables cannot be loaded");
+    LoadReorderingTable(path, GetWeights(weights, *reorderingTable, numFeatures), reordering);
+  }
+
+  size_t numFeatures = Scan<size_t>(GetArg(*phraseTable, "num-features"));
+  const string path = ResolvePath(GetArg(*phraseTable, "path"));
+  UTIL_THROW_IF2(!FileExists(path), "Transliteration model " << iniPath << " has no text phrase table " << path);
+  LoadPhraseTable(path, GetWeights(weights, *phraseTable, numFeatures), reordering, tableLimit);
+}
+
+void TransliterationModel::LoadIni(const string &path, FeatureLines &features, Weights &weights)
+{
+  InputFileStream inStream(path);
+
+  map<string, size_t> classCount;
+  string section, line;
+  while (getline(inStream, line)) {
+    line = Trim(line);
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    if (line[0] == '[') {
+      section = line;
+      continue;
+    }
+
+    if (section == "[feature]") {
+      vector<string> toks = Tokenize(line);
+      FeatureArgs args;
+      for (size_t i = 1; i < toks.size(); ++i) {
+        vector<string> keyValue = TokenizeFirstOnly(toks[i], "=");
+        if (keyValue.size() == 2) {
+          args[keyValue[0]] = keyValue[1];
+        }
+      }
+      // default name, as FeatureFunction gives it
+      size_t index = classCount[toks[0]]++;
+      if (args.find("name") == args.end()) {
+        args["name"] = toks[0] + SPrint(index);
+      }
+      features.push_back(make_pair(toks[0], args));
+    } else if (section == "[weight]") {
+      vector<string> toks = Tokenize(line);
+      UTIL_THROW_IF2(toks.empty() || toks[0][toks[0].size() - 1] != '=',
+                     "Malformed weight in " << path << ": " << line);
+      string name = toks[0].substr(0, toks[0].size() - 1);
+      weights[name] = Scan<float>(vector<string>(toks.begin() + 1, toks.end()));
+    }
+  }
+}
+
+const TransliterationModel::FeatureArgs *TransliterationModel::FindFeature(const FeatureLines &features, const string &featureClass)
+{
+  for (size_t i = 0; i < features.size(); ++i) {
+    if (features[i].first.compare(0, featureClass.size(), featureClass) == 0) {
+      return &features[i].second;
+    }
+  }
+  return NULL;
+}
+
+const vector<float> &TransliterationModel::GetWeights(const Weights &weights, const FeatureArgs &feature, size_t numFeatures)
+{
+  const string &name = feature.find("name")->second;
+  Weights::const_iterator iter = weights.find(name);
+  UTIL_THROW_IF2(iter == weights.end() || iter->second.size() != numFeatures,
+                 "Transliteration model needs " << numFeatures << " weights for " << name);
+  return iter->second;
+}
+
+void TransliterationModel::LoadReorderingTable(const string &path, const vector<float> &weights, ReorderingColl &reordering)
+{
+  InputFileStream inStream(path);
+
+  string line;
+  while (getline(inStream, line)) {
+    vector<string> toks = TokenizeMultiCharSeparator(line, "|||");
+    UTIL_THROW_IF2(toks.size() < 3, "Syntax error in " << path << ": " << line);
+
+    vector<float> scores = Tokenize<float>(toks[2]);
+    UTIL_THROW_IF2(scores.size() != weights.size(), "Wrong number of scores in " << path << ": " << line);
+
+    // backward, and for bidirectional models forward, monotone orientation
+    float score = weights[0] * FloorScore(TransformScore(scores[0]));
+    if (scores.size() == 6) {
+      score += weights[3] * FloorScore(TransformScore(scores[3]));
+    }
+    reordering[Trim(toks[0]) + " ||| " + Join(" ", Tokenize(toks[1]))] = score;
+  }
+}
+
+void TransliterationModel::LoadPhraseTable(const string &path, const vector<float> &weights
+    , const ReorderingColl &reordering, size_t tableLimit)
+{
+  InputFileStream inStream(path);
+  const lm::ngram::State &nullContext = *static_cast<const lm::ngram::State*>(m_lm->NullContextMemory());
+
+  string line;
+  while (getline(inStream, line)) {
+    vector<string> toks = TokenizeMultiCharSeparator(line, "|||");
+    UTIL_THROW_IF2(toks.size() < 3, "Syntax error in " << path << ": " << line);
+
+    const string source = Trim(toks[0]);
+    const vector<string> targetChars = Tokenize(toks[1]);
+    vector<float> scores = Tokenize<float>(toks[2]);
+    UTIL_THROW_IF2(scores.size() != weights.size(), "Wrong number of scores in " << path << ": " << line);
+
+    Option option;
+    option.score = m_phrasePenaltyWeight - m_wordPenaltyWeight * targetChars.size();
+    for (size_t i = 0; i < scores.size(); ++i) {
+      option.score += weights[i] * FloorScore(TransformScore(scores[i]));
+    }
+
+    ReorderingColl::const_iterator reorderingScore = reordering.find(source + " ||| " + Join(" ", targetChars));
+    if (reorderingScore != reordering.end()) {
+      option.score += reorderingScore->second;
+    }
+
+    // language model score without context, as moses estimates it for the table limit
+    lm::ngram::State state = nullContext, outState;
+    float lmScore = 0;
+    for (size_t i = 0; i < targetChars.size(); ++i) {
+      option.target += targetChars[i];
+      lm::WordIndex lmWord = m_lm->BaseVocabulary().Index(targetChars[i]);
+      option.lmWords.push_back(lmWord);
+      lmScore += m_lm->BaseScore(&state, lmWord, &outState);
+      state = outState;
+    }
+    option.estimate = option.score + m_lmWeight * TransformLMScore(lmScore);
+
+    m_options[source].push_back(option);
+    m_maxSourceLength = max(m_maxSourceLength, Tokenize(source).size());
+  }
+
+  for (OptionColl::iterator iter = m_options.begin(); iter != m_options.end(); ++iter) {
+    vector<Option> &options = iter->second;
+    sort(options.begin(), options.end());
+    if (tableLimit && options.size() > tableLimit) {
+      options.resize(tableLimit);
+    }
+  }
+}
+
+void TransliterationModel::SplitCharacters(const string &word, vector<string> &chars)
+{
+  chars.clear();
+  for (size_t i = 0; i < word.size(); ) {
+    // continuation bytes 10xxxxxx belong to the preceding character
+    size_t length = 1;
+    while (i + length < word.size() && (static_cast<unsigned char>(word[i + length]) & 0xC0) == 0x80) {
+      ++length;
+    }
+    chars.push_back(word.substr(i, length));
+    i += length;
+  }
+}
+
+void TransliterationModel::Transliterate(const string &word, size_t nBestSize, vector<Candidate> &candidates) const
+{
+  candidates.clear();
+
+  vector<string> chars;
+  SplitCharacters(word, chars);
+  if (chars.empty()) {
+    return;
+  }
+
+  // stacks of nodes by number of characters covered, and the nodes of the
+  // stacks still to be expanded by language model state
+  vector<Node> nodes;
+  vector< vector<size_t> > stacks(chars.size() + 1);
+  vector< boost::unordered_map<lm::ngram::State, size_t> > recombination(chars.size() + 1);
+
+  Node start;
+  start.state = *static_cast<const lm::ngram::State*>(m_lm->BeginSentenceMemory());
+  start.score = 0;
+  nodes.push_back(start);
+  stacks[0].push_back(0);
+
+  for (size_t pos = 0; pos < chars.size(); ++pos) {
+    vector<size_t> &stack = stacks[pos];
+    if (stack.size() > m_stackSize) {
+      nth_element(stack.begin(), stack.begin() + m_stackSize, stack.end(), NodeOrderer(nodes));
+      stack.resize(m_stackSize);
+    }
+    boost::unordered_map<lm::ngram::State, size_t>().swap(recombination[pos]);
+
+    for (size_t h = 0; h < stack.size(); ++h) {
+      const size_t prev = stack[h];
+      // nodes grows below
+      const lm::ngram::State prevState = nodes[prev].state;
+      const float prevScore = nodes[prev].score;
+      bool translated = false;
+
+      string source;
+      for (size_t length = 1; length <= m_maxSourceLength && pos + length <= chars.size(); ++length) {
+        if (length > 1) {
+          source += " ";
+        }
+        source += chars[pos + length - 1];
+
+        OptionColl::const_iterator iter = m_options.find(source);
+        if (iter == m_options.end()) {
+          continue;
+        }
+        translated |= (length == 1);
+
+        const vector<Option> &options = iter->second;
+        for (size_t i = 0; i < options.size(); ++i) {
+          const Option &option = options[i];
+
+          lm::ngram::State state = prevState, outState;
+          float lmScore = 0;
+          for (size_t w = 0; w < option.lmWords.size(); ++w) {
+            lmScore += m_lm->BaseScore(&state, option.lmWords[w], &outState);
+            state = outState;
+          }
+
+          Arc arc = { prev, &option.target, option.score + m_lmWeight * TransformLMScore(lmScore) };
+          AddArc(nodes, stacks[pos + length], recombination[pos + length], state, arc);
+        }
+      }
+
+      if (!translated) {
+        // drop the unknown character
+        Arc arc = { prev, NULL, 0 };
+        AddArc(nodes, stacks[pos + 1], recombination[pos + 1], prevState, arc);
+      }
+    }
+  }
+
+  // complete with the end of sentence
+  Node goal;
+  goal.score = -numeric_limits<float>::infinity();
+  const vector<size_t> &last = stacks.back();
+  for (size_t h = 0; h < last.size(); ++h) {
+    lm::ngram::State outState;
+    Arc arc = { last[h], NULL, m_lmWeight * TransformLMScore(
+                  m_lm->BaseScore(&nodes[last[h]].state, m_lm->BaseVocabulary().EndSentence(), &outState)) };
+    goal.arcs.push_back(arc);
+    goal.score = max(goal.score, nodes[last[h]].score + arc.score);
+  }
+  if (goal.arcs.empty()) {
+    return;
+  }
+  const size_t goalNode = nodes.size();
+  nodes.push_back(goal);
+
+  // read off the distinct transliterations of the n-best, looking at
+  // nBestSize * 20 of them at most, as moses -n-best-factor does
+  KBest kBest(nodes);
+  set<string> seen;
+  const Derivation *derivation;
+  for (size_t k = 0; candidates.size() < nBestSize && k < nBestSize * 20
+       && (derivation = kBest.Get(goalNode, k)) != NULL; ++k) {
+    Candidate candidate;
+    candidate.score = derivation->score;
+
+    vector<const string*> targets;
+    for (size_t node = goalNode; derivation->arc != NOT_FOUND; ) {
+      const Arc &arc = nodes[node].arcs[derivation->arc];
+      if (arc.target) {
+        targets.push_back(arc.target);
+      }
+      node = arc.prev;
+      derivation = kBest.Get(node, derivation->prevRank);
+    }
+    for (size_t i = targets.size(); i > 0; --i) {
+      candidate.word += *targets[i - 1];
+    }
+    if (!candidate.word.empty() && seen.insert(candidate.word).second) {
+      candidates.push_back(candidate);
+    }
+  }
+}
+
+}
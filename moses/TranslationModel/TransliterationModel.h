@@ -0,0 +1,96 @@
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "lm/virtual_interface.hh"
+
+namespace Moses
+{
+
+/** Character-level transliteration model, as trained by
+ *  train-transliteration-module.pl. The phrase table, lexicalized
+ *  reordering table and language model of the model directory are loaded
+ *  once, with the weights of tuning/moses.tuned.ini. A word is then
+ *  transliterated by a monotone beam search over its characters, as
+ *  prepare-transliteration-phrase-table.pl did by running a second moses
+ *  with -distortion-limit 0 -drop-unknown. As in moses, partial
+ *  transliterations with the same language model state are recombined, and
+ *  the n-best is read off the recombined search graph.
+ */
+class TransliterationModel
+{
+public:
+  struct Candidate {
+    std::string word;
+    float score; //!< weighted model score, as in the n-best list of moses
+  };
+
+  TransliterationModel(const std::string &modelDir, size_t stackSize, size_t tableLimit);
+
+  /** Best distinct transliterations of a word, best first. Thread-safe.
+   */
+  void Transliterate(const std::string &word, size_t nBestSize, std::vector<Candidate> &candidates) const;
+
+  //! split a UTF-8 string into its characters
+  static void SplitCharacters(const std::string &word, std::vector<std::string> &chars);
+
+protected:
+  //! target side of a phrase pair, with its weighted translation and reordering scores
+  struct Option {
+    std::string target; //!< characters, without spaces
+    std::vector<lm::WordIndex> lmWords;
+    float score;
+    float estimate; //!< score with the language model estimate, to apply the table limit
+
+    bool operator<(const Option &other) const {
+      return estimate > other.estimate;
+    }
+  };
+
+  typedef std::map<std::string, std::string> FeatureArgs;
+  typedef std::vector<std::pair<std::string, FeatureArgs> > FeatureLines; //!< feature class and arguments, with the name
+  typedef std::map<std::string, std::vector<float> > Weights;
+  typedef boost::unordered_map<std::string, std::vector<Option> > OptionColl;
+  typedef boost::unordered_map<std::string, float> ReorderingColl; //!< by source and target
+
+  OptionColl m_options; //!< by source characters, separated by spaces
+  size_t m_maxSourceLength;
+  size_t m_stackSize; //!< recombined partial transliterations per stack
+
+  boost::scoped_ptr<lm::base::Model> m_lm;
+  float m_lmWeight, m_wordPenaltyWeight, m_phrasePenaltyWeight;
+
+  void LoadPhraseTable(const std::string &path, const std::vector<float> &weights
+                       , const ReorderingColl &reordering, size_t tableLimit);
+  static void LoadReorderingTable(const std::string &path, const std::vector<float> &weights, ReorderingColl &reordering);
+
+  static void LoadIni(const std::string &path, FeatureLines &features, Weights &weights);
+  static const FeatureArgs *FindFeature(const FeatureLines &features, const std::string &featureClass);
+  static const std::vector<float> &GetWeights(const Weights &weights, const FeatureArgs &feature, size_t numFeatures);
+};
+
+}
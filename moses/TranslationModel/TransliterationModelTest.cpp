@@ -0,0 +1,196 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "TransliterationModel.h"
+#include "util/exception.hh"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+// Greek characters, two bytes each in UTF-8
+const string kAlpha = "\xce\xb1", kBeta = "\xce\xb2", kGamma = "\xce\xb3";
+
+/** Model directory of train-transliteration-module.pl, reduced to a
+ *  phrase table with one score and a bigram language model whose only
+ *  bigram is never used, so that the characters score as unigrams.
+ */
+struct ModelDir {
+  explicit ModelDir(const string &phraseDictionary = "PhraseDictionaryMemory") {
+    dir = boost::filesystem::unique_path(
+            boost::filesystem::temp_directory_path() / "transliteration-test-%%%%-%%%%");
+    boost::filesystem::create_directories(dir / "model");
+    const string phraseTable = (dir / "model" / "phrase-table").string();
+    const string lm = (dir / "model" / "lm.arpa").string();
+
+    ofstream ini((dir / "model" / "moses.ini").string().c_str());
+    ini << "[feature]\n"
+        << "WordPenalty\n"
+        << "PhrasePenalty\n"
+        << phraseDictionary << " name=TranslationModel0 num-features=1 path=" << phraseTable
+        << " input-factor=0 output-factor=0\n"
+        << "KENLM name=LM0 factor=0 order=2 path=" << lm << "\n"
+        << "[weight]\n"
+        << "WordPenalty0= -1\n"
+        << "PhrasePenalty0= 0.2\n"
+        << "TranslationModel0= 1\n"
+        << "LM0= 0.5\n";
+
+    ofstream table(phraseTable.c_str());
+    table << kAlpha << " ||| a ||| 0.5 ||| 0-0\n"
+          << kBeta << " ||| b ||| 0.25 ||| 0-0\n"
+          << kAlpha << " " << kBeta << " ||| x ||| 0.1 ||| 0-0 1-0\n"
+          << kAlpha << " " << kBeta << " ||| a b ||| 0.05 ||| 0-0 1-1\n";
+
+    ofstream arpa(lm.c_str());
+    arpa << "\\data\\\n"
+         << "ngram 1=6\n"
+         << "ngram 2=1\n"
+         << "\n"
+         << "\\1-grams:\n"
+         << "-99\t<s>\n"
+         << "-1.0\t</s>\n"
+         << "-2.0\t<unk>\n"
+         << "-0.5\ta\n"
+         << "-0.7\tb\n"
+         << "-0.3\tx\n"
+         << "\n"
+         << "\\2-grams:\n"
+         << "-0.1\tx a\n"
+         << "\n"
+         << "\\end\\\n";
+  }
+
+  ~ModelDir() {
+    boost::filesystem::remove_all(dir);
+  }
+
+  boost::filesystem::path dir;
+};
+
+//! weighted score of the characters' language model log10 probabilities
+float LM(float log10Prob)
+{
+  return 0.5 * log(10.0) * log10Prob;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(transliteration_model)
+
+BOOST_AUTO_TEST_CASE(split_characters)
+{
+  vector<string> chars;
+  TransliterationModel::SplitCharacters("a" + kAlpha + "b\xe2\x82\xac", chars);
+  BOOST_REQUIRE_EQUAL(chars.size(), 4);
+  BOOST_CHECK_EQUAL(chars[0], "a");
+  BOOST_CHECK_EQUAL(chars[1], kAlpha);
+  BOOST_CHECK_EQUAL(chars[2], "b");
+  BOOST_CHECK_EQUAL(chars[3], "\xe2\x82\xac");
+
+  TransliterationModel::SplitCharacters("", chars);
+  BOOST_CHECK(chars.empty());
+}
+
+BOOST_AUTO_TEST_CASE(scores)
+{
+  ModelDir model;
+  TransliterationModel transliteration(model.dir.string(), 5000, 20);
+
+  // phrase penalty 0.2 per phrase, word penalty +1 per character. The
+  // "a b" phrase gives "ab" again, with a worse score, which is dropped
+  vector<TransliterationModel::Candidate> candidates;
+  transliteration.Transliterate(kAlpha + kBeta, 10, candidates);
+  BOOST_REQUIRE_EQUAL(candidates.size(), 2);
+  BOOST_CHECK_EQUAL(candidates[0].word, "ab");
+  BOOST_CHECK_CLOSE(candidates[0].score, log(0.5) + log(0.25) + 2 * 0.2 + 2 + LM(-0.5 - 0.7 - 1.0), 0.001);
+  BOOST_CHECK_EQUAL(candidates[1].word, "x");
+  BOOST_CHECK_CLOSE(candidates[1].score, log(0.1) + 0.2 + 1 + LM(-0.3 - 1.0), 0.001);
+
+  // n-best size
+  transliteration.Transliterate(kAlpha + kBeta, 1, candidates);
+  BOOST_REQUIRE_EQUAL(candidates.size(), 1);
+  BOOST_CHECK_EQUAL(candidates[0].word, "ab");
+}
+
+BOOST_AUTO_TEST_CASE(recombination)
+{
+  ModelDir model;
+  TransliterationModel transliteration(model.dir.string(), 5000, 20);
+
+  // ab, x and "a b" for each half. The language model states are a, b and x
+  vector<TransliterationModel::Candidate> candidates;
+  transliteration.Transliterate(kAlpha + kBeta + kAlpha + kBeta, 10, candidates);
+  BOOST_REQUIRE_EQUAL(candidates.size(), 4);
+  set<string> words;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    words.insert(candidates[i].word);
+    if (i > 0) {
+      BOOST_CHECK(candidates[i - 1].score >= candidates[i].score);
+    }
+    if (candidates[i].word == "xx") {
+      BOOST_CHECK_CLOSE(candidates[i].score, 2 * log(0.1) + 2 * 0.2 + 2 + LM(-0.3 - 0.3 - 1.0), 0.001);
+    }
+  }
+  BOOST_CHECK(words.count("abab") && words.count("xab") && words.count("abx") && words.count("xx"));
+
+  // with one node per language model state, a stack of 3 loses nothing
+  TransliterationModel small(model.dir.string(), 3, 20);
+  vector<TransliterationModel::Candidate> smallCandidates;
+  small.Transliterate(kAlpha + kBeta + kAlpha + kBeta, 10, smallCandidates);
+  BOOST_REQUIRE_EQUAL(smallCandidates.size(), candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    BOOST_CHECK_EQUAL(smallCandidates[i].word, candidates[i].word);
+    BOOST_CHECK_CLOSE(smallCandidates[i].score, candidates[i].score, 0.001);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(unknown_characters)
+{
+  ModelDir model;
+  TransliterationModel transliteration(model.dir.string(), 5000, 20);
+
+  vector<TransliterationModel::Candidate> candidates;
+  transliteration.Transliterate(kAlpha + kGamma, 10, candidates);
+  BOOST_REQUIRE_EQUAL(candidates.size(), 1);
+  BOOST_CHECK_EQUAL(candidates[0].word, "a");
+  BOOST_CHECK_CLOSE(candidates[0].score, log(0.5) + 0.2 + 1 + LM(-0.5 - 1.0), 0.001);
+
+  transliteration.Transliterate(kGamma, 10, candidates);
+  BOOST_CHECK(candidates.empty());
+}
+
+BOOST_AUTO_TEST_CASE(binary_phrase_table)
+{
+  ModelDir model("PhraseDictionaryCompact");
+  BOOST_CHECK_THROW(TransliterationModel(model.dir.string(), 5000, 20), util::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
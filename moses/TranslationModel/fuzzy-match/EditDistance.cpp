@@ -0,0 +1,118 @@
+#include "EditDistance.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace tmmt
+{
+
+namespace
+{
+
+/* advance one block of the column by one text word.
+ carry is the difference between the row above the block and the row
+ before it in the previous column, i.e. -1, 0 or 1.
+ returns the difference for the high row of the block */
+
+inline int AdvanceBlock( uint64_t &pv, uint64_t &mv, uint64_t eq, uint64_t high, int carry )
+{
+  uint64_t xv = eq | mv;
+  if (carry < 0)
+    eq |= 1;
+  uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+  uint64_t ph = mv | ~(xh | pv);
+  uint64_t mh = pv & xh;
+
+  int out = 0;
+  if (ph & high)
+    out = 1;
+  else if (mh & high)
+    out = -1;
+
+  ph <<= 1;
+  mh <<= 1;
+  if (carry < 0)
+    mh |= 1;
+  else if (carry > 0)
+    ph |= 1;
+
+  pv = mh | ~(xv | ph);
+  mv = ph & xv;
+  return out;
+}
+
+}
+
+EditDistance::EditDistance( const vector< WORD_ID > &pattern )
+  :m_length(pattern.size())
+  ,m_blockCount((pattern.size() + BLOCK_SIZE - 1) / BLOCK_SIZE)
+  ,m_lastRow(0)
+  ,m_words(pattern)
+{
+  if (m_length > 0)
+    m_lastRow = (Block) 1 << ((m_length - 1) % BLOCK_SIZE);
+
+  sort( m_words.begin(), m_words.end() );
+  m_words.erase( unique( m_words.begin(), m_words.end() ), m_words.end() );
+
+  // one more set of blocks, all zero, for words not in the pattern
+  m_peq.resize( (m_words.size() + 1) * m_blockCount, 0 );
+  for(size_t i=0; i<m_length; i++) {
+    size_t w = lower_bound( m_words.begin(), m_words.end(), pattern[i] ) - m_words.begin();
+    m_peq[ w * m_blockCount + i / BLOCK_SIZE ] |= (Block) 1 << (i % BLOCK_SIZE);
+  }
+}
+
+const EditDistance::Block *EditDistance::GetPeq( WORD_ID word ) const
+{
+  vector< WORD_ID >::const_iterator i = lower_bound( m_words.begin(), m_words.end(), word );
+  size_t w = (i != m_words.end() && *i == word) ? i - m_words.begin() : m_words.size();
+  return &m_peq[ w * m_blockCount ];
+}
+
+unsigned int EditDistance::Compute( const vector< WORD_ID > &text ) const
+{
+  return Compute( text, m_length + text.size() );
+}
+
+unsigned int EditDistance::Compute( const vector< WORD_ID > &text, unsigned int max_cost ) const
+{
+  if (m_length == 0)
+    return text.size();
+
+  const Block highRow = (Block) 1 << (BLOCK_SIZE - 1);
+
+  // vertical differences of the current column, positive and negative
+  Block pv0 = ~(Block) 0, mv0 = 0;
+  vector< Block > pv, mv;
+  if (m_blockCount > 1) {
+    pv.resize( m_blockCount, ~(Block) 0 );
+    mv.resize( m_blockCount, 0 );
+  }
+
+  // value of the last row, in the first column
+  unsigned int score = m_length;
+  for(size_t j=0; j<text.size(); j++) {
+    const Block *peq = GetPeq( text[j] );
+
+    // the first row increases by 1 with each text word
+    int carry = 1;
+    if (m_blockCount == 1) {
+      carry = AdvanceBlock( pv0, mv0, peq[0], m_lastRow, carry );
+    } else {
+      for(size_t b=0; b<m_blockCount; b++) {
+        Block high = (b+1 == m_blockCount) ? m_lastRow : highRow;
+        carry = AdvanceBlock( pv[b], mv[b], peq[b], high, carry );
+      }
+    }
+    score += carry;
+
+    // each remaining word reduces the cost by at most 1
+    size_t remaining = text.size() - j - 1;
+    if (score > max_cost + remaining)
+      return score - remaining;
+  }
+  return score;
+}
+
+}
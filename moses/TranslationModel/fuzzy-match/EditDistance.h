@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Vocabulary.h"
+
+namespace tmmt
+{
+
+/* bit-parallel word edit distance (Myers 1999, with the blocks of Hyyro 2003)
+ each row of the edit distance matrix is a bit of a 64-bit block, so
+ a column is computed with a few logical operations per block.
+ insertions, deletions and substitutions cost 1, as in sed() without
+ letter edit distance. */
+
+class EditDistance
+{
+public:
+  EditDistance( const std::vector< WORD_ID > &pattern );
+
+  /* edit distance between pattern and text */
+  unsigned int Compute( const std::vector< WORD_ID > &text ) const;
+
+  /* as above, but gives up as soon as the distance must exceed max_cost,
+   and then returns some value larger than max_cost */
+  unsigned int Compute( const std::vector< WORD_ID > &text, unsigned int max_cost ) const;
+
+  size_t GetLength() const {
+    return m_length;
+  }
+
+private:
+  typedef uint64_t Block;
+  static const size_t BLOCK_SIZE = 64;
+
+  size_t m_length;
+  size_t m_blockCount;
+  Block m_lastRow; // bit of the last row in the last block
+
+  std::vector< WORD_ID > m_words; // distinct words of the pattern, sorted
+  std::vector< Block > m_peq; // for each of m_words, where it occurs in the pattern
+
+  const Block *GetPeq( WORD_ID word ) const;
+};
+
+}
@@ -0,0 +1,105 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "EditDistance.h"
+
+using namespace tmmt;
+using namespace std;
+
+namespace
+{
+// full matrix edit distance, as sed() without letter edit distance
+unsigned int MatrixDistance(const vector<WORD_ID> &a, const vector<WORD_ID> &b)
+{
+  vector< vector<unsigned int> > cost(a.size() + 1, vector<unsigned int>(b.size() + 1));
+  for (size_t i = 0; i <= a.size(); ++i) {
+    cost[i][0] = i;
+  }
+  for (size_t j = 0; j <= b.size(); ++j) {
+    cost[0][j] = j;
+  }
+  for (size_t i = 1; i <= a.size(); ++i) {
+    for (size_t j = 1; j <= b.size(); ++j) {
+      unsigned int diag = cost[i-1][j-1] + (a[i-1] == b[j-1] ? 0 : 1);
+      cost[i][j] = min(diag, min(cost[i-1][j], cost[i][j-1]) + 1);
+    }
+  }
+  return cost[a.size()][b.size()];
+}
+
+vector<WORD_ID> RandomSentence(size_t length, size_t vocabSize)
+{
+  vector<WORD_ID> sentence(length);
+  for (size_t i = 0; i < length; ++i) {
+    sentence[i] = rand() % vocabSize;
+  }
+  return sentence;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(edit_distance)
+
+BOOST_AUTO_TEST_CASE(small)
+{
+  WORD_ID a[] = {1, 2, 3, 4};
+  WORD_ID b[] = {1, 3, 4, 5, 6};
+  vector<WORD_ID> pattern(a, a + 4), text(b, b + 5), empty;
+
+  EditDistance distance(pattern);
+  BOOST_CHECK_EQUAL(distance.Compute(text), 3);
+  BOOST_CHECK_EQUAL(distance.Compute(pattern), 0);
+  BOOST_CHECK_EQUAL(distance.Compute(empty), 4);
+  BOOST_CHECK_EQUAL(EditDistance(empty).Compute(text), 5);
+}
+
+BOOST_AUTO_TEST_CASE(matches_matrix)
+{
+  srand(1);
+  // up to several blocks
+  for (size_t n = 0; n < 2000; ++n) {
+    vector<WORD_ID> pattern = RandomSentence(rand() % 200, 1 + rand() % 8);
+    vector<WORD_ID> text = RandomSentence(rand() % 200, 1 + rand() % 8);
+    BOOST_CHECK_EQUAL(EditDistance(pattern).Compute(text), MatrixDistance(pattern, text));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bounded)
+{
+  srand(2);
+  for (size_t n = 0; n < 2000; ++n) {
+    vector<WORD_ID> pattern = RandomSentence(rand() % 100, 4);
+    vector<WORD_ID> text = RandomSentence(rand() % 100, 4);
+    unsigned int maxCost = rand() % 50;
+    unsigned int expected = MatrixDistance(pattern, text);
+    unsigned int cost = EditDistance(pattern).Compute(text, maxCost);
+    if (expected <= maxCost) {
+      BOOST_CHECK_EQUAL(cost, expected);
+    } else {
+      BOOST_CHECK_GT(cost, maxCost);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
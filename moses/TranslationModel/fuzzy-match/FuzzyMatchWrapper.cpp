@@ -6,14 +6,19 @@
 //  Copyright 2012 __MyCompanyName__. All rights reserved.
 //
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <map>
+#include <set>
+#include <boost/unordered_map.hpp>
 #include "FuzzyMatchWrapper.h"
 #include "SentenceAlignment.h"
 #include "Match.h"
 #include "create_xml.h"
+#include "EditDistance.h"
 #include "moses/Util.h"
-#include "moses/StaticData.h"
-#include "util/file.hh"
+#include "moses/ThreadPool.h"
 
 using namespace std;
 
@@ -49,55 +54,117 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   cerr << "loading completed" << endl;
 }
 
-string FuzzyMatchWrapper::Extract(long translationId, const string &dirNameStr)
+void FuzzyMatchWrapper::Extract(long translationId, const string &input, vector<FuzzyMatchRule> &rules)
 {
-  const Moses::StaticData &staticData = Moses::StaticData::Instance();
-
   WordIndex wordIndex;
 
-  string fuzzyMatchFile = ExtractTM(wordIndex, translationId, dirNameStr);
-
-  // create extrac files
-  create_xml(fuzzyMatchFile);
-
-  // create phrase table with usual Moses scoring and consolidate programs
-  string cmd;
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract | gzip -c > "
-        + fuzzyMatchFile + ".extract.sorted.gz";
-  system(cmd.c_str());
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract.inv | gzip -c > "
-        + fuzzyMatchFile + ".extract.inv.sorted.gz";
-  system(cmd.c_str());
-
-#ifdef IS_XCODE
-  cmd = "/Users/hieuhoang/unison/workspace/github/moses-smt/bin";
-#elif IS_ECLIPSE
-  cmd = "/home/hieu/workspace/github/moses-smt/bin";
-#else
-  cmd = staticData.GetBinDirectory();
-#endif
+  vector<FuzzyMatch> matches;
+  ExtractTM(wordIndex, translationId, input, matches);
+
+  // create extract
+  vector<ExtractedRule> extracted;
+  create_xml(matches, extracted);
+
+  // create phrase table as the usual Moses scoring and consolidate programs would
+  ScoreRules(extracted, rules);
+}
 
-  cmd += string("/../scripts/training/train-model.perl -dont-zip -first-step 6 -last-step 6 -f en -e fr -hierarchical ")
-         + " -extract-file " + fuzzyMatchFile + ".extract -lexical-file - -score-options \"--NoLex\" "
-         + " -phrase-translation-table " + fuzzyMatchFile + ".pt";
-  system(cmd.c_str());
+namespace
+{
+typedef vector< set< size_t > > RuleAlignment; // target to source, without the left hand side
 
+bool IsNonTerminal(const string &word)
+{
+  return word.size() >= 3 && word[0] == '[' && word[word.size() - 1] == ']';
+}
 
-  return fuzzyMatchFile + ".pt.gz";
+//! a distinct rule of the extract, with the counts of its word alignments
+struct RuleCounts {
+  RuleCounts() : count(0) {}
+  float count;
+  map< RuleAlignment, float > alignments;
+};
 }
 
-string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const string &dirNameStr)
+void FuzzyMatchWrapper::ScoreRules(const vector<ExtractedRule> &extracted, vector<FuzzyMatchRule> &rules)
 {
-  const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
+  // rules are distinct if their words or the alignment of their non-terminals differ,
+  // see ExtractionPhrasePair::Matches() of score
+  typedef pair< pair< string, string >, RuleAlignment > RuleKey;
+  map< RuleKey, RuleCounts > ruleCounts;
+  map< string, float > sourceCounts, targetCounts;
+
+  for (size_t i = 0; i < extracted.size(); ++i) {
+    const ExtractedRule &rule = extracted[i];
+    const vector<string> sourceToks = Moses::Tokenize(rule.source);
+    const vector<string> targetToks = Moses::Tokenize(rule.target);
+    const string source = Moses::Join(" ", sourceToks);
+    const string target = Moses::Join(" ", targetToks);
+
+    RuleAlignment alignment(targetToks.size() - 1);
+    const vector<string> points = Moses::Tokenize(rule.alignment);
+    for (size_t j = 0; j < points.size(); ++j) {
+      size_t s, t;
+      if (sscanf(points[j].c_str(), "%zu-%zu", &s, &t) == 2 && s < sourceToks.size() - 1 && t < alignment.size()) {
+        alignment[t].insert(s);
+      }
+    }
+
+    RuleAlignment nonTermAlignment(alignment.size());
+    for (size_t t = 0; t < alignment.size(); ++t) {
+      if (IsNonTerminal(targetToks[t])) {
+        nonTermAlignment[t] = alignment[t];
+      }
+    }
+
+    RuleCounts &counts = ruleCounts[make_pair(make_pair(source, target), nonTermAlignment)];
+    counts.count += rule.count;
+    counts.alignments[alignment] += rule.count;
+    sourceCounts[source] += rule.count;
+    targetCounts[target] += rule.count;
+  }
 
-  string inputPath = dirNameStr + "/in";
-  string fuzzyMatchFile = dirNameStr + "/fuzzyMatchFile";
-  ofstream fuzzyMatchStream(fuzzyMatchFile.c_str());
+  rules.reserve(rules.size() + ruleCounts.size());
+  for (map< RuleKey, RuleCounts >::const_iterator iter = ruleCounts.begin(); iter != ruleCounts.end(); ++iter) {
+    const string &source = iter->first.first.first;
+    const string &target = iter->first.first.second;
+    const RuleCounts &counts = iter->second;
+
+    // most frequent alignment, see ExtractionPhrasePair::FindBestAlignmentTargetToSource()
+    map< RuleAlignment, float >::const_iterator best = counts.alignments.begin();
+    for (map< RuleAlignment, float >::const_iterator align = counts.alignments.begin(); align != counts.alignments.end(); ++align) {
+      if (align->second >= best->second) {
+        best = align;
+      }
+    }
+
+    FuzzyMatchRule rule;
+    rule.source = source;
+    rule.target = target;
+    // the points sorted by source index, as score prints them for rules
+    vector<string> points;
+    for (size_t t = 0; t < best->first.size(); ++t) {
+      for (set<size_t>::const_iterator s = best->first[t].begin(); s != best->first[t].end(); ++s) {
+        points.push_back(Moses::SPrint(*s) + "-" + Moses::SPrint(t));
+      }
+    }
+    sort(points.begin(), points.end());
+    for (size_t i = 0; i < points.size(); ++i) {
+      rule.alignment += points[i] + " ";
+    }
+    rule.scores.push_back(counts.count / targetCounts[target]);
+    rule.scores.push_back(counts.count / sourceCounts[source]);
+    rules.push_back(rule);
+  }
+}
+
+void FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const string &inputSentence, vector<FuzzyMatch> &matches)
+{
+  const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
 
   vector< vector< WORD_ID > > input;
-  load_corpus(inputPath, input);
+  input.push_back( GetVocabulary().Tokenize( inputSentence.c_str() ) );
 
-  assert(input.size() == 1);
   size_t sentenceInd = 0;
 
   clock_t start_clock = clock();
@@ -117,12 +184,12 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   for(size_t start=0; start<input[sentenceInd].size(); start++) {
     SuffixArray::INDEX prior_first_match = 0;
     SuffixArray::INDEX prior_last_match = suffixArray->GetSize()-1;
-    vector< string > substring;
+    vector< WORD_ID > substring;
     bool stillMatched = true;
     vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > matchedAtThisStart;
     //cerr << "start: " << start;
     for(int word=start; stillMatched && word<input[sentenceInd].size(); word++) {
-      substring.push_back( GetVocabulary().GetWord( input[sentenceInd][word] ) );
+      substring.push_back( input[sentenceInd][word] );
 
       // only look up, if needed (i.e. no unnecessary short gram lookups)
       //				if (! word-start+1 <= short_match_max_length( input_length ) )
@@ -248,6 +315,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   }
   vector< int > best_tm;
   typedef map< int, vector< Match > >::iterator I;
+  EditDistance distance( input[sentenceInd] );
 
   clock_t clock_validation_sum = 0;
 
@@ -289,8 +357,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     clock_t clock_validation_start = clock();
     if (! parse_flag ||
         pruned.size()>=10) { // to prevent worst cases
-      string path;
-      cost = sed( input[sentenceInd], source[tmID], path, false );
+      cost = distance.Compute( source[tmID], best_cost );
       if (cost <  best_cost) {
         best_cost = cost;
       }
@@ -329,7 +396,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
       sed( input[sentenceInd], source[s], path, true );
       const vector<WORD_ID> &sourceSentence = source[s];
       vector<SentenceAlignment> &targets = targetAndAlignment[s];
-      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, fuzzyMatchStream);
+      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, matches);
 
     }
   } // if (multiple_flag)
@@ -384,13 +451,9 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     // creat xml & extracts
     const vector<WORD_ID> &sourceSentence = source[best_match];
     vector<SentenceAlignment> &targets = targetAndAlignment[best_match];
-    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, fuzzyMatchStream);
+    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, matches);
 
   } // else if (multiple_flag)
-
-  fuzzyMatchStream.close();
-
-  return fuzzyMatchFile;
 }
 
 void FuzzyMatchWrapper::load_corpus( const std::string &fileName, vector< vector< WORD_ID > > &corpus )
@@ -700,9 +763,12 @@ unsigned int FuzzyMatchWrapper::compute_length( const vector< WORD_ID > &sentenc
 
 /* brute force method: compare input to all corpus sentences */
 
-void FuzzyMatchWrapper::basic_fuzzy_match( vector< vector< WORD_ID > > source,
-    vector< vector< WORD_ID > > input )
+void FuzzyMatchWrapper::basic_fuzzy_match( const vector< vector< WORD_ID > > &input,
+    vector< FuzzyMatchResult > &results )
 {
+  const vector< vector< WORD_ID > > &source = suffixArray->GetCorpus();
+  results.resize( input.size() );
+
   // go through input set...
   for(unsigned int i=0; i<input.size(); i++) {
     bool use_letter_sed = false;
@@ -743,6 +809,136 @@ void FuzzyMatchWrapper::basic_fuzzy_match( vector< vector< WORD_ID > > source,
       }
     }
     //cout << best_cost << " ||| " << best_match << " ||| " << best_path << endl;
+    results[i].sentence = best_match;
+    results[i].cost = (best_match == -1) ? 0 : best_cost;
+  }
+}
+
+/* n-gram filtered method: only compare input to corpus sentences
+ that share enough n-grams with it to be close enough.
+ a sentence within k edits of an input of length m shares at least
+ m-n+1-k*n of the input's n-grams (q-gram lemma), so no match is lost. */
+
+void FuzzyMatchWrapper::ngram_fuzzy_match( const vector< WORD_ID > &input, FuzzyMatchResult &result )
+{
+  const vector< vector< WORD_ID > > &source = suffixArray->GetCorpus();
+
+  // same worst allowed cost as basic_fuzzy_match()
+  int input_length = input.size();
+  unsigned int best_cost = input_length * (100-min_match) / 100 + 2;
+  int best_match = -1;
+
+  // bigrams filter best, unigrams are needed for short sentences
+  int n = 2;
+  int min_shared = input_length - n + 1 - (int)(best_cost-1) * n;
+  if (min_shared <= 0) {
+    n = 1;
+    min_shared = input_length - (int)(best_cost-1);
+  }
+
+  // candidate sentences and their number of shared n-grams
+  vector< pair< int, size_t > > candidates;
+  if (min_shared <= 0) {
+    // too short to filter
+    for(size_t s=0; s<source.size(); s++) {
+      candidates.push_back( make_pair( 0, s ) );
+    }
+  } else {
+    // count each input n-gram once per sentence it occurs in
+    boost::unordered_map< size_t, pair< int, int > > shared;
+    for(int start=0; start+n<=input_length; start++) {
+      vector< WORD_ID > ngram( input.begin()+start, input.begin()+start+n );
+      SuffixArray::INDEX first_match, last_match;
+      if (! suffixArray->FindMatches( ngram, first_match, last_match, 0, suffixArray->GetSize()-1 ) ) {
+        continue;
+      }
+      for(SuffixArray::INDEX i=first_match; i<=last_match; i++) {
+        size_t sentence_id = suffixArray->GetSentence( suffixArray->GetPosition( i ) );
+        pair< int, int > &count = shared[ sentence_id ];
+        if (count.second != start+1) {
+          count.first++;
+          count.second = start+1;
+        }
+      }
+    }
+
+    boost::unordered_map< size_t, pair< int, int > >::const_iterator iter;
+    for(iter = shared.begin(); iter != shared.end(); ++iter) {
+      if (iter->second.first >= min_shared) {
+        candidates.push_back( make_pair( -iter->second.first, iter->first ) );
+      }
+    }
+
+    // most shared n-grams first, so that the allowed cost drops early
+    sort( candidates.begin(), candidates.end() );
+  }
+
+  EditDistance distance( input );
+  for(size_t c=0; c<candidates.size(); c++) {
+    size_t s = candidates[c].second;
+
+    // ties are allowed once a match is found, to report the first sentence as basic_fuzzy_match() does
+    unsigned int max_cost = (best_match == -1) ? best_cost-1 : best_cost;
+    if (min_shared > 0 && -candidates[c].first < input_length - n + 1 - (int)max_cost * n) {
+      break;
+    }
+
+    int diff = abs((int)source[s].size() - input_length);
+    if (length_filter_flag && (diff > (int)max_cost)) {
+      continue;
+    }
+
+    unsigned int cost = distance.Compute( source[s], max_cost );
+    if (cost < best_cost || (cost == best_cost && (int)s < best_match)) {
+      best_cost = cost;
+      best_match = s;
+    }
+  }
+
+  result.sentence = best_match;
+  result.cost = (best_match == -1) ? 0 : best_cost;
+}
+
+namespace
+{
+class FuzzyMatchTask : public Moses::Task
+{
+public:
+  FuzzyMatchTask(FuzzyMatchWrapper &wrapper, const vector< WORD_ID > &input, FuzzyMatchResult &result)
+    :m_wrapper(wrapper)
+    ,m_input(input)
+    ,m_result(result) {
+  }
+
+  void Run() {
+    m_wrapper.ngram_fuzzy_match( m_input, m_result );
+  }
+
+private:
+  FuzzyMatchWrapper &m_wrapper;
+  const vector< WORD_ID > &m_input;
+  FuzzyMatchResult &m_result;
+};
+}
+
+void FuzzyMatchWrapper::batch_fuzzy_match( const vector< vector< WORD_ID > > &input,
+    vector< FuzzyMatchResult > &results, size_t numThreads )
+{
+  results.resize( input.size() );
+
+#ifdef WITH_THREADS
+  if (numThreads > 1) {
+    Moses::ThreadPool pool( numThreads );
+    for(size_t i=0; i<input.size(); i++) {
+      pool.Submit( new FuzzyMatchTask( *this, input[i], results[i] ) );
+    }
+    pool.Stop( true );
+    return;
+  }
+#endif
+
+  for(size_t i=0; i<input.size(); i++) {
+    ngram_fuzzy_match( input[i], results[i] );
   }
 }
 
@@ -1000,7 +1196,7 @@ int FuzzyMatchWrapper::parse_matches( vector< Match > &match, int input_length,
 }
 
 
-void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, ofstream &outputFile)
+void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, vector<FuzzyMatch> &matches)
 {
   string sourceStr;
   for (size_t pos = 0; pos < sourceSentence.size(); ++pos) {
@@ -1013,15 +1209,15 @@ void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector<
     string targetStr = sentenceAlignment.getTargetString(GetVocabulary());
     string alignStr = sentenceAlignment.getAlignmentString();
 
-    outputFile
-        << sentenceInd << endl
-        << cost << endl
-        << sourceStr << endl
-        << inputStr << endl
-        << targetStr << endl
-        << alignStr << endl
-        << path << endl
-        << sentenceAlignment.count << endl;
+    FuzzyMatch match;
+    match.cost = cost;
+    match.source = sourceStr;
+    match.input = inputStr;
+    match.target = targetStr;
+    match.alignment = alignStr;
+    match.path = path;
+    match.count = sentenceAlignment.count;
+    matches.push_back(match);
 
   }
 }
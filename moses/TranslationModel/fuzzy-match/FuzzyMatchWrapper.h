@@ -18,6 +18,7 @@
 #include "SuffixArray.h"
 #include "Vocabulary.h"
 #include "Match.h"
+#include "create_xml.h"
 #include "moses/InputType.h"
 
 namespace tmmt
@@ -25,12 +26,50 @@ namespace tmmt
 class Match;
 struct SentenceAlignment;
 
+//! a rule of the phrase table built for one input sentence
+struct FuzzyMatchRule {
+  std::string source, target, alignment; //!< in the text rule table format
+  std::vector<float> scores; //!< p(s|t) and p(t|s)
+};
+
+//! the best match of an input sentence in the translation memory
+struct FuzzyMatchResult {
+  FuzzyMatchResult() : sentence(-1), cost(0) {}
+  int sentence; //!< -1 if no sentence is close enough
+  unsigned int cost; //!< word edit distance
+};
+
 class FuzzyMatchWrapper
 {
 public:
   FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment);
 
-  std::string Extract(long translationId, const std::string &dirNameStr);
+  /** Builds the rule table of an input sentence from its fuzzy matches in
+   *  the translation memory. The rules are scored as train-model.perl
+   *  -hierarchical with -score-options --NoLex would, but in memory.
+   */
+  void Extract(long translationId, const std::string &input, std::vector<FuzzyMatchRule> &rules);
+
+  /** Scores extracted rules as score and consolidate with --NoLex do:
+   *  p(s|t), p(t|s) and the most frequent word alignment of each rule.
+   *  The rules are appended to \p rules, sorted by source and target.
+   */
+  static void ScoreRules(const std::vector<ExtractedRule> &extracted, std::vector<FuzzyMatchRule> &rules);
+
+  void load_corpus( const std::string &fileName, std::vector< std::vector< tmmt::WORD_ID > > &corpus );
+
+  /** brute force method: compare input to all corpus sentences */
+  void basic_fuzzy_match( const std::vector< std::vector< tmmt::WORD_ID > > &input,
+                          std::vector< FuzzyMatchResult > &results );
+
+  /** finds the same matches as basic_fuzzy_match(), but only compares
+   *  input to the corpus sentences that share enough n-grams with it,
+   *  with a bit-parallel edit distance, on several threads */
+  void batch_fuzzy_match( const std::vector< std::vector< tmmt::WORD_ID > > &input,
+                          std::vector< FuzzyMatchResult > &results, size_t numThreads );
+
+  /** match of one input sentence, as done by batch_fuzzy_match() */
+  void ngram_fuzzy_match( const std::vector< tmmt::WORD_ID > &input, FuzzyMatchResult &result );
 
 protected:
   // tm-mt
@@ -55,14 +94,9 @@ protected:
   mutable boost::shared_mutex m_accessLock;
 #endif
 
-  void load_corpus( const std::string &fileName, std::vector< std::vector< tmmt::WORD_ID > > &corpus );
   void load_target( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus);
   void load_alignment( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus );
 
-  /** brute force method: compare input to all corpus sentences */
-  void basic_fuzzy_match( std::vector< std::vector< tmmt::WORD_ID > > source,
-                          std::vector< std::vector< tmmt::WORD_ID > > input ) ;
-
   /** utlility function: compute length of sentence in characters
    (spaces do not count) */
   unsigned int compute_length( const std::vector< tmmt::WORD_ID > &sentence );
@@ -74,9 +108,9 @@ protected:
   std::vector< Match > prune_matches( const std::vector< Match > &match, int best_cost );
   int parse_matches( std::vector< Match > &match, int input_length, int tm_length, int &best_cost );
 
-  void create_extract(int sentenceInd, int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::ofstream &outputFile);
+  void create_extract(int sentenceInd, int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::vector<FuzzyMatch> &matches);
 
-  std::string ExtractTM(WordIndex &wordIndex, long translationId, const std::string &inputPath);
+  void ExtractTM(WordIndex &wordIndex, long translationId, const std::string &input, std::vector<FuzzyMatch> &matches);
   Vocabulary &GetVocabulary() {
     return suffixArray->GetVocabulary();
   }
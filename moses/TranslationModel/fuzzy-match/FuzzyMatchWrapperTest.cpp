@@ -0,0 +1,119 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "FuzzyMatchWrapper.h"
+#include "create_xml.h"
+
+using namespace tmmt;
+using namespace std;
+
+namespace
+{
+
+struct Rule {
+  const char *source, *target, *alignment;
+  int count;
+};
+
+// an extract as create_xml() makes it, with a tie of two word alignments
+// of a rule, a target with two sources, a source with two targets and a
+// rule whose non-terminals are aligned in two ways
+const Rule kExtract[] = {
+  { "a [X][X] b [X]", "x [X][X] y [X]", "0-0 1-1 2-2", 2 },
+  { "a [X][X] b [X]", "x [X][X] y [X]", "0-0 1-1 2-0", 2 },
+  { "a [X][X] b [X]", "x [X][X] z [X]", "0-0 1-1 2-2", 1 },
+  { "c [X][X] b [X]", "x [X][X] y [X]", "0-0 1-1 2-2", 3 },
+  { "[X][X] d [X][X] [X]", "[X][X] e [X][X] [X]", "0-2 1-1 2-0", 1 },
+  { "[X][X] d [X][X] [X]", "[X][X] e [X][X] [X]", "0-0 1-1 2-2", 1 },
+  { "a [X]", "x [X]", "0-0", 1 },
+  { "a b [X]", "x [X]", "0-0 1-0", 4 }
+};
+
+struct ScoredRule {
+  const char *source, *target;
+  float pSourceGivenTarget, pTargetGivenSource;
+  const char *alignment;
+};
+
+// output of score --Hierarchical --NoLex on the sorted extract and its
+// inverse, and of consolidate --Hierarchical on the two halves
+const ScoredRule kRuleTable[] = {
+  { "[X][X] d [X][X] [X]", "[X][X] e [X][X] [X]", 0.5, 0.5, "0-0 1-1 2-2" },
+  { "[X][X] d [X][X] [X]", "[X][X] e [X][X] [X]", 0.5, 0.5, "0-2 1-1 2-0" },
+  { "a [X]", "x [X]", 0.2, 1, "0-0" },
+  { "a [X][X] b [X]", "x [X][X] y [X]", 0.571429, 0.8, "0-0 1-1 2-0" },
+  { "a [X][X] b [X]", "x [X][X] z [X]", 1, 0.2, "0-0 1-1 2-2" },
+  { "a b [X]", "x [X]", 0.8, 1, "0-0 1-0" },
+  { "c [X][X] b [X]", "x [X][X] y [X]", 0.428571, 1, "0-0 1-1 2-2" }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(fuzzy_match_wrapper)
+
+BOOST_AUTO_TEST_CASE(score_rules_as_score_and_consolidate)
+{
+  vector<ExtractedRule> extracted;
+  for (size_t i = 0; i < sizeof(kExtract) / sizeof(kExtract[0]); ++i) {
+    ExtractedRule rule;
+    rule.source = kExtract[i].source;
+    rule.target = kExtract[i].target;
+    rule.alignment = kExtract[i].alignment;
+    rule.count = kExtract[i].count;
+    extracted.push_back(rule);
+  }
+
+  vector<FuzzyMatchRule> rules;
+  FuzzyMatchWrapper::ScoreRules(extracted, rules);
+
+  const size_t expected = sizeof(kRuleTable) / sizeof(kRuleTable[0]);
+  BOOST_REQUIRE_EQUAL(rules.size(), expected);
+  for (size_t i = 0; i < expected; ++i) {
+    BOOST_CHECK_EQUAL(rules[i].source, kRuleTable[i].source);
+    BOOST_CHECK_EQUAL(rules[i].target, kRuleTable[i].target);
+    BOOST_CHECK_EQUAL(boost::algorithm::trim_copy(rules[i].alignment), kRuleTable[i].alignment);
+    BOOST_REQUIRE_EQUAL(rules[i].scores.size(), 2);
+    BOOST_CHECK_CLOSE(rules[i].scores[0], kRuleTable[i].pSourceGivenTarget, 0.001);
+    BOOST_CHECK_CLOSE(rules[i].scores[1], kRuleTable[i].pTargetGivenSource, 0.001);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(score_rules_appends)
+{
+  vector<ExtractedRule> extracted(1);
+  extracted[0].source = "a [X]";
+  extracted[0].target = "x [X]";
+  extracted[0].alignment = "0-0";
+  extracted[0].count = 3;
+
+  vector<FuzzyMatchRule> rules(1);
+  FuzzyMatchWrapper::ScoreRules(extracted, rules);
+  BOOST_REQUIRE_EQUAL(rules.size(), 2);
+  BOOST_CHECK_EQUAL(rules[1].source, "a [X]");
+  BOOST_CHECK_CLOSE(rules[1].scores[0], 1, 0.001);
+  BOOST_CHECK_CLOSE(rules[1].scores[1], 1, 0.001);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -153,7 +153,22 @@ int SuffixArray::FindMatches( const vector< WORD > &phrase, INDEX &firstMatch, I
   return LimitedCount( phrase, m_size, firstMatch, lastMatch, search_start, search_end );
 }
 
+int SuffixArray::FindMatches( const vector< WORD_ID > &phrase, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start, INDEX search_end )
+{
+  return LimitedCount( phrase, m_size, firstMatch, lastMatch, search_start, search_end );
+}
+
 int SuffixArray::LimitedCount( const vector< WORD > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start, INDEX search_end )
+{
+  // look up the words once, not at every comparison
+  vector< WORD_ID > phraseIds;
+  for(size_t i=0; i<phrase.size(); i++) {
+    phraseIds.push_back( m_vcb.GetWordID( phrase[i] ) );
+  }
+  return LimitedCount( phraseIds, min, firstMatch, lastMatch, search_start, search_end );
+}
+
+int SuffixArray::LimitedCount( const vector< WORD_ID > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start, INDEX search_end )
 {
   // cerr << "FindFirst\n";
   INDEX start = search_start;
@@ -176,7 +191,7 @@ int SuffixArray::LimitedCount( const vector< WORD > &phrase, INDEX min, INDEX &f
   return matchCount;
 }
 
-SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX start, INDEX end, int direction )
+SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD_ID > &phrase, INDEX start, INDEX end, int direction )
 {
   end += direction;
   while(true) {
@@ -195,7 +210,7 @@ SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX st
   }
 }
 
-SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &start, INDEX &end )
+SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD_ID > &phrase, INDEX &start, INDEX &end )
 {
   while(true) {
     INDEX mid = ( start + end + 1 )/2;
@@ -212,11 +227,11 @@ SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &
   }
 }
 
-int SuffixArray::Match( const vector< WORD > &phrase, INDEX index )
+int SuffixArray::Match( const vector< WORD_ID > &phrase, INDEX index )
 {
   INDEX pos = m_index[ index ];
   for(INDEX i=0; i<phrase.size() && i+pos<m_size; i++) {
-    int match = CompareWord( m_vcb.GetWordID( phrase[i] ), m_array[ pos+i ] );
+    int match = CompareWord( phrase[i], m_array[ pos+i ] );
     // cerr << "{" << index << "+" << i << "," << pos+i << ":" << match << "}" << endl;
     if (match != 0)
       return match;
@@ -36,10 +36,12 @@ public:
   bool MinCount( const std::vector< WORD > &phrase, INDEX min );
   bool Exists( const std::vector< WORD > &phrase );
   int FindMatches( const std::vector< WORD > &phrase, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = 0, INDEX search_end = -1 );
+  int FindMatches( const std::vector< WORD_ID > &phrase, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = 0, INDEX search_end = -1 );
   int LimitedCount( const std::vector< WORD > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = -1, INDEX search_end = 0 );
-  INDEX FindFirst( const std::vector< WORD > &phrase, INDEX &start, INDEX &end );
-  INDEX FindLast( const std::vector< WORD > &phrase, INDEX start, INDEX end, int direction );
-  int Match( const std::vector< WORD > &phrase, INDEX index );
+  int LimitedCount( const std::vector< WORD_ID > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = -1, INDEX search_end = 0 );
+  INDEX FindFirst( const std::vector< WORD_ID > &phrase, INDEX &start, INDEX &end );
+  INDEX FindLast( const std::vector< WORD_ID > &phrase, INDEX start, INDEX end, int direction );
+  int Match( const std::vector< WORD_ID > &phrase, INDEX index );
   void List( INDEX start, INDEX end );
   inline INDEX GetPosition( INDEX index ) {
     return m_index[ index ];
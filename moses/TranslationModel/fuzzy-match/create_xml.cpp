@@ -6,6 +6,7 @@
 #include <string>
 #include "moses/Util.h"
 #include "Alignments.h"
+#include "create_xml.h"
 
 using namespace std;
 using namespace Moses;
@@ -20,87 +21,32 @@ inline const std::string TrimInternal(const std::string& str, const std::string
 class CreateXMLRetValues
 {
 public:
-  string frame, ruleS, ruleT, ruleAlignment, ruleAlignmentInv;
+  string frame, ruleS, ruleT, ruleAlignment;
 };
 
 CreateXMLRetValues createXML(int ruleCount, const string &source, const string &input, const string &target, const string &align, const string &path );
 
-void create_xml(const string &inPath)
+namespace tmmt
 {
-  ifstream inStrme(inPath.c_str());
-  ofstream rule((inPath + ".extract").c_str());
-  ofstream ruleInv((inPath + ".extract.inv").c_str());
 
-  // int setenceId;
-  // float score;
-  string source, target, align, path;
-  string *input = NULL;
-  int count;
-
-  int lineCount = 1;
+void create_xml(const vector<FuzzyMatch> &matches, vector<ExtractedRule> &rules)
+{
   int ruleCount = 1;
-  string inLine;
-
-  int step = 0;
-  while (!inStrme.eof()) {
-    getline(inStrme, inLine);
-    //cout << inLine << endl;
-    switch (step) {
-    case 0:
-      /*setenceId = */ Scan<int>(inLine);
-      ++step;
-      break;
-    case 1:
-      /*score = */ Scan<float>(inLine);
-      ++step;
-      break;
-    case 2:
-      source = inLine;
-      ++step;
-      break;
-    case 3:
-      if (input == NULL) {
-        input = new string(inLine);
-      } else {
-        assert(inLine == *input);
-      }
-      ++step;
-      break;
-    case 4:
-      target = inLine;
-      ++step;
-      break;
-    case 5:
-      align = inLine;
-      ++step;
-      break;
-    case 6:
-      path = inLine + "X";
-      ++step;
-      break;
-    case 7:
-      count = Scan<int>(inLine);
-      CreateXMLRetValues ret = createXML(ruleCount, source, *input, target, align, path);
-
-      //print STDOUT $frame."\n";
-      rule << ret.ruleS << " [X] ||| " << ret.ruleT << " [X] ||| " << ret.ruleAlignment
-           << " ||| " << count << endl;
-      ruleInv << ret.ruleT << " [X] ||| " << ret.ruleS << " [X] ||| " << ret.ruleAlignmentInv
-              << " ||| " << count << endl;
-
-      //print STDOUT "$sentenceInd ||| $score ||| $count\n";
-      ++ruleCount;
-      step = 0;
-      break;
-    }
-
-    ++lineCount;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    const FuzzyMatch &match = matches[i];
+    assert(match.input == matches[0].input);
+    CreateXMLRetValues ret = createXML(ruleCount, match.source, match.input, match.target, match.alignment, match.path + "X");
+
+    ExtractedRule rule;
+    rule.source = ret.ruleS + " [X]";
+    rule.target = ret.ruleT + " [X]";
+    rule.alignment = ret.ruleAlignment;
+    rule.count = match.count;
+    rules.push_back(rule);
+
+    ++ruleCount;
   }
-
-  delete input;
-  ruleInv.close();
-  rule.close();
-  inStrme.close();
+}
 
 }
 
@@ -328,15 +274,6 @@ CreateXMLRetValues createXML(int ruleCount, const string &source, const string &
   ret.ruleT = TrimInternal(ret.ruleT);
   ret.ruleAlignment = TrimInternal(ret.ruleAlignment);
 
-  vector<string> ruleAlignmentToks = Tokenize(ret.ruleAlignment);
-  for (size_t i = 0; i < ruleAlignmentToks.size(); ++i) {
-    const string &alignPoint = ruleAlignmentToks[i];
-    vector<string> toks = Tokenize(alignPoint, "-");
-    assert(toks.size() == 2);
-    ret.ruleAlignmentInv += toks[1] + "-" +toks[0];
-  }
-  ret.ruleAlignmentInv = TrimInternal(ret.ruleAlignmentInv);
-
   // frame
   // ret.frame;
   if (frameInput.find(-1) == frameInput.end())
@@ -376,7 +313,6 @@ CreateXMLRetValues createXML(int ruleCount, const string &source, const string &
 
   } //for (int t = 0
 
-  cerr << ret.frame << "\n-------------------------------------\n";
   return ret;
 
 }
@@ -1,5 +1,26 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
-void create_xml(const std::string &inPath);
+namespace tmmt
+{
+
+//! a translation of a sentence of the translation memory that matches the input
+struct FuzzyMatch {
+  int cost;
+  std::string source, input, target, alignment;
+  std::string path; //!< edit operations from the input to the source
+  int count;
+};
+
+//! a hierarchical rule as written to an extract file, with left hand sides
+struct ExtractedRule {
+  std::string source, target, alignment;
+  int count;
+};
+
+//! extract one rule from each match
+void create_xml(const std::vector<FuzzyMatch> &matches, std::vector<ExtractedRule> &rules);
+
+}
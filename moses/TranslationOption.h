@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Phrase.h"
 #include "TargetPhrase.h"
 #include "Hypothesis.h"
+#include "HypothesisArena.h"
 #include "Util.h"
 #include "TypeDef.h"
 #include "ScoreComponentCollection.h"
@@ -58,8 +59,9 @@ class LexicalReordering;
  *
  * m_targetPhrase points to a phrase-table entry.
  * The source word range is zero-indexed, so it can't refer to an empty range. The target phrase may be empty.
+ * Options created while decoding come out of the HypothesisArena of the sentence.
  */
-class TranslationOption
+class TranslationOption : public ArenaObject
 {
   friend std::ostream& operator<<(std::ostream& out, const TranslationOption& possibleTranslation);
 
@@ -30,6 +30,11 @@ TranslationTask::~TranslationTask() {
   delete m_source;
 }
 
+size_t TranslationTask::GetPriority() const
+{
+  return StaticData::Instance().GetThreadPriority(m_source->GetSize());
+}
+
 void TranslationTask::Run()
 {
 	switch (m_pbOrChart)
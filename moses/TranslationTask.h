@@ -34,6 +34,9 @@ public:
    * gets called by main function implemented at end of this source file */
   void Run();
 
+  /** shorter sentences go into more urgent classes, see -thread-priority-length */
+  size_t GetPriority() const;
+
 
 private:
   int m_pbOrChart; // 1=pb. 2=chart
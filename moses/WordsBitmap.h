@@ -28,6 +28,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <cstring>
 #include <cmath>
 #include <cstdlib>
+#include <stdint.h>
+#include <boost/functional/hash.hpp>
 #include "TypeDef.h"
 #include "WordsRange.h"
 
@@ -35,73 +37,140 @@ namespace Moses
 {
 typedef unsigned long WordsBitmapID;
 
-/** vector of boolean used to represent whether a word has been translated or not
+/** vector of boolean used to represent whether a word has been translated or not.
+ *  Packed into 64 bit chunks, held inline for sentences of up to 256 words
+ *  and on the heap beyond. Bits past the end of the sentence are always 0.
 */
 class WordsBitmap
 {
   friend std::ostream& operator<<(std::ostream& out, const WordsBitmap& wordsBitmap);
+public:
+  typedef uint64_t Chunk;
+  static const size_t kChunkBits = 64;
+  static const size_t kInlineChunks = 4;
+
 protected:
   const size_t m_size; /**< number of words in sentence */
-  bool	*m_bitmap;	/**< ticks of words that have been done */
+  const size_t m_numChunks;
+  Chunk *m_bitmap;	/**< ticks of words that have been done */
+  Chunk m_inline[kInlineChunks];
 
   WordsBitmap(); // not implemented
+  WordsBitmap &operator=(const WordsBitmap &); // not implemented
+
+  static size_t NumChunks(size_t size) {
+    return (size + kChunkBits - 1) / kChunkBits;
+  }
+
+  static size_t PopCount(Chunk c) {
+#ifdef __GNUC__
+    return __builtin_popcountll(c);
+#else
+    size_t count = 0;
+    for (; c; c &= c - 1) ++count;
+    return count;
+#endif
+  }
+  //! index of lowest set bit, c must not be 0
+  static size_t LowestBit(Chunk c) {
+#ifdef __GNUC__
+    return __builtin_ctzll(c);
+#else
+    size_t pos = 0;
+    while (!(c & 1)) {
+      c >>= 1;
+      ++pos;
+    }
+    return pos;
+#endif
+  }
+  //! index of highest set bit, c must not be 0
+  static size_t HighestBit(Chunk c) {
+#ifdef __GNUC__
+    return kChunkBits - 1 - __builtin_clzll(c);
+#else
+    size_t pos = 0;
+    while (c >>= 1) ++pos;
+    return pos;
+#endif
+  }
+  //! bits of chunk i that are inside the sentence
+  Chunk ValidMask(size_t i) const {
+    size_t rest = m_size - i * kChunkBits;
+    return rest >= kChunkBits ? ~Chunk(0) : (Chunk(1) << rest) - 1;
+  }
+  //! bits at positions lo .. hi (inclusive) of chunk i, clipped to the chunk
+  static Chunk RangeMask(size_t i, size_t lo, size_t hi) {
+    size_t base = i * kChunkBits;
+    size_t from = lo > base ? lo - base : 0;
+    size_t to = hi - base < kChunkBits ? hi - base : kChunkBits - 1;
+    Chunk upTo = (to == kChunkBits - 1) ? ~Chunk(0) : (Chunk(1) << (to + 1)) - 1;
+    return upTo & ~((Chunk(1) << from) - 1);
+  }
+
+  void Allocate() {
+    m_bitmap = (m_numChunks <= kInlineChunks)
+               ? m_inline
+               : (Chunk*) malloc(sizeof(Chunk) * m_numChunks);
+  }
 
   //! set all elements to false
   void Initialize() {
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      m_bitmap[pos] = false;
-    }
+    std::memset(m_bitmap, 0, sizeof(Chunk) * m_numChunks);
   }
 
   //sets elements by vector
-  void Initialize(std::vector<bool> vector) {
+  void Initialize(const std::vector<bool> &vector) {
+    Initialize();
     size_t vector_size = vector.size();
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (pos < vector_size && vector[pos] == true) m_bitmap[pos] = true;
-      else m_bitmap[pos] = false;
+    for (size_t pos = 0 ; pos < m_size && pos < vector_size ; pos++) {
+      if (vector[pos]) SetValue(pos, true);
     }
   }
 
 
 public:
   //! create WordsBitmap of length size and initialise with vector
-  WordsBitmap(size_t size, std::vector<bool> initialize_vector)
-    :m_size	(size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * size);
+  WordsBitmap(size_t size, const std::vector<bool> &initialize_vector)
+    :m_size	(size)
+    ,m_numChunks(NumChunks(size)) {
+    Allocate();
     Initialize(initialize_vector);
   }
   //! create WordsBitmap of length size and initialise
   WordsBitmap(size_t size)
-    :m_size	(size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * size);
+    :m_size	(size)
+    ,m_numChunks(NumChunks(size)) {
+    Allocate();
     Initialize();
   }
   //! deep copy
   WordsBitmap(const WordsBitmap &copy)
-    :m_size	(copy.m_size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * m_size);
-    for (size_t pos = 0 ; pos < copy.m_size ; pos++) {
-      m_bitmap[pos] = copy.GetValue(pos);
-    }
+    :m_size	(copy.m_size)
+    ,m_numChunks(copy.m_numChunks) {
+    Allocate();
+    std::memcpy(m_bitmap, copy.m_bitmap, sizeof(Chunk) * m_numChunks);
   }
   ~WordsBitmap() {
-    free(m_bitmap);
+    if (m_bitmap != m_inline) {
+      free(m_bitmap);
+    }
   }
   //! count of words translated
   size_t GetNumWordsCovered() const {
     size_t count = 0;
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (m_bitmap[pos])
-        count++;
+    for (size_t i = 0 ; i < m_numChunks ; i++) {
+      count += PopCount(m_bitmap[i]);
     }
     return count;
   }
 
   //! position of 1st word not yet translated, or NOT_FOUND if everything already translated
   size_t GetFirstGapPos() const {
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (!m_bitmap[pos]) {
-        return pos;
+    for (size_t i = 0 ; i < m_numChunks ; i++) {
+      Chunk gaps = ~m_bitmap[i] & ValidMask(i);
+      if (gaps) {
+        return i * kChunkBits + LowestBit(gaps);
       }
     }
     // no starting pos
@@ -111,9 +180,10 @@ public:
 
   //! position of last word not yet translated, or NOT_FOUND if everything already translated
   size_t GetLastGapPos() const {
-    for (int pos = (int) m_size - 1 ; pos >= 0 ; pos--) {
-      if (!m_bitmap[pos]) {
-        return pos;
+    for (size_t i = m_numChunks ; i-- > 0 ; ) {
+      Chunk gaps = ~m_bitmap[i] & ValidMask(i);
+      if (gaps) {
+        return i * kChunkBits + HighestBit(gaps);
       }
     }
     // no starting pos
@@ -123,9 +193,9 @@ public:
 
   //! position of last translated word
   size_t GetLastPos() const {
-    for (int pos = (int) m_size - 1 ; pos >= 0 ; pos--) {
-      if (m_bitmap[pos]) {
-        return pos;
+    for (size_t i = m_numChunks ; i-- > 0 ; ) {
+      if (m_bitmap[i]) {
+        return i * kChunkBits + HighestBit(m_bitmap[i]);
       }
     }
     // no starting pos
@@ -136,26 +206,37 @@ public:
 
   //! whether a word has been translated at a particular position
   bool GetValue(size_t pos) const {
-    return m_bitmap[pos];
+    return (m_bitmap[pos / kChunkBits] >> (pos % kChunkBits)) & 1;
   }
   //! set value at a particular position
   void SetValue( size_t pos, bool value ) {
-    m_bitmap[pos] = value;
+    Chunk bit = Chunk(1) << (pos % kChunkBits);
+    if (value) {
+      m_bitmap[pos / kChunkBits] |= bit;
+    } else {
+      m_bitmap[pos / kChunkBits] &= ~bit;
+    }
   }
   //! set value between 2 positions, inclusive
   void SetValue( size_t startPos, size_t endPos, bool value ) {
-    for(size_t pos = startPos ; pos <= endPos ; pos++) {
-      m_bitmap[pos] = value;
+    for (size_t i = startPos / kChunkBits ; i <= endPos / kChunkBits ; i++) {
+      Chunk mask = RangeMask(i, startPos, endPos);
+      if (value) {
+        m_bitmap[i] |= mask;
+      } else {
+        m_bitmap[i] &= ~mask;
+      }
     }
   }
   //! whether every word has been translated
   bool IsComplete() const {
-    return GetSize() == GetNumWordsCovered();
+    return GetFirstGapPos() == NOT_FOUND;
   }
   //! whether the wordrange overlaps with any translated word in this bitmap
   bool Overlap(const WordsRange &compare) const {
-    for (size_t pos = compare.GetStartPos() ; pos <= compare.GetEndPos() ; pos++) {
-      if (m_bitmap[pos])
+    size_t startPos = compare.GetStartPos(), endPos = compare.GetEndPos();
+    for (size_t i = startPos / kChunkBits ; i <= endPos / kChunkBits ; i++) {
+      if (m_bitmap[i] & RangeMask(i, startPos, endPos))
         return true;
     }
     return false;
@@ -177,27 +258,56 @@ public:
     if (thisSize != compareSize) {
       return (thisSize < compareSize) ? -1 : 1;
     }
-    return std::memcmp(m_bitmap, compare.m_bitmap, thisSize * sizeof(bool));
+    // same order as comparing position by position from the left
+    for (size_t i = 0 ; i < m_numChunks ; i++) {
+      Chunk diff = m_bitmap[i] ^ compare.m_bitmap[i];
+      if (diff) {
+        return ((m_bitmap[i] >> LowestBit(diff)) & 1) ? 1 : -1;
+      }
+    }
+    return 0;
   }
 
   bool operator< (const WordsBitmap &compare) const {
     return Compare(compare) < 0;
   }
 
+  bool operator== (const WordsBitmap &compare) const {
+    return m_size == compare.m_size
+           && std::memcmp(m_bitmap, compare.m_bitmap, sizeof(Chunk) * m_numChunks) == 0;
+  }
+
+  //! hash of the coverage, consistent with operator==
+  size_t hash() const {
+    size_t seed = m_size;
+    for (size_t i = 0 ; i < m_numChunks ; i++) {
+      boost::hash_combine(seed, m_bitmap[i]);
+    }
+    return seed;
+  }
+
+  //! first position after the last translated word left of l, or 0
   inline size_t GetEdgeToTheLeftOf(size_t l) const {
     if (l == 0) return l;
-    while (l && !m_bitmap[l-1]) {
-      --l;
+    for (size_t i = (l - 1) / kChunkBits + 1 ; i-- > 0 ; ) {
+      Chunk covered = m_bitmap[i] & RangeMask(i, 0, l - 1);
+      if (covered) {
+        return i * kChunkBits + HighestBit(covered) + 1;
+      }
     }
-    return l;
+    return 0;
   }
 
+  //! last position before the next translated word right of r, or the last position
   inline size_t GetEdgeToTheRightOf(size_t r) const {
     if (r+1 == m_size) return r;
-    while (r+1 < m_size && !m_bitmap[r+1]) {
-      ++r;
+    for (size_t i = (r + 1) / kChunkBits ; i < m_numChunks ; i++) {
+      Chunk covered = m_bitmap[i] & RangeMask(i, r + 1, m_size - 1);
+      if (covered) {
+        return i * kChunkBits + LowestBit(covered) - 1;
+      }
     }
-    return r;
+    return m_size - 1;
   }
 
 
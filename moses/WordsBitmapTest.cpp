@@ -0,0 +1,165 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "WordsBitmap.h"
+
+using namespace Moses;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(words_bitmap)
+
+namespace
+{
+
+// straightforward versions of the queries, on an unpacked vector
+size_t FirstGap(const vector<bool> &v)
+{
+  for (size_t i = 0; i < v.size(); ++i) if (!v[i]) return i;
+  return NOT_FOUND;
+}
+
+size_t LastGap(const vector<bool> &v)
+{
+  for (size_t i = v.size(); i-- > 0; ) if (!v[i]) return i;
+  return NOT_FOUND;
+}
+
+size_t LastPos(const vector<bool> &v)
+{
+  for (size_t i = v.size(); i-- > 0; ) if (v[i]) return i;
+  return NOT_FOUND;
+}
+
+size_t EdgeLeft(const vector<bool> &v, size_t l)
+{
+  while (l && !v[l-1]) --l;
+  return l;
+}
+
+size_t EdgeRight(const vector<bool> &v, size_t r)
+{
+  while (r+1 < v.size() && !v[r+1]) ++r;
+  return r;
+}
+
+int CompareRef(const vector<bool> &a, const vector<bool> &b)
+{
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i] != b[i]) return a[i] ? 1 : -1;
+  }
+  return 0;
+}
+
+vector<bool> RandomCoverage(size_t size, int density)
+{
+  vector<bool> v(size);
+  for (size_t i = 0; i < size; ++i) v[i] = (rand() % 100) < density;
+  return v;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(set_and_query)
+{
+  WordsBitmap bitmap(130);
+  BOOST_CHECK_EQUAL(bitmap.GetNumWordsCovered(), 0);
+  BOOST_CHECK_EQUAL(bitmap.GetFirstGapPos(), 0);
+  BOOST_CHECK_EQUAL(bitmap.GetLastPos(), NOT_FOUND);
+
+  bitmap.SetValue(0, 70, true);
+  BOOST_CHECK_EQUAL(bitmap.GetNumWordsCovered(), 71);
+  BOOST_CHECK_EQUAL(bitmap.GetFirstGapPos(), 71);
+  BOOST_CHECK_EQUAL(bitmap.GetLastPos(), 70);
+  BOOST_CHECK(bitmap.Overlap(WordsRange(70, 80)));
+  BOOST_CHECK(!bitmap.Overlap(WordsRange(71, 129)));
+  BOOST_CHECK_EQUAL(bitmap.GetEdgeToTheLeftOf(100), 71);
+  BOOST_CHECK_EQUAL(bitmap.GetEdgeToTheRightOf(100), 129);
+
+  bitmap.SetValue(71, 129, true);
+  BOOST_CHECK(bitmap.IsComplete());
+  BOOST_CHECK_EQUAL(bitmap.GetFirstGapPos(), NOT_FOUND);
+  BOOST_CHECK_EQUAL(bitmap.GetLastGapPos(), NOT_FOUND);
+
+  bitmap.SetValue(64, false);
+  BOOST_CHECK_EQUAL(bitmap.GetFirstGapPos(), 64);
+  BOOST_CHECK_EQUAL(bitmap.GetLastGapPos(), 64);
+}
+
+BOOST_AUTO_TEST_CASE(matches_unpacked)
+{
+  srand(1234);
+  const size_t sizes[] = {1, 5, 63, 64, 65, 128, 200, 256, 257, 400};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+    const size_t size = sizes[s];
+    for (int density = 0; density <= 100; density += 25) {
+      vector<bool> ref = RandomCoverage(size, density);
+      vector<bool> other = RandomCoverage(size, density);
+      WordsBitmap bitmap(size, ref);
+      WordsBitmap copy(bitmap);
+      WordsBitmap otherBitmap(size, other);
+
+      size_t covered = 0;
+      for (size_t i = 0; i < size; ++i) {
+        BOOST_CHECK_EQUAL(copy.GetValue(i), ref[i]);
+        covered += ref[i];
+      }
+      BOOST_CHECK_EQUAL(copy.GetNumWordsCovered(), covered);
+      BOOST_CHECK_EQUAL(copy.GetFirstGapPos(), FirstGap(ref));
+      BOOST_CHECK_EQUAL(copy.GetLastGapPos(), LastGap(ref));
+      BOOST_CHECK_EQUAL(copy.GetLastPos(), LastPos(ref));
+      BOOST_CHECK_EQUAL(copy.IsComplete(), covered == size);
+
+      for (size_t start = 0; start < size; start += 7) {
+        BOOST_CHECK_EQUAL(copy.GetEdgeToTheLeftOf(start), EdgeLeft(ref, start));
+        BOOST_CHECK_EQUAL(copy.GetEdgeToTheRightOf(start), EdgeRight(ref, start));
+        for (size_t end = start; end < size; end += 11) {
+          bool overlap = false;
+          for (size_t i = start; i <= end; ++i) overlap = overlap || ref[i];
+          BOOST_CHECK_EQUAL(copy.Overlap(WordsRange(start, end)), overlap);
+        }
+      }
+
+      int cmp = CompareRef(ref, other);
+      BOOST_CHECK_EQUAL(bitmap.Compare(otherBitmap), cmp);
+      BOOST_CHECK_EQUAL(bitmap == otherBitmap, cmp == 0);
+      BOOST_CHECK_EQUAL(bitmap.Compare(copy), 0);
+      BOOST_CHECK(bitmap == copy);
+      BOOST_CHECK_EQUAL(bitmap.hash(), copy.hash());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(set_range_clears)
+{
+  WordsBitmap bitmap(300);
+  bitmap.SetValue(0, 299, true);
+  bitmap.SetValue(60, 270, false);
+  BOOST_CHECK_EQUAL(bitmap.GetNumWordsCovered(), 60 + 29);
+  BOOST_CHECK_EQUAL(bitmap.GetFirstGapPos(), 60);
+  BOOST_CHECK_EQUAL(bitmap.GetLastGapPos(), 270);
+  BOOST_CHECK_EQUAL(bitmap.GetEdgeToTheLeftOf(200), 60);
+  BOOST_CHECK_EQUAL(bitmap.GetEdgeToTheRightOf(200), 270);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,351 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ExternalSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <boost/bind.hpp>
+
+#include "util/exception.hh"
+#include "util/fake_ofstream.hh"
+#include "util/file.hh"
+#include "util/file_piece.hh"
+
+namespace MosesTraining
+{
+
+namespace
+{
+void SortLines(const std::string &text, std::vector<StringPiece> &lines)
+{
+  for (std::size_t begin = 0; begin < text.size(); ) {
+    std::size_t end = text.find('\n', begin);
+    lines.push_back(StringPiece(text.data() + begin, end - begin));
+    begin = end + 1;
+  }
+  std::sort(lines.begin(), lines.end());
+}
+
+//! forwards what is written to a SortedOutputFileStream to its ExternalSort
+class SortSink : public boost::iostreams::sink
+{
+public:
+  explicit SortSink(ExternalSort &sorter) : m_sorter(&sorter) {}
+
+  std::streamsize write(const char *data, std::streamsize size) {
+    m_sorter->Write(data, size);
+    return size;
+  }
+
+private:
+  ExternalSort *m_sorter;
+};
+}
+
+ExternalSort::ExternalSort(std::size_t memoryLimit, const std::string &tempPrefix, std::size_t maxFanIn)
+  : m_memoryLimit(memoryLimit)
+  , m_tempPrefix(tempPrefix)
+  , m_maxFanIn(std::max<std::size_t>(maxFanIn, 2))
+  , m_reading(false)
+  , m_nextLine(0)
+  , m_previousRun(0)
+{
+  util::NormalizeTempPrefix(m_tempPrefix);
+}
+
+ExternalSort::~ExternalSort()
+{
+  if (m_spillThread.joinable()) {
+    m_spillThread.join();
+  }
+  for (std::size_t i = 0; i < m_runs.size(); ++i) {
+    util::scoped_fd close(m_runs[i].fd);
+  }
+}
+
+std::size_t ExternalSort::GetNumRuns()
+{
+  WaitForSpill();
+  return m_runs.size();
+}
+
+void ExternalSort::Write(const char *data, std::size_t size)
+{
+  UTIL_THROW_IF(m_reading, util::Exception, "Lines written to an ExternalSort which is being read");
+  m_buffer.append(data, size);
+  if (m_buffer.size() >= m_memoryLimit / 2) {
+    Spill();
+  }
+}
+
+void ExternalSort::Spill()
+{
+  WaitForSpill();
+
+  // only complete lines are spilled
+  std::size_t end = m_buffer.rfind('\n') + 1;
+  if (end == 0) {
+    return;
+  }
+  m_spilling.swap(m_buffer);
+  m_buffer.assign(m_spilling, end, std::string::npos);
+  m_spilling.resize(end);
+
+  m_runs.push_back(Run(util::MakeTemp(m_tempPrefix), 0));
+  m_spillThread = boost::thread(boost::bind(&ExternalSort::WriteRun, this, m_runs.back().fd));
+}
+
+void ExternalSort::WaitForSpill()
+{
+  if (m_spillThread.joinable()) {
+    m_spillThread.join();
+  }
+  UTIL_THROW_IF(!m_spillError.empty(), util::Exception, "Writing sorted lines to " << m_tempPrefix << " failed: " << m_spillError);
+}
+
+void ExternalSort::WriteRun(int fd)
+{
+  try {
+    {
+      std::vector<StringPiece> lines;
+      SortLines(m_spilling, lines);
+      util::FakeOFStream out(fd);
+      for (std::size_t i = 0; i < lines.size(); ++i) {
+        out << lines[i] << '\n';
+      }
+      out.Flush();
+    }
+
+    // bound the number of open runs: maxFanIn runs of one level become one
+    // of the next, as long as the last ones are of the same level
+    while (m_runs.size() >= m_maxFanIn) {
+      std::size_t begin = m_runs.size() - m_maxFanIn;
+      if (m_runs[begin].level != m_runs.back().level) {
+        break;
+      }
+      MergeRuns(begin, m_runs.size());
+    }
+  } catch (const std::exception &e) {
+    m_spillError = e.what();
+  }
+}
+
+void ExternalSort::MergeRuns(std::size_t begin, std::size_t end)
+{
+  boost::ptr_vector<util::FilePiece> readers;
+  std::priority_queue<RunLine> lines;
+  std::size_t level = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    util::SeekOrThrow(m_runs[i].fd, 0);
+    readers.push_back(new util::FilePiece(m_runs[i].fd, "sorted run"));
+    level = std::max(level, m_runs[i].level);
+    m_runs[i].fd = -1;
+    StringPiece line;
+    if (readers.back().ReadLineOrEOF(line)) {
+      lines.push(RunLine(line, i - begin));
+    }
+  }
+  m_runs.erase(m_runs.begin() + begin, m_runs.begin() + end);
+
+  Run merged(util::MakeTemp(m_tempPrefix), level + 1);
+  try {
+    util::FakeOFStream out(merged.fd);
+    while (!lines.empty()) {
+      RunLine top = lines.top();
+      lines.pop();
+      out << top.line << '\n';
+      if (readers[top.run].ReadLineOrEOF(top.line)) {
+        lines.push(top);
+      }
+    }
+    out.Flush();
+  } catch (...) {
+    util::scoped_fd close(merged.fd);
+    throw;
+  }
+  m_runs.insert(m_runs.begin() + begin, merged);
+}
+
+void ExternalSort::StartReading()
+{
+  m_reading = true;
+  if (!m_buffer.empty() && m_buffer[m_buffer.size() - 1] != '\n') {
+    m_buffer += '\n';
+  }
+
+  if (m_runs.empty()) {
+    // everything fitted into memory
+    SortLines(m_buffer, m_lines);
+    return;
+  }
+
+  Spill();
+  WaitForSpill();
+  std::string().swap(m_spilling);
+  std::string().swap(m_buffer);
+
+  // at most maxFanIn runs in the final merge
+  while (m_runs.size() > m_maxFanIn) {
+    std::size_t count = std::min(m_maxFanIn, m_runs.size() - m_maxFanIn + 1);
+    MergeRuns(m_runs.size() - count, m_runs.size());
+  }
+
+  for (std::size_t i = 0; i < m_runs.size(); ++i) {
+    util::SeekOrThrow(m_runs[i].fd, 0);
+    m_readers.push_back(new util::FilePiece(m_runs[i].fd, "sorted run"));
+    m_runs[i].fd = -1;
+    StringPiece line;
+    if (m_readers.back().ReadLineOrEOF(line)) {
+      m_merge.push(RunLine(line, i));
+    }
+  }
+  m_runs.clear();
+  m_previousRun = m_readers.size();
+}
+
+bool ExternalSort::ReadLine(StringPiece &line)
+{
+  if (!m_reading) {
+    StartReading();
+  }
+
+  if (m_readers.empty()) {
+    if (m_nextLine == m_lines.size()) {
+      return false;
+    }
+    line = m_lines[m_nextLine++];
+    return true;
+  }
+
+  // the line returned last is still in its reader, which may go on now
+  if (m_previousRun < m_readers.size()) {
+    StringPiece next;
+    if (m_readers[m_previousRun].ReadLineOrEOF(next)) {
+      m_merge.push(RunLine(next, m_previousRun));
+    }
+    m_previousRun = m_readers.size();
+  }
+  if (m_merge.empty()) {
+    return false;
+  }
+  line = m_merge.top().line;
+  m_previousRun = m_merge.top().run;
+  m_merge.pop();
+  return true;
+}
+
+void ExternalSort::Finish(std::ostream &out)
+{
+  StringPiece line;
+  while (ReadLine(line)) {
+    out << line << '\n';
+  }
+  std::string().swap(m_buffer);
+  std::vector<StringPiece>().swap(m_lines);
+  m_readers.clear();
+}
+
+std::streamsize ExternalSortSource::read(char *data, std::streamsize size)
+{
+  std::streamsize done = 0;
+  while (done < size && !m_end) {
+    if (m_offset > m_line.size()) {
+      if (!m_sorter->ReadLine(m_line)) {
+        m_end = true;
+        break;
+      }
+      m_offset = 0;
+    }
+    if (m_offset < m_line.size()) {
+      std::size_t count = std::min<std::size_t>(m_line.size() - m_offset, size - done);
+      std::memcpy(data + done, m_line.data() + m_offset, count);
+      m_offset += count;
+      done += count;
+    } else {
+      data[done++] = '\n';
+      ++m_offset;
+    }
+  }
+  return done == 0 && m_end ? -1 : done;
+}
+
+SortedOutputFileStream::SortedOutputFileStream()
+  : m_memoryLimit(0)
+{
+}
+
+SortedOutputFileStream::~SortedOutputFileStream()
+{
+  Close();
+}
+
+void SortedOutputFileStream::SetSorting(std::size_t memoryLimit, const std::string &tempPrefix)
+{
+  m_memoryLimit = memoryLimit;
+  m_tempPrefix = tempPrefix;
+}
+
+bool SortedOutputFileStream::Open(const std::string &filePath)
+{
+  if (m_memoryLimit == 0) {
+    return OutputFileStream::Open(filePath);
+  }
+
+  // check now that the file can be written, rather than after sorting
+  if (!std::ofstream(filePath.c_str(), std::ios_base::out | std::ios_base::binary)) {
+    return false;
+  }
+
+  m_filePath = filePath;
+  m_sorter.reset(new ExternalSort(m_memoryLimit, m_tempPrefix));
+  this->push(SortSink(*m_sorter));
+  return true;
+}
+
+void SortedOutputFileStream::OpenUnwritten()
+{
+  UTIL_THROW_IF(m_memoryLimit == 0, util::Exception, "SortedOutputFileStream::OpenUnwritten() without SetSorting()");
+  m_filePath.clear();
+  m_sorter.reset(new ExternalSort(m_memoryLimit, m_tempPrefix));
+  this->push(SortSink(*m_sorter));
+}
+
+void SortedOutputFileStream::Close()
+{
+  if (m_sorter && !this->empty()) {
+    this->flush();
+    this->pop(); // sorter
+    if (m_filePath.empty()) {
+      // read back by GetSorted()
+      return;
+    }
+
+    // now write the file itself
+    boost::scoped_ptr<ExternalSort> sorter;
+    sorter.swap(m_sorter);
+    OutputFileStream::Open(m_filePath);
+    sorter->Finish(*this);
+  }
+  OutputFileStream::Close();
+}
+
+}  // namespace MosesTraining
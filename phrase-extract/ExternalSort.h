@@ -0,0 +1,169 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <ostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <boost/iostreams/concepts.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "OutputFileStream.h"
+#include "util/string_piece.hh"
+
+namespace util
+{
+class FilePiece;
+}
+
+namespace MosesTraining
+{
+
+/** Sorts text lines by their bytes, as LC_ALL=C sort does, in bounded memory.
+ *
+ *  Lines are collected until they fill half of the memory limit. They are
+ *  then sorted and written to an unlinked temporary file on a background
+ *  thread, while the next lines are collected in the other half. Once
+ *  maxFanIn runs of the same size are on disk, they are merged into one, so
+ *  that no more than maxFanIn runs are ever merged at once. Finish() or
+ *  ReadLine() merge the remaining runs. If all lines fit, nothing is written
+ *  to disk.
+ */
+class ExternalSort
+{
+public:
+  //! runs merged at once by default, as sort --batch-size
+  static const std::size_t DEFAULT_MAX_FAN_IN = 16;
+
+  ExternalSort(std::size_t memoryLimit, const std::string &tempPrefix, std::size_t maxFanIn = DEFAULT_MAX_FAN_IN);
+  ~ExternalSort();
+
+  //! add text of '\n' terminated lines; the last line may continue in the next call
+  void Write(const char *data, std::size_t size);
+
+  //! write all lines to out, sorted
+  void Finish(std::ostream &out);
+
+  /** read the lines back one at a time, sorted, instead of Finish(). The
+   *  line is valid until the next call. Nothing can be written after the
+   *  first call.
+   */
+  bool ReadLine(StringPiece &line);
+
+  //! number of runs in temporary files, once the last one is written
+  std::size_t GetNumRuns();
+
+private:
+  //! a sorted temporary file, made of 1, maxFanIn, maxFanIn^2... spills
+  struct Run {
+    Run(int fd, std::size_t level) : fd(fd), level(level) {}
+    int fd;
+    std::size_t level;
+  };
+
+  //! current line of a run being merged, the smallest on top
+  struct RunLine {
+    RunLine(const StringPiece &line, std::size_t run) : line(line), run(run) {}
+    StringPiece line;
+    std::size_t run;
+
+    bool operator<(const RunLine &other) const {
+      return line > other.line;
+    }
+  };
+
+  void Spill();
+  void WaitForSpill();
+  void WriteRun(int fd);
+  void MergeRuns(std::size_t begin, std::size_t end);
+  void StartReading();
+
+  std::size_t m_memoryLimit;
+  std::string m_tempPrefix;
+  std::size_t m_maxFanIn;
+  std::string m_buffer; // lines being collected
+  std::string m_spilling; // lines being sorted and written by m_spillThread
+  boost::thread m_spillThread;
+  std::string m_spillError;
+  std::vector<Run> m_runs; // levels do not increase from the first to the last run
+
+  // reading
+  bool m_reading;
+  std::vector<StringPiece> m_lines; // sorted lines of m_buffer, if there are no runs
+  std::size_t m_nextLine;
+  boost::ptr_vector<util::FilePiece> m_readers;
+  std::priority_queue<RunLine> m_merge;
+  std::size_t m_previousRun; // whose line was read last
+};
+
+/** Source of an istream over the lines of an ExternalSort, in order, e.g.
+ *  boost::iostreams::stream<ExternalSortSource> in(ExternalSortSource(sorter));
+ */
+class ExternalSortSource : public boost::iostreams::source
+{
+public:
+  explicit ExternalSortSource(ExternalSort &sorter) : m_sorter(&sorter), m_offset(1), m_end(false) {}
+
+  std::streamsize read(char *data, std::streamsize size);
+
+private:
+  ExternalSort *m_sorter;
+  StringPiece m_line;
+  std::size_t m_offset; // into m_line and its '\n', past them if the next line is due
+  bool m_end;
+};
+
+/** An OutputFileStream whose lines are written to the file sorted, when it
+ *  is closed. Without SetSorting() it is a plain OutputFileStream.
+ */
+class SortedOutputFileStream : public Moses::OutputFileStream
+{
+public:
+  SortedOutputFileStream();
+  ~SortedOutputFileStream();
+
+  //! sort files opened from now on in memoryLimit bytes, with temporary files starting with tempPrefix
+  void SetSorting(std::size_t memoryLimit, const std::string &tempPrefix);
+
+  bool Open(const std::string &filePath);
+
+  /** sort the lines without writing them to a file; they are read back from
+   *  GetSorted() once the stream is closed. Needs SetSorting().
+   */
+  void OpenUnwritten();
+
+  ExternalSort &GetSorted() {
+    return *m_sorter;
+  }
+
+  void Close();
+
+private:
+  std::size_t m_memoryLimit;
+  std::string m_tempPrefix;
+  std::string m_filePath;
+  boost::scoped_ptr<ExternalSort> m_sorter;
+};
+
+}  // namespace MosesTraining
@@ -0,0 +1,131 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ExternalSort.h"
+
+#define  BOOST_TEST_MODULE MosesTrainingExternalSort
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/iostreams/stream.hpp>
+#include <string>
+#include <vector>
+
+using namespace MosesTraining;
+using namespace std;
+
+namespace
+{
+vector<string> MakeLines(size_t count)
+{
+  vector<string> lines;
+  for (size_t i = 0; i < count; ++i) {
+    ostringstream line;
+    // mixes prefixes of other lines, bytes above 127 and repeated lines
+    line << (i * 7919) % 1000 << " ||| " << (i % 3 ? "b" : "\xc3\xa9") << " ||| " << i % 13;
+    lines.push_back(line.str());
+  }
+  return lines;
+}
+
+void WriteTo(ExternalSort &sorter, const vector<string> &lines)
+{
+  for (size_t i = 0; i < lines.size(); ++i) {
+    string line = lines[i] + "\n";
+    // lines split across writes
+    sorter.Write(line.data(), line.size() / 2);
+    sorter.Write(line.data() + line.size() / 2, line.size() - line.size() / 2);
+  }
+}
+
+string SortWith(ExternalSort &sorter, const vector<string> &lines)
+{
+  WriteTo(sorter, lines);
+  ostringstream out;
+  sorter.Finish(out);
+  return out.str();
+}
+
+string Expected(vector<string> lines)
+{
+  sort(lines.begin(), lines.end());
+  string ret;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    ret += lines[i] + "\n";
+  }
+  return ret;
+}
+}
+
+BOOST_AUTO_TEST_CASE(sort_in_memory)
+{
+  vector<string> lines = MakeLines(1000);
+  ExternalSort sorter(1 << 20, "/tmp/");
+  BOOST_CHECK_EQUAL(Expected(lines), SortWith(sorter, lines));
+  BOOST_CHECK_EQUAL(0, sorter.GetNumRuns());
+}
+
+BOOST_AUTO_TEST_CASE(sort_with_runs)
+{
+  vector<string> lines = MakeLines(10000);
+  ExternalSort sorter(4096, "/tmp/");
+  BOOST_CHECK_EQUAL(Expected(lines), SortWith(sorter, lines));
+}
+
+BOOST_AUTO_TEST_CASE(last_line_without_newline)
+{
+  ExternalSort sorter(1 << 20, "/tmp/");
+  sorter.Write("b\na", 3);
+  ostringstream out;
+  sorter.Finish(out);
+  BOOST_CHECK_EQUAL("a\nb\n", out.str());
+}
+
+BOOST_AUTO_TEST_CASE(fan_in_is_capped)
+{
+  // about 70 spills, merged two at a time
+  vector<string> lines = MakeLines(10000);
+  ExternalSort sorter(4096, "/tmp/", 2);
+  WriteTo(sorter, vector<string>(lines.begin(), lines.begin() + 5000));
+  BOOST_CHECK_LE(sorter.GetNumRuns(), 7);
+  BOOST_CHECK_GT(sorter.GetNumRuns(), 0);
+  WriteTo(sorter, vector<string>(lines.begin() + 5000, lines.end()));
+  BOOST_CHECK_LE(sorter.GetNumRuns(), 8);
+  ostringstream out;
+  sorter.Finish(out);
+  BOOST_CHECK_EQUAL(Expected(lines), out.str());
+}
+
+BOOST_AUTO_TEST_CASE(read_as_stream)
+{
+  vector<string> lines = MakeLines(10000);
+  for (size_t memory = 4096; memory <= (1 << 20); memory *= 256) {
+    ExternalSort sorter(memory, "/tmp/");
+    WriteTo(sorter, lines);
+    boost::iostreams::stream<ExternalSortSource> in((ExternalSortSource(sorter)));
+    string line, read;
+    while (getline(in, line)) {
+      read += line + "\n";
+    }
+    BOOST_CHECK_EQUAL(Expected(lines), read);
+  }
+}
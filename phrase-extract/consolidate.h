@@ -0,0 +1,37 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace MosesTraining
+{
+
+/** Merges the direct and the indirect half of a phrase table, each sorted
+ *  the same way, as the consolidate program does. args are the options of
+ *  consolidate after the three file names. Consolidate() may be called
+ *  again, but not concurrently.
+ */
+void Consolidate(const std::vector<std::string> &args, std::istream &fileDirect,
+                 std::istream &fileIndirect, std::ostream &fileConsolidated);
+
+}
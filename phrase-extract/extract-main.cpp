@@ -19,12 +19,22 @@
 #include <set>
 #include <vector>
 #include <limits>
+#include <algorithm>
+#include <unistd.h>
 
 #include "SentenceAlignment.h"
 #include "tables-core.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
+#include "ExternalSort.h"
 #include "PhraseExtractionOptions.h"
+#include "score.h"
+#include "consolidate.h"
+
+#include <boost/bind.hpp>
+#include <boost/iostreams/device/file_descriptor.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace std;
 using namespace MosesTraining;
@@ -117,6 +127,85 @@ private:
   Moses::OutputFileStream &m_extractFileContext;
   Moses::OutputFileStream &m_extractFileContextInv;
 };
+
+//! consolidate needs the counts of counts, which score writes at the end
+bool needsCountOfCounts(const vector<string> &consolidateArgs)
+{
+  return find(consolidateArgs.begin(), consolidateArgs.end(), "--GoodTuring") != consolidateArgs.end()
+         || find(consolidateArgs.begin(), consolidateArgs.end(), "--KneserNey") != consolidateArgs.end();
+}
+
+//! score into the write end of a pipe, closing it when done
+void scoreIntoPipe(const vector<string> &args, ExternalSort *extract, int fd, const string &fileNamePhraseTable)
+{
+  ExternalSortSource source(*extract);
+  boost::iostreams::stream<ExternalSortSource> in(source);
+  boost::iostreams::stream<boost::iostreams::file_descriptor_sink> out(fd, boost::iostreams::close_handle);
+  Score(args, in, out, fileNamePhraseTable);
+  out.close();
+}
+
+/** Scores both halves of the phrase table from the sorted extract and
+ *  consolidates them into fileNamePhraseTable, as train-model.perl does with
+ *  score, sort and consolidate, without writing the halves to files. The
+ *  indirect half is sorted in sortMemory bytes. The direct half comes out of
+ *  score in order already and is passed to consolidate through a pipe, or,
+ *  if consolidate needs its counts of counts, held in sortMemory bytes until
+ *  it is complete. Score writes these to fileNamePhraseTable.half.f2e.coc.
+ */
+void writePhraseTable(const string &fileNamePhraseTable, const vector<string> &directArgs,
+                      const vector<string> &indirectArgs, const vector<string> &consolidateArgs,
+                      ExternalSort &extract, ExternalSort &extractInv,
+                      size_t sortMemory, const string &sortTempDir)
+{
+  SortedOutputFileStream halfE2F;
+  halfE2F.SetSorting(sortMemory, sortTempDir);
+  halfE2F.OpenUnwritten();
+  {
+    ExternalSortSource source(extractInv);
+    boost::iostreams::stream<ExternalSortSource> in(source);
+    Score(indirectArgs, in, halfE2F, fileNamePhraseTable + ".half.e2f");
+  }
+  halfE2F.Close();
+  ExternalSortSource indirectSource(halfE2F.GetSorted());
+  boost::iostreams::stream<ExternalSortSource> indirect(indirectSource);
+
+  Moses::OutputFileStream phraseTable;
+  if (!phraseTable.Open(fileNamePhraseTable)) {
+    cerr << "extract: could not open phrase table file " << fileNamePhraseTable << endl;
+    exit(1);
+  }
+
+  if (needsCountOfCounts(consolidateArgs)) {
+    SortedOutputFileStream halfF2E;
+    halfF2E.SetSorting(sortMemory, sortTempDir);
+    halfF2E.OpenUnwritten();
+    {
+      ExternalSortSource source(extract);
+      boost::iostreams::stream<ExternalSortSource> in(source);
+      Score(directArgs, in, halfF2E, fileNamePhraseTable + ".half.f2e");
+    }
+    halfF2E.Close();
+    ExternalSortSource directSource(halfF2E.GetSorted());
+    boost::iostreams::stream<ExternalSortSource> direct(directSource);
+    Consolidate(consolidateArgs, direct, indirect, phraseTable);
+  } else {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      cerr << "extract: could not create a pipe for the direct half of the phrase table" << endl;
+      exit(1);
+    }
+    boost::thread scorer(boost::bind(&scoreIntoPipe, boost::cref(directArgs), &extract, fds[1],
+                                     fileNamePhraseTable + ".half.f2e"));
+    {
+      boost::iostreams::stream<boost::iostreams::file_descriptor_source> direct(fds[0], boost::iostreams::close_handle);
+      Consolidate(consolidateArgs, direct, indirect, phraseTable);
+    }
+    scorer.join();
+  }
+  phraseTable.Close();
+}
+
 }
 
 int main(int argc, char* argv[])
@@ -126,20 +215,30 @@ int main(int argc, char* argv[])
 
   if (argc < 6) {
     cerr << "syntax: extract en de align extract max-length [orientation [ --model [wbe|phrase|hier]-[msd|mslr|mono] ] ";
-    cerr<<"| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ]\n";
+    cerr<<"| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ";
+    cerr<<"| --SortedOutput [--SortMemory MB] [--SortTempDir dir] ";
+    cerr<<"| --PhraseTable file --ScoreDirect \"lex.f2e [options]\" --ScoreIndirect \"lex.e2f [options]\" [--Consolidate \"options\"] ]\n";
     exit(1);
   }
 
-  Moses::OutputFileStream extractFile;
-  Moses::OutputFileStream extractFileInv;
-  Moses::OutputFileStream extractFileOrientation;
-  Moses::OutputFileStream extractFileContext;
-  Moses::OutputFileStream extractFileContextInv;
+  // with --SortedOutput the files are written sorted, as extract.sorted etc.
+  // With --PhraseTable the translation table is scored and consolidated
+  // from the sorted extract, which is then not written
+  SortedOutputFileStream extractFile;
+  SortedOutputFileStream extractFileInv;
+  SortedOutputFileStream extractFileOrientation;
+  SortedOutputFileStream extractFileContext;
+  SortedOutputFileStream extractFileContextInv;
   const char* const &fileNameE = argv[1];
   const char* const &fileNameF = argv[2];
   const char* const &fileNameA = argv[3];
   const string fileNameExtract = string(argv[4]);
   PhraseExtractionOptions options(atoi(argv[5]));
+  bool sortedOutput = false;
+  size_t sortMemory = 256; // MB for all the sorted files together
+  string sortTempDir;
+  string fileNamePhraseTable;
+  vector<string> scoreDirectArgs, scoreIndirectArgs, consolidateArgs;
 
   for(int i=6; i<argc; i++) {
     if (strcmp(argv[i],"--OnlyOutputSpanInfo") == 0) {
@@ -160,6 +259,39 @@ int main(int argc, char* argv[])
       sentenceOffset = atoi(argv[++i]);
     } else if (strcmp(argv[i], "--GZOutput") == 0) {
       options.initGzOutput(true);
+    } else if (strcmp(argv[i], "--SortedOutput") == 0) {
+      sortedOutput = true;
+    } else if (strcmp(argv[i], "--SortMemory") == 0) {
+      if (i+1 >= argc || argv[i+1][0] < '0' || argv[i+1][0] > '9') {
+        cerr << "extract: syntax error, used switch --SortMemory without a number" << endl;
+        exit(1);
+      }
+      sortMemory = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--SortTempDir") == 0) {
+      if (i+1 >= argc) {
+        cerr << "extract: syntax error, used switch --SortTempDir without a directory" << endl;
+        exit(1);
+      }
+      sortTempDir = argv[++i];
+    } else if (strcmp(argv[i], "--PhraseTable") == 0) {
+      if (i+1 >= argc) {
+        cerr << "extract: syntax error, used switch --PhraseTable without file name" << endl;
+        exit(1);
+      }
+      fileNamePhraseTable = argv[++i];
+    } else if (strcmp(argv[i], "--ScoreDirect") == 0 || strcmp(argv[i], "--ScoreIndirect") == 0) {
+      if (i+1 >= argc) {
+        cerr << "extract: syntax error, used switch " << argv[i] << " without lexical table and options" << endl;
+        exit(1);
+      }
+      vector<string> &args = strcmp(argv[i], "--ScoreDirect") == 0 ? scoreDirectArgs : scoreIndirectArgs;
+      args = Tokenize(argv[++i]);
+    } else if (strcmp(argv[i], "--Consolidate") == 0) {
+      if (i+1 >= argc) {
+        cerr << "extract: syntax error, used switch --Consolidate without options" << endl;
+        exit(1);
+      }
+      consolidateArgs = Tokenize(argv[++i]);
     } else if (strcmp(argv[i], "--InstanceWeights") == 0) {
       if (i+1 >= argc) {
         cerr << "extract: syntax error, used switch --InstanceWeights without file name" << endl;
@@ -238,6 +370,21 @@ int main(int argc, char* argv[])
     options.initWordType(REO_MSD);
   }
 
+  if (!fileNamePhraseTable.empty()) {
+    if (!options.isTranslationFlag() || options.isOnlyOutputSpanInfo()) {
+      cerr << "extract: --PhraseTable needs the extracted phrase pairs, it cannot be used with --NoTTable or --OnlyOutputSpanInfo" << endl;
+      exit(1);
+    }
+    if (scoreDirectArgs.empty() || scoreIndirectArgs.empty()) {
+      cerr << "extract: --PhraseTable needs --ScoreDirect and --ScoreIndirect with the lexical tables" << endl;
+      exit(1);
+    }
+    if (find(scoreIndirectArgs.begin(), scoreIndirectArgs.end(), "--Inverse") == scoreIndirectArgs.end()) {
+      scoreIndirectArgs.push_back("--Inverse");
+    }
+    sortedOutput = true;
+  }
+
   // open input files
   Moses::InputFileStream eFile(fileNameE);
   Moses::InputFileStream fFile(fileNameF);
@@ -255,18 +402,42 @@ int main(int argc, char* argv[])
   }
 
   // open output files
-  if (options.isTranslationFlag()) {
-    string fileNameExtractInv = fileNameExtract + ".inv" + (options.isGzOutput()?".gz":"");
-    extractFile.Open( (fileNameExtract + (options.isGzOutput()?".gz":"")).c_str());
+  // sorted in memory as far as possible, so the files need not be sorted afterwards
+  const string sorted = sortedOutput ? ".sorted" : "";
+  size_t sortMemoryPerFile = 0;
+  if (sortedOutput) {
+    if (sortTempDir.empty()) {
+      size_t slash = fileNameExtract.rfind('/');
+      sortTempDir = slash == string::npos ? "." : fileNameExtract.substr(0, slash);
+    }
+    // --SortMemory is shared by all the files sorted at the same time,
+    // including the halves of the phrase table that are sorted or held
+    size_t sorters = (options.isTranslationFlag() ? 2 : 0) + (options.isOrientationFlag() ? 1 : 0)
+                     + (options.isFlexScoreFlag() ? 2 : 0);
+    if (!fileNamePhraseTable.empty()) {
+      sorters += needsCountOfCounts(consolidateArgs) ? 2 : 1;
+    }
+    sortMemoryPerFile = max<size_t>((sortMemory << 20) / max<size_t>(sorters, 1), 1 << 20);
+    SortedOutputFileStream *files[] = { &extractFile, &extractFileInv, &extractFileOrientation, &extractFileContext, &extractFileContextInv };
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+      files[f]->SetSorting(sortMemoryPerFile, sortTempDir);
+    }
+  }
+  if (!fileNamePhraseTable.empty()) {
+    extractFile.OpenUnwritten();
+    extractFileInv.OpenUnwritten();
+  } else if (options.isTranslationFlag()) {
+    string fileNameExtractInv = fileNameExtract + ".inv" + sorted + (options.isGzOutput()?".gz":"");
+    extractFile.Open( (fileNameExtract + sorted + (options.isGzOutput()?".gz":"")).c_str());
     extractFileInv.Open(fileNameExtractInv.c_str());
   }
   if (options.isOrientationFlag()) {
-    string fileNameExtractOrientation = fileNameExtract + ".o" + (options.isGzOutput()?".gz":"");
+    string fileNameExtractOrientation = fileNameExtract + ".o" + sorted + (options.isGzOutput()?".gz":"");
     extractFileOrientation.Open(fileNameExtractOrientation.c_str());
   }
   if (options.isFlexScoreFlag()) {
-    string fileNameExtractContext = fileNameExtract + ".context"  + (options.isGzOutput()?".gz":"");
-    string fileNameExtractContextInv = fileNameExtract + ".context.inv"  + (options.isGzOutput()?".gz":"");
+    string fileNameExtractContext = fileNameExtract + ".context" + sorted + (options.isGzOutput()?".gz":"");
+    string fileNameExtractContextInv = fileNameExtract + ".context.inv" + sorted + (options.isGzOutput()?".gz":"");
     extractFileContext.Open(fileNameExtractContext.c_str());
     extractFileContextInv.Open(fileNameExtractContextInv.c_str());
   }
@@ -316,6 +487,16 @@ int main(int argc, char* argv[])
 
   //az: only close if we actually opened it
   if (!options.isOnlyOutputSpanInfo()) {
+    if (sortedOutput) {
+      // merge the sorted files at the same time
+      boost::thread_group merges;
+      merges.create_thread(boost::bind(&SortedOutputFileStream::Close, &extractFile));
+      merges.create_thread(boost::bind(&SortedOutputFileStream::Close, &extractFileInv));
+      merges.create_thread(boost::bind(&SortedOutputFileStream::Close, &extractFileOrientation));
+      merges.create_thread(boost::bind(&SortedOutputFileStream::Close, &extractFileContext));
+      merges.create_thread(boost::bind(&SortedOutputFileStream::Close, &extractFileContextInv));
+      merges.join_all();
+    }
     if (options.isTranslationFlag()) {
       extractFile.Close();
       extractFileInv.Close();
@@ -329,6 +510,11 @@ int main(int argc, char* argv[])
       extractFileContext.Close();
       extractFileContextInv.Close();
     }
+
+    if (!fileNamePhraseTable.empty()) {
+      writePhraseTable(fileNamePhraseTable, scoreDirectArgs, scoreIndirectArgs, consolidateArgs,
+                       extractFile.GetSorted(), extractFileInv.GetSorted(), sortMemoryPerFile, sortTempDir);
+    }
   }
 }
 
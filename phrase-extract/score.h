@@ -17,11 +17,28 @@
   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
+#pragma once
+
+#include <iosfwd>
+#include <map>
 #include <string>
 #include <vector>
 
+#include "tables-core.h"
+
 namespace MosesTraining
 {
+
+/** Scores the phrase pairs of a sorted extract file, as the score program
+ *  does. args are the arguments of score after the extract and phrase table
+ *  files: the lexical table and the options. fileNamePhraseTable is the
+ *  base name of the files written besides the phrase table, e.g. the counts
+ *  of counts. Score() may be called again, e.g. for the other direction, but
+ *  not concurrently.
+ */
+void Score(const std::vector<std::string> &args, std::istream &extractFile,
+           std::ostream &phraseTableFile, const std::string &fileNamePhraseTable);
+
 class LexicalTable
 {
 public:
@@ -29,10 +46,12 @@ public:
   void load( const std::string &filePath );
   double permissiveLookup( WORD_ID wordS, WORD_ID wordT ) {
     // cout << endl << vcbS.getWord( wordS ) << "-" << vcbT.getWord( wordT ) << ":";
-    if (ltable.find( wordS ) == ltable.end()) return 1.0;
-    if (ltable[ wordS ].find( wordT ) == ltable[ wordS ].end()) return 1.0;
-    // cout << ltable[ wordS ][ wordT ];
-    return ltable[ wordS ][ wordT ];
+    // only find(), so that several threads may look up at the same time
+    std::map< WORD_ID, std::map< WORD_ID, double > >::const_iterator s = ltable.find( wordS );
+    if (s == ltable.end()) return 1.0;
+    std::map< WORD_ID, double >::const_iterator t = s->second.find( wordT );
+    if (t == s->second.end()) return 1.0;
+    return t->second;
   }
 };
 
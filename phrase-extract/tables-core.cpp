@@ -45,8 +45,15 @@ WORD_ID Vocabulary::storeIfNew( const WORD& word )
   if( i != lookup.end() )
     return i->second;
 
-  WORD_ID id = vocab.size();
-  vocab.push_back( word );
+  WORD_ID id = lookup.size();
+  if ( id % BLOCK_SIZE == 0 ) {
+    if ( vocab.empty() ) {
+      vocab.reserve( (WORD_ID) -1 / BLOCK_SIZE + 1 );
+    }
+    vocab.push_back( std::vector< WORD >() );
+    vocab.back().reserve( BLOCK_SIZE );
+  }
+  vocab.back().push_back( word );
   lookup[ word ] = id;
   return id;
 }
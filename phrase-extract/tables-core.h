@@ -10,6 +10,7 @@
 #include <string>
 #include <queue>
 #include <map>
+#include <vector>
 #include <cmath>
 
 extern std::vector<std::string> tokenize( const char*);
@@ -20,16 +21,23 @@ namespace MosesTraining
 typedef std::string WORD;
 typedef unsigned int WORD_ID;
 
+/** Words are stored in blocks that never move, so words may be read with
+ *  getWord() on other threads while one thread stores new ones.
+ */
 class Vocabulary
 {
 public:
   std::map<WORD, WORD_ID>  lookup;
-  std::vector< WORD > vocab;
   WORD_ID storeIfNew( const WORD& );
   WORD_ID getWordID( const WORD& );
   inline WORD &getWord( const WORD_ID id ) {
-    return vocab[ id ];
+    return vocab[ id >> BLOCK_BITS ][ id & (BLOCK_SIZE-1) ];
   }
+
+private:
+  static const WORD_ID BLOCK_BITS = 16;
+  static const WORD_ID BLOCK_SIZE = 1 << BLOCK_BITS;
+  std::vector< std::vector< WORD > > vocab; // blocks, reserved in full when created
 };
 
 typedef std::vector< WORD_ID > PHRASE;
@@ -0,0 +1,2 @@
+#!/bin/sh
+./bjam -j2 --without-tcmalloc -q cxxflags=-std=gnu++11 moses-cmd/